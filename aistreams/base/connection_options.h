@@ -46,6 +46,13 @@ struct RpcOptions {
   // If true, then block until the underlying communication channel
   // becomes ready instead of failing fast.
   bool wait_for_ready = true;
+
+  // The algorithm used to compress messages sent to the server: "gzip",
+  // "deflate", or empty for none.
+  //
+  // This trades client and server CPU for bandwidth, and mostly pays off for
+  // compressible payloads on constrained links.
+  std::string compression_algorithm;
 };
 
 // AI Streams connection options.
@@ -0,0 +1,163 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "aistreams/base/packet.h"
+#include "aistreams/base/types/eos.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/util/alloc_counter.h"
+#include "google/protobuf/wrappers.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+// Payload sizes from 100 B to 25 MB.
+void PayloadSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(16)->Range(100, 25 << 20);
+}
+
+// Returns a value of type T whose payload is about `size` bytes.
+template <typename T>
+T MakeValue(int64_t size);
+
+template <>
+std::string MakeValue<std::string>(int64_t size) {
+  return std::string(size, 'a');
+}
+
+template <>
+GstreamerBuffer MakeValue<GstreamerBuffer>(int64_t size) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string("video/x-h264");
+  gstreamer_buffer.assign(std::string(size, 'a'));
+  return gstreamer_buffer;
+}
+
+template <>
+RawImage MakeValue<RawImage>(int64_t size) {
+  int side = std::max(1, static_cast<int>(std::sqrt(size / 3)));
+  return RawImage(side, side, RAW_IMAGE_FORMAT_SRGB);
+}
+
+template <>
+JpegFrame MakeValue<JpegFrame>(int64_t size) {
+  return JpegFrame(std::string(size, 'a'));
+}
+
+template <>
+google::protobuf::BytesValue MakeValue<google::protobuf::BytesValue>(
+    int64_t size) {
+  google::protobuf::BytesValue bytes_value;
+  bytes_value.set_value(std::string(size, 'a'));
+  return bytes_value;
+}
+
+template <>
+Eos MakeValue<Eos>(int64_t size) {
+  Eos eos;
+  eos.set_reason(std::string(size, 'a'));
+  return eos;
+}
+
+void SetCounters(const AllocationCounter& allocs, int64_t bytes_per_op,
+                 benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * bytes_per_op);
+  state.counters["allocs_per_op"] = benchmark::Counter(
+      allocs.allocations(), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+template <typename T>
+void BM_MakePacket(benchmark::State& state) {
+  T value = MakeValue<T>(state.range(0));
+  int64_t payload_size = MakePacket(value).ValueOrDie().payload().size();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    auto packet_statusor = MakePacket(value);
+    benchmark::DoNotOptimize(packet_statusor);
+  }
+  SetCounters(allocs, payload_size, state);
+}
+
+template <typename T>
+void BM_Pack(benchmark::State& state) {
+  T value = MakeValue<T>(state.range(0));
+  Packet packet;
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    Status status = Pack(value, &packet);
+    benchmark::DoNotOptimize(status);
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+
+template <typename T>
+void BM_PacketAs(benchmark::State& state) {
+  T value = MakeValue<T>(state.range(0));
+  Packet packet = MakePacket(value).ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    PacketAs<T> packet_as(packet);
+    CHECK(packet_as.ok());
+    benchmark::DoNotOptimize(packet_as.ValueOrDie());
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+
+#define AIS_PACKET_TYPE_BENCHMARKS(T)                        \
+  BENCHMARK_TEMPLATE(BM_MakePacket, T)->Apply(PayloadSizes); \
+  BENCHMARK_TEMPLATE(BM_Pack, T)->Apply(PayloadSizes);       \
+  BENCHMARK_TEMPLATE(BM_PacketAs, T)->Apply(PayloadSizes)
+
+AIS_PACKET_TYPE_BENCHMARKS(std::string);
+AIS_PACKET_TYPE_BENCHMARKS(GstreamerBuffer);
+AIS_PACKET_TYPE_BENCHMARKS(RawImage);
+AIS_PACKET_TYPE_BENCHMARKS(JpegFrame);
+AIS_PACKET_TYPE_BENCHMARKS(google::protobuf::BytesValue);
+
+// A decoder's frame cycle at 4K: a frame is allocated, moved into a Packet and
+// out of it as a receiver would, then dropped, which recycles its buffer.
+void BM_RawImageFrameCycle(benchmark::State& state) {
+  AllocationCounter allocs;
+  size_t frame_size = 0;
+  for (auto _ : state) {
+    RawImage raw_image(2160, 3840, RAW_IMAGE_FORMAT_NV12);
+    frame_size = raw_image.size();
+    PacketAs<RawImage> packet_as(
+        MakePacket(std::move(raw_image)).ValueOrDie());
+    CHECK(packet_as.ok());
+    benchmark::DoNotOptimize(packet_as.ValueOrDie().data());
+  }
+  SetCounters(allocs, frame_size, state);
+  state.counters["alloc_bytes_per_op"] = benchmark::Counter(
+      allocs.bytes(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RawImageFrameCycle);
+
+// The Eos payload is only its reason, so a single small size suffices.
+BENCHMARK_TEMPLATE(BM_MakePacket, Eos)->Arg(100);
+BENCHMARK_TEMPLATE(BM_Pack, Eos)->Arg(100);
+BENCHMARK_TEMPLATE(BM_PacketAs, Eos)->Arg(100);
+
+}  // namespace aistreams
@@ -14,10 +14,12 @@
 
 #include "aistreams/base/packet_receiver.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "absl/random/random.h"
 #include "absl/time/clock.h"
+#include "aistreams/base/util/packet_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/status_macros.h"
@@ -26,6 +28,11 @@ namespace aistreams {
 
 namespace {
 constexpr int kRandomConsumerNameLength = 8;
+constexpr int kDefaultUnaryRpcBatchMaxPackets = 64;
+
+// The number of ReceivePacketBatch calls in a row that may run past their
+// deadline before Receive reports it.
+constexpr int kMaxConsecutiveUnaryRpcTimeouts = 3;
 constexpr char kRandomConsumerChars[] =
     "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
@@ -38,9 +45,27 @@ void RandomConsumerName(std::string* s) {
   }
   return;
 }
+
+absl::Time PacketTime(const Packet& packet) {
+  const auto& timestamp = packet.header().timestamp();
+  return absl::FromUnixSeconds(timestamp.seconds()) +
+         absl::Nanoseconds(timestamp.nanos());
+}
 }  // namespace
 
-PacketReceiver::PacketReceiver(const Options& options) : options_(options) {}
+PacketReceiver::PacketReceiver(const Options& options) : options_(options) {
+  MetricsRegistry* metrics = MetricsRegistry::Global();
+  MetricLabels labels = {{"stream", options_.stream_name}};
+  packets_received_ = metrics->GetCounter(
+      "ais_receiver_packets_total", "Packets received from the server.",
+      labels);
+  bytes_received_ =
+      metrics->GetCounter("ais_receiver_payload_bytes_total",
+                          "Payload bytes received from the server.", labels);
+  stale_packets_ = metrics->GetCounter(
+      "ais_receiver_stale_packets_total",
+      "Packets skipped for being older than the max packet age.", labels);
+}
 
 Status PacketReceiver::Initialize() {
   StreamChannel::Options stream_channel_options;
@@ -65,7 +90,38 @@ Status PacketReceiver::Initialize() {
   } else {
     streaming_request_.set_consumer_name(options_.receiver_name);
   }
-  if (!options_.enable_unary_rpc) {
+  streaming_request_.set_start_position(options_.start_position);
+  if (options_.start_position == START_POSITION_TIMESTAMP) {
+    if (options_.start_time == absl::InfinitePast()) {
+      return InvalidArgumentError(
+          "A start_time must be given to start from a timestamp");
+    }
+    timespec ts = absl::ToTimespec(options_.start_time);
+    streaming_request_.mutable_start_timestamp()->set_seconds(ts.tv_sec);
+    streaming_request_.mutable_start_timestamp()->set_nanos(ts.tv_nsec);
+  }
+  if (options_.enable_credit_flow_control) {
+    auto ctx_status_or = std::move(stream_channel_->MakeClientContext());
+    if (!ctx_status_or.ok()) {
+      LOG(ERROR) << ctx_status_or.status();
+      return InternalError("Failed to create a grpc client context");
+    }
+    ctx_ = std::move(ctx_status_or).ValueOrDie();
+    credit_stream_ = std::move(stub_->ReceivePacketsWithCredits(ctx_.get()));
+    if (credit_stream_ == nullptr) {
+      return UnknownError(
+          "Failed to create a ClientReaderWriter for credit based streaming");
+    }
+    ReceivePacketsControl control;
+    ReceivePacketsSetup* setup = control.mutable_setup();
+    *setup->mutable_request() = streaming_request_;
+    setup->set_overflow_policy(options_.overflow_policy);
+    setup->set_max_pending_packets(std::max(0, options_.max_pending_packets));
+    setup->set_limit_bytes(options_.max_bytes_in_flight > 0);
+    if (!credit_stream_->Write(control)) {
+      return UnavailableError("Failed to set up the credit based stream");
+    }
+  } else if (!options_.enable_unary_rpc) {
     auto ctx_status_or = std::move(stream_channel_->MakeClientContext());
     if (!ctx_status_or.ok()) {
       LOG(ERROR) << ctx_status_or.status();
@@ -95,31 +151,66 @@ Status PacketReceiver::UnarySubscribe(const PacketCallback& callback) {
     Packet packet;
     Status rpc_status = UnaryReceive(&packet);
     if (!rpc_status.ok()) {
-      LOG(ERROR) << "Unary rpc returned non-ok status: "
-                 << rpc_status.message();
-    } else {
-      Status s = callback(std::move(packet));
-      if (!s.ok()) {
-        if (IsCancelled(s)) {
-          LOG(INFO) << "The subscriber has requested to cancel";
-          break;
-        } else {
-          LOG(ERROR) << "PacketCallback returned non-ok status: "
-                     << s.message();
-        }
+      if (!IsNotFound(rpc_status)) {
+        LOG(ERROR) << "Unary rpc returned non-ok status: "
+                   << rpc_status.message();
       }
+      if (options_.unary_rpc_poll_interval_ms > 0) {
+        absl::SleepFor(
+            absl::Milliseconds(options_.unary_rpc_poll_interval_ms));
+      }
+      continue;
     }
-
-    if (options_.unary_rpc_poll_interval_ms > 0) {
-      absl::SleepFor(absl::Milliseconds(options_.unary_rpc_poll_interval_ms));
+    if (IsTooOld(packet)) {
+      continue;
+    }
+    Status s = callback(std::move(packet));
+    if (!s.ok()) {
+      if (IsCancelled(s)) {
+        LOG(INFO) << "The subscriber has requested to cancel";
+        break;
+      } else {
+        LOG(ERROR) << "PacketCallback returned non-ok status: " << s.message();
+      }
     }
   }
   return OkStatus();
 }
 
+void PacketReceiver::RecordArrival(Packet* packet) {
+  packet->mutable_header()->mutable_stage_times()->set_receive_nanos(
+      absl::GetCurrentTimeNanos());
+  sequence_tracker_.Record(packet->header());
+  packets_received_->Increment();
+  bytes_received_->Increment(packet->payload().size());
+}
+
 Status PacketReceiver::StreamingSubscribe(const PacketCallback& callback) {
   Packet packet;
   while (streaming_reader_->Read(&packet)) {
+    RecordArrival(&packet);
+    if (IsTooOld(packet)) {
+      continue;
+    }
+    Status s = callback(std::move(packet));
+    if (!s.ok()) {
+      if (IsCancelled(s)) {
+        LOG(INFO) << "The subscriber has requested to cancel";
+        break;
+      } else {
+        LOG(ERROR) << "PacketCallback returned non-ok status: " << s.message();
+      }
+    }
+  }
+  return OkStatus();
+}
+
+Status PacketReceiver::CreditSubscribe(const PacketCallback& callback) {
+  Packet packet;
+  while (CreditReceive(&packet).ok()) {
+    if (IsTooOld(packet)) {
+      continue;
+    }
     Status s = callback(std::move(packet));
     if (!s.ok()) {
       if (IsCancelled(s)) {
@@ -134,6 +225,9 @@ Status PacketReceiver::StreamingSubscribe(const PacketCallback& callback) {
 }
 
 Status PacketReceiver::Subscribe(const PacketCallback& callback) {
+  if (credit_stream_ != nullptr) {
+    return CreditSubscribe(callback);
+  }
   if (streaming_reader_ == nullptr) {
     return UnarySubscribe(callback);
   } else {
@@ -141,7 +235,94 @@ Status PacketReceiver::Subscribe(const PacketCallback& callback) {
   }
 }
 
+Status PacketReceiver::FetchUnaryBatch() {
+  auto ctx_status_or = stream_channel_->MakeClientContext();
+  if (!ctx_status_or.ok()) {
+    LOG(ERROR) << ctx_status_or.status();
+    return InternalError("Failed to create a grpc client context");
+  }
+  auto ctx = std::move(ctx_status_or).ValueOrDie();
+
+  // The server may legitimately hold the call open for the full wait, so the
+  // configured rpc timeout only starts counting after it.
+  absl::Duration max_wait =
+      std::max(options_.unary_rpc_max_wait, absl::ZeroDuration());
+  if (options_.connection_options.rpc_options.timeout > absl::ZeroDuration()) {
+    ctx->set_deadline(absl::ToChronoTime(
+        absl::Now() + max_wait +
+        options_.connection_options.rpc_options.timeout));
+  }
+
+  ReceivePacketBatchRequest request;
+  request.set_consumer_name(streaming_request_.consumer_name());
+  request.set_max_packets(options_.unary_rpc_batch_max_packets > 0
+                              ? options_.unary_rpc_batch_max_packets
+                              : kDefaultUnaryRpcBatchMaxPackets);
+  request.set_max_bytes(
+      std::max<int64_t>(0, options_.unary_rpc_batch_max_bytes));
+  timespec ts = absl::ToTimespec(max_wait);
+  request.mutable_max_wait()->set_seconds(ts.tv_sec);
+  request.mutable_max_wait()->set_nanos(ts.tv_nsec);
+  request.set_start_position(streaming_request_.start_position());
+  *request.mutable_start_timestamp() = streaming_request_.start_timestamp();
+
+  ReceivePacketBatchResponse response;
+  grpc::Status grpc_status =
+      stub_->ReceivePacketBatch(ctx.get(), request, &response);
+  if (grpc_status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+    LOG(WARNING) << "The server does not support ReceivePacketBatch; falling "
+                    "back to ReceiveOnePacket";
+    batch_rpc_unimplemented_ = true;
+    return OkStatus();
+  }
+  if (grpc_status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED) {
+    // The deadline leaves room for the full `max_wait` and then the rpc
+    // timeout, so a server that honors the long-poll never reaches it. Retry
+    // a few times in case it was a hiccup, but do not mistake a hung or
+    // unreachable server for an empty poll.
+    ++consecutive_unary_rpc_timeouts_;
+    LOG(WARNING) << "ReceivePacketBatch ran past its deadline ("
+                 << consecutive_unary_rpc_timeouts_ << " in a row): "
+                 << grpc_status.error_message();
+    if (consecutive_unary_rpc_timeouts_ >= kMaxConsecutiveUnaryRpcTimeouts) {
+      consecutive_unary_rpc_timeouts_ = 0;
+      return DeadlineExceededError(
+          "The server repeatedly failed to answer ReceivePacketBatch in time");
+    }
+    return OkStatus();
+  }
+  consecutive_unary_rpc_timeouts_ = 0;
+  if (!grpc_status.ok()) {
+    LOG(ERROR) << grpc_status.error_message();
+    return UnknownError("Encountered error calling ReceivePacketBatch RPC");
+  }
+  // Every packet in the batch arrived with the response, so stamp them now
+  // rather than as the caller gets to each one.
+  for (auto& packet : *response.mutable_packets()) {
+    RecordArrival(&packet);
+    unary_batch_.push_back(std::move(packet));
+  }
+  return OkStatus();
+}
+
 Status PacketReceiver::UnaryReceive(Packet* packet) {
+  if (unary_batch_.empty() && !batch_rpc_unimplemented_) {
+    AIS_RETURN_IF_ERROR(FetchUnaryBatch());
+  }
+  if (!unary_batch_.empty()) {
+    *packet = std::move(unary_batch_.front());
+    unary_batch_.pop_front();
+    return OkStatus();
+  }
+  if (batch_rpc_unimplemented_) {
+    AIS_RETURN_IF_ERROR(UnaryReceiveOne(packet));
+    RecordArrival(packet);
+    return OkStatus();
+  }
+  return NotFoundError("No packets arrived before the poll deadline.");
+}
+
+Status PacketReceiver::UnaryReceiveOne(Packet* packet) {
   // Create a client context.
   auto ctx_status_or = std::move(stream_channel_->MakeClientContext());
   if (!ctx_status_or.ok()) {
@@ -152,7 +333,10 @@ Status PacketReceiver::UnaryReceive(Packet* packet) {
 
   // Make the unary rpc.
   ReceiveOnePacketRequest request;
+  request.set_consumer_name(streaming_request_.consumer_name());
   request.set_blocking(true);
+  request.set_start_position(streaming_request_.start_position());
+  *request.mutable_start_timestamp() = streaming_request_.start_timestamp();
   ReceiveOnePacketResponse response;
   grpc::Status grpc_status =
       stub_->ReceiveOnePacket(ctx_.get(), request, &response);
@@ -173,14 +357,81 @@ Status PacketReceiver::StreamingReceive(Packet* packet) {
   if (!streaming_reader_->Read(packet)) {
     return UnavailableError("The packet stream has ended");
   }
+  RecordArrival(packet);
   return OkStatus();
 }
 
+Status PacketReceiver::WriteCredits(int64_t packets, int64_t bytes) {
+  ReceivePacketsControl control;
+  control.mutable_credits()->set_packets(packets);
+  control.mutable_credits()->set_bytes(bytes);
+  absl::MutexLock lock(&credit_writer_mu_);
+  if (!credit_stream_->Write(control)) {
+    return UnavailableError("Failed to grant credits; the stream has ended");
+  }
+  outstanding_packets_ += packets;
+  outstanding_bytes_ += bytes;
+  return OkStatus();
+}
+
+Status PacketReceiver::GrantCredits(int64_t packets) {
+  if (credit_stream_ == nullptr) {
+    return FailedPreconditionError("Credit flow control is not enabled");
+  }
+  if (packets <= 0) {
+    return InvalidArgumentError("Credits must be positive");
+  }
+  int64_t bytes = 0;
+  if (options_.max_bytes_in_flight > 0) {
+    bytes = std::max<int64_t>(
+        0, options_.max_bytes_in_flight - outstanding_bytes_.load());
+  }
+  return WriteCredits(packets, bytes);
+}
+
+Status PacketReceiver::CreditReceive(Packet* packet) {
+  if (outstanding_packets_ <= 0) {
+    AIS_RETURN_IF_ERROR(GrantCredits(1));
+  } else if (options_.max_bytes_in_flight > 0 && outstanding_bytes_ <= 0) {
+    // Top up bytes only; the server needs both to send anything.
+    AIS_RETURN_IF_ERROR(
+        WriteCredits(0, options_.max_bytes_in_flight - outstanding_bytes_));
+  }
+  if (!credit_stream_->Read(packet)) {
+    return UnavailableError("The packet stream has ended");
+  }
+  RecordArrival(packet);
+  outstanding_packets_ -= 1;
+  if (options_.max_bytes_in_flight > 0) {
+    outstanding_bytes_ -= packet->payload().size();
+  }
+  return OkStatus();
+}
+
+bool PacketReceiver::IsTooOld(const Packet& packet) const {
+  if (options_.max_packet_age <= absl::ZeroDuration() ||
+      IsControlSignal(packet)) {
+    return false;
+  }
+  if (absl::Now() - PacketTime(packet) <= options_.max_packet_age) {
+    return false;
+  }
+  stale_packets_->Increment();
+  return true;
+}
+
 Status PacketReceiver::Receive(Packet* packet) {
-  if (streaming_reader_ == nullptr) {
-    return UnaryReceive(packet);
-  } else {
-    return StreamingReceive(packet);
+  while (true) {
+    if (credit_stream_ != nullptr) {
+      AIS_RETURN_IF_ERROR(CreditReceive(packet));
+    } else if (streaming_reader_ == nullptr) {
+      AIS_RETURN_IF_ERROR(UnaryReceive(packet));
+    } else {
+      AIS_RETURN_IF_ERROR(StreamingReceive(packet));
+    }
+    if (!IsTooOld(*packet)) {
+      return OkStatus();
+    }
   }
 }
 
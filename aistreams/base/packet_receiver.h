@@ -17,14 +17,21 @@
 #ifndef AISTREAMS_BASE_PACKET_RECEIVER_H_
 #define AISTREAMS_BASE_PACKET_RECEIVER_H_
 
+#include <atomic>
+#include <deque>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/base/stream_channel.h"
+#include "aistreams/base/util/packet_sequence_tracker.h"
 #include "aistreams/port/grpcpp.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
 #include "aistreams/proto/packet.pb.h"
 #include "aistreams/proto/stream.grpc.pb.h"
 #include "aistreams/proto/stream.pb.h"
+#include "aistreams/util/metrics.h"
 
 namespace aistreams {
 
@@ -58,8 +65,63 @@ class PacketReceiver {
     // istio. It is not particularly efficient.
     bool enable_unary_rpc = false;
 
-    // The interval (ms) between unary rpc polls.
+    // The interval (ms) to wait before polling again after a unary rpc poll
+    // that returned no packets or failed.
     int unary_rpc_poll_interval_ms = 0;
+
+    // The maximum number of packets to fetch per unary rpc. Packets beyond the
+    // first are buffered and returned by subsequent calls to Receive.
+    //
+    // Non-positive values resolve to a pre-configured default.
+    int unary_rpc_batch_max_packets = 0;
+
+    // If positive, a soft limit on the payload bytes fetched per unary rpc.
+    int64_t unary_rpc_batch_max_bytes = 0;
+
+    // How long the server may hold a unary rpc open waiting for a packet.
+    //
+    // The rpc timeout of the connection counts from the end of this wait. A
+    // call that runs past both is retried, and Receive returns an error once
+    // a few calls in a row have done so.
+    absl::Duration unary_rpc_max_wait = absl::Seconds(5);
+
+    // Where to start reading when the server has not seen `receiver_name`
+    // before. A receiver that reconnects under a known name resumes from its
+    // recorded offset regardless of this setting.
+    //
+    // Use START_POSITION_LATEST to skip any backlog after a restart.
+    StartPosition start_position = START_POSITION_UNSPECIFIED;
+
+    // The starting point when `start_position` is START_POSITION_TIMESTAMP.
+    absl::Time start_time = absl::InfinitePast();
+
+    // If positive, data packets whose header timestamp is older than this when
+    // they arrive are dropped on the client. Control signals (e.g. EOS) are
+    // always delivered.
+    //
+    // This bounds catch-up time even when the server ignores the start
+    // position or the receiver resumes from an old offset.
+    absl::Duration max_packet_age = absl::ZeroDuration();
+
+    // Set this true to receive over a stream in which the server only sends
+    // what the client has granted credits for (see GrantCredits). Packets
+    // arriving at the server while the client is out of credits are handled
+    // according to `overflow_policy` instead of queuing up in transport
+    // buffers.
+    //
+    // This takes precedence over `enable_unary_rpc`.
+    bool enable_credit_flow_control = false;
+
+    // What the server does with packets while the client is out of credits.
+    OverflowPolicy overflow_policy = OVERFLOW_POLICY_UNSPECIFIED;
+
+    // The number of packets the server may hold while the client is out of
+    // credits. Non-positive values let the server decide.
+    int max_pending_packets = 0;
+
+    // If positive, bounds the payload bytes in flight from the server. Byte
+    // credits are topped up to this budget as packets arrive.
+    int64_t max_bytes_in_flight = 0;
   };
 
   // Creates and initializes an instance that is ready for use.
@@ -68,6 +130,8 @@ class PacketReceiver {
   // Receive a packet.
   //
   // This call blocks until a packet is available or when an error occurs.
+  // With unary rpc, a poll that ends without packets returns NotFound; the
+  // caller may simply call Receive again.
   //
   // Note: You should use exactly one of Receive or Subscribe. In the case that
   // you need both, run them in two distinct PacketReceivers.
@@ -81,6 +145,27 @@ class PacketReceiver {
   // you need both, run them in two distinct PacketReceivers.
   Status Subscribe(const PacketCallback&);
 
+  // Grant the server credits to send `packets` more packets.
+  //
+  // Only valid when `enable_credit_flow_control` is set. Receive and Subscribe
+  // grant a single credit whenever none are outstanding, so explicit grants
+  // are only needed to keep more than one packet in flight; e.g. to match the
+  // free space of a local buffer. This may be called concurrently with a
+  // blocked Receive.
+  Status GrantCredits(int64_t packets);
+
+  // Returns how the packets received so far arrived relative to the sequence
+  // numbers stamped by their senders. Packets dropped on the client by
+  // `max_packet_age` are still counted as received.
+  //
+  // This may be called from any thread.
+  PacketSequenceStats GetSequenceStats() const {
+    return sequence_tracker_.GetStats();
+  }
+
+  // The number of packet credits granted but not yet used by the server.
+  int64_t outstanding_credits() const { return outstanding_packets_; }
+
   // Use Create instead of the bare constructors.
   PacketReceiver(const Options&);
   ~PacketReceiver() = default;
@@ -93,11 +178,34 @@ class PacketReceiver {
   ReceivePacketsRequest streaming_request_;
   std::unique_ptr<grpc::ClientReader<Packet>> streaming_reader_ = nullptr;
 
+  absl::Mutex credit_writer_mu_;
+  std::unique_ptr<grpc::ClientReaderWriter<ReceivePacketsControl, Packet>>
+      credit_stream_ = nullptr;
+  std::atomic<int64_t> outstanding_packets_{0};
+  std::atomic<int64_t> outstanding_bytes_{0};
+
+  PacketSequenceTracker sequence_tracker_;
+
+  Counter* packets_received_;
+  Counter* bytes_received_;
+  Counter* stale_packets_;
+
+  std::deque<Packet> unary_batch_;
+  bool batch_rpc_unimplemented_ = false;
+  int consecutive_unary_rpc_timeouts_ = 0;
+
   Status Initialize();
+  bool IsTooOld(const Packet&) const;
+  void RecordArrival(Packet*);
   Status StreamingReceive(Packet*);
   Status StreamingSubscribe(const PacketCallback&);
   Status UnaryReceive(Packet*);
+  Status UnaryReceiveOne(Packet*);
+  Status FetchUnaryBatch();
   Status UnarySubscribe(const PacketCallback&);
+  Status CreditReceive(Packet*);
+  Status CreditSubscribe(const PacketCallback&);
+  Status WriteCredits(int64_t packets, int64_t bytes);
 };
 
 }  // namespace aistreams
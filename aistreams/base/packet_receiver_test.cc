@@ -0,0 +1,151 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/packet_receiver.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/grpcpp.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/stream.grpc.pb.h"
+#include "aistreams/proto/stream.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+// A server from before ReceivePacketBatch, which serves one packet per call.
+class BatchlessService : public StreamServer::Service {
+ public:
+  grpc::Status ReceiveOnePacket(grpc::ServerContext* ctx,
+                                const ReceiveOnePacketRequest* request,
+                                ReceiveOnePacketResponse* response) override {
+    auto packet_status_or = MakePacket(absl::StrCat(next_++));
+    *response->mutable_packet() = std::move(packet_status_or).ValueOrDie();
+    response->set_valid(true);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ReceivePacketBatch(
+      grpc::ServerContext* ctx, const ReceivePacketBatchRequest* request,
+      ReceivePacketBatchResponse* response) override {
+    ++batch_calls_;
+    return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "");
+  }
+
+  int batch_calls() const { return batch_calls_; }
+
+ private:
+  std::atomic<int> next_{0};
+  std::atomic<int> batch_calls_{0};
+};
+
+// A server that never answers ReceivePacketBatch.
+class HungBatchService : public StreamServer::Service {
+ public:
+  grpc::Status ReceivePacketBatch(
+      grpc::ServerContext* ctx, const ReceivePacketBatchRequest* request,
+      ReceivePacketBatchResponse* response) override {
+    ++batch_calls_;
+    while (!ctx->IsCancelled()) {
+      absl::SleepFor(absl::Milliseconds(5));
+    }
+    return grpc::Status::CANCELLED;
+  }
+
+  int batch_calls() const { return batch_calls_; }
+
+ private:
+  std::atomic<int> batch_calls_{0};
+};
+
+std::unique_ptr<grpc::Server> StartServer(grpc::Service* service,
+                                          std::string* address) {
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterService(service);
+  auto server = builder.BuildAndStart();
+  EXPECT_NE(server, nullptr);
+  *address = absl::StrCat("127.0.0.1:", port);
+  return server;
+}
+
+PacketReceiver::Options UnaryOptions(const std::string& address) {
+  PacketReceiver::Options options;
+  options.connection_options.target_address = address;
+  options.connection_options.ssl_options.use_insecure_channel = true;
+  options.stream_name = "test-stream";
+  options.receiver_name = "test-receiver";
+  options.enable_unary_rpc = true;
+  return options;
+}
+
+}  // namespace
+
+TEST(PacketReceiverTest, UnaryBatchUnimplementedTest) {
+  BatchlessService service;
+  std::string address;
+  auto server = StartServer(&service, &address);
+
+  auto receiver_status_or = PacketReceiver::Create(UnaryOptions(address));
+  ASSERT_TRUE(receiver_status_or.ok());
+  auto receiver = std::move(receiver_status_or).ValueOrDie();
+  for (int i = 0; i < 3; ++i) {
+    Packet packet;
+    ASSERT_TRUE(receiver->Receive(&packet).ok());
+    PacketAs<std::string> packet_as(std::move(packet));
+    ASSERT_TRUE(packet_as.ok());
+    EXPECT_EQ(packet_as.ValueOrDie(), absl::StrCat(i));
+  }
+
+  // The batch rpc is not tried again once the server turned it down.
+  EXPECT_EQ(service.batch_calls(), 1);
+  server->Shutdown();
+}
+
+TEST(PacketReceiverTest, UnaryBatchDeadlineTest) {
+  HungBatchService service;
+  std::string address;
+  auto server = StartServer(&service, &address);
+
+  PacketReceiver::Options options = UnaryOptions(address);
+  options.unary_rpc_max_wait = absl::Milliseconds(10);
+  options.connection_options.rpc_options.timeout = absl::Milliseconds(50);
+  auto receiver_status_or = PacketReceiver::Create(options);
+  ASSERT_TRUE(receiver_status_or.ok());
+  auto receiver = std::move(receiver_status_or).ValueOrDie();
+
+  // A hung server is reported rather than polled forever. The timeouts before
+  // the last one look like empty polls to the caller.
+  Packet packet;
+  Status status = receiver->Receive(&packet);
+  while (IsNotFound(status)) {
+    status = receiver->Receive(&packet);
+  }
+  EXPECT_EQ(status.code(), StatusCode::kDeadlineExceeded);
+  EXPECT_EQ(service.batch_calls(), 3);
+  server->Shutdown(std::chrono::system_clock::now());
+}
+
+}  // namespace aistreams
@@ -16,13 +16,37 @@
 
 #include <utility>
 
+#include "absl/random/random.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/status_macros.h"
 
 namespace aistreams {
 
-PacketSender::PacketSender(const Options& options) : options_(options) {}
+namespace {
+std::string RandomSessionId() {
+  absl::BitGen bitgen;
+  return absl::StrFormat("%016x", absl::Uniform<uint64_t>(bitgen));
+}
+}  // namespace
+
+PacketSender::PacketSender(const Options& options)
+    : options_(options), session_id_(RandomSessionId()) {
+  MetricsRegistry* metrics = MetricsRegistry::Global();
+  MetricLabels labels = {{"stream", options_.stream_name}};
+  packets_sent_ = metrics->GetCounter(
+      "ais_sender_packets_total", "Packets sent to the server.", labels);
+  bytes_sent_ =
+      metrics->GetCounter("ais_sender_payload_bytes_total",
+                          "Payload bytes sent to the server.", labels);
+  send_errors_ = metrics->GetCounter("ais_sender_errors_total",
+                                     "Packets that failed to send.", labels);
+  write_latency_ = metrics->GetLatencyHistogram(
+      "ais_sender_write_latency_seconds",
+      "Time taken to write a packet to the RPC.", labels);
+}
 
 Status PacketSender::Initialize() {
   StreamChannel::Options stream_channel_options;
@@ -92,12 +116,27 @@ Status PacketSender::StreamingSend(const Packet& packet) {
   return OkStatus();
 }
 
-Status PacketSender::Send(const Packet& packet) {
-  if (streaming_writer_ == nullptr) {
-    return UnarySend(packet);
-  } else {
-    return StreamingSend(packet);
+Status PacketSender::Send(Packet&& packet) {
+  PacketHeader* header = packet.mutable_header();
+  header->set_sender_session_id(session_id_);
+  header->set_sequence_number(next_sequence_number_++);
+  int64_t start_nanos = absl::GetCurrentTimeNanos();
+  header->mutable_stage_times()->set_send_nanos(start_nanos);
+  Status status = streaming_writer_ == nullptr ? UnarySend(packet)
+                                               : StreamingSend(packet);
+  write_latency_->Record(
+      absl::Nanoseconds(absl::GetCurrentTimeNanos() - start_nanos));
+  if (!status.ok()) {
+    send_errors_->Increment();
+    return status;
   }
+  packets_sent_->Increment();
+  bytes_sent_->Increment(packet.payload().size());
+  return OkStatus();
+}
+
+Status PacketSender::Send(const Packet& packet) {
+  return Send(Packet(packet));
 }
 
 PacketSender::~PacketSender() {
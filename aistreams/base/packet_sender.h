@@ -25,6 +25,7 @@
 #include "aistreams/proto/packet.pb.h"
 #include "aistreams/proto/stream.grpc.pb.h"
 #include "aistreams/proto/stream.pb.h"
+#include "aistreams/util/metrics.h"
 
 namespace aistreams {
 
@@ -53,8 +54,16 @@ class PacketSender {
   static StatusOr<std::unique_ptr<PacketSender>> Create(const Options&);
 
   // Send the given packet.
+  //
+  // The packet is stamped with this sender's session id and the next sequence
+  // number before it is sent. Pass an rvalue to stamp in place; otherwise the
+  // packet is copied first.
+  Status Send(Packet&&);
   Status Send(const Packet&);
 
+  // The id stamped as `sender_session_id` on every packet this sender sends.
+  const std::string& session_id() const { return session_id_; }
+
   // Use Create instead of the bare constructors.
   PacketSender(const Options&);
   ~PacketSender();
@@ -66,6 +75,13 @@ class PacketSender {
   std::unique_ptr<grpc::ClientContext> ctx_ = nullptr;
   SendPacketsResponse streaming_response_;
   std::unique_ptr<grpc::ClientWriter<Packet>> streaming_writer_ = nullptr;
+  std::string session_id_;
+  int64_t next_sequence_number_ = 1;
+
+  Counter* packets_sent_;
+  Counter* bytes_sent_;
+  Counter* send_errors_;
+  LatencyHistogram* write_latency_;
 
   Status Initialize();
   Status StreamingSend(const Packet&);
@@ -21,6 +21,8 @@
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/jpeg_frame.h"
 #include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/types/tensor.h"
 #include "aistreams/port/gtest.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
@@ -29,6 +31,8 @@
 #include "aistreams/proto/types/control_signal.pb.h"
 #include "aistreams/proto/types/raw_image.pb.h"
 #include "aistreams/proto/types/raw_image_packet_type_descriptor.pb.h"
+#include "aistreams/proto/types/tensor.pb.h"
+#include "aistreams/proto/types/tensor_packet_type_descriptor.pb.h"
 
 namespace aistreams {
 
@@ -136,6 +140,113 @@ TEST(PacketTest, PacketAsRawImageTest) {
   }
 }
 
+TEST(PacketTest, PacketAsPaddedRawImageTest) {
+  RawImageDescriptor desc;
+  desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+  desc.set_height(2);
+  desc.set_width(3);
+  desc.add_planes()->set_stride(12);
+  std::string bytes(24, 0);
+  bytes[12] = 7;
+  RawImage src(desc, std::move(bytes));
+  auto packet_status_or = MakePacket(src);
+  EXPECT_TRUE(packet_status_or.ok());
+  Packet packet = std::move(packet_status_or).ValueOrDie();
+  EXPECT_EQ(packet.payload().size(), 24);
+
+  {
+    PacketAs<RawImage> packet_as(packet);
+    EXPECT_TRUE(packet_as.ok());
+    RawImage dst = std::move(packet_as).ValueOrDie();
+    EXPECT_FALSE(dst.is_packed());
+    EXPECT_EQ(dst.row_stride(), 12);
+    EXPECT_EQ(dst.row(1)[0], 7);
+  }
+  {
+    // The payload must hold every row.
+    packet.mutable_payload()->resize(20);
+    PacketAs<RawImage> packet_as(std::move(packet));
+    EXPECT_FALSE(packet_as.ok());
+  }
+}
+
+TEST(PacketTest, PacketAsRawImageViewTest) {
+  RawImage src(4, 6, RAW_IMAGE_FORMAT_SRGB);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src.data()[i] = static_cast<uint8_t>(i);
+  }
+
+  // Views pack only the viewed pixels.
+  RawImageView region = RawImageView(src).Crop(1, 2, 2, 3).ValueOrDie();
+  auto packet_status_or = MakePacket(region);
+  EXPECT_TRUE(packet_status_or.ok());
+  Packet packet = std::move(packet_status_or).ValueOrDie();
+  EXPECT_EQ(packet.header().type().type_id(), PACKET_TYPE_RAW_IMAGE);
+  EXPECT_EQ(packet.payload().size(), 18);
+  {
+    PacketAs<RawImage> packet_as(packet);
+    EXPECT_TRUE(packet_as.ok());
+    RawImage dst = std::move(packet_as).ValueOrDie();
+    EXPECT_EQ(dst.height(), 2);
+    EXPECT_EQ(dst.width(), 3);
+    EXPECT_EQ(dst.row(1)[0], src.row(2)[6]);
+  }
+  {
+    // Unpacking by move takes over the payload.
+    const char* payload = packet.payload().data();
+    PacketAs<RawImageView> packet_as(std::move(packet));
+    EXPECT_TRUE(packet_as.ok());
+    RawImageView dst = std::move(packet_as).ValueOrDie();
+    EXPECT_TRUE(dst.owns_buffer());
+    EXPECT_EQ(reinterpret_cast<const char*>(dst.data()), payload);
+    EXPECT_EQ(dst.row(1)[0], src.row(2)[6]);
+  }
+}
+
+TEST(PacketTest, PacketAsTensorTest) {
+  Tensor src(TENSOR_DATA_TYPE_FLOAT32, {2, 3});
+  for (int i = 0; i < 6; ++i) {
+    src.data_as<float>()[i] = i * 0.5f;
+  }
+  auto packet_status_or = MakePacket(src);
+  EXPECT_TRUE(packet_status_or.ok());
+  Packet packet = std::move(packet_status_or).ValueOrDie();
+  EXPECT_EQ(packet.header().type().type_id(), PACKET_TYPE_TENSOR);
+  TensorPacketTypeDescriptor tensor_packet_type_desc;
+  EXPECT_TRUE(packet.header().type().type_descriptor().UnpackTo(
+      &tensor_packet_type_desc));
+  EXPECT_EQ(tensor_packet_type_desc.tensor_descriptor().dtype(),
+            TENSOR_DATA_TYPE_FLOAT32);
+  EXPECT_EQ(tensor_packet_type_desc.tensor_descriptor().shape_size(), 2);
+
+  {
+    PacketAs<Tensor> packet_as(packet);
+    EXPECT_TRUE(packet_as.ok());
+    Tensor dst = std::move(packet_as).ValueOrDie();
+    EXPECT_EQ(dst.shape(), src.shape());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(dst.data()) % Tensor::kAlignment, 0);
+    for (int i = 0; i < 6; ++i) {
+      EXPECT_EQ(dst.data_as<float>()[i], i * 0.5f);
+    }
+  }
+  {
+    // Moving the tensor through a packet keeps its buffer.
+    const uint8_t* data = src.data();
+    auto moved_packet_status_or = MakePacket(std::move(src));
+    EXPECT_TRUE(moved_packet_status_or.ok());
+    PacketAs<Tensor> packet_as(std::move(moved_packet_status_or).ValueOrDie());
+    EXPECT_TRUE(packet_as.ok());
+    Tensor dst = std::move(packet_as).ValueOrDie();
+    EXPECT_EQ(dst.data(), data);
+  }
+  {
+    // The payload must hold every element.
+    packet.mutable_payload()->resize(packet.payload().size() - 4);
+    PacketAs<Tensor> packet_as(std::move(packet));
+    EXPECT_FALSE(packet_as.ok());
+  }
+}
+
 TEST(PacketTest, MakePacketJpegFrameTest) {
   {
     std::string bytes(10, 2);
@@ -289,6 +400,37 @@ TEST(PacketTest, PacketAsGstreamerBufferTest) {
     GstreamerBuffer dst = std::move(packet_as).ValueOrDie();
     EXPECT_EQ(caps, dst.get_caps());
     EXPECT_EQ(bytes, std::string(dst.data(), dst.size()));
+    EXPECT_FALSE(dst.is_delta_unit());
+  }
+  {
+    GstreamerBuffer src;
+    src.set_caps_string("video/x-h264");
+    src.set_delta_unit(true);
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+    PacketAs<GstreamerBuffer> packet_as(
+        std::move(packet_status_or).ValueOrDie());
+    EXPECT_TRUE(packet_as.ok());
+    EXPECT_TRUE(packet_as.ValueOrDie().is_delta_unit());
+  }
+  {
+    GstreamerBuffer src;
+    src.set_caps_string("video/x-raw,format=RGB,width=3,height=2");
+    src.assign(std::string(28, 0));
+    GstreamerBuffer::VideoPlane plane;
+    plane.offset = 4;
+    plane.stride = 12;
+    src.set_video_planes({plane});
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+
+    PacketAs<GstreamerBuffer> packet_as(
+        std::move(packet_status_or).ValueOrDie());
+    EXPECT_TRUE(packet_as.ok());
+    GstreamerBuffer dst = std::move(packet_as).ValueOrDie();
+    ASSERT_EQ(dst.get_video_planes().size(), 1);
+    EXPECT_EQ(dst.get_video_planes()[0].offset, 4);
+    EXPECT_EQ(dst.get_video_planes()[0].stride, 12);
   }
 }
 
@@ -15,6 +15,7 @@
 #include "aistreams/base/stream_channel.h"
 
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
 #include "aistreams/base/util/auth_helpers.h"
 #include "aistreams/base/util/grpc_helpers.h"
 #include "aistreams/port/canonical_errors.h"
@@ -26,6 +27,11 @@ namespace aistreams {
 
 using ::aistreams::constants::kStreamMetadataKeyName;
 
+namespace {
+// ID tokens are valid for an hour; refresh well before that.
+constexpr absl::Duration kIdTokenRefreshInterval = absl::Minutes(30);
+}  // namespace
+
 StreamChannel::StreamChannel(const Options& options) : options_(options) {}
 
 Status StreamChannel::Initialize() {
@@ -37,6 +43,21 @@ Status StreamChannel::Initialize() {
   return OkStatus();
 }
 
+StatusOr<std::string> StreamChannel::GetIdToken() const {
+  absl::MutexLock lock(&token_mu_);
+  absl::Time now = absl::Now();
+  if (now - id_token_fetch_time_ < kIdTokenRefreshInterval) {
+    return id_token_;
+  }
+  auto token_statusor = GetIdTokenWithDefaultServiceAccount();
+  if (!token_statusor.ok()) {
+    return token_statusor.status();
+  }
+  id_token_ = std::move(token_statusor).ValueOrDie();
+  id_token_fetch_time_ = now;
+  return id_token_;
+}
+
 StatusOr<std::unique_ptr<grpc::ClientContext>>
 StreamChannel::MakeClientContext() const {
   auto ctx = std::make_unique<grpc::ClientContext>();
@@ -51,7 +72,7 @@ StreamChannel::MakeClientContext() const {
   // Active only for the managed service. This fetches the JWT token and uses it
   // to authenticate against the k8s Ingress.
   if (options_.connection_options.authenticate_with_google) {
-    auto token_statusor = GetIdTokenWithDefaultServiceAccount();
+    auto token_statusor = GetIdToken();
     if (!token_statusor.ok()) {
       LOG(ERROR) << token_statusor.status();
       return InternalError("Failed to get token.");
@@ -18,7 +18,11 @@
 #define AISTREAMS_BASE_STREAM_CHANNEL_H_
 
 #include <memory>
+#include <string>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/port/grpcpp.h"
 #include "aistreams/port/status.h"
@@ -50,6 +54,10 @@ class StreamChannel {
   std::shared_ptr<grpc::Channel> GetChannel() const { return grpc_channel_; }
 
   // Create a configured RPC client context.
+  //
+  // When authenticating with Google, the ID token is cached and shared by the
+  // contexts made within its refresh interval, so this is cheap to call once
+  // per RPC.
   StatusOr<std::unique_ptr<grpc::ClientContext>> MakeClientContext() const;
 
   // Use Create instead of the bare constructors.
@@ -59,7 +67,13 @@ class StreamChannel {
   Options options_;
   std::shared_ptr<grpc::Channel> grpc_channel_ = nullptr;
 
+  mutable absl::Mutex token_mu_;
+  mutable std::string id_token_ ABSL_GUARDED_BY(token_mu_);
+  mutable absl::Time id_token_fetch_time_ ABSL_GUARDED_BY(token_mu_) =
+      absl::InfinitePast();
+
   Status Initialize();
+  StatusOr<std::string> GetIdToken() const;
 };
 
 }  // namespace aistreams
@@ -0,0 +1,516 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/testing/in_memory_stream_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/stream.grpc.pb.h"
+#include "aistreams/proto/stream.pb.h"
+#include "aistreams/util/constants.h"
+#include "aistreams/util/file_helpers.h"
+
+namespace aistreams {
+
+namespace {
+
+using ::aistreams::constants::kStreamMetadataKeyName;
+
+// How often blocked calls check whether they should end.
+constexpr absl::Duration kPollInterval = absl::Milliseconds(50);
+
+// How long the server waits for outstanding calls when it stops.
+constexpr absl::Duration kShutdownGracePeriod = absl::Seconds(1);
+
+constexpr int kDefaultMaxPendingPackets = 16;
+constexpr int kDefaultBatchMaxPackets = 64;
+
+absl::Time ToTime(const google::protobuf::Timestamp& timestamp) {
+  return absl::FromUnixSeconds(timestamp.seconds()) +
+         absl::Nanoseconds(timestamp.nanos());
+}
+
+absl::Duration ToDuration(const google::protobuf::Duration& duration) {
+  return absl::Seconds(duration.seconds()) +
+         absl::Nanoseconds(duration.nanos());
+}
+
+// The retained packets of one stream and where its named consumers are.
+struct MemoryStream {
+  absl::Mutex mu;
+  absl::CondVar cv;
+
+  // The packets are immutable once appended, so they can be written out to
+  // any number of receivers without holding `mu`.
+  std::deque<std::shared_ptr<const Packet>> packets ABSL_GUARDED_BY(mu);
+
+  // The offset of packets.front() since the stream was created.
+  int64_t first_offset ABSL_GUARDED_BY(mu) = 0;
+
+  // The offset of the next packet for each consumer seen so far.
+  absl::flat_hash_map<std::string, int64_t> consumer_offsets
+      ABSL_GUARDED_BY(mu);
+
+  int64_t end_offset() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    return first_offset + static_cast<int64_t>(packets.size());
+  }
+};
+
+}  // namespace
+
+class InMemoryStreamService : public StreamServer::Service {
+ public:
+  explicit InMemoryStreamService(int max_packets_per_stream)
+      : max_packets_per_stream_(std::max(1, max_packets_per_stream)) {}
+
+  // End all outstanding calls, and make new ones return immediately.
+  void Stop();
+
+  int64_t packets_accepted() const { return packets_accepted_; }
+
+  grpc::Status SendPackets(grpc::ServerContext* ctx,
+                           grpc::ServerReader<Packet>* reader,
+                           SendPacketsResponse* response) override;
+
+  grpc::Status SendOnePacket(grpc::ServerContext* ctx, const Packet* packet,
+                             SendOnePacketResponse* response) override;
+
+  grpc::Status ReceivePackets(grpc::ServerContext* ctx,
+                              const ReceivePacketsRequest* request,
+                              grpc::ServerWriter<Packet>* writer) override;
+
+  grpc::Status ReceivePacketsWithCredits(
+      grpc::ServerContext* ctx,
+      grpc::ServerReaderWriter<Packet, ReceivePacketsControl>* stream)
+      override;
+
+  grpc::Status ReceiveOnePacket(grpc::ServerContext* ctx,
+                                const ReceiveOnePacketRequest* request,
+                                ReceiveOnePacketResponse* response) override;
+
+  grpc::Status ReceivePacketBatch(grpc::ServerContext* ctx,
+                                  const ReceivePacketBatchRequest* request,
+                                  ReceivePacketBatchResponse* response) override;
+
+ private:
+  // Returns the stream named in the call metadata, creating it if needed.
+  MemoryStream* GetStream(grpc::ServerContext* ctx);
+
+  void Append(MemoryStream* stream, Packet packet);
+
+  // Returns the offset of the next packet for `consumer_name`. Consumers not
+  // seen before start at `position`.
+  int64_t ConsumerOffset(MemoryStream* stream, const std::string& consumer_name,
+                         StartPosition position,
+                         const google::protobuf::Timestamp& start_timestamp)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream->mu);
+
+  // Waits until `stream` has a packet at or after `*offset`, advancing
+  // `*offset` past packets that are no longer retained.
+  //
+  // Returns false if `deadline` passes or the call should end first.
+  bool WaitForPacket(grpc::ServerContext* ctx, MemoryStream* stream,
+                     int64_t* offset, absl::Time deadline)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream->mu);
+
+  bool Done(grpc::ServerContext* ctx) const {
+    return stopped_ || ctx->IsCancelled();
+  }
+
+  const int max_packets_per_stream_;
+  std::atomic<bool> stopped_{false};
+  std::atomic<int64_t> packets_accepted_{0};
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, std::unique_ptr<MemoryStream>> streams_
+      ABSL_GUARDED_BY(mu_);
+};
+
+void InMemoryStreamService::Stop() {
+  stopped_ = true;
+  absl::MutexLock lock(&mu_);
+  for (auto& entry : streams_) {
+    absl::MutexLock stream_lock(&entry.second->mu);
+    entry.second->cv.SignalAll();
+  }
+}
+
+MemoryStream* InMemoryStreamService::GetStream(grpc::ServerContext* ctx) {
+  std::string name;
+  const auto& metadata = ctx->client_metadata();
+  auto it = metadata.find(kStreamMetadataKeyName);
+  if (it != metadata.end()) {
+    name.assign(it->second.data(), it->second.size());
+  }
+  absl::MutexLock lock(&mu_);
+  std::unique_ptr<MemoryStream>& stream = streams_[name];
+  if (stream == nullptr) {
+    stream = std::make_unique<MemoryStream>();
+  }
+  return stream.get();
+}
+
+void InMemoryStreamService::Append(MemoryStream* stream, Packet packet) {
+  auto shared_packet = std::make_shared<const Packet>(std::move(packet));
+  absl::MutexLock lock(&stream->mu);
+  stream->packets.push_back(std::move(shared_packet));
+  while (stream->packets.size() >
+         static_cast<size_t>(max_packets_per_stream_)) {
+    stream->packets.pop_front();
+    ++stream->first_offset;
+  }
+  ++packets_accepted_;
+  stream->cv.SignalAll();
+}
+
+int64_t InMemoryStreamService::ConsumerOffset(
+    MemoryStream* stream, const std::string& consumer_name,
+    StartPosition position,
+    const google::protobuf::Timestamp& start_timestamp) {
+  auto it = stream->consumer_offsets.find(consumer_name);
+  if (it != stream->consumer_offsets.end()) {
+    return it->second;
+  }
+  int64_t offset = stream->end_offset();
+  if (position == START_POSITION_EARLIEST) {
+    offset = stream->first_offset;
+  } else if (position == START_POSITION_TIMESTAMP) {
+    absl::Time start_time = ToTime(start_timestamp);
+    for (size_t i = 0; i < stream->packets.size(); ++i) {
+      if (ToTime(stream->packets[i]->header().timestamp()) >= start_time) {
+        offset = stream->first_offset + i;
+        break;
+      }
+    }
+  }
+  stream->consumer_offsets[consumer_name] = offset;
+  return offset;
+}
+
+bool InMemoryStreamService::WaitForPacket(grpc::ServerContext* ctx,
+                                          MemoryStream* stream,
+                                          int64_t* offset,
+                                          absl::Time deadline) {
+  while (true) {
+    *offset = std::max(*offset, stream->first_offset);
+    if (*offset < stream->end_offset()) {
+      return true;
+    }
+    absl::Time now = absl::Now();
+    if (Done(ctx) || now >= deadline) {
+      return false;
+    }
+    stream->cv.WaitWithTimeout(&stream->mu,
+                               std::min(kPollInterval, deadline - now));
+  }
+}
+
+grpc::Status InMemoryStreamService::SendPackets(
+    grpc::ServerContext* ctx, grpc::ServerReader<Packet>* reader,
+    SendPacketsResponse* response) {
+  MemoryStream* stream = GetStream(ctx);
+  Packet packet;
+  while (!stopped_ && reader->Read(&packet)) {
+    Append(stream, std::move(packet));
+    packet.Clear();
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status InMemoryStreamService::SendOnePacket(
+    grpc::ServerContext* ctx, const Packet* packet,
+    SendOnePacketResponse* response) {
+  Append(GetStream(ctx), *packet);
+  response->set_accepted(true);
+  return grpc::Status::OK;
+}
+
+grpc::Status InMemoryStreamService::ReceivePackets(
+    grpc::ServerContext* ctx, const ReceivePacketsRequest* request,
+    grpc::ServerWriter<Packet>* writer) {
+  MemoryStream* stream = GetStream(ctx);
+  int64_t offset;
+  {
+    absl::MutexLock lock(&stream->mu);
+    offset = ConsumerOffset(stream, request->consumer_name(),
+                            request->start_position(),
+                            request->start_timestamp());
+  }
+  while (true) {
+    std::shared_ptr<const Packet> packet;
+    {
+      absl::MutexLock lock(&stream->mu);
+      if (!WaitForPacket(ctx, stream, &offset, absl::InfiniteFuture())) {
+        break;
+      }
+      packet = stream->packets[offset - stream->first_offset];
+      stream->consumer_offsets[request->consumer_name()] = ++offset;
+    }
+    if (!writer->Write(*packet)) {
+      break;
+    }
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status InMemoryStreamService::ReceivePacketsWithCredits(
+    grpc::ServerContext* ctx,
+    grpc::ServerReaderWriter<Packet, ReceivePacketsControl>* rw) {
+  ReceivePacketsControl control;
+  if (!rw->Read(&control) || !control.has_setup()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "The first message must be a ReceivePacketsSetup");
+  }
+  const ReceivePacketsSetup setup = control.setup();
+  const std::string& consumer_name = setup.request().consumer_name();
+  OverflowPolicy policy = setup.overflow_policy();
+  int max_pending = setup.max_pending_packets() > 0
+                        ? setup.max_pending_packets()
+                        : kDefaultMaxPendingPackets;
+  if (policy == OVERFLOW_POLICY_CONFLATE) {
+    max_pending = 1;
+  }
+
+  MemoryStream* stream = GetStream(ctx);
+  int64_t offset;
+  {
+    absl::MutexLock lock(&stream->mu);
+    offset = ConsumerOffset(stream, consumer_name,
+                            setup.request().start_position(),
+                            setup.request().start_timestamp());
+  }
+
+  // Credits are read on their own thread so that grants arriving while this
+  // one waits for packets take effect right away.
+  int64_t packet_credits = 0;
+  int64_t byte_credits = 0;
+  bool client_done = false;
+  std::thread credit_reader([&]() {
+    ReceivePacketsControl credit_control;
+    while (rw->Read(&credit_control)) {
+      if (!credit_control.has_credits()) {
+        continue;
+      }
+      absl::MutexLock lock(&stream->mu);
+      packet_credits += credit_control.credits().packets();
+      byte_credits += credit_control.credits().bytes();
+      stream->cv.SignalAll();
+    }
+    absl::MutexLock lock(&stream->mu);
+    client_done = true;
+    stream->cv.SignalAll();
+  });
+
+  // Packets the consumer has no credits for yet. This is where the overflow
+  // policy is applied.
+  std::deque<std::shared_ptr<const Packet>> pending;
+  while (true) {
+    std::shared_ptr<const Packet> packet;
+    {
+      absl::MutexLock lock(&stream->mu);
+      while (true) {
+        if (Done(ctx) || client_done) {
+          break;
+        }
+        offset = std::max(offset, stream->first_offset);
+        for (; offset < stream->end_offset(); ++offset) {
+          pending.push_back(stream->packets[offset - stream->first_offset]);
+          if (pending.size() > static_cast<size_t>(max_pending)) {
+            if (policy == OVERFLOW_POLICY_DROP_NEWEST) {
+              pending.pop_back();
+            } else {
+              pending.pop_front();
+            }
+          }
+        }
+        stream->consumer_offsets[consumer_name] = offset;
+        if (!pending.empty() && packet_credits > 0 &&
+            (!setup.limit_bytes() || byte_credits > 0)) {
+          break;
+        }
+        stream->cv.WaitWithTimeout(&stream->mu, kPollInterval);
+      }
+      if (Done(ctx) || client_done) {
+        break;
+      }
+      packet = std::move(pending.front());
+      pending.pop_front();
+      packet_credits -= 1;
+      if (setup.limit_bytes()) {
+        byte_credits -= packet->payload().size();
+      }
+    }
+    if (!rw->Write(*packet)) {
+      break;
+    }
+  }
+
+  // Unblock the credit reader if the client is still connected.
+  ctx->TryCancel();
+  credit_reader.join();
+  return grpc::Status::OK;
+}
+
+grpc::Status InMemoryStreamService::ReceiveOnePacket(
+    grpc::ServerContext* ctx, const ReceiveOnePacketRequest* request,
+    ReceiveOnePacketResponse* response) {
+  MemoryStream* stream = GetStream(ctx);
+  absl::MutexLock lock(&stream->mu);
+  int64_t offset =
+      ConsumerOffset(stream, request->consumer_name(),
+                     request->start_position(), request->start_timestamp());
+  absl::Time deadline =
+      request->blocking() ? absl::InfiniteFuture() : absl::InfinitePast();
+  if (!WaitForPacket(ctx, stream, &offset, deadline)) {
+    response->set_valid(false);
+    return grpc::Status::OK;
+  }
+  *response->mutable_packet() =
+      *stream->packets[offset - stream->first_offset];
+  response->set_valid(true);
+  stream->consumer_offsets[request->consumer_name()] = offset + 1;
+  return grpc::Status::OK;
+}
+
+grpc::Status InMemoryStreamService::ReceivePacketBatch(
+    grpc::ServerContext* ctx, const ReceivePacketBatchRequest* request,
+    ReceivePacketBatchResponse* response) {
+  int max_packets = request->max_packets() > 0 ? request->max_packets()
+                                               : kDefaultBatchMaxPackets;
+  absl::Time deadline = absl::Now() + ToDuration(request->max_wait());
+
+  MemoryStream* stream = GetStream(ctx);
+  absl::MutexLock lock(&stream->mu);
+  int64_t offset =
+      ConsumerOffset(stream, request->consumer_name(),
+                     request->start_position(), request->start_timestamp());
+  if (!WaitForPacket(ctx, stream, &offset, deadline)) {
+    return grpc::Status::OK;
+  }
+  int64_t bytes = 0;
+  for (; offset < stream->end_offset() &&
+         response->packets_size() < max_packets;
+       ++offset) {
+    const Packet& packet = *stream->packets[offset - stream->first_offset];
+    if (request->max_bytes() > 0 && response->packets_size() > 0 &&
+        bytes + packet.payload().size() > request->max_bytes()) {
+      break;
+    }
+    bytes += packet.payload().size();
+    *response->add_packets() = packet;
+  }
+  stream->consumer_offsets[request->consumer_name()] = offset;
+  return grpc::Status::OK;
+}
+
+InMemoryStreamServer::InMemoryStreamServer(const Options& options)
+    : options_(options) {}
+
+InMemoryStreamServer::~InMemoryStreamServer() {
+  if (server_ != nullptr) {
+    service_->Stop();
+    server_->Shutdown(absl::ToChronoTime(absl::Now() + kShutdownGracePeriod));
+    server_->Wait();
+  }
+}
+
+Status InMemoryStreamServer::Initialize() {
+  std::shared_ptr<grpc::ServerCredentials> credentials;
+  if (!options_.ssl_cert_path.empty() && !options_.ssl_key_path.empty()) {
+    grpc::SslServerCredentialsOptions::PemKeyCertPair key_cert_pair;
+    AIS_RETURN_IF_ERROR(
+        file::GetContents(options_.ssl_key_path, &key_cert_pair.private_key));
+    AIS_RETURN_IF_ERROR(
+        file::GetContents(options_.ssl_cert_path, &key_cert_pair.cert_chain));
+    grpc::SslServerCredentialsOptions ssl_options;
+    ssl_options.pem_key_cert_pairs.push_back(key_cert_pair);
+    credentials = grpc::SslServerCredentials(ssl_options);
+  } else {
+    credentials = grpc::InsecureServerCredentials();
+  }
+
+  service_ =
+      std::make_unique<InMemoryStreamService>(options_.max_packets_per_stream);
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(options_.address, credentials, &port);
+  builder.RegisterService(service_.get());
+  builder.SetMaxReceiveMessageSize(-1);
+  builder.SetMaxSendMessageSize(-1);
+  server_ = builder.BuildAndStart();
+  if (server_ == nullptr || port == 0) {
+    return UnavailableError(
+        absl::StrCat("Failed to start a server on ", options_.address));
+  }
+
+  std::string host = options_.address.substr(0, options_.address.rfind(':'));
+  address_ = absl::StrCat(host, ":", port);
+  return OkStatus();
+}
+
+ConnectionOptions InMemoryStreamServer::InsecureConnectionOptions() const {
+  ConnectionOptions options;
+  options.target_address = address_;
+  options.ssl_options.use_insecure_channel = true;
+  return options;
+}
+
+int64_t InMemoryStreamServer::packets_accepted() const {
+  return service_->packets_accepted();
+}
+
+StatusOr<std::unique_ptr<InMemoryStreamServer>> InMemoryStreamServer::Create(
+    const Options& options) {
+  auto server = std::make_unique<InMemoryStreamServer>(options);
+  AIS_RETURN_IF_ERROR(server->Initialize());
+  return server;
+}
+
+std::unique_ptr<InMemoryStreamServer> StartServer(
+    const InMemoryStreamServer::Options& options) {
+  auto server_status_or = InMemoryStreamServer::Create(options);
+  CHECK(server_status_or.ok()) << server_status_or.status();
+  return std::move(server_status_or).ValueOrDie();
+}
+
+Status SendPackets(const InMemoryStreamServer& server,
+                   const std::string& stream_name, std::vector<Packet> packets,
+                   bool enable_unary_rpc) {
+  PacketSender::Options options;
+  options.connection_options = server.InsecureConnectionOptions();
+  options.stream_name = stream_name;
+  options.enable_unary_rpc = enable_unary_rpc;
+  AIS_ASSIGN_OR_RETURN(auto sender, PacketSender::Create(options));
+  for (auto& packet : packets) {
+    AIS_RETURN_IF_ERROR(sender->Send(std::move(packet)));
+  }
+  return OkStatus();
+}
+
+}  // namespace aistreams
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TESTING_IN_MEMORY_STREAM_SERVER_H_
+#define AISTREAMS_BASE_TESTING_IN_MEMORY_STREAM_SERVER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aistreams/base/connection_options.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/port/grpcpp.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+class InMemoryStreamService;
+
+// A stand-in for the stream server that keeps packets in memory.
+//
+// It implements every StreamServer rpc well enough to exercise PacketSenders
+// and PacketReceivers end to end without a cluster; e.g. in tests, benchmarks
+// and load generators that must work offline. Streams are created on first
+// use and are named by the stream metadata that clients attach.
+//
+// Each stream retains its most recent packets. Receivers that fall further
+// behind than that skip ahead to the oldest retained packet, which shows up
+// as gaps in the sequence numbers they see.
+class InMemoryStreamServer {
+ public:
+  struct Options {
+    // The address to listen on. Use port 0 to pick any free port.
+    std::string address = "127.0.0.1:0";
+
+    // The number of most recent packets retained per stream.
+    int max_packets_per_stream = 1024;
+
+    // If both are set, serve TLS with this PEM certificate chain and key.
+    // Otherwise, the server is insecure.
+    std::string ssl_cert_path;
+    std::string ssl_key_path;
+  };
+
+  // Create and start a server.
+  static StatusOr<std::unique_ptr<InMemoryStreamServer>> Create(
+      const Options&);
+
+  // Returns the address (ip:port) that clients should connect to.
+  const std::string& address() const { return address_; }
+
+  // Returns the options for clients to connect to an insecure server.
+  ConnectionOptions InsecureConnectionOptions() const;
+
+  // The total number of packets accepted across all streams.
+  int64_t packets_accepted() const;
+
+  // Copy-control members. Use Create() rather than the constructors.
+  //
+  // The destructor ends all outstanding calls and stops the server.
+  InMemoryStreamServer(const Options&);
+  ~InMemoryStreamServer();
+  InMemoryStreamServer(const InMemoryStreamServer&) = delete;
+  InMemoryStreamServer& operator=(const InMemoryStreamServer&) = delete;
+
+ private:
+  Status Initialize();
+
+  Options options_;
+  std::string address_;
+  std::unique_ptr<InMemoryStreamService> service_;
+  std::unique_ptr<grpc::Server> server_;
+};
+
+// Creates and starts an InMemoryStreamServer, dying if it cannot.
+std::unique_ptr<InMemoryStreamServer> StartServer(
+    const InMemoryStreamServer::Options& options =
+        InMemoryStreamServer::Options());
+
+// Sends `packets`, in order, to the named stream of `server` over an insecure
+// connection.
+//
+// With unary rpc, each packet is stored by the server before the next is
+// sent.
+Status SendPackets(const InMemoryStreamServer& server,
+                   const std::string& stream_name, std::vector<Packet> packets,
+                   bool enable_unary_rpc = false);
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TESTING_IN_MEMORY_STREAM_SERVER_H_
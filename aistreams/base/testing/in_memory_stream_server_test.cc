@@ -0,0 +1,168 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/testing/in_memory_stream_server.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kStreamName[] = "test-stream";
+
+// Sends the strings [begin, end).
+void SendStringRange(const InMemoryStreamServer& server, int begin, int end,
+                     bool enable_unary_rpc) {
+  std::vector<Packet> packets;
+  for (int i = begin; i < end; ++i) {
+    auto packet_status_or = MakePacket(absl::StrCat(i));
+    ASSERT_TRUE(packet_status_or.ok());
+    packets.push_back(std::move(packet_status_or).ValueOrDie());
+  }
+  ASSERT_TRUE(
+      SendPackets(server, kStreamName, std::move(packets), enable_unary_rpc)
+          .ok());
+}
+
+void SendStrings(const InMemoryStreamServer& server, int count,
+                 bool enable_unary_rpc) {
+  SendStringRange(server, 0, count, enable_unary_rpc);
+}
+
+std::string ReceiveString(PacketReceiver* receiver) {
+  Packet packet;
+  EXPECT_TRUE(receiver->Receive(&packet).ok());
+  PacketAs<std::string> packet_as(std::move(packet));
+  EXPECT_TRUE(packet_as.ok());
+  return std::move(packet_as).ValueOrDie();
+}
+
+std::unique_ptr<PacketReceiver> MakeReceiver(
+    const InMemoryStreamServer& server, PacketReceiver::Options options) {
+  options.connection_options = server.InsecureConnectionOptions();
+  options.stream_name = kStreamName;
+  options.receiver_name = "test-receiver";
+  options.start_position = START_POSITION_EARLIEST;
+  auto receiver_status_or = PacketReceiver::Create(options);
+  EXPECT_TRUE(receiver_status_or.ok());
+  return std::move(receiver_status_or).ValueOrDie();
+}
+
+}  // namespace
+
+TEST(InMemoryStreamServerTest, StreamingTest) {
+  auto server = StartServer();
+  auto receiver = MakeReceiver(*server, PacketReceiver::Options());
+  SendStrings(*server, 10, false);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(ReceiveString(receiver.get()), absl::StrCat(i));
+  }
+  EXPECT_EQ(server->packets_accepted(), 10);
+  PacketSequenceStats stats = receiver->GetSequenceStats();
+  EXPECT_EQ(stats.received, 10);
+  EXPECT_EQ(stats.missing, 0);
+}
+
+TEST(InMemoryStreamServerTest, UnaryTest) {
+  auto server = StartServer();
+  SendStrings(*server, 10, true);
+  PacketReceiver::Options options;
+  options.enable_unary_rpc = true;
+  options.unary_rpc_batch_max_packets = 4;
+  auto receiver = MakeReceiver(*server, options);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(ReceiveString(receiver.get()), absl::StrCat(i));
+  }
+}
+
+TEST(InMemoryStreamServerTest, RetentionTest) {
+  InMemoryStreamServer::Options server_options;
+  server_options.max_packets_per_stream = 4;
+  auto server = StartServer(server_options);
+  SendStrings(*server, 10, false);
+  auto receiver = MakeReceiver(*server, PacketReceiver::Options());
+  for (int i = 6; i < 10; ++i) {
+    EXPECT_EQ(ReceiveString(receiver.get()), absl::StrCat(i));
+  }
+}
+
+TEST(InMemoryStreamServerTest, CreditConflateTest) {
+  auto server = StartServer();
+  SendStrings(*server, 10, false);
+  PacketReceiver::Options options;
+  options.enable_credit_flow_control = true;
+  options.overflow_policy = OVERFLOW_POLICY_CONFLATE;
+  auto receiver = MakeReceiver(*server, options);
+  EXPECT_EQ(ReceiveString(receiver.get()), "9");
+}
+
+TEST(InMemoryStreamServerTest, CreditDropNewestTest) {
+  auto server = StartServer();
+  SendStrings(*server, 10, false);
+  PacketReceiver::Options options;
+  options.enable_credit_flow_control = true;
+  options.overflow_policy = OVERFLOW_POLICY_DROP_NEWEST;
+  options.max_pending_packets = 3;
+  auto receiver = MakeReceiver(*server, options);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(ReceiveString(receiver.get()), absl::StrCat(i));
+  }
+  SendStringRange(*server, 10, 11, true);
+  EXPECT_EQ(ReceiveString(receiver.get()), "10");
+}
+
+TEST(InMemoryStreamServerTest, CreditDropOldestTest) {
+  auto server = StartServer();
+  SendStrings(*server, 10, false);
+  PacketReceiver::Options options;
+  options.enable_credit_flow_control = true;
+  options.overflow_policy = OVERFLOW_POLICY_DROP_OLDEST;
+  options.max_pending_packets = 3;
+  auto receiver = MakeReceiver(*server, options);
+  for (int i = 7; i < 10; ++i) {
+    EXPECT_EQ(ReceiveString(receiver.get()), absl::StrCat(i));
+  }
+}
+
+TEST(InMemoryStreamServerTest, CreditBytesTest) {
+  auto server = StartServer();
+  PacketReceiver::Options options;
+  options.enable_credit_flow_control = true;
+  options.overflow_policy = OVERFLOW_POLICY_DROP_OLDEST;
+  options.max_pending_packets = 1;
+  options.max_bytes_in_flight = 1;
+  auto receiver = MakeReceiver(*server, options);
+  SendStringRange(*server, 0, 1, true);
+  EXPECT_EQ(ReceiveString(receiver.get()), "0");
+
+  // Plenty of packet credits, but the byte budget only covers one packet.
+  ASSERT_TRUE(receiver->GrantCredits(10).ok());
+  SendStringRange(*server, 1, 2, true);
+  EXPECT_EQ(ReceiveString(receiver.get()), "1");
+
+  // So these wait on the server, which keeps only the newest. Receiving tops
+  // up the bytes again.
+  SendStringRange(*server, 2, 10, true);
+  EXPECT_EQ(ReceiveString(receiver.get()), "9");
+  EXPECT_EQ(receiver->outstanding_credits(), 8);
+}
+
+}  // namespace aistreams
@@ -23,6 +23,8 @@
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/jpeg_frame.h"
 #include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/types/tensor.h"
 // All protobuf message types are considered basic.
 
 #endif  // AISTREAMS_BASE_TYPES_BASIC_TYPES_H_
@@ -0,0 +1,251 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/frame_buffer.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <cstring>
+#include <vector>
+
+#include "aistreams/port/logging.h"
+
+namespace aistreams {
+
+namespace {
+
+// Transparent huge pages are only worth asking for on buffers that span
+// several of them.
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr size_t kPageSize = 4096;
+
+int FloorLog2(size_t n) {
+  int log = 0;
+  while (n >>= 1) {
+    ++log;
+  }
+  return log;
+}
+
+// Size class c holds buffers of at least 2^(c/4) * (1 + (c%4)/4) bytes.
+size_t GetClassSize(int c) {
+  size_t base = size_t{1} << (c / 4);
+  return base + (c % 4) * (base / 4);
+}
+
+// Returns the largest class whose size is at most `size`.
+int GetFloorClass(size_t size) {
+  int log = FloorLog2(size);
+  int c = 4 * log + static_cast<int>((size - (size_t{1} << log)) /
+                                     ((size_t{1} << log) / 4));
+  return c;
+}
+
+// Returns the smallest class whose size is at least `size`.
+int GetCeilClass(size_t size) {
+  int c = GetFloorClass(size);
+  return GetClassSize(c) == size ? c : c + 1;
+}
+
+void AdviseHugePages(std::string* s) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (s->capacity() < 2 * kHugePageSize) {
+    return;
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(&(*s)[0]);
+  uintptr_t end = begin + s->capacity();
+  begin = (begin + kPageSize - 1) & ~(kPageSize - 1);
+  end &= ~(kPageSize - 1);
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+}
+
+}  // namespace
+
+constexpr size_t FrameBufferPool::kMinPooledSize;
+constexpr size_t FrameBuffer::kAlignment;
+
+FrameBufferPool::FrameBufferPool(const Options& options) : options_(options) {}
+
+FrameBufferPool* FrameBufferPool::Default() {
+  static FrameBufferPool* pool = new FrameBufferPool(Options());
+  return pool;
+}
+
+std::string FrameBufferPool::Acquire(size_t size) {
+  std::string bytes;
+  if (size < kMinPooledSize) {
+    bytes.resize(size);
+    return bytes;
+  }
+
+  int c = GetCeilClass(size);
+  bool hit = false;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = classes_.find(c);
+    if (it == classes_.end() || it->second.empty()) {
+      ++stats_.misses;
+    } else {
+      bytes = std::move(it->second.back().bytes);
+      it->second.pop_back();
+      stats_.held_bytes -= bytes.capacity();
+      ++stats_.hits;
+      hit = true;
+    }
+  }
+
+  if (!hit) {
+    bytes.reserve(GetClassSize(c));
+    if (options_.huge_pages) {
+      AdviseHugePages(&bytes);
+    }
+  }
+  // std::string zero-fills the bytes it grows by, but shrinking leaves them
+  // alone, so a recycled buffer that is reused for a size it already held is
+  // never written.
+  bytes.resize(size);
+  return bytes;
+}
+
+void FrameBufferPool::Recycle(std::string&& bytes) {
+  size_t capacity = bytes.capacity();
+  if (capacity < kMinPooledSize || capacity > options_.max_bytes) {
+    return;
+  }
+
+  // Free the evicted buffers outside of the lock.
+  std::vector<std::string> evicted;
+  absl::MutexLock lock(&mu_);
+  while (stats_.held_bytes + capacity > options_.max_bytes) {
+    evicted.push_back(EvictOldest());
+  }
+  classes_[GetFloorClass(capacity)].push_back(
+      Entry{std::move(bytes), generation_++});
+  stats_.held_bytes += capacity;
+}
+
+std::string FrameBufferPool::EvictOldest() {
+  auto oldest = classes_.end();
+  for (auto it = classes_.begin(); it != classes_.end(); ++it) {
+    if (!it->second.empty() &&
+        (oldest == classes_.end() || it->second.front().generation <
+                                         oldest->second.front().generation)) {
+      oldest = it;
+    }
+  }
+  std::string bytes = std::move(oldest->second.front().bytes);
+  oldest->second.pop_front();
+  stats_.held_bytes -= bytes.capacity();
+  return bytes;
+}
+
+void FrameBufferPool::Clear() {
+  std::map<int, std::deque<Entry>> classes;
+  absl::MutexLock lock(&mu_);
+  classes.swap(classes_);
+  stats_.held_bytes = 0;
+}
+
+FrameBufferPool::Stats FrameBufferPool::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+FrameBuffer::FrameBuffer() : pool_(FrameBufferPool::Default()) {}
+
+FrameBuffer::FrameBuffer(size_t size, size_t alignment, FrameBufferPool* pool)
+    : alignment_(alignment), pool_(pool) {
+  CHECK(pool != nullptr);
+  CHECK(alignment > 0 && alignment <= kAlignment &&
+        (alignment & (alignment - 1)) == 0);
+  if (size == 0) {
+    return;
+  }
+  // Over-allocate so that an aligned address is always inside the buffer,
+  // then start the frame there.
+  bytes_ = pool_->Acquire(size + alignment - 1);
+  if (alignment == 1) {
+    return;
+  }
+  // Strings small enough to be stored inline would move their bytes, and so
+  // lose the alignment, whenever the buffer is moved.
+  if (bytes_.capacity() < kAlignment) {
+    bytes_.reserve(kAlignment);
+  }
+  size_t misalignment =
+      reinterpret_cast<uintptr_t>(bytes_.data()) % alignment;
+  offset_ = (alignment - misalignment) % alignment;
+  bytes_.resize(offset_ + size);
+
+  // The leading bytes go along when the buffer is released, e.g. into a
+  // Packet, so do not leave stale memory in them.
+  std::memset(&bytes_[0], 0, offset_);
+}
+
+FrameBuffer::FrameBuffer(std::string&& bytes, size_t offset)
+    : bytes_(std::move(bytes)),
+      offset_(offset),
+      pool_(FrameBufferPool::Default()) {
+  CHECK_LE(offset_, bytes_.size());
+}
+
+FrameBuffer::~FrameBuffer() { pool_->Recycle(std::move(bytes_)); }
+
+FrameBuffer::FrameBuffer(const FrameBuffer& other)
+    : FrameBuffer(other.size(), other.alignment_, other.pool_) {
+  std::memcpy(data(), other.data(), size());
+}
+
+FrameBuffer& FrameBuffer::operator=(const FrameBuffer& other) {
+  if (this != &other) {
+    FrameBuffer copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other)
+    : offset_(other.offset_),
+      alignment_(other.alignment_),
+      pool_(other.pool_) {
+  bytes_ = std::move(other).Release();
+}
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) {
+  if (this != &other) {
+    pool_->Recycle(std::move(bytes_));
+    offset_ = other.offset_;
+    alignment_ = other.alignment_;
+    pool_ = other.pool_;
+    bytes_ = std::move(other).Release();
+  }
+  return *this;
+}
+
+void FrameBuffer::Truncate(size_t size) {
+  CHECK_LE(size, this->size());
+  bytes_.resize(offset_ + size);
+}
+
+std::string FrameBuffer::Release() && {
+  std::string bytes = std::move(bytes_);
+  bytes_.clear();
+  offset_ = 0;
+  return bytes;
+}
+
+}  // namespace aistreams
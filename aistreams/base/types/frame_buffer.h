@@ -0,0 +1,188 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_FRAME_BUFFER_H_
+#define AISTREAMS_BASE_TYPES_FRAME_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace aistreams {
+
+// A FrameBufferPool keeps the byte buffers of dead frames around so that the
+// next frames of a similar size can reuse them instead of going back to the
+// allocator.
+//
+// The buffers are std::strings so that they can move into and out of Packet
+// payloads without copies. They are kept in size classes a quarter of a power
+// of two apart; a buffer is handed out for any size up to its class.
+//
+// Buffers smaller than kMinPooledSize are not pooled.
+//
+// This class is thread-safe.
+class FrameBufferPool {
+ public:
+  // Buffers smaller than this are left to the allocator.
+  static constexpr size_t kMinPooledSize = 64 * 1024;
+
+  struct Options {
+    // The most bytes of idle buffers to keep. When recycling a buffer would
+    // exceed it, the buffers that have been idle the longest are freed.
+    size_t max_bytes = 256 * 1024 * 1024;
+
+    // Whether to ask the kernel to back large new buffers with transparent
+    // huge pages. This is a hint and is ignored where unsupported.
+    bool huge_pages = true;
+  };
+
+  // Counters of the pool's activity.
+  struct Stats {
+    // The number of acquisitions served from the pool.
+    int64_t hits = 0;
+
+    // The number of acquisitions of pooled sizes that had to allocate.
+    int64_t misses = 0;
+
+    // The number of bytes of idle buffers currently held.
+    size_t held_bytes = 0;
+  };
+
+  explicit FrameBufferPool(const Options& options);
+
+  // Returns the pool shared by the process.
+  static FrameBufferPool* Default();
+
+  // Returns a buffer of `size` bytes. Its contents are unspecified. Fresh
+  // buffers are zero-filled by std::string; recycled ones are not cleared
+  // up to the size they last held.
+  std::string Acquire(size_t size);
+
+  // Gives `bytes` to the pool for reuse. It may come from anywhere, e.g. a
+  // received Packet.
+  void Recycle(std::string&& bytes);
+
+  // Frees all idle buffers.
+  void Clear();
+
+  // Returns the current counters.
+  Stats stats() const;
+
+  FrameBufferPool(const FrameBufferPool&) = delete;
+  FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+ private:
+  struct Entry {
+    std::string bytes;
+    uint64_t generation;
+  };
+
+  // Removes and returns the buffer that has been idle the longest.
+  std::string EvictOldest() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+  mutable absl::Mutex mu_;
+
+  // Idle buffers by size class, most recently recycled at the back. Classes
+  // are kept when they empty out, since they usually fill up again.
+  std::map<int, std::deque<Entry>> classes_ ABSL_GUARDED_BY(mu_);
+  uint64_t generation_ ABSL_GUARDED_BY(mu_) = 0;
+  Stats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+// A FrameBuffer owns the bytes of a frame, e.g. the pixels of a RawImage.
+//
+// Buffers allocated by FrameBuffer come from a FrameBufferPool and return to
+// it when the FrameBuffer is destroyed, so that reused buffers skip the
+// allocation and the zero-fill of a fresh std::string. Buffers
+// can also be adopted from and released into std::strings, e.g. Packet
+// payloads, without copies.
+//
+// The allocator decides where a string starts, so an aligned frame starts
+// offset() bytes into its string.
+class FrameBuffer {
+ public:
+  // The largest supported alignment.
+  static constexpr size_t kAlignment = 64;
+
+  // Constructs an empty buffer.
+  FrameBuffer();
+
+  // Allocates a buffer of `size` bytes from `pool` that starts
+  // at an address that is a multiple of `alignment`. The alignment must be a
+  // power of two no larger than kAlignment; 1 leaves the frame at the start
+  // of its string.
+  explicit FrameBuffer(size_t size, size_t alignment = kAlignment,
+                       FrameBufferPool* pool = FrameBufferPool::Default());
+
+  // Adopts `bytes`, whose first `offset` bytes are not part of the frame.
+  //
+  // The bytes are not realigned. They go to the default pool once the
+  // FrameBuffer is destroyed.
+  explicit FrameBuffer(std::string&& bytes, size_t offset = 0);
+
+  ~FrameBuffer();
+
+  // Copies are allocated from the pool of the original, with the alignment it
+  // was allocated with. Copies of adopted buffers are not realigned.
+  FrameBuffer(const FrameBuffer&);
+  FrameBuffer& operator=(const FrameBuffer&);
+
+  // Moves leave the original empty.
+  FrameBuffer(FrameBuffer&&);
+  FrameBuffer& operator=(FrameBuffer&&);
+
+  // Returns a pointer to the first byte of the frame.
+  //
+  // The valid bytes are in the contiguous address range
+  // [data(), data()+size()).
+  uint8_t* data() {
+    return const_cast<uint8_t*>(static_cast<const FrameBuffer&>(*this).data());
+  }
+
+  const uint8_t* data() const {
+    return reinterpret_cast<const uint8_t*>(bytes_.data()) + offset_;
+  }
+
+  // Returns the number of bytes of the frame.
+  size_t size() const { return bytes_.size() - offset_; }
+
+  // Returns the number of bytes that precede the frame in the released
+  // string.
+  size_t offset() const { return offset_; }
+
+  // Drops the bytes past the first `size`. It must not be more than size().
+  void Truncate(size_t size);
+
+  // Returns the underlying string for the caller to acquire. The frame starts
+  // offset() bytes into it; get the offset before releasing.
+  std::string Release() &&;
+
+ private:
+  std::string bytes_;
+  size_t offset_ = 0;
+  size_t alignment_ = 1;
+  FrameBufferPool* pool_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_FRAME_BUFFER_H_
@@ -0,0 +1,162 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/frame_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr size_t kFrameSize = 1920 * 1080 * 3 / 2;
+
+bool IsAligned(const void* p) {
+  return reinterpret_cast<uintptr_t>(p) % FrameBuffer::kAlignment == 0;
+}
+
+FrameBufferPool::Options MakeOptions(size_t max_bytes) {
+  FrameBufferPool::Options options;
+  options.max_bytes = max_bytes;
+  return options;
+}
+
+}  // namespace
+
+TEST(FrameBufferTest, AllocateTest) {
+  FrameBufferPool pool(MakeOptions(16 * kFrameSize));
+  for (size_t size : {size_t{0}, size_t{1}, size_t{100}, kFrameSize}) {
+    FrameBuffer buffer(size, FrameBuffer::kAlignment, &pool);
+    EXPECT_EQ(buffer.size(), size);
+    if (size > 0) {
+      EXPECT_TRUE(IsAligned(buffer.data()));
+    }
+    std::memset(buffer.data(), 7, size);
+
+    FrameBuffer copy = buffer;
+    EXPECT_EQ(copy.size(), size);
+    EXPECT_NE(copy.data(), buffer.data());
+    if (size > 0) {
+      EXPECT_TRUE(IsAligned(copy.data()));
+      EXPECT_EQ(copy.data()[size - 1], 7);
+    }
+  }
+}
+
+TEST(FrameBufferTest, UnalignedTest) {
+  FrameBufferPool pool(MakeOptions(16 * kFrameSize));
+  FrameBuffer buffer(kFrameSize, 1, &pool);
+  EXPECT_EQ(buffer.offset(), 0);
+  EXPECT_EQ(buffer.size(), kFrameSize);
+
+  FrameBuffer copy = buffer;
+  EXPECT_EQ(copy.offset(), 0);
+  EXPECT_EQ(std::move(copy).Release().size(), kFrameSize);
+}
+
+TEST(FrameBufferTest, RecycleTest) {
+  FrameBufferPool pool(MakeOptions(16 * kFrameSize));
+  const uint8_t* data;
+  {
+    FrameBuffer buffer(kFrameSize, FrameBuffer::kAlignment, &pool);
+    data = buffer.data();
+  }
+  EXPECT_EQ(pool.stats().misses, 1);
+  EXPECT_GE(pool.stats().held_bytes, kFrameSize);
+
+  // A frame of the same or a slightly smaller size reuses the buffer.
+  {
+    FrameBuffer buffer(kFrameSize, FrameBuffer::kAlignment, &pool);
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(pool.stats().held_bytes, 0);
+  }
+  {
+    FrameBuffer buffer(kFrameSize - 1000, FrameBuffer::kAlignment, &pool);
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_TRUE(IsAligned(buffer.data()));
+  }
+  EXPECT_EQ(pool.stats().hits, 2);
+
+  // A much smaller one does not.
+  {
+    FrameBuffer buffer(kFrameSize / 2, FrameBuffer::kAlignment, &pool);
+    EXPECT_NE(buffer.data(), data);
+  }
+  EXPECT_EQ(pool.stats().misses, 2);
+
+  pool.Clear();
+  EXPECT_EQ(pool.stats().held_bytes, 0);
+}
+
+TEST(FrameBufferTest, SmallBuffersAreNotPooledTest) {
+  FrameBufferPool pool(MakeOptions(16 * kFrameSize));
+  { FrameBuffer buffer(100, FrameBuffer::kAlignment, &pool); }
+  EXPECT_EQ(pool.stats().held_bytes, 0);
+  EXPECT_EQ(pool.stats().hits + pool.stats().misses, 0);
+}
+
+TEST(FrameBufferTest, EvictionTest) {
+  FrameBufferPool pool(MakeOptions(2 * kFrameSize));
+  const uint8_t* data;
+  {
+    FrameBuffer first(kFrameSize, FrameBuffer::kAlignment, &pool);
+    FrameBuffer second(kFrameSize / 2, FrameBuffer::kAlignment, &pool);
+    FrameBuffer third(kFrameSize, FrameBuffer::kAlignment, &pool);
+    data = third.data();
+  }
+  EXPECT_LE(pool.stats().held_bytes, 2 * kFrameSize);
+
+  // The buffers die in reverse order, so the third one was idle the longest
+  // and made room for the first one.
+  FrameBuffer small(kFrameSize / 2, FrameBuffer::kAlignment, &pool);
+  FrameBuffer large(kFrameSize, FrameBuffer::kAlignment, &pool);
+  EXPECT_NE(large.data(), data);
+  EXPECT_EQ(pool.stats().hits, 2);
+  EXPECT_EQ(pool.stats().held_bytes, 0);
+}
+
+TEST(FrameBufferTest, ReleaseAndAdoptTest) {
+  FrameBufferPool pool(MakeOptions(16 * kFrameSize));
+  FrameBuffer buffer(kFrameSize, FrameBuffer::kAlignment, &pool);
+  buffer.data()[0] = 1;
+  const uint8_t* data = buffer.data();
+  size_t offset = buffer.offset();
+  std::string bytes = std::move(buffer).Release();
+  EXPECT_EQ(buffer.size(), 0);
+  EXPECT_EQ(bytes.size(), offset + kFrameSize);
+  EXPECT_EQ(bytes.data() + offset, reinterpret_cast<const char*>(data));
+  for (size_t i = 0; i < offset; ++i) {
+    EXPECT_EQ(bytes[i], 0);
+  }
+
+  FrameBuffer adopted(std::move(bytes), offset);
+  EXPECT_EQ(adopted.data(), data);
+  EXPECT_EQ(adopted.size(), kFrameSize);
+  EXPECT_EQ(adopted.data()[0], 1);
+
+  adopted.Truncate(10);
+  EXPECT_EQ(adopted.size(), 10);
+  EXPECT_EQ(adopted.data(), data);
+
+  FrameBuffer moved = std::move(adopted);
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_EQ(adopted.size(), 0);
+}
+
+}  // namespace aistreams
@@ -17,9 +17,13 @@
 #ifndef AISTREAMS_BASE_TYPES_GSTREAMER_BUFFER_H_
 #define AISTREAMS_BASE_TYPES_GSTREAMER_BUFFER_H_
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "aistreams/base/types/frame_buffer.h"
 #include "aistreams/port/status.h"
 
 namespace aistreams {
@@ -28,6 +32,15 @@ namespace aistreams {
 // describes its GstCaps (the "type").
 class GstreamerBuffer {
  public:
+  // The placement of one plane of a video/x-raw buffer.
+  struct VideoPlane {
+    // The byte offset of the first row of the plane.
+    size_t offset = 0;
+
+    // The number of bytes between the starts of consecutive rows.
+    int stride = 0;
+  };
+
   // Construct an empty GstreamerBuffer.
   GstreamerBuffer() = default;
 
@@ -47,12 +60,54 @@ class GstreamerBuffer {
   // The reference remains valid between calls to set_caps_string.
   const char* get_caps_cstr() const { return caps_.c_str(); }
 
+  // Set the presentation timestamp (nanoseconds) of the held data.
+  //
+  // This is only carried within the process (e.g. through a GstreamerRunner)
+  // and is not serialized when the buffer is packed into a Packet. A negative
+  // value means that there is no timestamp.
+  void set_pts(int64_t pts) { pts_ = pts; }
+
+  // Return the presentation timestamp, or a negative value if none is set.
+  int64_t get_pts() const { return pts_; }
+
+  // Set whether the held data cannot be decoded on its own; i.e. it is a
+  // delta frame of an inter-frame codec rather than a keyframe (see
+  // GST_BUFFER_FLAG_DELTA_UNIT).
+  void set_delta_unit(bool delta_unit) { delta_unit_ = delta_unit; }
+
+  // Return true if the held data is a delta frame. Buffers are keyframes
+  // unless marked otherwise.
+  bool is_delta_unit() const { return delta_unit_; }
+
+  // Set the placement of each plane of the held video/x-raw data.
+  //
+  // Gstreamer assumes a default layout for raw video given just its caps
+  // (e.g. RGB rows padded to 4 bytes). Set this when the data is laid out
+  // differently; it is attached as a GstVideoMeta when the buffer is fed into
+  // a GstreamerRunner. An empty vector means the default layout.
+  void set_video_planes(std::vector<VideoPlane> video_planes) {
+    video_planes_ = std::move(video_planes);
+  }
+
+  // Return the placement of each video plane, or an empty vector for the
+  // default layout.
+  const std::vector<VideoPlane>& get_video_planes() const {
+    return video_planes_;
+  }
+
   // Replaces the contents of the held data buffer by the bytes held between the
   // address range [src, src+size).
   //
   // Usually, you would use gst_buffer_map to obtain the starting address of the
   // GstBuffer and its size. You can then pass those into src and size.
-  void assign(const char* src, size_t size) { bytes_.assign(src, src + size); }
+  //
+  // The bytes are copied into a buffer from the default FrameBufferPool, so
+  // that the buffers of frames that are done with (e.g. RawImages adopted
+  // from them) are reused.
+  void assign(const char* src, size_t size) {
+    bytes_ = FrameBufferPool::Default()->Acquire(size);
+    std::memcpy(&bytes_[0], src, size);
+  }
 
   // Replaces the contents of the held data buffer by copying the argument.
   void assign(const std::string& s) { bytes_ = s; }
@@ -85,6 +140,9 @@ class GstreamerBuffer {
  private:
   std::string caps_;
   std::string bytes_;
+  int64_t pts_ = -1;
+  bool delta_unit_ = false;
+  std::vector<VideoPlane> video_planes_;
 };
 
 }  // namespace aistreams
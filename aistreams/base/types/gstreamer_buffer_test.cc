@@ -48,6 +48,36 @@ TEST(GstreamerBufferTest, CapsTest) {
   }
 }
 
+TEST(GstreamerBufferTest, PtsTest) {
+  GstreamerBuffer gstreamer_buffer;
+  EXPECT_LT(gstreamer_buffer.get_pts(), 0);
+  gstreamer_buffer.set_pts(42);
+  EXPECT_EQ(gstreamer_buffer.get_pts(), 42);
+  GstreamerBuffer copy = gstreamer_buffer;
+  EXPECT_EQ(copy.get_pts(), 42);
+}
+
+TEST(GstreamerBufferTest, VideoPlanesTest) {
+  GstreamerBuffer gstreamer_buffer;
+  EXPECT_TRUE(gstreamer_buffer.get_video_planes().empty());
+  GstreamerBuffer::VideoPlane plane;
+  plane.offset = 8;
+  plane.stride = 64;
+  gstreamer_buffer.set_video_planes({plane});
+  GstreamerBuffer copy = gstreamer_buffer;
+  ASSERT_EQ(copy.get_video_planes().size(), 1);
+  EXPECT_EQ(copy.get_video_planes()[0].offset, 8);
+  EXPECT_EQ(copy.get_video_planes()[0].stride, 64);
+}
+
+TEST(GstreamerBufferTest, DeltaUnitTest) {
+  GstreamerBuffer gstreamer_buffer;
+  EXPECT_FALSE(gstreamer_buffer.is_delta_unit());
+  gstreamer_buffer.set_delta_unit(true);
+  GstreamerBuffer copy = gstreamer_buffer;
+  EXPECT_TRUE(copy.is_delta_unit());
+}
+
 TEST(GstreamerBufferTest, AssignTest) {
   {
     std::string some_data("hello");
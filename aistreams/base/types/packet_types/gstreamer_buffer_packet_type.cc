@@ -14,6 +14,8 @@
 
 #include "aistreams/base/types/packet_types/gstreamer_buffer_packet_type.h"
 
+#include <vector>
+
 #include "absl/strings/str_format.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/port/canonical_errors.h"
@@ -39,6 +41,17 @@ StatusOr<GstreamerBufferPacketTypeDescriptor> GetTypeDescriptor(
   return gstreamer_buffer_packet_type_desc;
 }
 
+std::vector<GstreamerBuffer::VideoPlane> GetVideoPlanes(
+    const GstreamerBufferPacketTypeDescriptor& desc) {
+  std::vector<GstreamerBuffer::VideoPlane> video_planes(
+      desc.video_planes_size());
+  for (int i = 0; i < desc.video_planes_size(); ++i) {
+    video_planes[i].offset = desc.video_planes(i).offset();
+    video_planes[i].stride = desc.video_planes(i).stride();
+  }
+  return video_planes;
+}
+
 }  // namespace
 
 Status PackPayload(const GstreamerBuffer& gstreamer_buffer, Packet* p) {
@@ -69,6 +82,8 @@ Status UnpackPayload(const Packet& p, GstreamerBuffer* to) {
   auto gstreamer_packet_type_desc =
       std::move(gstreamer_packet_type_desc_statusor).ValueOrDie();
   to->set_caps_string(gstreamer_packet_type_desc.caps_string());
+  to->set_video_planes(GetVideoPlanes(gstreamer_packet_type_desc));
+  to->set_delta_unit(gstreamer_packet_type_desc.delta_unit());
   to->assign(p.payload());
   return OkStatus();
 }
@@ -84,6 +99,8 @@ Status UnpackPayload(Packet&& p, GstreamerBuffer* to) {
   auto gstreamer_packet_type_desc =
       std::move(gstreamer_packet_type_desc_statusor).ValueOrDie();
   to->set_caps_string(gstreamer_packet_type_desc.caps_string());
+  to->set_video_planes(GetVideoPlanes(gstreamer_packet_type_desc));
+  to->set_delta_unit(gstreamer_packet_type_desc.delta_unit());
   to->assign(std::move(*p.mutable_payload()));
   return OkStatus();
 }
@@ -23,6 +23,7 @@
 #include "aistreams/port/status.h"
 #include "aistreams/proto/packet.pb.h"
 #include "aistreams/proto/types/gstreamer_buffer_packet_type_descriptor.pb.h"
+#include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
@@ -45,6 +46,13 @@ struct PacketTypeTraits<GstreamerBuffer> {
     GstreamerBufferPacketTypeDescriptor gstreamer_buffer_packet_type_desc;
     gstreamer_buffer_packet_type_desc.set_caps_string(
         gstreamer_buffer.get_caps());
+    for (const auto& plane : gstreamer_buffer.get_video_planes()) {
+      RawImagePlane* p = gstreamer_buffer_packet_type_desc.add_video_planes();
+      p->set_offset(plane.offset);
+      p->set_stride(plane.stride);
+    }
+    gstreamer_buffer_packet_type_desc.set_delta_unit(
+        gstreamer_buffer.is_delta_unit());
     any->PackFrom(gstreamer_buffer_packet_type_desc);
     return OkStatus();
   }
@@ -27,6 +27,7 @@
 #include "aistreams/base/types/packet_types/protobuf_packet_type.h"
 #include "aistreams/base/types/packet_types/raw_image_packet_type.h"
 #include "aistreams/base/types/packet_types/string_packet_type.h"
+#include "aistreams/base/types/packet_types/tensor_packet_type.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
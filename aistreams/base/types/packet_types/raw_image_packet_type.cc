@@ -18,6 +18,7 @@
 #include "aistreams/base/types/raw_image.h"
 #include "aistreams/base/types/raw_image_helpers.h"
 #include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
 #include "aistreams/port/statusor.h"
 #include "aistreams/proto/packet.pb.h"
 #include "aistreams/proto/types/raw_image_packet_type_descriptor.pb.h"
@@ -50,7 +51,11 @@ StatusOr<RawImageDescriptor> ValidateAndGetDescriptor(const Packet& p) {
   }
   auto expected_payload_size =
       std::move(expected_payload_size_statusor).ValueOrDie();
-  if (p.payload().size() != expected_payload_size) {
+  // Padded images may carry bytes beyond the end of their last row.
+  bool size_ok = raw_image_descriptor.planes_size() == 0
+                     ? p.payload().size() == expected_payload_size
+                     : p.payload().size() >= expected_payload_size;
+  if (!size_ok) {
     return InvalidArgumentError(absl::StrFormat(
         "The given Packet's payload size is inconsistent with its "
         "RawImageDescriptor (%d vs %d)",
@@ -65,8 +70,10 @@ Status PackPayload(const RawImage& raw_image, Packet* p) {
   if (p == nullptr) {
     return InvalidArgumentError("Given a nullptr to a Packet");
   }
-  p->mutable_payload()->assign(raw_image.data(),
-                               raw_image.data() + raw_image.size());
+  // Keep the bytes that precede the image; the planes of its descriptor
+  // account for them.
+  const uint8_t* begin = raw_image.data() - raw_image.buffer_offset();
+  p->mutable_payload()->assign(begin, raw_image.data() + raw_image.size());
   return OkStatus();
 }
 
@@ -90,9 +97,7 @@ Status UnpackPayload(const Packet& p, RawImage* to) {
   RawImageDescriptor raw_image_descriptor =
       raw_image_desc_status_or.ValueOrDie();
 
-  RawImage from(raw_image_descriptor);
-  std::copy(p.payload().begin(), p.payload().end(), from.data());
-  *to = std::move(from);
+  *to = RawImage(raw_image_descriptor, std::string(p.payload()));
   return OkStatus();
 }
 
@@ -112,4 +117,28 @@ Status UnpackPayload(Packet&& p, RawImage* to) {
   return OkStatus();
 }
 
+Status PackPayload(const RawImageView& view, Packet* p) {
+  return PackPayload(view.ToRawImage(), p);
+}
+
+Status UnpackPayload(const Packet& p, RawImageView* to) {
+  if (to == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a RawImageView");
+  }
+  RawImage raw_image;
+  AIS_RETURN_IF_ERROR(UnpackPayload(p, &raw_image));
+  *to = RawImageView(std::move(raw_image));
+  return OkStatus();
+}
+
+Status UnpackPayload(Packet&& p, RawImageView* to) {
+  if (to == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a RawImageView");
+  }
+  RawImage raw_image;
+  AIS_RETURN_IF_ERROR(UnpackPayload(std::move(p), &raw_image));
+  *to = RawImageView(std::move(raw_image));
+  return OkStatus();
+}
+
 }  // namespace aistreams
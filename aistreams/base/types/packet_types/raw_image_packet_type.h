@@ -19,6 +19,7 @@
 
 #include "aistreams/base/types/packet_types/packet_type_traits.h"
 #include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/status.h"
 #include "aistreams/proto/packet.pb.h"
@@ -43,12 +44,8 @@ struct PacketTypeTraits<RawImage> {
       return InvalidArgumentError("Given a nullptr to a google::protobuf::Any");
     }
     RawImagePacketTypeDescriptor raw_image_packet_type_desc;
-    raw_image_packet_type_desc.mutable_raw_image_descriptor()->set_format(
-        raw_image.format());
-    raw_image_packet_type_desc.mutable_raw_image_descriptor()->set_height(
-        raw_image.height());
-    raw_image_packet_type_desc.mutable_raw_image_descriptor()->set_width(
-        raw_image.width());
+    *raw_image_packet_type_desc.mutable_raw_image_descriptor() =
+        raw_image.descriptor();
     any->PackFrom(raw_image_packet_type_desc);
     return OkStatus();
   }
@@ -66,6 +63,45 @@ Status UnpackPayload(const Packet& p, RawImage* to);
 // Unpack the Packet's payload with move semantics.
 Status UnpackPayload(Packet&& p, RawImage* to);
 
+// Specialization to map RawImageView to Packets of type PACKET_TYPE_RAW_IMAGE.
+//
+// Views are packed into the same Packets as RawImages, so either type can
+// unpack them.
+template <>
+struct PacketTypeTraits<RawImageView> {
+  using value_type = RawImageView;
+  constexpr static PacketTypeId packet_type_id() {
+    return PACKET_TYPE_RAW_IMAGE;
+  }
+
+  constexpr static const char* packet_type_name() { return "RawImage"; }
+
+  static Status packet_type_descriptor(const RawImageView& view,
+                                       google::protobuf::Any* any) {
+    if (any == nullptr) {
+      return InvalidArgumentError("Given a nullptr to a google::protobuf::Any");
+    }
+    // Only the viewed pixels are packed, without padding.
+    RawImagePacketTypeDescriptor raw_image_packet_type_desc;
+    RawImageDescriptor* desc =
+        raw_image_packet_type_desc.mutable_raw_image_descriptor();
+    desc->set_height(view.height());
+    desc->set_width(view.width());
+    desc->set_format(view.format());
+    any->PackFrom(raw_image_packet_type_desc);
+    return OkStatus();
+  }
+};
+
+// Pack the viewed pixels into the Packet's payload. They are always copied.
+Status PackPayload(const RawImageView& view, Packet* p);
+
+// Unpack the Packet's payload into a view of a copy of it.
+Status UnpackPayload(const Packet& p, RawImageView* to);
+
+// Unpack the Packet's payload into a view that takes over it without copies.
+Status UnpackPayload(Packet&& p, RawImageView* to);
+
 }  // namespace aistreams
 
 #endif  // AISTREAMS_BASE_TYPES_PACKET_TYPES_RAW_IMAGE_PACKET_TYPE_H_
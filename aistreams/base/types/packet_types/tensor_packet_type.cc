@@ -0,0 +1,115 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/packet_types/tensor_packet_type.h"
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/base/types/tensor_helpers.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/tensor_packet_type_descriptor.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+// Validate the Packet against its TensorPacketTypeDescriptor. Return the
+// corresponding TensorDescriptor if all went well.
+StatusOr<TensorDescriptor> ValidateAndGetDescriptor(const Packet& p) {
+  TensorPacketTypeDescriptor tensor_packet_type_desc;
+  if (!p.header().type().type_descriptor().UnpackTo(
+          &tensor_packet_type_desc)) {
+    return InvalidArgumentError(
+        "Failed to Unpack the type decriptor as a TensorPacketTypeDescriptor");
+  }
+  TensorDescriptor tensor_descriptor =
+      tensor_packet_type_desc.tensor_descriptor();
+  Status s = Validate(tensor_descriptor);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return InvalidArgumentError("Given an invalid TensorDescriptor");
+  }
+
+  auto expected_payload_size_statusor = GetBufferSize(tensor_descriptor);
+  if (!expected_payload_size_statusor.ok()) {
+    return expected_payload_size_statusor.status();
+  }
+  auto expected_payload_size =
+      std::move(expected_payload_size_statusor).ValueOrDie();
+  // Strided tensors may carry bytes beyond the end of their last element.
+  bool size_ok =
+      IsDense(tensor_descriptor)
+          ? static_cast<int64_t>(p.payload().size()) == expected_payload_size
+          : static_cast<int64_t>(p.payload().size()) >= expected_payload_size;
+  if (!size_ok) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The given Packet's payload size is inconsistent with its "
+        "TensorDescriptor (%d vs %d)",
+        p.payload().size(), expected_payload_size));
+  }
+  return tensor_descriptor;
+}
+
+}  // namespace
+
+Status PackPayload(const Tensor& tensor, Packet* p) {
+  if (p == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  const uint8_t* begin = tensor.data() - tensor.descriptor().offset();
+  p->mutable_payload()->assign(begin, tensor.data() + tensor.size());
+  return OkStatus();
+}
+
+Status PackPayload(Tensor&& tensor, Packet* p) {
+  if (p == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  *p->mutable_payload() = std::move(tensor).ReleaseBuffer();
+  return OkStatus();
+}
+
+Status UnpackPayload(const Packet& p, Tensor* to) {
+  if (to == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Tensor");
+  }
+
+  auto tensor_desc_status_or = ValidateAndGetDescriptor(p);
+  if (!tensor_desc_status_or.ok()) {
+    return tensor_desc_status_or.status();
+  }
+  TensorDescriptor tensor_descriptor = tensor_desc_status_or.ValueOrDie();
+
+  *to = Tensor(tensor_descriptor, std::string(p.payload()));
+  return OkStatus();
+}
+
+Status UnpackPayload(Packet&& p, Tensor* to) {
+  if (to == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Tensor");
+  }
+
+  auto tensor_desc_status_or = ValidateAndGetDescriptor(p);
+  if (!tensor_desc_status_or.ok()) {
+    return tensor_desc_status_or.status();
+  }
+  TensorDescriptor tensor_descriptor = tensor_desc_status_or.ValueOrDie();
+
+  *to = Tensor(tensor_descriptor, std::move(*p.mutable_payload()));
+  return OkStatus();
+}
+
+}  // namespace aistreams
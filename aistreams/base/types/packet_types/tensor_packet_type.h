@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_PACKET_TYPES_TENSOR_PACKET_TYPE_H_
+#define AISTREAMS_BASE_TYPES_PACKET_TYPES_TENSOR_PACKET_TYPE_H_
+
+#include "aistreams/base/types/packet_types/packet_type_traits.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/tensor.pb.h"
+#include "aistreams/proto/types/tensor_packet_type_descriptor.pb.h"
+
+namespace aistreams {
+
+// Specialization to map Tensor to Packets of type PACKET_TYPE_TENSOR.
+template <>
+struct PacketTypeTraits<Tensor> {
+  using value_type = Tensor;
+  constexpr static PacketTypeId packet_type_id() { return PACKET_TYPE_TENSOR; }
+
+  constexpr static const char* packet_type_name() { return "Tensor"; }
+
+  static Status packet_type_descriptor(const Tensor& tensor,
+                                       google::protobuf::Any* any) {
+    if (any == nullptr) {
+      return InvalidArgumentError("Given a nullptr to a google::protobuf::Any");
+    }
+    TensorPacketTypeDescriptor tensor_packet_type_desc;
+    *tensor_packet_type_desc.mutable_tensor_descriptor() = tensor.descriptor();
+    any->PackFrom(tensor_packet_type_desc);
+    return OkStatus();
+  }
+};
+
+// The payload is the whole tensor buffer, including the bytes before the
+// aligned first element that the descriptor's offset skips.
+
+// Pack the Packet's payload with copy semantics.
+Status PackPayload(const Tensor& tensor, Packet* p);
+
+// Pack the Packet's payload with move semantics.
+Status PackPayload(Tensor&& tensor, Packet* p);
+
+// Unpack the Packet's payload with copy semantics.
+Status UnpackPayload(const Packet& p, Tensor* to);
+
+// Unpack the Packet's payload with move semantics.
+Status UnpackPayload(Packet&& p, Tensor* to);
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_PACKET_TYPES_TENSOR_PACKET_TYPE_H_
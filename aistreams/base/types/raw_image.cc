@@ -14,6 +14,8 @@
 
 #include "aistreams/base/types/raw_image.h"
 
+#include <cstring>
+
 #include "absl/strings/str_format.h"
 #include "aistreams/base/types/raw_image_helpers.h"
 #include "aistreams/port/logging.h"
@@ -21,34 +23,48 @@
 
 namespace aistreams {
 
-RawImage::RawImage() : RawImage(0, 0, RAW_IMAGE_FORMAT_SRGB) {}
-
-RawImage::RawImage(const RawImageDescriptor &desc)
-    : RawImage(desc.height(), desc.width(), desc.format()) {}
+namespace {
 
-RawImage::RawImage(int height, int width, RawImageFormat format) {
+RawImageDescriptor MakeDescriptor(int height, int width,
+                                  RawImageFormat format) {
   RawImageDescriptor desc;
   desc.set_height(height);
   desc.set_width(width);
   desc.set_format(format);
+  return desc;
+}
+
+}  // namespace
+
+RawImage::RawImage() : RawImage(0, 0, RAW_IMAGE_FORMAT_SRGB) {}
+
+RawImage::RawImage(int height, int width, RawImageFormat format)
+    : RawImage(MakeDescriptor(height, width, format)) {}
+
+RawImage::RawImage(const RawImageDescriptor &desc) {
   auto status = Validate(desc);
   if (!status.ok()) {
     LOG(FATAL) << status;
   }
-
-  height_ = desc.height();
-  width_ = desc.width();
-  raw_image_format_ = desc.format();
-  channels_ = GetNumChannels(desc.format());
+  SetLayout(desc);
 
   auto image_buf_size_statusor = GetBufferSize(desc);
   if (!image_buf_size_statusor.ok()) {
     LOG(FATAL) << image_buf_size_statusor.status();
   }
-  data_.resize(image_buf_size_statusor.ValueOrDie());
+  // The buffer is not realigned, so that it is released as is.
+  data_ = FrameBuffer(image_buf_size_statusor.ValueOrDie(), 1);
 }
 
 RawImage::RawImage(const RawImageDescriptor &desc, std::string &&bytes) {
+  Adopt(desc, FrameBuffer(std::move(bytes)));
+}
+
+RawImage::RawImage(const RawImageDescriptor &desc, FrameBuffer &&buffer) {
+  Adopt(desc, std::move(buffer));
+}
+
+void RawImage::Adopt(const RawImageDescriptor &desc, FrameBuffer &&buffer) {
   auto status = Validate(desc);
   if (!status.ok()) {
     LOG(FATAL) << status;
@@ -58,17 +74,103 @@ RawImage::RawImage(const RawImageDescriptor &desc, std::string &&bytes) {
     LOG(FATAL) << expected_bufsize_statusor.status();
   }
   auto expected_bufsize = std::move(expected_bufsize_statusor).ValueOrDie();
-  if (static_cast<size_t>(expected_bufsize) != bytes.size()) {
+  bool size_ok = desc.planes_size() == 0
+                     ? static_cast<size_t>(expected_bufsize) == buffer.size()
+                     : static_cast<size_t>(expected_bufsize) <= buffer.size();
+  if (!size_ok) {
     LOG(FATAL) << absl::StrFormat(
         "Attempted to move construct a RawImage expecting %d bytes with a "
         "string containing %d bytes",
-        expected_bufsize, bytes.size());
+        expected_bufsize, buffer.size());
   }
+  SetLayout(desc);
+  data_ = std::move(buffer);
+}
+
+void RawImage::SetLayout(const RawImageDescriptor &desc) {
   height_ = desc.height();
   width_ = desc.width();
   raw_image_format_ = desc.format();
   channels_ = GetNumChannels(desc.format());
-  data_ = std::move(bytes);
+
+  int num_planes = GetNumPlanes(desc.format());
+  planes_.resize(num_planes);
+  size_t packed_offset = 0;
+  for (int i = 0; i < num_planes; ++i) {
+    if (desc.planes_size() == 0) {
+      planes_[i].offset = packed_offset;
+      planes_[i].stride = static_cast<int>(GetPlaneRowSize(desc, i));
+      packed_offset += static_cast<size_t>(planes_[i].stride) *
+                       GetPlaneHeight(desc, i);
+    } else {
+      planes_[i].offset = static_cast<size_t>(desc.planes(i).offset());
+      planes_[i].stride = desc.planes(i).stride();
+    }
+  }
+}
+
+bool RawImage::is_packed() const {
+  RawImageDescriptor desc = MakeDescriptor(height_, width_, raw_image_format_);
+  size_t packed_offset = 0;
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    if (planes_[i].offset != packed_offset ||
+        planes_[i].stride != GetPlaneRowSize(desc, i)) {
+      return false;
+    }
+    packed_offset +=
+        static_cast<size_t>(planes_[i].stride) * GetPlaneHeight(desc, i);
+  }
+  return true;
+}
+
+RawImageDescriptor RawImage::descriptor() const {
+  RawImageDescriptor desc = MakeDescriptor(height_, width_, raw_image_format_);
+  if (!is_packed() || data_.offset() != 0) {
+    for (const auto &plane : planes_) {
+      RawImagePlane *p = desc.add_planes();
+      p->set_offset(data_.offset() + plane.offset);
+      p->set_stride(plane.stride);
+    }
+  }
+  return desc;
+}
+
+void RawImage::Pack() {
+  if (is_packed()) {
+    return;
+  }
+  RawImageDescriptor desc = MakeDescriptor(height_, width_, raw_image_format_);
+  std::vector<Plane> padded_planes = planes_;
+  SetLayout(desc);
+
+  // A packed row never starts after its padded counterpart when the planes
+  // are in buffer order, so the rows can be moved front to back in place.
+  // Otherwise, pack into a new buffer.
+  bool in_order = true;
+  for (size_t i = 1; i < padded_planes.size(); ++i) {
+    in_order &= padded_planes[i - 1].offset < padded_planes[i].offset;
+  }
+  FrameBuffer packed;
+  uint8_t *dst = data_.data();
+  if (!in_order) {
+    packed = FrameBuffer(GetBufferSize(desc).ValueOrDie(), 1);
+    dst = packed.data();
+  }
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    size_t row_size = planes_[i].stride;
+    int plane_height = GetPlaneHeight(desc, i);
+    for (int y = 0; y < plane_height; ++y) {
+      std::memmove(dst + planes_[i].offset + row_size * y,
+                   data_.data() + padded_planes[i].offset +
+                       static_cast<size_t>(padded_planes[i].stride) * y,
+                   row_size);
+    }
+  }
+  if (in_order) {
+    data_.Truncate(GetBufferSize(desc).ValueOrDie());
+  } else {
+    data_ = std::move(packed);
+  }
 }
 
 }  // namespace aistreams
@@ -17,25 +17,64 @@
 #ifndef AISTREAMS_BASE_TYPES_RAW_IMAGE_H_
 #define AISTREAMS_BASE_TYPES_RAW_IMAGE_H_
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
+#include "aistreams/base/types/frame_buffer.h"
 #include "aistreams/port/status.h"
 #include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
+// A RawImage holds the pixels of an image in a single buffer.
+//
+// Each plane of the image is a sequence of rows. By default, the rows are
+// tightly packed and the planes follow one another, so the value of channel c
+// of pixel (y, x) in an interleaved format is at (y*width + x)*channels + c.
+//
+// Rows may also be padded or planes spaced apart, as is common for buffers
+// produced by hardware or by Gstreamer. In that case, the value is at
+// planes()[0].offset + y*planes()[0].stride + x*channels + c. Use row() to
+// avoid the arithmetic, or Pack() if you need the packed layout.
+//
+// Interleaved formats (e.g. SRGB, RGBA, GRAY8) have a single plane. Planar YUV
+// formats have a full resolution luma plane followed by subsampled chroma
+// planes; see GetPlaneHeight and GetPlaneRowSize for their dimensions.
+//
+// The buffer is a FrameBuffer. Those of images allocated by RawImage are not
+// cleared, and all are recycled once the image is destroyed.
 class RawImage {
  public:
-  // Constructs a raw image of the specified height, width, and format.
+  // The placement of one plane within the image buffer.
+  struct Plane {
+    // The byte offset of the first row of the plane.
+    size_t offset = 0;
+
+    // The number of bytes between the starts of consecutive rows.
+    int stride = 0;
+  };
+
+  // Constructs a raw image of the specified height, width, and format. The
+  // values are unspecified.
   RawImage(int height, int width, RawImageFormat format);
 
-  // Constructs a raw image from a RawImageDescriptor.
+  // Constructs a raw image from a RawImageDescriptor. The values are
+  // unspecified.
   explicit RawImage(const RawImageDescriptor&);
 
   // Constructs a raw image from a RawImageDescriptor and is
   // move initialized to the given bytes.
+  //
+  // If the descriptor has explicit planes, then the bytes are adopted as is
+  // with that layout and may be longer than GetBufferSize; otherwise, they
+  // must be exactly the packed size.
   RawImage(const RawImageDescriptor&, std::string&& bytes);
 
+  // Constructs a raw image from a RawImageDescriptor that adopts the given
+  // buffer, as above. The planes are relative to buffer.data().
+  RawImage(const RawImageDescriptor&, FrameBuffer&& buffer);
+
   // Constructs a zero height, zero width, SRGB image.
   RawImage();
 
@@ -45,18 +84,47 @@ class RawImage {
   // Returns the width of the image.
   int width() const { return width_; }
 
-  // Returns the number of channels of the image.
+  // Returns the number of channels (color components) of the image.
   int channels() const { return channels_; }
 
   // Returns the image format.
   RawImageFormat format() const { return raw_image_format_; }
 
+  // Returns the placement of each plane in the image buffer.
+  const std::vector<Plane>& planes() const { return planes_; }
+
+  // Returns the number of bytes between the starts of consecutive rows of the
+  // first plane.
+  int row_stride() const { return planes_[0].stride; }
+
+  // Returns true if the rows of each plane are tightly packed and the planes
+  // follow one another.
+  bool is_packed() const;
+
+  // Returns a pointer to the first value of row y of the given plane.
+  const uint8_t* row(int y, int plane = 0) const {
+    return data() + planes_[plane].offset +
+           static_cast<size_t>(planes_[plane].stride) * y;
+  }
+
+  uint8_t* row(int y, int plane = 0) {
+    return const_cast<uint8_t*>(
+        static_cast<const RawImage&>(*this).row(y, plane));
+  }
+
+  // Returns a descriptor for this image. It has explicit planes only if the
+  // image is not packed or its buffer starts with bytes that precede the
+  // image (see ReleaseBuffer).
+  RawImageDescriptor descriptor() const;
+
+  // Removes any row padding and gaps between planes so that the image is
+  // packed. The rows are moved in place; this is a no-op on packed images.
+  void Pack();
+
   // Returns a reference to the i'th value of the image buffer.
   //
   // You must ensure i is in the range [0, size()).
-  const uint8_t& operator()(size_t i) const {
-    return reinterpret_cast<const uint8_t&>(data_[i]);
-  }
+  const uint8_t& operator()(size_t i) const { return data()[i]; }
 
   uint8_t& operator()(size_t i) {
     return const_cast<uint8_t&>(static_cast<const RawImage&>(*this)(i));
@@ -70,22 +138,34 @@ class RawImage {
     return const_cast<uint8_t*>(static_cast<const RawImage&>(*this).data());
   }
 
-  const uint8_t* data() const {
-    return reinterpret_cast<const uint8_t*>(data_.data());
-  }
+  const uint8_t* data() const { return data_.data(); }
 
-  // Returns the total size of the image.
+  // Returns the total size of the image buffer, including any padding.
   size_t size() const { return data_.size(); }
 
+  // Returns the number of bytes that precede data() in the released buffer.
+  size_t buffer_offset() const { return data_.offset(); }
+
   // Returns the released image buffer for the caller to acquire.
-  std::string&& ReleaseBuffer() && { return std::move(data_); }
+  //
+  // The buffer starts with buffer_offset() bytes that precede the image, if
+  // it was adopted as a FrameBuffer with an offset. The planes of descriptor()
+  // account for them, so get the descriptor before releasing the buffer.
+  std::string ReleaseBuffer() && { return std::move(data_).Release(); }
+
+  // Returns the released image buffer for the caller to acquire, as is.
+  FrameBuffer ReleaseFrameBuffer() && { return std::move(data_); }
 
  private:
   int height_;
   int width_;
   int channels_;
   RawImageFormat raw_image_format_;
-  std::string data_;
+  std::vector<Plane> planes_;
+  FrameBuffer data_;
+
+  void SetLayout(const RawImageDescriptor&);
+  void Adopt(const RawImageDescriptor&, FrameBuffer&&);
 };
 
 }  // namespace aistreams
@@ -14,6 +14,9 @@
 
 #include "aistreams/base/types/raw_image_helpers.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "absl/strings/str_format.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
@@ -23,7 +26,14 @@ namespace aistreams {
 int GetNumChannels(const RawImageFormat& format) {
   switch (format) {
     case RAW_IMAGE_FORMAT_SRGB:
+    case RAW_IMAGE_FORMAT_BGR:
+    case RAW_IMAGE_FORMAT_NV12:
+    case RAW_IMAGE_FORMAT_I420:
       return 3;
+    case RAW_IMAGE_FORMAT_RGBA:
+      return 4;
+    case RAW_IMAGE_FORMAT_GRAY8:
+      return 1;
     case RAW_IMAGE_FORMAT_UNKNOWN:
       LOG(WARNING) << "Received a raw image with an UNKNOWN format";
       return 1;
@@ -34,6 +44,41 @@ int GetNumChannels(const RawImageFormat& format) {
   }
 }
 
+int GetNumPlanes(const RawImageFormat& format) {
+  switch (format) {
+    case RAW_IMAGE_FORMAT_NV12:
+      return 2;
+    case RAW_IMAGE_FORMAT_I420:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+int GetPlaneHeight(const RawImageDescriptor& desc, int plane) {
+  switch (desc.format()) {
+    case RAW_IMAGE_FORMAT_NV12:
+    case RAW_IMAGE_FORMAT_I420:
+      // Chroma planes are subsampled vertically, rounding up.
+      return plane == 0 ? desc.height() : (desc.height() + 1) / 2;
+    default:
+      return desc.height();
+  }
+}
+
+int64_t GetPlaneRowSize(const RawImageDescriptor& desc, int plane) {
+  int64_t width = desc.width();
+  switch (desc.format()) {
+    case RAW_IMAGE_FORMAT_NV12:
+      // The chroma plane holds a U, V pair for every two luma samples.
+      return plane == 0 ? width : 2 * ((width + 1) / 2);
+    case RAW_IMAGE_FORMAT_I420:
+      return plane == 0 ? width : (width + 1) / 2;
+    default:
+      return width * GetNumChannels(desc.format());
+  }
+}
+
 Status Validate(const RawImageDescriptor& desc) {
   if (desc.height() < 0) {
     return InvalidArgumentError(
@@ -43,6 +88,30 @@ Status Validate(const RawImageDescriptor& desc) {
     return InvalidArgumentError(
         "Given a raw image descriptor of negative width");
   }
+  if (desc.planes_size() == 0) {
+    return OkStatus();
+  }
+  int num_planes = GetNumPlanes(desc.format());
+  if (desc.planes_size() != num_planes) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a raw image descriptor with %d planes for a format with %d",
+        desc.planes_size(), num_planes));
+  }
+  for (int i = 0; i < num_planes; ++i) {
+    const RawImagePlane& plane = desc.planes(i);
+    if (plane.offset() < 0) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given a raw image descriptor with a negative offset for plane %d",
+          i));
+    }
+    int64_t row_size = GetPlaneRowSize(desc, i);
+    if (plane.stride() < row_size) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given a raw image descriptor whose plane %d has a stride (%d) "
+          "smaller than its row size (%d)",
+          i, plane.stride(), row_size));
+    }
+  }
   return OkStatus();
 }
 
@@ -57,26 +126,64 @@ StatusOr<int> GetBufferSize(const RawImageDescriptor& desc) {
         height, width, channels));
   }
 
-  int pixels = 0;
-  auto overflow = __builtin_mul_overflow(height, width, &pixels);
-  if (overflow) {
+  int num_planes = GetNumPlanes(desc.format());
+  if (desc.planes_size() != 0 && desc.planes_size() != num_planes) {
     return InvalidArgumentError(absl::StrFormat(
-        "Multiplication overflow when multiplying height (%d) and width (%d). "
-        "Please contact us if you really need an image this large.",
-        height, width));
+        "The given raw image descriptor has %d planes for a format with %d",
+        desc.planes_size(), num_planes));
   }
 
-  int buf_size = 0;
-  overflow = __builtin_mul_overflow(pixels, channels, &buf_size);
-  if (overflow) {
-    return InvalidArgumentError(
-        absl::StrFormat("Multiplication overflow when multiply number of "
-                        "pixels (%d) and the number of channels (%d), Please "
-                        "contact us if you really need an image this large.",
-                        pixels, channels));
+  int64_t buf_size = 0;
+  for (int i = 0; i < num_planes; ++i) {
+    int64_t plane_height = GetPlaneHeight(desc, i);
+    int64_t row_size = GetPlaneRowSize(desc, i);
+    int64_t plane_end = 0;
+    bool overflow = false;
+    if (desc.planes_size() == 0) {
+      // Packed planes follow one another.
+      overflow = __builtin_mul_overflow(plane_height, row_size, &plane_end) ||
+                 __builtin_add_overflow(buf_size, plane_end, &plane_end);
+    } else {
+      // Explicit planes only need to reach the end of their last row.
+      const RawImagePlane& plane = desc.planes(i);
+      plane_end = plane.offset();
+      if (plane_height > 0) {
+        int64_t rows_before_last = 0;
+        overflow = __builtin_mul_overflow(plane_height - 1,
+                                          static_cast<int64_t>(plane.stride()),
+                                          &rows_before_last) ||
+                   __builtin_add_overflow(plane_end, rows_before_last,
+                                          &plane_end) ||
+                   __builtin_add_overflow(plane_end, row_size, &plane_end);
+      }
+    }
+    if (overflow || plane_end > std::numeric_limits<int>::max()) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Overflow when computing the buffer size of an image with height "
+          "(%d), width (%d) and channels (%d). Please contact us if you "
+          "really need an image this large.",
+          height, width, channels));
+    }
+    buf_size = std::max(buf_size, plane_end);
   }
 
-  return buf_size;
+  return static_cast<int>(buf_size);
+}
+
+bool IsPacked(const RawImageDescriptor& desc) {
+  if (desc.planes_size() == 0) {
+    return true;
+  }
+  int64_t packed_offset = 0;
+  for (int i = 0; i < desc.planes_size(); ++i) {
+    int64_t row_size = GetPlaneRowSize(desc, i);
+    if (desc.planes(i).offset() != packed_offset ||
+        desc.planes(i).stride() != row_size) {
+      return false;
+    }
+    packed_offset += row_size * GetPlaneHeight(desc, i);
+  }
+  return true;
 }
 
 }  // namespace aistreams
@@ -17,18 +17,38 @@
 #ifndef AISTREAMS_BASE_TYPES_RAW_IMAGE_HELPERS_H_
 #define AISTREAMS_BASE_TYPES_RAW_IMAGE_HELPERS_H_
 
+#include <cstdint>
+
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
 #include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
-// Get the number of channels for the given image format.
+// Get the number of channels (color components) for the given image format.
 int GetNumChannels(const RawImageFormat& format);
 
+// Get the number of planes for the given image format.
+int GetNumPlanes(const RawImageFormat& format);
+
+// Get the number of rows in the given plane of the described image.
+int GetPlaneHeight(const RawImageDescriptor& desc, int plane);
+
+// Get the number of bytes in one row of the given plane of the described
+// image, excluding any padding.
+int64_t GetPlaneRowSize(const RawImageDescriptor& desc, int plane);
+
 // Get the expected buffer size specified by the given descriptor.
+//
+// For a descriptor with explicit planes, this is the smallest buffer that
+// holds the last row of every plane; padding after the last row of a plane
+// is not required.
 StatusOr<int> GetBufferSize(const RawImageDescriptor& desc);
 
+// Returns true if the given descriptor has no explicit planes, or if its
+// planes place the rows exactly as they would be when tightly packed.
+bool IsPacked(const RawImageDescriptor& desc);
+
 // Validate the given descriptor.
 Status Validate(const RawImageDescriptor& desc);
 
@@ -29,6 +29,45 @@ namespace aistreams {
 TEST(RawImageHelpersTest, GetNumChannelsTest) {
   EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_UNKNOWN), 1);
   EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_SRGB), 3);
+  EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_RGBA), 4);
+  EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_BGR), 3);
+  EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_GRAY8), 1);
+  EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_NV12), 3);
+  EXPECT_EQ(GetNumChannels(RAW_IMAGE_FORMAT_I420), 3);
+}
+
+TEST(RawImageHelpersTest, PlaneGeometryTest) {
+  RawImageDescriptor desc;
+  desc.set_height(5);
+  desc.set_width(7);
+
+  desc.set_format(RAW_IMAGE_FORMAT_GRAY8);
+  EXPECT_EQ(GetNumPlanes(desc.format()), 1);
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 35);
+
+  desc.set_format(RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(GetNumPlanes(desc.format()), 2);
+  EXPECT_EQ(GetPlaneHeight(desc, 1), 3);
+  EXPECT_EQ(GetPlaneRowSize(desc, 1), 8);
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 35 + 24);
+
+  desc.set_format(RAW_IMAGE_FORMAT_I420);
+  EXPECT_EQ(GetNumPlanes(desc.format()), 3);
+  EXPECT_EQ(GetPlaneHeight(desc, 2), 3);
+  EXPECT_EQ(GetPlaneRowSize(desc, 2), 4);
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 35 + 12 + 12);
+
+  // Luma rows padded to 8 bytes, with the chroma planes after them.
+  desc.add_planes()->set_stride(8);
+  RawImagePlane* u = desc.add_planes();
+  u->set_offset(40);
+  u->set_stride(4);
+  RawImagePlane* v = desc.add_planes();
+  v->set_offset(52);
+  v->set_stride(4);
+  EXPECT_TRUE(Validate(desc).ok());
+  EXPECT_FALSE(IsPacked(desc));
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 64);
 }
 
 TEST(RawImageHelpersTest, GetBufferSizeTest) {
@@ -82,6 +121,48 @@ TEST(RawImageHelpersTest, GetBufferSizeTest) {
   }
 }
 
+TEST(RawImageHelpersTest, GetPaddedBufferSizeTest) {
+  {
+    RawImageDescriptor desc;
+    desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+    desc.set_height(3);
+    desc.set_width(5);
+    RawImagePlane* plane = desc.add_planes();
+    plane->set_offset(8);
+    plane->set_stride(16);
+    auto bufsize = GetBufferSize(desc);
+    EXPECT_TRUE(bufsize.ok());
+    // The last row need not be padded.
+    EXPECT_EQ(bufsize.ValueOrDie(), 8 + 16 * 2 + 15);
+    EXPECT_FALSE(IsPacked(desc));
+  }
+  {
+    RawImageDescriptor desc;
+    desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+    desc.set_height(3);
+    desc.set_width(5);
+    RawImagePlane* plane = desc.add_planes();
+    plane->set_offset(0);
+    plane->set_stride(15);
+    auto bufsize = GetBufferSize(desc);
+    EXPECT_TRUE(bufsize.ok());
+    EXPECT_EQ(bufsize.ValueOrDie(), 45);
+    EXPECT_TRUE(IsPacked(desc));
+  }
+  {
+    RawImageDescriptor desc;
+    desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+    desc.set_height((1 << 15) + 1);
+    desc.set_width(1 << 10);
+    RawImagePlane* plane = desc.add_planes();
+    plane->set_offset(0);
+    plane->set_stride(1 << 16);
+    auto bufsize = GetBufferSize(desc);
+    EXPECT_FALSE(bufsize.ok());
+    LOG(ERROR) << bufsize.status();
+  }
+}
+
 TEST(RawImageHelpersTest, ValidateTest) {
   {
     int height = 1080;
@@ -122,6 +203,21 @@ TEST(RawImageHelpersTest, ValidateTest) {
     desc.set_width(width);
     auto status = Validate(desc);
     EXPECT_TRUE(status.ok());
+  }  {
+    RawImageDescriptor desc;
+    desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+    desc.set_height(2);
+    desc.set_width(5);
+    desc.add_planes()->set_stride(16);
+    EXPECT_TRUE(Validate(desc).ok());
+    desc.mutable_planes(0)->set_stride(14);
+    EXPECT_FALSE(Validate(desc).ok());
+    desc.mutable_planes(0)->set_stride(16);
+    desc.mutable_planes(0)->set_offset(-1);
+    EXPECT_FALSE(Validate(desc).ok());
+    desc.mutable_planes(0)->set_offset(0);
+    desc.add_planes()->set_stride(16);
+    EXPECT_FALSE(Validate(desc).ok());
   }
 }
 
@@ -255,6 +351,77 @@ TEST(RawImageTest, StringMoveConstructorTest) {
   }
 }
 
+TEST(RawImageTest, PaddedLayoutTest) {
+  // A 2x3 image whose 9 byte rows are padded to 12 and start after 4 bytes.
+  RawImageDescriptor desc;
+  desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+  desc.set_height(2);
+  desc.set_width(3);
+  RawImagePlane* plane = desc.add_planes();
+  plane->set_offset(4);
+  plane->set_stride(12);
+  std::string bytes(4 + 12 * 2, 0);
+  for (int y = 0; y < 2; ++y) {
+    for (int i = 0; i < 9; ++i) {
+      bytes[4 + 12 * y + i] = 10 * y + i;
+    }
+  }
+
+  RawImage r(desc, std::move(bytes));
+  EXPECT_FALSE(r.is_packed());
+  EXPECT_EQ(r.row_stride(), 12);
+  EXPECT_EQ(r.planes()[0].offset, 4);
+  EXPECT_EQ(r.size(), 28);
+  EXPECT_EQ(r.row(1) - r.data(), 16);
+  EXPECT_EQ(r.row(1)[2], 12);
+  EXPECT_EQ(r.descriptor().planes_size(), 1);
+  EXPECT_EQ(r.descriptor().planes(0).stride(), 12);
+
+  r.Pack();
+  EXPECT_TRUE(r.is_packed());
+  EXPECT_EQ(r.row_stride(), 9);
+  EXPECT_EQ(r.size(), 18);
+  EXPECT_EQ(r.descriptor().planes_size(), 0);
+  for (int y = 0; y < 2; ++y) {
+    for (int i = 0; i < 9; ++i) {
+      EXPECT_EQ(r(9 * y + i), 10 * y + i);
+    }
+  }
+}
+
+TEST(RawImageTest, PlanarPackTest) {
+  // An NV12 image with padded rows and a gap before the chroma plane.
+  RawImageDescriptor desc;
+  desc.set_format(RAW_IMAGE_FORMAT_NV12);
+  desc.set_height(2);
+  desc.set_width(2);
+  desc.add_planes()->set_stride(4);
+  RawImagePlane* uv = desc.add_planes();
+  uv->set_offset(12);
+  uv->set_stride(4);
+  std::string bytes = {1, 2, 0, 0, 3, 4, 0, 0, 0, 0, 0, 0, 5, 6};
+  RawImage r(desc, std::move(bytes));
+  EXPECT_EQ(r.row(1, 0)[1], 4);
+  EXPECT_EQ(r.row(0, 1)[0], 5);
+
+  r.Pack();
+  EXPECT_TRUE(r.is_packed());
+  ASSERT_EQ(r.size(), 6);
+  for (size_t i = 0; i < r.size(); ++i) {
+    EXPECT_EQ(r(i), i + 1);
+  }
+}
+
+TEST(RawImageTest, PaddedLayoutTooShortTest) {
+  RawImageDescriptor desc;
+  desc.set_format(RAW_IMAGE_FORMAT_SRGB);
+  desc.set_height(2);
+  desc.set_width(3);
+  desc.add_planes()->set_stride(12);
+  std::string bytes(20, 0);
+  ASSERT_DEATH({ RawImage r(desc, std::move(bytes)); }, "");
+}
+
 TEST(RawImageTest, ReleaseBufferTest) {
   {
     int height = 2;
@@ -0,0 +1,172 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/raw_image_view.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/types/raw_image_helpers.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace {
+
+RawImageDescriptor MakeDescriptor(int height, int width,
+                                  RawImageFormat format) {
+  RawImageDescriptor desc;
+  desc.set_height(height);
+  desc.set_width(width);
+  desc.set_format(format);
+  return desc;
+}
+
+bool IsYuv(RawImageFormat format) {
+  return format == RAW_IMAGE_FORMAT_NV12 || format == RAW_IMAGE_FORMAT_I420;
+}
+
+// Returns the byte offset of pixel (y, x) of an image of the given format
+// within the given plane, relative to the start of the plane.
+size_t GetPlanePixelOffset(RawImageFormat format, int channels, int stride,
+                           int plane, int y, int x) {
+  if (!IsYuv(format)) {
+    return static_cast<size_t>(stride) * y + static_cast<size_t>(x) * channels;
+  }
+  if (plane == 0) {
+    return static_cast<size_t>(stride) * y + x;
+  }
+  // NV12 interleaves both chroma components in its second plane.
+  int chroma_values = format == RAW_IMAGE_FORMAT_NV12 ? 2 : 1;
+  return static_cast<size_t>(stride) * (y / 2) +
+         static_cast<size_t>(x / 2) * chroma_values;
+}
+
+}  // namespace
+
+constexpr int RawImageView::kMaxPlanes;
+
+RawImageView::RawImageView()
+    : height_(0),
+      width_(0),
+      channels_(GetNumChannels(RAW_IMAGE_FORMAT_SRGB)),
+      format_(RAW_IMAGE_FORMAT_SRGB),
+      num_planes_(1),
+      planes_(),
+      data_(nullptr),
+      size_(0) {}
+
+RawImageView::RawImageView(const RawImage& image) {
+  SetGeometry(image);
+  data_ = image.data();
+  size_ = image.size();
+}
+
+RawImageView::RawImageView(RawImage&& image) {
+  SetGeometry(image);
+  buffer_ = std::make_shared<const FrameBuffer>(
+      std::move(image).ReleaseFrameBuffer());
+  data_ = buffer_->data();
+  size_ = buffer_->size();
+}
+
+void RawImageView::SetGeometry(const RawImage& image) {
+  height_ = image.height();
+  width_ = image.width();
+  channels_ = image.channels();
+  format_ = image.format();
+  num_planes_ = static_cast<int>(image.planes().size());
+  CHECK(num_planes_ <= kMaxPlanes);
+  std::copy(image.planes().begin(), image.planes().end(), planes_.begin());
+}
+
+RawImageDescriptor RawImageView::descriptor() const {
+  RawImageDescriptor desc = MakeDescriptor(height_, width_, format_);
+  for (const auto& plane : planes()) {
+    RawImagePlane* p = desc.add_planes();
+    p->set_offset(plane.offset);
+    p->set_stride(plane.stride);
+  }
+  return desc;
+}
+
+StatusOr<RawImageView> RawImageView::Crop(int y, int x, int height,
+                                          int width) const {
+  if (y < 0 || x < 0 || height < 0 || width < 0 ||
+      static_cast<int64_t>(y) + height > height_ ||
+      static_cast<int64_t>(x) + width > width_) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The region (y=%d, x=%d, height=%d, width=%d) is not inside the %dx%d "
+        "image",
+        y, x, height, width, height_, width_));
+  }
+  if (IsYuv(format_) && (y % 2 != 0 || x % 2 != 0)) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The region of a subsampled image must start at an even row and "
+        "column; got (y=%d, x=%d)",
+        y, x));
+  }
+
+  // Point the planes at the region, keeping the strides of the full image.
+  RawImageView view = *this;
+  view.height_ = height;
+  view.width_ = width;
+  for (int p = 0; p < num_planes_; ++p) {
+    view.planes_[p].offset += GetPlanePixelOffset(
+        format_, channels_, planes_[p].stride, p, y, x);
+  }
+  return view;
+}
+
+StatusOr<std::vector<RawImageView>> RawImageView::Tile(int tile_height,
+                                                       int tile_width) const {
+  if (tile_height <= 0 || tile_width <= 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The tile size must be positive; got %dx%d", tile_height, tile_width));
+  }
+  if (IsYuv(format_) && (tile_height % 2 != 0 || tile_width % 2 != 0)) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The tiles of a subsampled image must have an even size; got %dx%d",
+        tile_height, tile_width));
+  }
+  std::vector<RawImageView> tiles;
+  for (int y = 0; y < height_; y += tile_height) {
+    for (int x = 0; x < width_; x += tile_width) {
+      AIS_ASSIGN_OR_RETURN(
+          RawImageView tile,
+          Crop(y, x, std::min(tile_height, height_ - y),
+               std::min(tile_width, width_ - x)));
+      tiles.push_back(std::move(tile));
+    }
+  }
+  return tiles;
+}
+
+RawImage RawImageView::ToRawImage() const {
+  RawImage image(height_, width_, format_);
+  RawImageDescriptor desc = MakeDescriptor(height_, width_, format_);
+  for (int p = 0; p < num_planes_; ++p) {
+    size_t row_size = static_cast<size_t>(GetPlaneRowSize(desc, p));
+    for (int y = 0; y < GetPlaneHeight(desc, p); ++y) {
+      std::memcpy(image.row(y, p), row(y, p), row_size);
+    }
+  }
+  return image;
+}
+
+}  // namespace aistreams
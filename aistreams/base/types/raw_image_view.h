@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_RAW_IMAGE_VIEW_H_
+#define AISTREAMS_BASE_TYPES_RAW_IMAGE_VIEW_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "aistreams/base/types/frame_buffer.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace aistreams {
+
+// A RawImageView is a read-only view of a region of an image buffer.
+//
+// It has the same geometry accessors as a RawImage, but it does not own its
+// pixels: it either refers to a RawImage that must outlive it, or shares a
+// reference counted buffer with other views, e.g. one taken from a RawImage
+// or a received Packet. Copies and crops share the buffer and never copy
+// pixels, so the same frame can be handed to several consumers or cut into
+// regions of interest for free.
+//
+// As with RawImage, the value of channel c of pixel (y, x) of the first plane
+// is at row(y)[x*channels() + c]; row() accounts for the origin and stride of
+// the view.
+class RawImageView {
+ public:
+  using Plane = RawImage::Plane;
+
+  // The largest number of planes of any format.
+  static constexpr int kMaxPlanes = 3;
+
+  // Constructs a view of a zero height, zero width, SRGB image.
+  RawImageView();
+
+  // Constructs a view of all of `image`, which must outlive the view.
+  //
+  // This is implicit so that functions taking a view also accept a RawImage.
+  RawImageView(const RawImage& image);  // NOLINT
+
+  // Constructs a view of all of `image` that takes over its buffer. The
+  // buffer is freed once the last view sharing it is destroyed.
+  explicit RawImageView(RawImage&& image);
+
+  // Returns the height of the view.
+  int height() const { return height_; }
+
+  // Returns the width of the view.
+  int width() const { return width_; }
+
+  // Returns the number of channels (color components) of the image.
+  int channels() const { return channels_; }
+
+  // Returns the image format.
+  RawImageFormat format() const { return format_; }
+
+  // Returns the placement of each plane of the view in the buffer.
+  absl::Span<const Plane> planes() const {
+    return absl::MakeConstSpan(planes_.data(), num_planes_);
+  }
+
+  // Returns the number of bytes between the starts of consecutive rows of the
+  // first plane.
+  int row_stride() const { return planes_[0].stride; }
+
+  // Returns a pointer to the first value of row y of the given plane.
+  const uint8_t* row(int y, int plane = 0) const {
+    return data_ + planes_[plane].offset +
+           static_cast<size_t>(planes_[plane].stride) * y;
+  }
+
+  // Returns a pointer to the start of the viewed buffer. It is not the first
+  // value of the view unless planes()[0].offset is zero.
+  const uint8_t* data() const { return data_; }
+
+  // Returns the size of the viewed buffer.
+  size_t size() const { return size_; }
+
+  // Returns true if the view shares ownership of its buffer.
+  bool owns_buffer() const { return buffer_ != nullptr; }
+
+  // Returns a descriptor of the view relative to data(). It always has
+  // explicit planes.
+  RawImageDescriptor descriptor() const;
+
+  // Returns a view of the region whose top left corner is at row `y` and
+  // column `x` of this view. It shares the buffer of this view.
+  //
+  // For NV12 and I420, `y` and `x` must be even.
+  StatusOr<RawImageView> Crop(int y, int x, int height, int width) const;
+
+  // Returns views of tiles of at most `tile_height` by `tile_width` pixels
+  // that cover this view, in row-major order. Tiles on the bottom and right
+  // edges are smaller if the view does not divide evenly.
+  //
+  // For NV12 and I420, `tile_height` and `tile_width` must be even.
+  StatusOr<std::vector<RawImageView>> Tile(int tile_height,
+                                           int tile_width) const;
+
+  // Copies the viewed pixels into a new, packed RawImage.
+  RawImage ToRawImage() const;
+
+ private:
+  int height_;
+  int width_;
+  int channels_;
+  RawImageFormat format_;
+  int num_planes_;
+  std::array<Plane, kMaxPlanes> planes_;
+  const uint8_t* data_;
+  size_t size_;
+  std::shared_ptr<const FrameBuffer> buffer_;
+
+  void SetGeometry(const RawImage& image);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_RAW_IMAGE_VIEW_H_
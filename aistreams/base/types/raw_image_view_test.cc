@@ -0,0 +1,164 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/raw_image_view.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+namespace {
+
+// Returns an image whose every value is the index of the value in its plane.
+RawImage MakeImage(int height, int width, RawImageFormat format) {
+  RawImage image(height, width, format);
+  for (size_t p = 0; p < image.planes().size(); ++p) {
+    size_t plane_end = p + 1 < image.planes().size()
+                           ? image.planes()[p + 1].offset
+                           : image.size();
+    for (size_t i = image.planes()[p].offset; i < plane_end; ++i) {
+      image.data()[i] = static_cast<uint8_t>(i - image.planes()[p].offset);
+    }
+  }
+  return image;
+}
+
+}  // namespace
+
+TEST(RawImageViewTest, ViewTest) {
+  RawImage image = MakeImage(4, 6, RAW_IMAGE_FORMAT_NV12);
+  RawImageView view = image;
+  EXPECT_FALSE(view.owns_buffer());
+  EXPECT_EQ(view.height(), 4);
+  EXPECT_EQ(view.width(), 6);
+  EXPECT_EQ(view.channels(), 3);
+  EXPECT_EQ(view.format(), RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(view.data(), image.data());
+  EXPECT_EQ(view.size(), image.size());
+  ASSERT_EQ(view.planes().size(), 2);
+  EXPECT_EQ(view.row(1, 1), image.row(1, 1));
+
+  RawImageDescriptor desc = view.descriptor();
+  ASSERT_EQ(desc.planes_size(), 2);
+  EXPECT_EQ(desc.planes(1).offset(), 24);
+  EXPECT_EQ(desc.planes(1).stride(), 6);
+
+  RawImageView empty;
+  EXPECT_EQ(empty.height(), 0);
+  EXPECT_EQ(empty.width(), 0);
+  EXPECT_EQ(empty.format(), RAW_IMAGE_FORMAT_SRGB);
+}
+
+TEST(RawImageViewTest, CropTest) {
+  RawImage image = MakeImage(6, 8, RAW_IMAGE_FORMAT_SRGB);
+  RawImageView view = image;
+  auto cropped_statusor = view.Crop(2, 3, 3, 4);
+  ASSERT_TRUE(cropped_statusor.ok());
+  RawImageView cropped = std::move(cropped_statusor).ValueOrDie();
+
+  // The crop aliases the image.
+  EXPECT_EQ(cropped.data(), image.data());
+  EXPECT_EQ(cropped.height(), 3);
+  EXPECT_EQ(cropped.width(), 4);
+  EXPECT_EQ(cropped.row_stride(), 24);
+  EXPECT_EQ(cropped.row(0), image.row(2) + 9);
+
+  RawImage copy = cropped.ToRawImage();
+  EXPECT_EQ(copy.height(), 3);
+  EXPECT_EQ(copy.width(), 4);
+  EXPECT_EQ(copy.row_stride(), 12);
+  for (int y = 0; y < 3; ++y) {
+    EXPECT_EQ(std::memcmp(copy.row(y), image.row(y + 2) + 9, 12), 0);
+  }
+
+  // Crops of crops are relative to the crop.
+  RawImageView nested = cropped.Crop(1, 1, 2, 2).ValueOrDie();
+  EXPECT_EQ(nested.row(0), image.row(3) + 12);
+
+  EXPECT_EQ(view.Crop(2, 3, 5, 4).status().code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_EQ(view.Crop(-1, 0, 1, 1).status().code(),
+            StatusCode::kInvalidArgument);
+}
+
+TEST(RawImageViewTest, CropYuvTest) {
+  RawImage image = MakeImage(8, 12, RAW_IMAGE_FORMAT_I420);
+  RawImageView view = image;
+  EXPECT_EQ(view.Crop(1, 2, 2, 2).status().code(),
+            StatusCode::kInvalidArgument);
+
+  RawImageView cropped = view.Crop(4, 6, 3, 5).ValueOrDie();
+  EXPECT_EQ(cropped.row(0, 0), image.row(4, 0) + 6);
+  EXPECT_EQ(cropped.row(0, 1), image.row(2, 1) + 3);
+  EXPECT_EQ(cropped.row(0, 2), image.row(2, 2) + 3);
+
+  RawImage copy = cropped.ToRawImage();
+  for (int p = 0; p < 3; ++p) {
+    int rows = p == 0 ? 3 : 2;
+    int row_size = p == 0 ? 5 : 3;
+    for (int y = 0; y < rows; ++y) {
+      EXPECT_EQ(std::memcmp(copy.row(y, p), cropped.row(y, p), row_size), 0);
+    }
+  }
+}
+
+TEST(RawImageViewTest, TileTest) {
+  RawImage image = MakeImage(5, 7, RAW_IMAGE_FORMAT_GRAY8);
+  RawImageView view = image;
+  auto tiles_statusor = view.Tile(2, 3);
+  ASSERT_TRUE(tiles_statusor.ok());
+  std::vector<RawImageView> tiles = std::move(tiles_statusor).ValueOrDie();
+  ASSERT_EQ(tiles.size(), 9);
+  EXPECT_EQ(tiles[0].height(), 2);
+  EXPECT_EQ(tiles[0].width(), 3);
+  EXPECT_EQ(tiles[2].width(), 1);
+  EXPECT_EQ(tiles[6].height(), 1);
+  EXPECT_EQ(tiles[4].row(0), image.row(2) + 3);
+  for (const RawImageView& tile : tiles) {
+    EXPECT_EQ(tile.data(), image.data());
+  }
+
+  EXPECT_EQ(view.Tile(0, 3).status().code(), StatusCode::kInvalidArgument);
+  RawImage nv12 = MakeImage(4, 4, RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(RawImageView(nv12).Tile(2, 3).status().code(),
+            StatusCode::kInvalidArgument);
+}
+
+TEST(RawImageViewTest, SharedBufferTest) {
+  RawImage image = MakeImage(4, 6, RAW_IMAGE_FORMAT_RGBA);
+  RawImage expected = image;
+  const uint8_t* data = image.data();
+
+  RawImageView cropped;
+  {
+    RawImageView view(std::move(image));
+    EXPECT_TRUE(view.owns_buffer());
+    EXPECT_EQ(view.data(), data);
+    cropped = view.Crop(1, 2, 2, 3).ValueOrDie();
+  }
+
+  // The crop keeps the buffer alive after the original view is gone.
+  EXPECT_TRUE(cropped.owns_buffer());
+  EXPECT_EQ(cropped.data(), data);
+  EXPECT_EQ(std::memcmp(cropped.row(1), expected.row(2) + 8, 12), 0);
+}
+
+}  // namespace aistreams
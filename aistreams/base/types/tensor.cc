@@ -0,0 +1,140 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/tensor.h"
+
+#include <cstring>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/types/tensor_helpers.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+
+namespace aistreams {
+
+namespace {
+
+TensorDescriptor MakeDescriptor(TensorDataType dtype,
+                                const std::vector<int64_t>& shape) {
+  TensorDescriptor desc;
+  desc.set_dtype(dtype);
+  for (int64_t dim : shape) {
+    desc.add_shape(dim);
+  }
+  return desc;
+}
+
+size_t GetMisalignment(const void* p) {
+  return reinterpret_cast<uintptr_t>(p) % Tensor::kAlignment;
+}
+
+}  // namespace
+
+constexpr size_t Tensor::kAlignment;
+
+Tensor::Tensor() : Tensor(TENSOR_DATA_TYPE_FLOAT32, {0}) {}
+
+Tensor::Tensor(TensorDataType dtype, const std::vector<int64_t>& shape)
+    : Tensor(MakeDescriptor(dtype, shape)) {}
+
+Tensor::Tensor(const TensorDescriptor& desc) {
+  TensorDescriptor layout = desc;
+  layout.set_offset(0);
+  auto buffer_size_statusor = GetBufferSize(layout);
+  if (!buffer_size_statusor.ok()) {
+    LOG(FATAL) << buffer_size_statusor.status();
+  }
+  SetLayout(layout);
+  data_ = FrameBuffer(buffer_size_statusor.ValueOrDie());
+}
+
+Tensor::Tensor(const TensorDescriptor& desc, std::string&& bytes) {
+  auto expected_bufsize_statusor = GetBufferSize(desc);
+  if (!expected_bufsize_statusor.ok()) {
+    LOG(FATAL) << expected_bufsize_statusor.status();
+  }
+  auto expected_bufsize = expected_bufsize_statusor.ValueOrDie();
+  bool size_ok = IsDense(desc)
+                     ? static_cast<size_t>(expected_bufsize) == bytes.size()
+                     : static_cast<size_t>(expected_bufsize) <= bytes.size();
+  if (!size_ok) {
+    LOG(FATAL) << absl::StrFormat(
+        "Attempted to move construct a Tensor expecting %d bytes with a "
+        "string containing %d bytes",
+        expected_bufsize, bytes.size());
+  }
+  SetLayout(desc);
+
+  // Strings small enough to be stored inline would move their bytes, and so
+  // lose the alignment, whenever the tensor is moved.
+  size_t offset = static_cast<size_t>(desc.offset());
+  if (GetMisalignment(bytes.data() + offset) == 0 &&
+      bytes.capacity() >= kAlignment) {
+    data_ = FrameBuffer(std::move(bytes), offset);
+    return;
+  }
+  data_ = FrameBuffer(bytes.size() - offset);
+  std::memcpy(data(), bytes.data() + offset, size());
+}
+
+Tensor::Tensor(const Tensor& other)
+    : dtype_(other.dtype_),
+      shape_(other.shape_),
+      strides_(other.strides_),
+      data_(other.size()) {
+  std::memcpy(data(), other.data(), size());
+}
+
+Tensor& Tensor::operator=(const Tensor& other) {
+  if (this != &other) {
+    Tensor copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+void Tensor::SetLayout(const TensorDescriptor& desc) {
+  dtype_ = desc.dtype();
+  shape_.assign(desc.shape().begin(), desc.shape().end());
+  if (desc.strides_size() == 0) {
+    strides_ = GetDenseStrides(dtype_, shape_);
+  } else {
+    strides_.assign(desc.strides().begin(), desc.strides().end());
+  }
+}
+
+int64_t Tensor::num_elements() const {
+  int64_t num_elements = 1;
+  for (int64_t dim : shape_) {
+    num_elements *= dim;
+  }
+  return num_elements;
+}
+
+bool Tensor::is_dense() const {
+  return strides_ == GetDenseStrides(dtype_, shape_);
+}
+
+TensorDescriptor Tensor::descriptor() const {
+  TensorDescriptor desc = MakeDescriptor(dtype_, shape_);
+  if (!is_dense()) {
+    for (int64_t stride : strides_) {
+      desc.add_strides(stride);
+    }
+  }
+  desc.set_offset(data_.offset());
+  return desc;
+}
+
+}  // namespace aistreams
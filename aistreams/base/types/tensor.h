@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_TENSOR_H_
+#define AISTREAMS_BASE_TYPES_TENSOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "aistreams/base/types/frame_buffer.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/types/tensor.pb.h"
+
+namespace aistreams {
+
+// A Tensor holds a multi-dimensional array of elements of one data type in a
+// single buffer, e.g. the preprocessed input of a model.
+//
+// The first element is aligned to kAlignment bytes so that vectorized code
+// can use aligned loads; the buffer is a FrameBuffer and is recycled once the
+// tensor is destroyed. By default, the elements are dense in row-major
+// order, so element (i0, ..., iN) is at the sum of ik*strides()[k] bytes from
+// data(). Tensors adopted from a buffer may have arbitrary strides instead.
+class Tensor {
+ public:
+  // The alignment of the first element.
+  static constexpr size_t kAlignment = FrameBuffer::kAlignment;
+
+  // Constructs a dense tensor of the given data type and shape. The elements
+  // are unspecified.
+  Tensor(TensorDataType dtype, const std::vector<int64_t>& shape);
+
+  // Constructs a tensor from a TensorDescriptor. The offset of the descriptor
+  // is ignored; the first element is always aligned. The elements are
+  // unspecified.
+  explicit Tensor(const TensorDescriptor&);
+
+  // Constructs a tensor from a TensorDescriptor and is move initialized to the
+  // given bytes.
+  //
+  // If the descriptor is dense, then the bytes must be exactly
+  // GetBufferSize; otherwise, they may be longer. The bytes are adopted
+  // without a copy unless the first element would not be aligned.
+  Tensor(const TensorDescriptor&, std::string&& bytes);
+
+  // Constructs an empty FLOAT32 tensor of shape [0].
+  Tensor();
+
+  // Copies keep the alignment of the first element.
+  Tensor(const Tensor&);
+  Tensor& operator=(const Tensor&);
+  Tensor(Tensor&&) = default;
+  Tensor& operator=(Tensor&&) = default;
+
+  // Returns the data type of the elements.
+  TensorDataType dtype() const { return dtype_; }
+
+  // Returns the size of each dimension.
+  const std::vector<int64_t>& shape() const { return shape_; }
+
+  // Returns the number of bytes between consecutive elements along each
+  // dimension.
+  const std::vector<int64_t>& strides() const { return strides_; }
+
+  // Returns the number of dimensions.
+  int rank() const { return static_cast<int>(shape_.size()); }
+
+  // Returns the size of dimension i.
+  int64_t dim(int i) const { return shape_[i]; }
+
+  // Returns the number of elements.
+  int64_t num_elements() const;
+
+  // Returns true if the elements are dense in row-major order.
+  bool is_dense() const;
+
+  // Returns a descriptor for this tensor. It has explicit strides only if the
+  // tensor is not dense, and the offset of the first element in the buffer.
+  TensorDescriptor descriptor() const;
+
+  // Returns a pointer to the first element.
+  //
+  // The valid bytes are in the contiguous address range
+  // [data(), data()+size()).
+  uint8_t* data() {
+    return const_cast<uint8_t*>(static_cast<const Tensor&>(*this).data());
+  }
+
+  const uint8_t* data() const { return data_.data(); }
+
+  // Returns a pointer to the first element as the given C++ type.
+  //
+  // You must ensure that T matches dtype().
+  template <typename T>
+  T* data_as() {
+    return reinterpret_cast<T*>(data());
+  }
+
+  template <typename T>
+  const T* data_as() const {
+    return reinterpret_cast<const T*>(data());
+  }
+
+  // Returns the number of bytes from the first element to the end of the
+  // buffer.
+  size_t size() const { return data_.size(); }
+
+  // Returns the released tensor buffer for the caller to acquire.
+  //
+  // The first element is descriptor().offset() bytes into it; get the
+  // descriptor before releasing the buffer.
+  std::string ReleaseBuffer() && { return std::move(data_).Release(); }
+
+ private:
+  TensorDataType dtype_;
+  std::vector<int64_t> shape_;
+  std::vector<int64_t> strides_;
+  FrameBuffer data_;
+
+  void SetLayout(const TensorDescriptor&);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_TENSOR_H_
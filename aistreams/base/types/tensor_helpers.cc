@@ -0,0 +1,138 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/tensor_helpers.h"
+
+#include <limits>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+int GetDataTypeSize(const TensorDataType& dtype) {
+  switch (dtype) {
+    case TENSOR_DATA_TYPE_FLOAT32:
+    case TENSOR_DATA_TYPE_INT32:
+      return 4;
+    case TENSOR_DATA_TYPE_UINT8:
+    case TENSOR_DATA_TYPE_INT8:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+int64_t GetNumElements(const TensorDescriptor& desc) {
+  int64_t num_elements = 1;
+  for (int64_t dim : desc.shape()) {
+    num_elements *= dim;
+  }
+  return num_elements;
+}
+
+std::vector<int64_t> GetDenseStrides(const TensorDataType& dtype,
+                                     const std::vector<int64_t>& shape) {
+  std::vector<int64_t> strides(shape.size());
+  int64_t stride = GetDataTypeSize(dtype);
+  for (int i = static_cast<int>(shape.size()) - 1; i >= 0; --i) {
+    strides[i] = stride;
+    stride *= shape[i];
+  }
+  return strides;
+}
+
+StatusOr<int64_t> GetBufferSize(const TensorDescriptor& desc) {
+  AIS_RETURN_IF_ERROR(Validate(desc));
+  int64_t element_size = GetDataTypeSize(desc.dtype());
+  if (GetNumElements(desc) == 0) {
+    return desc.offset();
+  }
+
+  // The last element is the farthest from the first since no stride is
+  // negative.
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  int64_t size = desc.offset() + element_size;
+  std::vector<int64_t> shape(desc.shape().begin(), desc.shape().end());
+  std::vector<int64_t> strides =
+      desc.strides_size() == 0
+          ? GetDenseStrides(desc.dtype(), shape)
+          : std::vector<int64_t>(desc.strides().begin(), desc.strides().end());
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (strides[i] > 0 && shape[i] - 1 > (kMax - size) / strides[i]) {
+      return InvalidArgumentError(
+          "The given tensor descriptor spans more bytes than can be "
+          "addressed");
+    }
+    size += (shape[i] - 1) * strides[i];
+  }
+  return size;
+}
+
+bool IsDense(const TensorDescriptor& desc) {
+  if (desc.offset() != 0) {
+    return false;
+  }
+  if (desc.strides_size() == 0) {
+    return true;
+  }
+  std::vector<int64_t> shape(desc.shape().begin(), desc.shape().end());
+  std::vector<int64_t> strides = GetDenseStrides(desc.dtype(), shape);
+  for (int i = 0; i < desc.strides_size(); ++i) {
+    if (desc.strides(i) != strides[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status Validate(const TensorDescriptor& desc) {
+  if (GetDataTypeSize(desc.dtype()) == 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a tensor descriptor with an unsupported data type (%d)",
+        desc.dtype()));
+  }
+  int64_t num_elements = 1;
+  for (int64_t dim : desc.shape()) {
+    if (dim < 0) {
+      return InvalidArgumentError(
+          "Given a tensor descriptor with a negative dimension");
+    }
+    if (dim > 0 && num_elements > std::numeric_limits<int64_t>::max() / dim) {
+      return InvalidArgumentError(
+          "Given a tensor descriptor with too many elements");
+    }
+    num_elements *= dim;
+  }
+  if (desc.strides_size() != 0 && desc.strides_size() != desc.shape_size()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a tensor descriptor with %d strides for %d dimensions",
+        desc.strides_size(), desc.shape_size()));
+  }
+  for (int64_t stride : desc.strides()) {
+    if (stride < 0) {
+      return InvalidArgumentError(
+          "Given a tensor descriptor with a negative stride");
+    }
+  }
+  if (desc.offset() < 0) {
+    return InvalidArgumentError(
+        "Given a tensor descriptor with a negative offset");
+  }
+  return OkStatus();
+}
+
+}  // namespace aistreams
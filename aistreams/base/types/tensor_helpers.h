@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_TENSOR_HELPERS_H_
+#define AISTREAMS_BASE_TYPES_TENSOR_HELPERS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/tensor.pb.h"
+
+namespace aistreams {
+
+// Get the number of bytes of one element of the given data type, or 0 if the
+// type is unknown.
+int GetDataTypeSize(const TensorDataType& dtype);
+
+// Get the number of elements of the described tensor.
+int64_t GetNumElements(const TensorDescriptor& desc);
+
+// Get the byte strides of a dense, row-major tensor of the given data type and
+// shape.
+std::vector<int64_t> GetDenseStrides(const TensorDataType& dtype,
+                                     const std::vector<int64_t>& shape);
+
+// Get the expected buffer size specified by the given descriptor.
+//
+// This is the smallest buffer that holds the offset and every element; for a
+// dense tensor without an offset, it is the number of elements times their
+// size.
+StatusOr<int64_t> GetBufferSize(const TensorDescriptor& desc);
+
+// Returns true if the given descriptor has no offset and either no explicit
+// strides or strides that are exactly those of a dense tensor.
+bool IsDense(const TensorDescriptor& desc);
+
+// Validate the given descriptor.
+Status Validate(const TensorDescriptor& desc);
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_TENSOR_HELPERS_H_
@@ -0,0 +1,159 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/types/tensor.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "aistreams/base/types/tensor_helpers.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/tensor.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+bool IsAligned(const void* p) {
+  return reinterpret_cast<uintptr_t>(p) % Tensor::kAlignment == 0;
+}
+
+}  // namespace
+
+TEST(TensorHelpersTest, GeometryTest) {
+  TensorDescriptor desc;
+  desc.set_dtype(TENSOR_DATA_TYPE_FLOAT32);
+  for (int64_t dim : {2, 3, 4}) {
+    desc.add_shape(dim);
+  }
+  EXPECT_EQ(GetNumElements(desc), 24);
+  EXPECT_EQ(GetDenseStrides(desc.dtype(), {2, 3, 4}),
+            std::vector<int64_t>({48, 16, 4}));
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 96);
+  EXPECT_TRUE(IsDense(desc));
+
+  // Rows padded to 32 bytes, starting 64 bytes into the buffer.
+  for (int64_t stride : {96, 32, 4}) {
+    desc.add_strides(stride);
+  }
+  desc.set_offset(64);
+  EXPECT_FALSE(IsDense(desc));
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 64 + 96 + 64 + 16);
+
+  desc.set_dtype(TENSOR_DATA_TYPE_UINT8);
+  desc.clear_strides();
+  desc.set_offset(0);
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 24);
+
+  desc.set_shape(1, 0);
+  EXPECT_EQ(GetBufferSize(desc).ValueOrDie(), 0);
+}
+
+TEST(TensorHelpersTest, ValidateTest) {
+  TensorDescriptor desc;
+  desc.add_shape(2);
+  EXPECT_FALSE(Validate(desc).ok());
+  desc.set_dtype(TENSOR_DATA_TYPE_INT32);
+  EXPECT_TRUE(Validate(desc).ok());
+  desc.add_shape(-1);
+  EXPECT_FALSE(Validate(desc).ok());
+  desc.set_shape(1, 3);
+  desc.add_strides(12);
+  EXPECT_FALSE(Validate(desc).ok());
+  desc.add_strides(4);
+  EXPECT_TRUE(Validate(desc).ok());
+  desc.set_offset(-1);
+  EXPECT_FALSE(Validate(desc).ok());
+}
+
+TEST(TensorTest, DefaultTest) {
+  Tensor tensor;
+  EXPECT_EQ(tensor.dtype(), TENSOR_DATA_TYPE_FLOAT32);
+  EXPECT_EQ(tensor.rank(), 1);
+  EXPECT_EQ(tensor.num_elements(), 0);
+  EXPECT_EQ(tensor.size(), 0);
+}
+
+TEST(TensorTest, ConstructionTest) {
+  Tensor tensor(TENSOR_DATA_TYPE_FLOAT32, {1, 3, 5, 7});
+  EXPECT_EQ(tensor.rank(), 4);
+  EXPECT_EQ(tensor.dim(1), 3);
+  EXPECT_EQ(tensor.num_elements(), 105);
+  EXPECT_EQ(tensor.size(), 420);
+  EXPECT_EQ(tensor.strides(), std::vector<int64_t>({420, 140, 28, 4}));
+  EXPECT_TRUE(tensor.is_dense());
+  EXPECT_TRUE(IsAligned(tensor.data()));
+
+  TensorDescriptor desc = tensor.descriptor();
+  EXPECT_EQ(desc.shape_size(), 4);
+  EXPECT_EQ(desc.strides_size(), 0);
+
+  tensor.data_as<float>()[104] = 1.5f;
+  Tensor copy = tensor;
+  EXPECT_TRUE(IsAligned(copy.data()));
+  EXPECT_NE(copy.data(), tensor.data());
+  EXPECT_EQ(copy.data_as<float>()[104], 1.5f);
+
+  const uint8_t* data = tensor.data();
+  Tensor moved = std::move(tensor);
+  EXPECT_EQ(moved.data(), data);
+}
+
+TEST(TensorTest, AdoptTest) {
+  TensorDescriptor desc;
+  desc.set_dtype(TENSOR_DATA_TYPE_UINT8);
+  desc.add_shape(2);
+  desc.add_shape(100);
+
+  // The bytes are realigned if needed.
+  std::string bytes(200, 0);
+  bytes[150] = 9;
+  Tensor dense(desc, std::move(bytes));
+  EXPECT_TRUE(IsAligned(dense.data()));
+  EXPECT_EQ(dense.size(), 200);
+  EXPECT_EQ(dense.data()[150], 9);
+
+  // Padded rows with an offset are kept, and so is the buffer if the first
+  // element is aligned.
+  desc.add_strides(128);
+  desc.add_strides(1);
+  std::string buffer = std::move(dense).ReleaseBuffer();
+  buffer.resize(Tensor::kAlignment + 228);
+  size_t offset = 0;
+  while (!IsAligned(buffer.data() + offset)) {
+    ++offset;
+  }
+  desc.set_offset(offset);
+  buffer[offset + 128] = 5;
+  const char* data = buffer.data();
+  Tensor padded(desc, std::move(buffer));
+  EXPECT_FALSE(padded.is_dense());
+  EXPECT_EQ(static_cast<const void*>(padded.data()), data + offset);
+  EXPECT_EQ(padded.data()[padded.strides()[0]], 5);
+  EXPECT_EQ(padded.descriptor().offset(), offset);
+  EXPECT_EQ(padded.descriptor().strides_size(), 2);
+}
+
+TEST(TensorTest, AdoptDeathTest) {
+  TensorDescriptor desc;
+  desc.set_dtype(TENSOR_DATA_TYPE_FLOAT32);
+  desc.add_shape(4);
+  ASSERT_DEATH(Tensor(desc, std::string(15, 0)), "");
+  ASSERT_DEATH(Tensor(desc, std::string(17, 0)), "");
+}
+
+}  // namespace aistreams
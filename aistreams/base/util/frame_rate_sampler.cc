@@ -0,0 +1,42 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/frame_rate_sampler.h"
+
+#include <cmath>
+
+namespace aistreams {
+
+FrameRateSampler::FrameRateSampler(double fps)
+    : period_nanos_(fps > 0 ? static_cast<int64_t>(std::llround(1e9 / fps))
+                            : 0) {}
+
+bool FrameRateSampler::Sample(int64_t nanos) {
+  if (period_nanos_ <= 0) {
+    return true;
+  }
+  if (!started_ || nanos < next_nanos_ - period_nanos_ ||
+      nanos >= next_nanos_ + period_nanos_) {
+    started_ = true;
+    next_nanos_ = nanos + period_nanos_;
+    return true;
+  }
+  if (nanos < next_nanos_) {
+    return false;
+  }
+  next_nanos_ += period_nanos_;
+  return true;
+}
+
+}  // namespace aistreams
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_FRAME_RATE_SAMPLER_H_
+#define AISTREAMS_BASE_UTIL_FRAME_RATE_SAMPLER_H_
+
+#include <cstdint>
+
+namespace aistreams {
+
+// Picks the frames of a stream to keep so that it is at most a target frame
+// rate; e.g. to analyze 2 frames a second of a 30 fps stream.
+//
+// Frames are kept on a grid of 1/fps periods that starts at the first frame,
+// so jitter in the timestamps does not change the long run rate. A frame whose
+// timestamp goes back past the last kept frame, or skips ahead by more than a
+// period, restarts the grid from itself.
+//
+// This class is not thread-safe.
+class FrameRateSampler {
+ public:
+  // Creates a sampler that keeps at most `fps` frames a second. A
+  // non-positive `fps` keeps every frame.
+  explicit FrameRateSampler(double fps);
+
+  // Returns true if the frame with the given timestamp (nanoseconds) is to be
+  // kept.
+  bool Sample(int64_t nanos);
+
+ private:
+  int64_t period_nanos_;
+  bool started_ = false;
+  int64_t next_nanos_ = 0;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_FRAME_RATE_SAMPLER_H_
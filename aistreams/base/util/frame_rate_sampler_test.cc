@@ -0,0 +1,76 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/frame_rate_sampler.h"
+
+#include <cstdint>
+
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr int64_t kSecond = 1000000000;
+
+// Returns how many of `count` frames at `source_fps`, offset by `jitter`
+// nanoseconds on every other frame, are kept at `fps`.
+int CountSampled(double fps, int source_fps, int count, int64_t jitter = 0) {
+  FrameRateSampler sampler(fps);
+  int sampled = 0;
+  for (int i = 0; i < count; ++i) {
+    int64_t nanos = i * kSecond / source_fps + (i % 2 == 0 ? jitter : 0);
+    if (sampler.Sample(nanos)) {
+      ++sampled;
+    }
+  }
+  return sampled;
+}
+
+}  // namespace
+
+TEST(FrameRateSamplerTest, RateTest) {
+  EXPECT_EQ(CountSampled(2, 30, 300), 20);
+  EXPECT_EQ(CountSampled(1.5, 30, 300), 15);
+  EXPECT_EQ(CountSampled(7, 30, 300), 70);
+  EXPECT_EQ(CountSampled(2, 30, 300, kSecond / 100), 20);
+
+  // Slower sources are left alone.
+  EXPECT_EQ(CountSampled(60, 30, 300), 300);
+  EXPECT_EQ(CountSampled(0, 30, 300), 300);
+}
+
+TEST(FrameRateSamplerTest, EveryNthTest) {
+  FrameRateSampler sampler(10);
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_EQ(sampler.Sample(i * kSecond / 30), i % 3 == 0) << i;
+  }
+}
+
+TEST(FrameRateSamplerTest, RestartTest) {
+  FrameRateSampler sampler(1);
+  EXPECT_TRUE(sampler.Sample(10 * kSecond));
+  EXPECT_FALSE(sampler.Sample(10 * kSecond + kSecond / 2));
+
+  // A gap restarts the grid from the next frame.
+  EXPECT_TRUE(sampler.Sample(20 * kSecond + kSecond / 2));
+  EXPECT_FALSE(sampler.Sample(21 * kSecond));
+  EXPECT_TRUE(sampler.Sample(21 * kSecond + kSecond / 2));
+
+  // So does going back in time.
+  EXPECT_TRUE(sampler.Sample(5 * kSecond));
+  EXPECT_FALSE(sampler.Sample(5 * kSecond + 1));
+}
+
+}  // namespace aistreams
@@ -14,6 +14,7 @@
 
 #include "aistreams/base/util/grpc_helpers.h"
 
+#include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "aistreams/port/canonical_errors.h"
@@ -87,6 +88,17 @@ Status FillGrpcClientContext(const RpcOptions &options,
   if (options.timeout > absl::ZeroDuration()) {
     ctx->set_deadline(ToChronoTime(absl::Now() + options.timeout));
   }
+  if (options.compression_algorithm.empty() ||
+      options.compression_algorithm == "identity") {
+    ctx->set_compression_algorithm(GRPC_COMPRESS_NONE);
+  } else if (options.compression_algorithm == "gzip") {
+    ctx->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  } else if (options.compression_algorithm == "deflate") {
+    ctx->set_compression_algorithm(GRPC_COMPRESS_DEFLATE);
+  } else {
+    return InvalidArgumentError(absl::StrCat(
+        "Unknown compression algorithm: ", options.compression_algorithm));
+  }
   return OkStatus();
 }
 
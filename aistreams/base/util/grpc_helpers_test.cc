@@ -40,6 +40,28 @@ TEST(GrpcHelpersTest, FillGrpcClientContext) {
   }
 }
 
+TEST(GrpcHelpersTest, FillGrpcClientContextCompression) {
+  RpcOptions rpc_options;
+  {
+    grpc::ClientContext client_context;
+    EXPECT_TRUE(FillGrpcClientContext(rpc_options, &client_context).ok());
+    EXPECT_EQ(GRPC_COMPRESS_NONE, client_context.compression_algorithm());
+  }
+
+  {
+    grpc::ClientContext client_context;
+    rpc_options.compression_algorithm = "gzip";
+    EXPECT_TRUE(FillGrpcClientContext(rpc_options, &client_context).ok());
+    EXPECT_EQ(GRPC_COMPRESS_GZIP, client_context.compression_algorithm());
+  }
+
+  {
+    grpc::ClientContext client_context;
+    rpc_options.compression_algorithm = "lz4";
+    EXPECT_FALSE(FillGrpcClientContext(rpc_options, &client_context).ok());
+  }
+}
+
 }  // namespace
 
 }  // namespace aistreams
@@ -0,0 +1,578 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/image_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/types/raw_image_helpers.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/util/image_kernels_internal.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace image_kernels_internal {
+
+namespace {
+
+bool CpuSupports(Isa isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+    case Isa::kSse42:
+      return __builtin_cpu_supports("sse4.2");
+    case Isa::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case Isa::kAvx512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512bw");
+  }
+  return false;
+#else
+  return isa == Isa::kScalar;
+#endif
+}
+
+std::atomic<const KernelTable*> overridden_kernel_table{nullptr};
+
+}  // namespace
+
+const KernelTable* GetKernelTable(Isa isa) {
+  if (!CpuSupports(isa)) {
+    return nullptr;
+  }
+  switch (isa) {
+    case Isa::kScalar:
+      return GetScalarKernelTable();
+    case Isa::kSse42:
+      return GetSse42KernelTable();
+    case Isa::kAvx2:
+      return GetAvx2KernelTable();
+    case Isa::kAvx512:
+      return GetAvx512KernelTable();
+  }
+  return nullptr;
+}
+
+const KernelTable& GetBestKernelTable() {
+  static const KernelTable* const kBest = [] {
+    for (Isa isa : {Isa::kAvx512, Isa::kAvx2, Isa::kSse42}) {
+      const KernelTable* table = GetKernelTable(isa);
+      if (table != nullptr) {
+        return table;
+      }
+    }
+    return GetScalarKernelTable();
+  }();
+  return *kBest;
+}
+
+const KernelTable& GetActiveKernelTable() {
+  const KernelTable* kernels = overridden_kernel_table.load();
+  return kernels != nullptr ? *kernels : GetBestKernelTable();
+}
+
+void SetKernelTableForTesting(const KernelTable* kernels) {
+  overridden_kernel_table.store(kernels);
+}
+
+AxisWeights ComputeBilinearWeights(int in, int out) {
+  AxisWeights axis;
+  axis.taps = in > 1 ? 2 : 1;
+  axis.starts.resize(out);
+  axis.weights.resize(static_cast<size_t>(out) * axis.taps);
+  for (int i = 0; i < out; ++i) {
+    if (axis.taps == 1) {
+      axis.starts[i] = 0;
+      axis.weights[i] = kWeightOne;
+      continue;
+    }
+
+    // The center of output pixel i is at ((2i + 1)*in - out) / (2*out) in
+    // source pixel coordinates.
+    int64_t num = (2 * static_cast<int64_t>(i) + 1) * in - out;
+    int64_t den = 2 * static_cast<int64_t>(out);
+    int64_t start = 0;
+    int64_t frac = 0;
+    if (num > 0) {
+      start = num / den;
+      frac = ((num % den) * kWeightOne + den / 2) / den;
+    }
+    if (start >= in - 1) {
+      start = in - 2;
+      frac = kWeightOne;
+    }
+    axis.starts[i] = static_cast<int>(start);
+    axis.weights[2 * i] = static_cast<int16_t>(kWeightOne - frac);
+    axis.weights[2 * i + 1] = static_cast<int16_t>(frac);
+  }
+  return axis;
+}
+
+AxisWeights ComputeAreaWeights(int in, int out) {
+  if (out >= in) {
+    return ComputeBilinearWeights(in, out);
+  }
+  AxisWeights axis;
+  axis.taps = std::min(in, (in + out - 1) / out + 1);
+  axis.starts.resize(out);
+  axis.weights.assign(static_cast<size_t>(out) * axis.taps, 0);
+  for (int i = 0; i < out; ++i) {
+    // In units of 1/out source pixels, output pixel i covers
+    // [i*in, (i+1)*in) and source pixel j covers [j*out, (j+1)*out).
+    int64_t lo = static_cast<int64_t>(i) * in;
+    int64_t hi = lo + in;
+    int first = static_cast<int>(lo / out);
+    int last = static_cast<int>((hi - 1) / out);
+    int start = std::min(first, in - axis.taps);
+    axis.starts[i] = start;
+
+    int16_t* weights = &axis.weights[static_cast<size_t>(i) * axis.taps];
+    int sum = 0;
+    int largest = first - start;
+    for (int j = first; j <= last; ++j) {
+      int64_t overlap = std::min(hi, static_cast<int64_t>(j + 1) * out) -
+                        std::max(lo, static_cast<int64_t>(j) * out);
+      int weight = static_cast<int>((overlap * kWeightOne + in / 2) / in);
+      weights[j - start] = static_cast<int16_t>(weight);
+      sum += weight;
+      if (weight > weights[largest]) {
+        largest = j - start;
+      }
+    }
+    // Give the rounding error to the largest weight so the sum is exact.
+    weights[largest] += kWeightOne - sum;
+  }
+  return axis;
+}
+
+}  // namespace image_kernels_internal
+
+namespace {
+
+using image_kernels_internal::AxisWeights;
+using image_kernels_internal::ComputeAreaWeights;
+using image_kernels_internal::ComputeBilinearWeights;
+using image_kernels_internal::GetActiveKernelTable;
+using image_kernels_internal::KernelTable;
+using image_kernels_internal::kWeightOne;
+
+RawImageDescriptor MakeDescriptor(int height, int width,
+                                  RawImageFormat format) {
+  RawImageDescriptor desc;
+  desc.set_height(height);
+  desc.set_width(width);
+  desc.set_format(format);
+  return desc;
+}
+
+bool IsYuv(RawImageFormat format) {
+  return format == RAW_IMAGE_FORMAT_NV12 || format == RAW_IMAGE_FORMAT_I420;
+}
+
+// Returns the number of interleaved values per pixel in the given plane.
+int GetPlaneChannels(RawImageFormat format, int plane) {
+  switch (format) {
+    case RAW_IMAGE_FORMAT_NV12:
+      return plane == 0 ? 1 : 2;
+    case RAW_IMAGE_FORMAT_I420:
+      return 1;
+    default:
+      return GetNumChannels(format);
+  }
+}
+
+// Returns the number of pixels in one row of the given plane.
+int GetPlaneWidth(const RawImageDescriptor& desc, int plane) {
+  return static_cast<int>(GetPlaneRowSize(desc, plane) /
+                          GetPlaneChannels(desc.format(), plane));
+}
+
+// Returns the byte offset of pixel (y, x) of the image within the given plane,
+// relative to the start of the plane.
+size_t GetPlanePixelOffset(const RawImageView& image, int plane, int y, int x) {
+  int subsampling = IsYuv(image.format()) && plane > 0 ? 2 : 1;
+  return static_cast<size_t>(image.planes()[plane].stride) * (y / subsampling) +
+         static_cast<size_t>(x / subsampling) *
+             GetPlaneChannels(image.format(), plane);
+}
+
+Status CopyPlanes(const RawImageView& src, int y, int x, RawImage* dst) {
+  RawImageDescriptor desc =
+      MakeDescriptor(dst->height(), dst->width(), dst->format());
+  for (int p = 0; p < GetNumPlanes(dst->format()); ++p) {
+    int rows = GetPlaneHeight(desc, p);
+    size_t row_size = static_cast<size_t>(GetPlaneRowSize(desc, p));
+    const uint8_t* src_row = src.row(0, p) + GetPlanePixelOffset(src, p, y, x);
+    for (int i = 0; i < rows; ++i) {
+      std::memcpy(dst->row(i, p), src_row, row_size);
+      src_row += src.planes()[p].stride;
+    }
+  }
+  return OkStatus();
+}
+
+Status ValidateRegion(const RawImageView& image, int y, int x, int height,
+                      int width) {
+  if (y < 0 || x < 0 || height < 0 || width < 0 ||
+      static_cast<int64_t>(y) + height > image.height() ||
+      static_cast<int64_t>(x) + width > image.width()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The region (y=%d, x=%d, height=%d, width=%d) is not inside the %dx%d "
+        "image",
+        y, x, height, width, image.height(), image.width()));
+  }
+  if (IsYuv(image.format()) && (y % 2 != 0 || x % 2 != 0)) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The region of a subsampled image must start at an even row and "
+        "column; got (y=%d, x=%d)",
+        y, x));
+  }
+  return OkStatus();
+}
+
+AxisWeights ComputeWeights(ResizeMethod method, int in, int out) {
+  if (method == ResizeMethod::kArea) {
+    return ComputeAreaWeights(in, out);
+  }
+  return ComputeBilinearWeights(in, out);
+}
+
+void ResizePlane(const KernelTable& kernels, ResizeMethod method,
+                 const uint8_t* src, int src_stride, int src_height,
+                 int src_width, int channels, uint8_t* dst, int dst_stride,
+                 int dst_height, int dst_width) {
+  AxisWeights x_axis = ComputeWeights(method, src_width, dst_width);
+  AxisWeights y_axis = ComputeWeights(method, src_height, dst_height);
+
+  // Combine the source rows of each output row first, so that only one row
+  // is ever kept and the wider source rows go through the vertical pass,
+  // which vectorizes fully.
+  std::vector<uint16_t> row(static_cast<size_t>(src_width) * channels);
+  std::vector<const uint8_t*> taps(y_axis.taps);
+  for (int i = 0; i < dst_height; ++i) {
+    for (int t = 0; t < y_axis.taps; ++t) {
+      taps[t] = src + static_cast<size_t>(y_axis.starts[i] + t) * src_stride;
+    }
+    kernels.resample_vertical(
+        taps.data(), &y_axis.weights[static_cast<size_t>(i) * y_axis.taps],
+        y_axis.taps, static_cast<int>(row.size()), row.data());
+    kernels.resample_horizontal(row.data(), channels, x_axis.starts.data(),
+                                x_axis.weights.data(), x_axis.taps, dst_width,
+                                dst + static_cast<size_t>(i) * dst_stride);
+  }
+}
+
+using PixelRowFn = void (*)(const uint8_t*, int, uint8_t*);
+using Nv12RowFn = void (*)(const uint8_t*, const uint8_t*, int, uint8_t*);
+using I420RowFn = void (*)(const uint8_t*, const uint8_t*, const uint8_t*, int,
+                           uint8_t*);
+
+PixelRowFn GetPixelRowFn(const KernelTable& kernels, RawImageFormat from,
+                         RawImageFormat to) {
+  switch (from) {
+    case RAW_IMAGE_FORMAT_SRGB:
+      switch (to) {
+        case RAW_IMAGE_FORMAT_BGR:
+          return kernels.rgb_to_bgr;
+        case RAW_IMAGE_FORMAT_RGBA:
+          return kernels.rgb_to_rgba;
+        case RAW_IMAGE_FORMAT_GRAY8:
+          return kernels.rgb_to_gray;
+        default:
+          return nullptr;
+      }
+    case RAW_IMAGE_FORMAT_BGR:
+      switch (to) {
+        case RAW_IMAGE_FORMAT_SRGB:
+          // Swapping red and blue is its own inverse.
+          return kernels.rgb_to_bgr;
+        case RAW_IMAGE_FORMAT_RGBA:
+          return kernels.bgr_to_rgba;
+        case RAW_IMAGE_FORMAT_GRAY8:
+          return kernels.bgr_to_gray;
+        default:
+          return nullptr;
+      }
+    case RAW_IMAGE_FORMAT_RGBA:
+      switch (to) {
+        case RAW_IMAGE_FORMAT_SRGB:
+          return kernels.rgba_to_rgb;
+        case RAW_IMAGE_FORMAT_BGR:
+          return kernels.rgba_to_bgr;
+        case RAW_IMAGE_FORMAT_GRAY8:
+          return kernels.rgba_to_gray;
+        default:
+          return nullptr;
+      }
+    default:
+      return nullptr;
+  }
+}
+
+Nv12RowFn GetNv12RowFn(const KernelTable& kernels, RawImageFormat to) {
+  switch (to) {
+    case RAW_IMAGE_FORMAT_SRGB:
+      return kernels.nv12_to_rgb;
+    case RAW_IMAGE_FORMAT_BGR:
+      return kernels.nv12_to_bgr;
+    case RAW_IMAGE_FORMAT_RGBA:
+      return kernels.nv12_to_rgba;
+    default:
+      return nullptr;
+  }
+}
+
+I420RowFn GetI420RowFn(const KernelTable& kernels, RawImageFormat to) {
+  switch (to) {
+    case RAW_IMAGE_FORMAT_SRGB:
+      return kernels.i420_to_rgb;
+    case RAW_IMAGE_FORMAT_BGR:
+      return kernels.i420_to_bgr;
+    case RAW_IMAGE_FORMAT_RGBA:
+      return kernels.i420_to_rgba;
+    default:
+      return nullptr;
+  }
+}
+
+Status UnsupportedConversion(RawImageFormat from, RawImageFormat to) {
+  return UnimplementedError(
+      absl::StrFormat("Converting a raw image from %s to %s is not supported",
+                      RawImageFormat_Name(from), RawImageFormat_Name(to)));
+}
+
+}  // namespace
+
+Status ConvertColor(const RawImageView& src, RawImage* dst) {
+  if (dst == nullptr || dst->data() == src.data()) {
+    return InvalidArgumentError(
+        "Given a null destination or one that is the source image");
+  }
+  if (src.height() != dst->height() || src.width() != dst->width()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a %dx%d source image for a %dx%d destination image",
+        src.height(), src.width(), dst->height(), dst->width()));
+  }
+  if (src.format() == dst->format()) {
+    return CopyPlanes(src, 0, 0, dst);
+  }
+
+  const KernelTable& kernels = GetActiveKernelTable();
+  int height = src.height();
+  int width = src.width();
+  switch (src.format()) {
+    case RAW_IMAGE_FORMAT_NV12: {
+      Nv12RowFn convert = GetNv12RowFn(kernels, dst->format());
+      if (convert == nullptr) {
+        return UnsupportedConversion(src.format(), dst->format());
+      }
+      for (int y = 0; y < height; ++y) {
+        convert(src.row(y, 0), src.row(y / 2, 1), width, dst->row(y));
+      }
+      return OkStatus();
+    }
+    case RAW_IMAGE_FORMAT_I420: {
+      I420RowFn convert = GetI420RowFn(kernels, dst->format());
+      if (convert == nullptr) {
+        return UnsupportedConversion(src.format(), dst->format());
+      }
+      for (int y = 0; y < height; ++y) {
+        convert(src.row(y, 0), src.row(y / 2, 1), src.row(y / 2, 2), width,
+                dst->row(y));
+      }
+      return OkStatus();
+    }
+    default: {
+      PixelRowFn convert =
+          GetPixelRowFn(kernels, src.format(), dst->format());
+      if (convert == nullptr) {
+        return UnsupportedConversion(src.format(), dst->format());
+      }
+      for (int y = 0; y < height; ++y) {
+        convert(src.row(y), width, dst->row(y));
+      }
+      return OkStatus();
+    }
+  }
+}
+
+Status Resize(const RawImageView& src, ResizeMethod method, RawImage* dst) {
+  if (dst == nullptr || dst->data() == src.data()) {
+    return InvalidArgumentError(
+        "Given a null destination or one that is the source image");
+  }
+  if (src.format() != dst->format()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a %s source image for a %s destination image",
+        RawImageFormat_Name(src.format()), RawImageFormat_Name(dst->format())));
+  }
+  if (dst->height() == 0 || dst->width() == 0) {
+    return OkStatus();
+  }
+  if (src.height() == 0 || src.width() == 0) {
+    return InvalidArgumentError("Cannot resize an empty image");
+  }
+
+  const KernelTable& kernels = GetActiveKernelTable();
+  RawImageDescriptor src_desc =
+      MakeDescriptor(src.height(), src.width(), src.format());
+  RawImageDescriptor dst_desc =
+      MakeDescriptor(dst->height(), dst->width(), dst->format());
+  for (int p = 0; p < GetNumPlanes(src.format()); ++p) {
+    ResizePlane(kernels, method, src.row(0, p), src.planes()[p].stride,
+                GetPlaneHeight(src_desc, p), GetPlaneWidth(src_desc, p),
+                GetPlaneChannels(src.format(), p), dst->row(0, p),
+                dst->planes()[p].stride, GetPlaneHeight(dst_desc, p),
+                GetPlaneWidth(dst_desc, p));
+  }
+  return OkStatus();
+}
+
+Status Crop(const RawImageView& src, int y, int x, RawImage* dst) {
+  if (dst == nullptr || dst->data() == src.data()) {
+    return InvalidArgumentError(
+        "Given a null destination or one that is the source image");
+  }
+  if (src.format() != dst->format()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a %s source image for a %s destination image",
+        RawImageFormat_Name(src.format()), RawImageFormat_Name(dst->format())));
+  }
+  AIS_RETURN_IF_ERROR(
+      ValidateRegion(src, y, x, dst->height(), dst->width()));
+  return CopyPlanes(src, y, x, dst);
+}
+
+Status Crop(int y, int x, int height, int width, RawImage* image) {
+  if (image == nullptr) {
+    return InvalidArgumentError("Given a null image");
+  }
+  AIS_RETURN_IF_ERROR(ValidateRegion(*image, y, x, height, width));
+
+  // Point the planes at the region, keeping the strides of the full image.
+  RawImageDescriptor desc = MakeDescriptor(height, width, image->format());
+  for (int p = 0; p < static_cast<int>(image->planes().size()); ++p) {
+    RawImagePlane* plane = desc.add_planes();
+    plane->set_offset(image->planes()[p].offset +
+                      GetPlanePixelOffset(*image, p, y, x));
+    plane->set_stride(image->planes()[p].stride);
+  }
+  *image = RawImage(desc, std::move(*image).ReleaseFrameBuffer());
+  return OkStatus();
+}
+
+bool IsIdentity(const ImageTransformOptions& options) {
+  return (options.crop_height == 0 || options.crop_width == 0) &&
+         (options.resize_height == 0 || options.resize_width == 0) &&
+         options.format == RAW_IMAGE_FORMAT_UNKNOWN;
+}
+
+Status Transform(const ImageTransformOptions& options, RawImage* image) {
+  if (image == nullptr) {
+    return InvalidArgumentError("Given a null image");
+  }
+  if (options.crop_height > 0 && options.crop_width > 0) {
+    AIS_RETURN_IF_ERROR(Crop(options.crop_y, options.crop_x,
+                             options.crop_height, options.crop_width, image));
+  }
+
+  bool resize = options.resize_height > 0 && options.resize_width > 0 &&
+                (options.resize_height != image->height() ||
+                 options.resize_width != image->width());
+  bool convert = options.format != RAW_IMAGE_FORMAT_UNKNOWN &&
+                 options.format != image->format();
+  bool shrink = resize && static_cast<int64_t>(options.resize_height) *
+                                  options.resize_width <
+                              static_cast<int64_t>(image->height()) *
+                                  image->width();
+
+  auto resize_image = [&options, image]() -> Status {
+    RawImage resized(options.resize_height, options.resize_width,
+                     image->format());
+    AIS_RETURN_IF_ERROR(Resize(*image, options.resize_method, &resized));
+    *image = std::move(resized);
+    return OkStatus();
+  };
+  auto convert_image = [&options, image]() -> Status {
+    RawImage converted(image->height(), image->width(), options.format);
+    AIS_RETURN_IF_ERROR(ConvertColor(*image, &converted));
+    *image = std::move(converted);
+    return OkStatus();
+  };
+
+  if (resize && shrink) {
+    AIS_RETURN_IF_ERROR(resize_image());
+  }
+  if (convert) {
+    AIS_RETURN_IF_ERROR(convert_image());
+  }
+  if (resize && !shrink) {
+    AIS_RETURN_IF_ERROR(resize_image());
+  }
+  return OkStatus();
+}
+
+Status Transform(const ImageTransformOptions& options, const RawImageView& src,
+                 RawImage* dst) {
+  if (dst == nullptr) {
+    return InvalidArgumentError("Given a null image");
+  }
+  RawImageView region = src;
+  if (options.crop_height > 0 && options.crop_width > 0) {
+    AIS_ASSIGN_OR_RETURN(region,
+                         src.Crop(options.crop_y, options.crop_x,
+                                  options.crop_height, options.crop_width));
+  }
+
+  bool resize = options.resize_height > 0 && options.resize_width > 0 &&
+                (options.resize_height != region.height() ||
+                 options.resize_width != region.width());
+  bool convert = options.format != RAW_IMAGE_FORMAT_UNKNOWN &&
+                 options.format != region.format();
+  bool shrink = resize && static_cast<int64_t>(options.resize_height) *
+                                  options.resize_width <
+                              static_cast<int64_t>(region.height()) *
+                                  region.width();
+
+  // Do the first operation, in the order of the in-place Transform, from the
+  // source region into `dst`.
+  if (resize && (shrink || !convert)) {
+    *dst = RawImage(options.resize_height, options.resize_width,
+                    region.format());
+    AIS_RETURN_IF_ERROR(Resize(region, options.resize_method, dst));
+  } else if (convert) {
+    *dst = RawImage(region.height(), region.width(), options.format);
+    AIS_RETURN_IF_ERROR(ConvertColor(region, dst));
+  } else {
+    *dst = region.ToRawImage();
+    return OkStatus();
+  }
+
+  // The rest, if any, is done in place.
+  ImageTransformOptions rest = options;
+  rest.crop_height = 0;
+  rest.crop_width = 0;
+  return Transform(rest, dst);
+}
+
+}  // namespace aistreams
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_IMAGE_KERNELS_H_
+#define AISTREAMS_BASE_UTIL_IMAGE_KERNELS_H_
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace aistreams {
+
+// Colorspace conversion, resizing and cropping of RawImages.
+//
+// The kernels are vectorized for SSE4.2, AVX2 and AVX-512 and the best one
+// supported by the CPU is picked at runtime, with a scalar fallback. Every
+// kernel uses fixed point arithmetic, so the results are identical whichever
+// is picked.
+//
+// Functions that write into a `dst` image expect it to be allocated with the
+// desired geometry and format; its buffer is reused as is. Sources are taken
+// as RawImageViews, so a RawImage or a region of one can be passed without
+// copies, but they must not view `dst`. Padded layouts (see RawImage::planes)
+// are accepted for both.
+
+// Converts `src` into the format of `dst`, which must have the same height and
+// width.
+//
+// Supported conversions:
+// + NV12 and I420 to SRGB, BGR and RGBA (BT.601 limited range).
+// + SRGB, BGR and RGBA to GRAY8 (BT.601 luma).
+// + Between SRGB, BGR and RGBA.
+// + Any format to itself, which is a copy.
+Status ConvertColor(const RawImageView& src, RawImage* dst);
+
+// The interpolation used by Resize.
+enum class ResizeMethod {
+  // Weighs the two nearest source pixels along each axis.
+  kBilinear = 0,
+
+  // Averages the source pixels covered by each output pixel. This avoids the
+  // aliasing of bilinear when shrinking; it is the same as bilinear along an
+  // axis that is enlarged.
+  kArea,
+};
+
+// Resizes `src` to the height and width of `dst`, which must have the same
+// format. Planar formats are resized plane by plane.
+Status Resize(const RawImageView& src, ResizeMethod method, RawImage* dst);
+
+// Copies the region of `src` whose top left corner is at row `y` and column
+// `x` into `dst`. The region has the height and width of `dst`, which must
+// have the same format.
+//
+// For NV12 and I420, `y` and `x` must be even.
+Status Crop(const RawImageView& src, int y, int x, RawImage* dst);
+
+// Crops `image` in place to the given region without moving any pixels. The
+// image keeps its buffer, which then has padded rows; call RawImage::Pack if
+// you need them packed.
+//
+// For NV12 and I420, `y` and `x` must be even.
+Status Crop(int y, int x, int height, int width, RawImage* image);
+
+// A sequence of operations to apply to an image with Transform.
+struct ImageTransformOptions {
+  // The region to crop to; it is left alone if `crop_height` or `crop_width`
+  // is zero.
+  int crop_y = 0;
+  int crop_x = 0;
+  int crop_height = 0;
+  int crop_width = 0;
+
+  // The size to resize to after cropping; it is left alone if `resize_height`
+  // or `resize_width` is zero.
+  int resize_height = 0;
+  int resize_width = 0;
+  ResizeMethod resize_method = ResizeMethod::kBilinear;
+
+  // The format to convert to; it is left alone if this is
+  // RAW_IMAGE_FORMAT_UNKNOWN.
+  RawImageFormat format = RAW_IMAGE_FORMAT_UNKNOWN;
+};
+
+// Returns true if the given options would leave every image unchanged.
+bool IsIdentity(const ImageTransformOptions& options);
+
+// Crops, resizes and converts `image` in place as given by `options`.
+//
+// When shrinking, the image is resized before converting so that the
+// conversion touches fewer pixels; otherwise it is converted first.
+Status Transform(const ImageTransformOptions& options, RawImage* image);
+
+// Same as above, but writes the result into `dst` and leaves `src` alone;
+// e.g. to derive images of several sizes from one decoded frame. The first
+// operation reads straight from `src`, which is only copied as a whole if
+// `options` is the identity. `dst` need not be allocated.
+Status Transform(const ImageTransformOptions& options, const RawImageView& src,
+                 RawImage* dst);
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_IMAGE_KERNELS_H_
@@ -0,0 +1,43 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The row kernels of image_kernels vectorized for AVX2.
+//
+// This file is only built with AVX2 enabled on x86; elsewhere the kernels
+// are reported as unavailable.
+
+#include "aistreams/base/util/image_kernels_internal.h"
+
+#if defined(__AVX2__)
+
+#define AIS_IMAGE_KERNELS_ISA avx2
+#define AIS_IMAGE_KERNELS_ISA_ENUM Isa::kAvx2
+#define AIS_IMAGE_KERNELS_ISA_NAME "avx2"
+#include "aistreams/base/util/image_kernels_rows.inc"
+
+#endif  // defined(__AVX2__)
+
+namespace aistreams {
+namespace image_kernels_internal {
+
+const KernelTable* GetAvx2KernelTable() {
+#if defined(__AVX2__)
+  return &avx2::kKernelTable;
+#else
+  return nullptr;
+#endif
+}
+
+}  // namespace image_kernels_internal
+}  // namespace aistreams
@@ -0,0 +1,43 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The row kernels of image_kernels vectorized for AVX-512.
+//
+// This file is only built with AVX-512 (F and BW) enabled on x86; elsewhere
+// the kernels are reported as unavailable.
+
+#include "aistreams/base/util/image_kernels_internal.h"
+
+#if defined(__AVX512BW__)
+
+#define AIS_IMAGE_KERNELS_ISA avx512
+#define AIS_IMAGE_KERNELS_ISA_ENUM Isa::kAvx512
+#define AIS_IMAGE_KERNELS_ISA_NAME "avx512"
+#include "aistreams/base/util/image_kernels_rows.inc"
+
+#endif  // defined(__AVX512BW__)
+
+namespace aistreams {
+namespace image_kernels_internal {
+
+const KernelTable* GetAvx512KernelTable() {
+#if defined(__AVX512BW__)
+  return &avx512::kKernelTable;
+#else
+  return nullptr;
+#endif
+}
+
+}  // namespace image_kernels_internal
+}  // namespace aistreams
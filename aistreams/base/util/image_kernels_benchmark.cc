@@ -0,0 +1,238 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the image kernels on a 1080p frame for each instruction set.
+//
+// The first argument of every benchmark is the image_kernels_internal::Isa;
+// those the CPU does not support are skipped.
+
+#include <algorithm>
+#include <cstring>
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/base/util/image_kernels.h"
+#include "aistreams/base/util/image_kernels_internal.h"
+#include "aistreams/base/util/image_preprocessor.h"
+#include "aistreams/port/benchmark.h"
+
+namespace aistreams {
+
+namespace {
+
+using image_kernels_internal::GetKernelTable;
+using image_kernels_internal::Isa;
+using image_kernels_internal::KernelTable;
+using image_kernels_internal::SetKernelTableForTesting;
+
+constexpr int kHeight = 1080;
+constexpr int kWidth = 1920;
+
+RawImage MakeImage(int height, int width, RawImageFormat format) {
+  RawImage image(height, width, format);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image(i) = static_cast<uint8_t>(i * 7 + i / 4096);
+  }
+  return image;
+}
+
+// Selects the kernels of the benchmarked instruction set for the duration of
+// a benchmark.
+class ScopedKernels {
+ public:
+  explicit ScopedKernels(benchmark::State& state) {
+    const KernelTable* kernels =
+        GetKernelTable(static_cast<Isa>(state.range(0)));
+    if (kernels == nullptr) {
+      state.SkipWithError("Unsupported instruction set");
+      return;
+    }
+    state.SetLabel(kernels->name);
+    SetKernelTableForTesting(kernels);
+    ok_ = true;
+  }
+  ~ScopedKernels() { SetKernelTableForTesting(nullptr); }
+
+  bool ok() const { return ok_; }
+
+ private:
+  bool ok_ = false;
+};
+
+void ForEachIsa(benchmark::internal::Benchmark* b) {
+  for (Isa isa : {Isa::kScalar, Isa::kSse42, Isa::kAvx2, Isa::kAvx512}) {
+    b->Arg(static_cast<int>(isa));
+  }
+}
+
+void RunConvert(RawImageFormat from, RawImageFormat to,
+                benchmark::State& state) {
+  ScopedKernels kernels(state);
+  if (!kernels.ok()) {
+    return;
+  }
+  RawImage src = MakeImage(kHeight, kWidth, from);
+  RawImage dst(kHeight, kWidth, to);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ConvertColor(src, &dst));
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+  state.SetItemsProcessed(state.iterations());
+}
+
+void RunResize(RawImageFormat format, ResizeMethod method, int height,
+               int width, benchmark::State& state) {
+  ScopedKernels kernels(state);
+  if (!kernels.ok()) {
+    return;
+  }
+  RawImage src = MakeImage(kHeight, kWidth, format);
+  RawImage dst(height, width, format);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Resize(src, method, &dst));
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+  state.SetItemsProcessed(state.iterations());
+}
+
+ImagePreprocessor::Options MakePreprocessorOptions() {
+  ImagePreprocessor::Options options;
+  options.height = 224;
+  options.width = 224;
+  options.fit = ImageFit::kLetterbox;
+  options.mean = {123.675f, 116.28f, 103.53f};
+  options.stddev = {58.395f, 57.12f, 57.375f};
+  return options;
+}
+
+}  // namespace
+
+void BM_Nv12ToRgb(benchmark::State& state) {
+  RunConvert(RAW_IMAGE_FORMAT_NV12, RAW_IMAGE_FORMAT_SRGB, state);
+}
+BENCHMARK(BM_Nv12ToRgb)->Apply(ForEachIsa);
+
+void BM_I420ToBgr(benchmark::State& state) {
+  RunConvert(RAW_IMAGE_FORMAT_I420, RAW_IMAGE_FORMAT_BGR, state);
+}
+BENCHMARK(BM_I420ToBgr)->Apply(ForEachIsa);
+
+void BM_RgbToGray(benchmark::State& state) {
+  RunConvert(RAW_IMAGE_FORMAT_SRGB, RAW_IMAGE_FORMAT_GRAY8, state);
+}
+BENCHMARK(BM_RgbToGray)->Apply(ForEachIsa);
+
+void BM_RgbToBgr(benchmark::State& state) {
+  RunConvert(RAW_IMAGE_FORMAT_SRGB, RAW_IMAGE_FORMAT_BGR, state);
+}
+BENCHMARK(BM_RgbToBgr)->Apply(ForEachIsa);
+
+void BM_ResizeBilinearRgb(benchmark::State& state) {
+  RunResize(RAW_IMAGE_FORMAT_SRGB, ResizeMethod::kBilinear, 360, 640, state);
+}
+BENCHMARK(BM_ResizeBilinearRgb)->Apply(ForEachIsa);
+
+void BM_ResizeAreaRgb(benchmark::State& state) {
+  RunResize(RAW_IMAGE_FORMAT_SRGB, ResizeMethod::kArea, 360, 640, state);
+}
+BENCHMARK(BM_ResizeAreaRgb)->Apply(ForEachIsa);
+
+void BM_ResizeAreaNv12(benchmark::State& state) {
+  RunResize(RAW_IMAGE_FORMAT_NV12, ResizeMethod::kArea, 224, 224, state);
+}
+BENCHMARK(BM_ResizeAreaNv12)->Apply(ForEachIsa);
+
+// Letterboxes a 1080p NV12 frame into a normalized 224x224 NCHW tensor.
+void BM_PreprocessNv12(benchmark::State& state) {
+  ScopedKernels kernels(state);
+  if (!kernels.ok()) {
+    return;
+  }
+  auto preprocessor =
+      ImagePreprocessor::Create(MakePreprocessorOptions()).ValueOrDie();
+  RawImage src = MakeImage(kHeight, kWidth, RAW_IMAGE_FORMAT_NV12);
+  Tensor tensor = preprocessor->MakeTensor(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(preprocessor->Process(src, 0, &tensor));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PreprocessNv12)->Apply(ForEachIsa);
+
+// The same as above as separate passes: a resize and a conversion into
+// intermediate images, then normalization and transposition into the tensor.
+void BM_PreprocessNv12Unfused(benchmark::State& state) {
+  ScopedKernels kernels(state);
+  if (!kernels.ok()) {
+    return;
+  }
+  ImagePreprocessor::Options options = MakePreprocessorOptions();
+  RawImage src = MakeImage(kHeight, kWidth, RAW_IMAGE_FORMAT_NV12);
+  Tensor tensor(TENSOR_DATA_TYPE_FLOAT32, {1, 3, 224, 224});
+  for (auto _ : state) {
+    RawImage resized(126, 224, RAW_IMAGE_FORMAT_NV12);
+    benchmark::DoNotOptimize(Resize(src, ResizeMethod::kBilinear, &resized));
+    RawImage rgb(126, 224, RAW_IMAGE_FORMAT_SRGB);
+    benchmark::DoNotOptimize(ConvertColor(resized, &rgb));
+    float* planes = tensor.data_as<float>();
+    std::fill(planes, planes + 3 * 224 * 224, 0.0f);
+    for (int y = 0; y < 126; ++y) {
+      for (int x = 0; x < 224; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          planes[(c * 224 + y + 49) * 224 + x] =
+              (rgb.row(y)[3 * x + c] - options.mean[c]) / options.stddev[c];
+        }
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PreprocessNv12Unfused)->Apply(ForEachIsa);
+
+void BM_CropCopy(benchmark::State& state) {
+  RawImage src = MakeImage(kHeight, kWidth, RAW_IMAGE_FORMAT_SRGB);
+  RawImage dst(kHeight / 2, kWidth / 2, RAW_IMAGE_FORMAT_SRGB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Crop(src, kHeight / 4, kWidth / 4, &dst));
+  }
+  state.SetBytesProcessed(state.iterations() * dst.size());
+}
+BENCHMARK(BM_CropCopy);
+
+void BM_CropInPlace(benchmark::State& state) {
+  RawImage src = MakeImage(kHeight, kWidth, RAW_IMAGE_FORMAT_SRGB);
+  for (auto _ : state) {
+    state.PauseTiming();
+    RawImage image = src;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        Crop(kHeight / 4, kWidth / 4, kHeight / 2, kWidth / 2, &image));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CropInPlace);
+
+void BM_CropView(benchmark::State& state) {
+  RawImageView src(MakeImage(kHeight, kWidth, RAW_IMAGE_FORMAT_SRGB));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        src.Crop(kHeight / 4, kWidth / 4, kHeight / 2, kWidth / 2));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CropView);
+
+}  // namespace aistreams
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_IMAGE_KERNELS_INTERNAL_H_
+#define AISTREAMS_BASE_UTIL_IMAGE_KERNELS_INTERNAL_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace aistreams {
+namespace image_kernels_internal {
+
+// The instruction sets that the row kernels are built for.
+enum class Isa {
+  kScalar = 0,
+  kSse42,
+  kAvx2,
+  kAvx512,
+};
+
+// The fixed point precision of the resampling weights. The weights of each
+// output pixel sum to 1 << kWeightBits.
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+
+// The number of fractional bits kept in the vertically resampled rows.
+constexpr int kIntermediateBits = 7;
+
+// The row kernels for one instruction set.
+//
+// Every kernel processes a single row of `width` pixels. All instruction sets
+// compute exactly the same integer arithmetic, so their results are bit-exact.
+struct KernelTable {
+  Isa isa;
+  const char* name;
+
+  // Converts a row of NV12 (interleaved UV) or I420 (separate U and V) pixels
+  // into interleaved RGB, BGR or RGBA using BT.601 limited range coefficients.
+  void (*nv12_to_rgb)(const uint8_t* y, const uint8_t* uv, int width,
+                      uint8_t* dst);
+  void (*nv12_to_bgr)(const uint8_t* y, const uint8_t* uv, int width,
+                      uint8_t* dst);
+  void (*nv12_to_rgba)(const uint8_t* y, const uint8_t* uv, int width,
+                       uint8_t* dst);
+  void (*i420_to_rgb)(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                      int width, uint8_t* dst);
+  void (*i420_to_bgr)(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                      int width, uint8_t* dst);
+  void (*i420_to_rgba)(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                       int width, uint8_t* dst);
+
+  // Converts a row of RGB, BGR or RGBA pixels to GRAY8 (BT.601 luma).
+  void (*rgb_to_gray)(const uint8_t* src, int width, uint8_t* dst);
+  void (*bgr_to_gray)(const uint8_t* src, int width, uint8_t* dst);
+  void (*rgba_to_gray)(const uint8_t* src, int width, uint8_t* dst);
+
+  // Reorders the channels of a row between RGB, BGR and RGBA. Alpha is
+  // dropped or set to 255.
+  void (*rgb_to_bgr)(const uint8_t* src, int width, uint8_t* dst);
+  void (*rgb_to_rgba)(const uint8_t* src, int width, uint8_t* dst);
+  void (*bgr_to_rgba)(const uint8_t* src, int width, uint8_t* dst);
+  void (*rgba_to_rgb)(const uint8_t* src, int width, uint8_t* dst);
+  void (*rgba_to_bgr)(const uint8_t* src, int width, uint8_t* dst);
+
+  // Combines `taps` source rows of `n` values into one row with the given
+  // weights, keeping kIntermediateBits of fraction in `dst`.
+  void (*resample_vertical)(const uint8_t* const* rows,
+                            const int16_t* weights, int taps, int n,
+                            uint16_t* dst);
+
+  // Resamples a vertically combined row of `channels` interleaved values per
+  // pixel horizontally, rounding to the nearest value.
+  //
+  // Each channel of output pixel x is the sum over t in [0, taps) of
+  // weights[x*taps + t] times that channel of source pixel starts[x] + t.
+  void (*resample_horizontal)(const uint16_t* src, int channels,
+                              const int* starts, const int16_t* weights,
+                              int taps, int width, uint8_t* dst);
+
+  // Picks `channels` of the `src_channels` interleaved values of each pixel
+  // and converts them to floats: channel c of pixel x is
+  // src[x*src_channels + index[c]] * scale[c] + offset[c]. It is written to
+  // dst[c][x] if `planar`, or to dst[0][x*channels + c] otherwise.
+  //
+  // Unlike the other kernels, the results may differ in the last bit between
+  // instruction sets that fuse the multiply and add.
+  void (*normalize_row)(const uint8_t* src, int src_channels,
+                        const int* index, const float* scale,
+                        const float* offset, int channels, bool planar,
+                        int width, float* const* dst);
+
+  // Same as normalize_row, but copies the values as they are.
+  void (*copy_channels)(const uint8_t* src, int src_channels,
+                        const int* index, int channels, bool planar,
+                        int width, uint8_t* const* dst);
+};
+
+// The weights to resample one axis with.
+//
+// Output pixel i is the weighted sum of the `taps` source pixels starting at
+// starts[i], with weights weights[i*taps, (i+1)*taps) that sum to kWeightOne.
+struct AxisWeights {
+  int taps = 0;
+  std::vector<int> starts;
+  std::vector<int16_t> weights;
+};
+
+// Computes bilinear weights, aligning the centers of the corner pixels of the
+// source and output.
+AxisWeights ComputeBilinearWeights(int in, int out);
+
+// Computes area weights when shrinking; each output pixel weighs the source
+// pixels it covers by the overlap. This is bilinear when enlarging.
+AxisWeights ComputeAreaWeights(int in, int out);
+
+// Returns the kernels for the given instruction set, or nullptr if they were
+// not built or the CPU does not support them.
+const KernelTable* GetKernelTable(Isa isa);
+
+// Returns the kernels for the best instruction set the CPU supports.
+//
+// This is decided once and cached.
+const KernelTable& GetBestKernelTable();
+
+// Returns the kernels used by the functions of image_kernels.h. These are the
+// best ones unless overridden by SetKernelTableForTesting.
+const KernelTable& GetActiveKernelTable();
+
+// Makes the functions of image_kernels.h use the given kernels, or the best
+// ones again if given nullptr. This is meant for tests and benchmarks.
+void SetKernelTableForTesting(const KernelTable* kernels);
+
+// The kernels of each instruction set. Those not built for the target
+// architecture return nullptr.
+const KernelTable* GetScalarKernelTable();
+const KernelTable* GetSse42KernelTable();
+const KernelTable* GetAvx2KernelTable();
+const KernelTable* GetAvx512KernelTable();
+
+}  // namespace image_kernels_internal
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_IMAGE_KERNELS_INTERNAL_H_
@@ -0,0 +1,34 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The row kernels of image_kernels without any instruction set extensions.
+//
+// This is the fallback for CPUs (or architectures) that the vectorized
+// kernels do not support, and is built without auto-vectorization so that it
+// also serves as the reference for them.
+
+#include "aistreams/base/util/image_kernels_internal.h"
+
+#define AIS_IMAGE_KERNELS_ISA scalar
+#define AIS_IMAGE_KERNELS_ISA_ENUM Isa::kScalar
+#define AIS_IMAGE_KERNELS_ISA_NAME "scalar"
+#include "aistreams/base/util/image_kernels_rows.inc"
+
+namespace aistreams {
+namespace image_kernels_internal {
+
+const KernelTable* GetScalarKernelTable() { return &scalar::kKernelTable; }
+
+}  // namespace image_kernels_internal
+}  // namespace aistreams
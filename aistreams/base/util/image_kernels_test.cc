@@ -0,0 +1,552 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/image_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/util/image_kernels_internal.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+using image_kernels_internal::GetKernelTable;
+using image_kernels_internal::Isa;
+using image_kernels_internal::KernelTable;
+
+void FillRandom(uint8_t* data, size_t size, int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, 255);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(dist(gen));
+  }
+}
+
+RawImage MakeRandomImage(int height, int width, RawImageFormat format,
+                         int seed) {
+  RawImage image(height, width, format);
+  FillRandom(image.data(), image.size(), seed);
+  return image;
+}
+
+// Returns a copy of `image` whose rows are padded by `padding` bytes.
+RawImage MakePadded(const RawImage& image, int padding) {
+  RawImageDescriptor desc;
+  desc.set_height(image.height());
+  desc.set_width(image.width());
+  desc.set_format(image.format());
+  std::string bytes;
+  for (size_t p = 0; p < image.planes().size(); ++p) {
+    int rows = p == 0 ? image.height() : (image.height() + 1) / 2;
+    int row_size = image.planes()[p].stride;
+    RawImagePlane* plane = desc.add_planes();
+    plane->set_offset(bytes.size());
+    plane->set_stride(row_size + padding);
+    for (int y = 0; y < rows; ++y) {
+      bytes.append(reinterpret_cast<const char*>(image.row(y, p)), row_size);
+      bytes.append(padding, '\x7f');
+    }
+  }
+  return RawImage(desc, std::move(bytes));
+}
+
+// Returns true if the pixels (but not necessarily the layout) are equal.
+bool SamePixels(const RawImage& a, const RawImage& b) {
+  RawImage packed_a = a;
+  RawImage packed_b = b;
+  packed_a.Pack();
+  packed_b.Pack();
+  return packed_a.format() == packed_b.format() &&
+         packed_a.height() == packed_b.height() &&
+         packed_a.width() == packed_b.width() &&
+         packed_a.size() == packed_b.size() &&
+         std::memcmp(packed_a.data(), packed_b.data(), packed_a.size()) == 0;
+}
+
+uint8_t Clamp(int v) {
+  return static_cast<uint8_t>(std::min(255, std::max(0, v)));
+}
+
+// The reference BT.601 limited range conversion of one pixel.
+void ReferenceYuvToRgb(int y, int u, int v, uint8_t* rgb) {
+  int c = 74 * (y - 16);
+  int d = u - 128;
+  int e = v - 128;
+  rgb[0] = Clamp((c + 102 * e + 32) >> 6);
+  rgb[1] = Clamp((c - 25 * d - 52 * e + 32) >> 6);
+  rgb[2] = Clamp((c + 129 * d + 32) >> 6);
+}
+
+std::vector<const KernelTable*> GetSupportedKernelTables() {
+  std::vector<const KernelTable*> tables;
+  for (Isa isa : {Isa::kSse42, Isa::kAvx2, Isa::kAvx512}) {
+    if (GetKernelTable(isa) != nullptr) {
+      tables.push_back(GetKernelTable(isa));
+    }
+  }
+  return tables;
+}
+
+}  // namespace
+
+TEST(ImageKernelsTest, YuvToRgbMatchesReference) {
+  RawImage nv12 = MakeRandomImage(9, 13, RAW_IMAGE_FORMAT_NV12, 1);
+  RawImage i420(9, 13, RAW_IMAGE_FORMAT_I420);
+  for (int y = 0; y < 9; ++y) {
+    std::memcpy(i420.row(y, 0), nv12.row(y, 0), 13);
+  }
+  for (int y = 0; y < 5; ++y) {
+    for (int x = 0; x < 7; ++x) {
+      i420.row(y, 1)[x] = nv12.row(y, 1)[2 * x];
+      i420.row(y, 2)[x] = nv12.row(y, 1)[2 * x + 1];
+    }
+  }
+
+  RawImage expected(9, 13, RAW_IMAGE_FORMAT_SRGB);
+  for (int y = 0; y < 9; ++y) {
+    for (int x = 0; x < 13; ++x) {
+      ReferenceYuvToRgb(nv12.row(y, 0)[x], nv12.row(y / 2, 1)[x / 2 * 2],
+                        nv12.row(y / 2, 1)[x / 2 * 2 + 1],
+                        expected.row(y) + 3 * x);
+    }
+  }
+
+  RawImage rgb(9, 13, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(ConvertColor(nv12, &rgb).ok());
+  EXPECT_TRUE(SamePixels(rgb, expected));
+  RawImage rgb_from_i420(9, 13, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(ConvertColor(i420, &rgb_from_i420).ok());
+  EXPECT_TRUE(SamePixels(rgb_from_i420, expected));
+
+  RawImage bgr(9, 13, RAW_IMAGE_FORMAT_BGR);
+  RawImage rgba(9, 13, RAW_IMAGE_FORMAT_RGBA);
+  ASSERT_TRUE(ConvertColor(nv12, &bgr).ok());
+  ASSERT_TRUE(ConvertColor(i420, &rgba).ok());
+  for (int i = 0; i < 9 * 13; ++i) {
+    EXPECT_EQ(bgr(3 * i), expected(3 * i + 2));
+    EXPECT_EQ(bgr(3 * i + 2), expected(3 * i));
+    EXPECT_EQ(rgba(4 * i), expected(3 * i));
+    EXPECT_EQ(rgba(4 * i + 1), expected(3 * i + 1));
+    EXPECT_EQ(rgba(4 * i + 3), 255);
+  }
+}
+
+TEST(ImageKernelsTest, RgbToGrayMatchesReference) {
+  RawImage rgb = MakeRandomImage(5, 11, RAW_IMAGE_FORMAT_SRGB, 2);
+  RawImage gray(5, 11, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(ConvertColor(rgb, &gray).ok());
+  for (int i = 0; i < 5 * 11; ++i) {
+    EXPECT_EQ(gray(i),
+              (77 * rgb(3 * i) + 150 * rgb(3 * i + 1) + 29 * rgb(3 * i + 2) +
+               128) >> 8);
+  }
+
+  // The same luma results from every channel order.
+  RawImage bgr(5, 11, RAW_IMAGE_FORMAT_BGR);
+  RawImage rgba(5, 11, RAW_IMAGE_FORMAT_RGBA);
+  ASSERT_TRUE(ConvertColor(rgb, &bgr).ok());
+  ASSERT_TRUE(ConvertColor(bgr, &rgba).ok());
+  RawImage gray_from_bgr(5, 11, RAW_IMAGE_FORMAT_GRAY8);
+  RawImage gray_from_rgba(5, 11, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(ConvertColor(bgr, &gray_from_bgr).ok());
+  ASSERT_TRUE(ConvertColor(rgba, &gray_from_rgba).ok());
+  EXPECT_TRUE(SamePixels(gray_from_bgr, gray));
+  EXPECT_TRUE(SamePixels(gray_from_rgba, gray));
+
+  RawImage rgb_again(5, 11, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(ConvertColor(rgba, &rgb_again).ok());
+  EXPECT_TRUE(SamePixels(rgb_again, rgb));
+}
+
+TEST(ImageKernelsTest, ConvertColorErrors) {
+  RawImage gray(4, 4, RAW_IMAGE_FORMAT_GRAY8);
+  RawImage rgb(4, 4, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(ConvertColor(gray, &rgb).code(), StatusCode::kUnimplemented);
+  RawImage nv12(4, 4, RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(ConvertColor(rgb, &nv12).code(), StatusCode::kUnimplemented);
+  RawImage small_rgb(2, 4, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(ConvertColor(nv12, &small_rgb).code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_EQ(ConvertColor(rgb, &rgb).code(), StatusCode::kInvalidArgument);
+}
+
+TEST(ImageKernelsTest, PaddedImages) {
+  RawImage nv12 = MakeRandomImage(6, 10, RAW_IMAGE_FORMAT_NV12, 3);
+  RawImage expected(6, 10, RAW_IMAGE_FORMAT_BGR);
+  ASSERT_TRUE(ConvertColor(nv12, &expected).ok());
+
+  RawImage padded_bgr = MakePadded(RawImage(6, 10, RAW_IMAGE_FORMAT_BGR), 5);
+  ASSERT_TRUE(ConvertColor(MakePadded(nv12, 3), &padded_bgr).ok());
+  EXPECT_TRUE(SamePixels(padded_bgr, expected));
+
+  RawImage resized(3, 5, RAW_IMAGE_FORMAT_NV12);
+  RawImage padded_resized =
+      MakePadded(RawImage(3, 5, RAW_IMAGE_FORMAT_NV12), 7);
+  ASSERT_TRUE(Resize(nv12, ResizeMethod::kArea, &resized).ok());
+  ASSERT_TRUE(
+      Resize(MakePadded(nv12, 3), ResizeMethod::kArea, &padded_resized).ok());
+  EXPECT_TRUE(SamePixels(padded_resized, resized));
+}
+
+TEST(ImageKernelsTest, ResizeSameSizeIsCopy) {
+  RawImage rgb = MakeRandomImage(7, 9, RAW_IMAGE_FORMAT_SRGB, 4);
+  for (ResizeMethod method : {ResizeMethod::kBilinear, ResizeMethod::kArea}) {
+    RawImage resized(7, 9, RAW_IMAGE_FORMAT_SRGB);
+    ASSERT_TRUE(Resize(rgb, method, &resized).ok());
+    EXPECT_TRUE(SamePixels(resized, rgb));
+  }
+}
+
+TEST(ImageKernelsTest, AreaHalvingIsBoxAverage) {
+  RawImage gray = MakeRandomImage(8, 10, RAW_IMAGE_FORMAT_GRAY8, 5);
+  RawImage resized(4, 5, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(Resize(gray, ResizeMethod::kArea, &resized).ok());
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 5; ++x) {
+      int sum = gray.row(2 * y)[2 * x] + gray.row(2 * y)[2 * x + 1] +
+                gray.row(2 * y + 1)[2 * x] + gray.row(2 * y + 1)[2 * x + 1];
+      EXPECT_EQ(resized.row(y)[x], (sum + 2) / 4) << y << ", " << x;
+    }
+  }
+}
+
+TEST(ImageKernelsTest, BilinearInterpolatesBetweenCenters) {
+  RawImage gray(1, 2, RAW_IMAGE_FORMAT_GRAY8);
+  gray(0) = 0;
+  gray(1) = 200;
+  RawImage resized(1, 4, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(Resize(gray, ResizeMethod::kBilinear, &resized).ok());
+  EXPECT_EQ(resized(0), 0);
+  EXPECT_EQ(resized(1), 50);
+  EXPECT_EQ(resized(2), 150);
+  EXPECT_EQ(resized(3), 200);
+
+  // A constant image stays constant at any scale.
+  RawImage flat(5, 7, RAW_IMAGE_FORMAT_RGBA);
+  std::memset(flat.data(), 123, flat.size());
+  for (ResizeMethod method : {ResizeMethod::kBilinear, ResizeMethod::kArea}) {
+    for (int size : {1, 3, 11}) {
+      RawImage flat_resized(size, size + 1, RAW_IMAGE_FORMAT_RGBA);
+      ASSERT_TRUE(Resize(flat, method, &flat_resized).ok());
+      for (size_t i = 0; i < flat_resized.size(); ++i) {
+        ASSERT_EQ(flat_resized(i), 123);
+      }
+    }
+  }
+}
+
+TEST(ImageKernelsTest, ResizeErrors) {
+  RawImage rgb(4, 4, RAW_IMAGE_FORMAT_SRGB);
+  RawImage bgr(2, 2, RAW_IMAGE_FORMAT_BGR);
+  EXPECT_EQ(Resize(rgb, ResizeMethod::kBilinear, &bgr).code(),
+            StatusCode::kInvalidArgument);
+  RawImage empty(0, 0, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(Resize(empty, ResizeMethod::kBilinear, &rgb).code(),
+            StatusCode::kInvalidArgument);
+}
+
+TEST(ImageKernelsTest, CropCopy) {
+  RawImage rgb = MakeRandomImage(6, 8, RAW_IMAGE_FORMAT_SRGB, 6);
+  RawImage cropped(3, 4, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(Crop(rgb, 2, 3, &cropped).ok());
+  for (int y = 0; y < 3; ++y) {
+    EXPECT_EQ(std::memcmp(cropped.row(y), rgb.row(y + 2) + 3 * 3, 3 * 4), 0);
+  }
+
+  RawImage too_big(5, 4, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(Crop(rgb, 2, 3, &too_big).code(), StatusCode::kInvalidArgument);
+  RawImage nv12(6, 8, RAW_IMAGE_FORMAT_NV12);
+  RawImage nv12_cropped(2, 2, RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(Crop(nv12, 1, 2, &nv12_cropped).code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_TRUE(Crop(nv12, 2, 2, &nv12_cropped).ok());
+}
+
+TEST(ImageKernelsTest, CropInPlace) {
+  RawImage i420 = MakeRandomImage(8, 12, RAW_IMAGE_FORMAT_I420, 7);
+  RawImage expected(3, 5, RAW_IMAGE_FORMAT_I420);
+  ASSERT_TRUE(Crop(i420, 4, 6, &expected).ok());
+
+  const uint8_t* data = i420.data();
+  ASSERT_TRUE(Crop(4, 6, 3, 5, &i420).ok());
+  EXPECT_EQ(i420.data(), data);
+  EXPECT_EQ(i420.height(), 3);
+  EXPECT_EQ(i420.width(), 5);
+  EXPECT_EQ(i420.row_stride(), 12);
+  EXPECT_TRUE(SamePixels(i420, expected));
+
+  EXPECT_EQ(Crop(0, 0, 4, 6, &i420).code(), StatusCode::kInvalidArgument);
+}
+
+TEST(ImageKernelsTest, Views) {
+  RawImage nv12 = MakeRandomImage(8, 12, RAW_IMAGE_FORMAT_NV12, 8);
+  RawImage cropped(4, 6, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Crop(nv12, 2, 4, &cropped).ok());
+  RawImageView view = RawImageView(nv12).Crop(2, 4, 4, 6).ValueOrDie();
+
+  // A view of a region is the same as a copy of it.
+  RawImage expected(2, 3, RAW_IMAGE_FORMAT_SRGB);
+  RawImage small(2, 3, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Resize(cropped, ResizeMethod::kArea, &small).ok());
+  ASSERT_TRUE(ConvertColor(small, &expected).ok());
+  RawImage from_view(2, 3, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Resize(view, ResizeMethod::kArea, &from_view).ok());
+  RawImage converted(2, 3, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(ConvertColor(from_view, &converted).ok());
+  EXPECT_TRUE(SamePixels(converted, expected));
+
+  RawImage crop_of_view(2, 2, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Crop(view, 2, 2, &crop_of_view).ok());
+  RawImage crop_of_copy(2, 2, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Crop(cropped, 2, 2, &crop_of_copy).ok());
+  EXPECT_TRUE(SamePixels(crop_of_view, crop_of_copy));
+
+  // A view of the destination is rejected.
+  EXPECT_EQ(Crop(RawImageView(cropped), 0, 0, &cropped).code(),
+            StatusCode::kInvalidArgument);
+}
+
+TEST(ImageKernelsTest, Transform) {
+  RawImage nv12 = MakeRandomImage(48, 64, RAW_IMAGE_FORMAT_NV12, 8);
+
+  ImageTransformOptions options;
+  EXPECT_TRUE(IsIdentity(options));
+  options.crop_y = 8;
+  options.crop_x = 16;
+  options.crop_height = 32;
+  options.crop_width = 32;
+  options.resize_height = 16;
+  options.resize_width = 16;
+  options.resize_method = ResizeMethod::kArea;
+  options.format = RAW_IMAGE_FORMAT_SRGB;
+  EXPECT_FALSE(IsIdentity(options));
+
+  // Shrinking resizes the NV12 image before converting it.
+  RawImage cropped(32, 32, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Crop(nv12, 8, 16, &cropped).ok());
+  RawImage resized(16, 16, RAW_IMAGE_FORMAT_NV12);
+  ASSERT_TRUE(Resize(cropped, ResizeMethod::kArea, &resized).ok());
+  RawImage expected(16, 16, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(ConvertColor(resized, &expected).ok());
+
+  ASSERT_TRUE(Transform(options, &nv12).ok());
+  EXPECT_TRUE(SamePixels(nv12, expected));
+
+  // Enlarging converts first.
+  RawImage gray = MakeRandomImage(4, 4, RAW_IMAGE_FORMAT_SRGB, 9);
+  ImageTransformOptions enlarge;
+  enlarge.resize_height = 8;
+  enlarge.resize_width = 8;
+  enlarge.format = RAW_IMAGE_FORMAT_GRAY8;
+  RawImage converted(4, 4, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(ConvertColor(gray, &converted).ok());
+  RawImage enlarged(8, 8, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(Resize(converted, ResizeMethod::kBilinear, &enlarged).ok());
+  ASSERT_TRUE(Transform(enlarge, &gray).ok());
+  EXPECT_TRUE(SamePixels(gray, enlarged));
+}
+
+TEST(ImageKernelsTest, TransformIntoAnotherImage) {
+  RawImage nv12 = MakeRandomImage(48, 64, RAW_IMAGE_FORMAT_NV12, 10);
+  RawImage original = nv12;
+
+  ImageTransformOptions shrink;
+  shrink.crop_y = 8;
+  shrink.crop_x = 16;
+  shrink.crop_height = 32;
+  shrink.crop_width = 32;
+  shrink.resize_height = 16;
+  shrink.resize_width = 16;
+  shrink.format = RAW_IMAGE_FORMAT_SRGB;
+  ImageTransformOptions enlarge;
+  enlarge.resize_height = 96;
+  enlarge.resize_width = 128;
+  enlarge.format = RAW_IMAGE_FORMAT_RGBA;
+  ImageTransformOptions identity;
+
+  // Each gives the same pixels as the in-place Transform, and the source is
+  // left alone.
+  for (const auto& options : {shrink, enlarge, identity}) {
+    RawImage dst;
+    ASSERT_TRUE(Transform(options, nv12, &dst).ok());
+    RawImage expected = original;
+    ASSERT_TRUE(Transform(options, &expected).ok());
+    EXPECT_TRUE(SamePixels(dst, expected));
+    EXPECT_TRUE(SamePixels(nv12, original));
+  }
+
+  // Regions of padded images are accepted.
+  RawImage padded = MakePadded(original, 5);
+  RawImage from_padded;
+  ASSERT_TRUE(Transform(shrink, padded, &from_padded).ok());
+  RawImage expected = original;
+  ASSERT_TRUE(Transform(shrink, &expected).ok());
+  EXPECT_TRUE(SamePixels(from_padded, expected));
+
+  shrink.crop_x = 15;
+  EXPECT_FALSE(Transform(shrink, nv12, &from_padded).ok());
+}
+
+TEST(ImageKernelsTest, VectorizedKernelsAreBitExact) {
+  const KernelTable* scalar = GetKernelTable(Isa::kScalar);
+  ASSERT_NE(scalar, nullptr);
+  for (const KernelTable* kernels : GetSupportedKernelTables()) {
+    for (int width : {1, 2, 15, 16, 17, 255, 256, 257, 1001}) {
+      SCOPED_TRACE(std::string(kernels->name) + " " + std::to_string(width));
+      std::vector<uint8_t> src(4 * width + 8);
+      FillRandom(src.data(), src.size(), width);
+      const uint8_t* y = src.data();
+      const uint8_t* u = src.data() + width;
+      const uint8_t* v = src.data() + 2 * width;
+      std::vector<uint8_t> expected(4 * width);
+      std::vector<uint8_t> actual(4 * width);
+
+      auto check_pixels = [&](void (*want)(const uint8_t*, int, uint8_t*),
+                              void (*got)(const uint8_t*, int, uint8_t*)) {
+        want(src.data(), width, expected.data());
+        got(src.data(), width, actual.data());
+        EXPECT_EQ(expected, actual);
+      };
+      check_pixels(scalar->rgb_to_gray, kernels->rgb_to_gray);
+      check_pixels(scalar->bgr_to_gray, kernels->bgr_to_gray);
+      check_pixels(scalar->rgba_to_gray, kernels->rgba_to_gray);
+      check_pixels(scalar->rgb_to_bgr, kernels->rgb_to_bgr);
+      check_pixels(scalar->rgb_to_rgba, kernels->rgb_to_rgba);
+      check_pixels(scalar->bgr_to_rgba, kernels->bgr_to_rgba);
+      check_pixels(scalar->rgba_to_rgb, kernels->rgba_to_rgb);
+      check_pixels(scalar->rgba_to_bgr, kernels->rgba_to_bgr);
+
+      auto check_nv12 =
+          [&](void (*want)(const uint8_t*, const uint8_t*, int, uint8_t*),
+              void (*got)(const uint8_t*, const uint8_t*, int, uint8_t*)) {
+            want(y, u, width, expected.data());
+            got(y, u, width, actual.data());
+            EXPECT_EQ(expected, actual);
+          };
+      check_nv12(scalar->nv12_to_rgb, kernels->nv12_to_rgb);
+      check_nv12(scalar->nv12_to_bgr, kernels->nv12_to_bgr);
+      check_nv12(scalar->nv12_to_rgba, kernels->nv12_to_rgba);
+
+      auto check_i420 = [&](void (*want)(const uint8_t*, const uint8_t*,
+                                         const uint8_t*, int, uint8_t*),
+                            void (*got)(const uint8_t*, const uint8_t*,
+                                        const uint8_t*, int, uint8_t*)) {
+        want(y, u, v, width, expected.data());
+        got(y, u, v, width, actual.data());
+        EXPECT_EQ(expected, actual);
+      };
+      check_i420(scalar->i420_to_rgb, kernels->i420_to_rgb);
+      check_i420(scalar->i420_to_bgr, kernels->i420_to_bgr);
+      check_i420(scalar->i420_to_rgba, kernels->i420_to_rgba);
+
+      // Three taps of uneven weights per output pixel.
+      int out_width = (width + 1) / 2;
+      std::vector<int> starts(out_width);
+      std::vector<int16_t> weights(3 * out_width);
+      for (int x = 0; x < out_width; ++x) {
+        starts[x] = std::min(2 * x, std::max(0, width - 3));
+        weights[3 * x] = 4000;
+        weights[3 * x + 1] = 8000;
+        weights[3 * x + 2] = 4384;
+      }
+      const uint8_t* taps[3] = {y, u, v};
+      std::vector<uint16_t> want_row(width);
+      std::vector<uint16_t> got_row(width);
+      scalar->resample_vertical(taps, weights.data(), 3, width,
+                                want_row.data());
+      kernels->resample_vertical(taps, weights.data(), 3, width,
+                                 got_row.data());
+      EXPECT_EQ(want_row, got_row);
+
+      if (width >= 12) {
+        // Values just under the largest vertically combined value.
+        std::vector<uint16_t> row(width);
+        for (int i = 0; i < width; ++i) {
+          row[i] = static_cast<uint16_t>(32640 - src[i]);
+        }
+        for (int channels = 1; channels <= 4; ++channels) {
+          // Keeps starts[x] = 2x for every output pixel.
+          int out_pixels = (width / channels - 1) / 2;
+          std::fill(expected.begin(), expected.end(), 0);
+          std::fill(actual.begin(), actual.end(), 0);
+          scalar->resample_horizontal(row.data(), channels, starts.data(),
+                                      weights.data(), 3, out_pixels,
+                                      expected.data());
+          kernels->resample_horizontal(row.data(), channels, starts.data(),
+                                       weights.data(), 3, out_pixels,
+                                       actual.data());
+          EXPECT_EQ(expected, actual);
+        }
+      }
+    }
+  }
+}
+
+TEST(ImageKernelsTest, VectorizedNormalizationMatches) {
+  const KernelTable* scalar = GetKernelTable(Isa::kScalar);
+  ASSERT_NE(scalar, nullptr);
+  const int kIndex[] = {2, 1, 0};
+  const float kScale[] = {0.017f, 0.0175f, 0.0174f};
+  const float kOffset[] = {-2.1f, -2.03f, -1.8f};
+  for (const KernelTable* kernels : GetSupportedKernelTables()) {
+    for (int width : {1, 15, 16, 17, 257}) {
+      for (int src_channels : {3, 4}) {
+        for (bool planar : {true, false}) {
+          SCOPED_TRACE(std::string(kernels->name) + " " +
+                       std::to_string(width) + " " +
+                       std::to_string(src_channels) +
+                       (planar ? " planar" : ""));
+          std::vector<uint8_t> src(src_channels * width);
+          FillRandom(src.data(), src.size(), width);
+
+          std::vector<float> want(3 * width);
+          std::vector<float> got(3 * width);
+          float* want_dst[] = {&want[0], &want[width], &want[2 * width]};
+          float* got_dst[] = {&got[0], &got[width], &got[2 * width]};
+          scalar->normalize_row(src.data(), src_channels, kIndex, kScale,
+                                kOffset, 3, planar, width, want_dst);
+          kernels->normalize_row(src.data(), src_channels, kIndex, kScale,
+                                 kOffset, 3, planar, width, got_dst);
+          for (int i = 0; i < 3 * width; ++i) {
+            EXPECT_NEAR(want[i], got[i], 1e-6);
+          }
+
+          std::vector<uint8_t> want_bytes(3 * width);
+          std::vector<uint8_t> got_bytes(3 * width);
+          uint8_t* want_bytes_dst[] = {&want_bytes[0], &want_bytes[width],
+                                       &want_bytes[2 * width]};
+          uint8_t* got_bytes_dst[] = {&got_bytes[0], &got_bytes[width],
+                                      &got_bytes[2 * width]};
+          scalar->copy_channels(src.data(), src_channels, kIndex, 3, planar,
+                                width, want_bytes_dst);
+          kernels->copy_channels(src.data(), src_channels, kIndex, 3, planar,
+                                 width, got_bytes_dst);
+          EXPECT_EQ(want_bytes, got_bytes);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace aistreams
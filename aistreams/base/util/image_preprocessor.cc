@@ -0,0 +1,469 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/image_preprocessor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "aistreams/base/types/raw_image_helpers.h"
+#include "aistreams/base/types/tensor_helpers.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace {
+
+using image_kernels_internal::AxisWeights;
+using image_kernels_internal::ComputeAreaWeights;
+using image_kernels_internal::ComputeBilinearWeights;
+using image_kernels_internal::GetActiveKernelTable;
+using image_kernels_internal::KernelTable;
+
+bool IsYuv(RawImageFormat format) {
+  return format == RAW_IMAGE_FORMAT_NV12 || format == RAW_IMAGE_FORMAT_I420;
+}
+
+bool IsSupportedImageFormat(RawImageFormat format) {
+  switch (format) {
+    case RAW_IMAGE_FORMAT_SRGB:
+    case RAW_IMAGE_FORMAT_BGR:
+    case RAW_IMAGE_FORMAT_RGBA:
+    case RAW_IMAGE_FORMAT_GRAY8:
+    case RAW_IMAGE_FORMAT_NV12:
+    case RAW_IMAGE_FORMAT_I420:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns num / den rounded to the nearest integer, for positive values.
+int RoundedDivide(int64_t num, int64_t den) {
+  return static_cast<int>((2 * num + den) / (2 * den));
+}
+
+AxisWeights ComputeWeights(ResizeMethod method, int in, int out) {
+  if (method == ResizeMethod::kArea) {
+    return ComputeAreaWeights(in, out);
+  }
+  return ComputeBilinearWeights(in, out);
+}
+
+// Resamples output row i from the `values` interleaved values per row of the
+// source rows at `src`, which are `stride` bytes apart.
+void ResampleRow(const KernelTable& kernels, const AxisWeights& y_axis,
+                 const AxisWeights& x_axis, int i, const uint8_t* src,
+                 int stride, int values, int channels, int width,
+                 const uint8_t** taps, uint16_t* vertical_row, uint8_t* dst) {
+  for (int t = 0; t < y_axis.taps; ++t) {
+    taps[t] = src + static_cast<size_t>(y_axis.starts[i] + t) * stride;
+  }
+  kernels.resample_vertical(
+      taps, &y_axis.weights[static_cast<size_t>(i) * y_axis.taps],
+      y_axis.taps, values, vertical_row);
+  kernels.resample_horizontal(vertical_row, channels, x_axis.starts.data(),
+                              x_axis.weights.data(), x_axis.taps, width, dst);
+}
+
+using GrayRowFn = void (*)(const uint8_t*, int, uint8_t*);
+
+GrayRowFn GetGrayRowFn(const KernelTable& kernels, RawImageFormat format) {
+  switch (format) {
+    case RAW_IMAGE_FORMAT_SRGB:
+      return kernels.rgb_to_gray;
+    case RAW_IMAGE_FORMAT_BGR:
+      return kernels.bgr_to_gray;
+    case RAW_IMAGE_FORMAT_RGBA:
+      return kernels.rgba_to_gray;
+    default:
+      return nullptr;
+  }
+}
+
+// Gets the index of each tensor channel within a pixel of the given
+// interleaved format.
+void GetChannelIndex(RawImageFormat row_format, RawImageFormat color_format,
+                     int* index) {
+  if (color_format == RAW_IMAGE_FORMAT_GRAY8) {
+    index[0] = 0;
+    return;
+  }
+  if (row_format == RAW_IMAGE_FORMAT_GRAY8) {
+    index[0] = index[1] = index[2] = 0;
+    return;
+  }
+  int red = row_format == RAW_IMAGE_FORMAT_BGR ? 2 : 0;
+  bool swap = color_format == RAW_IMAGE_FORMAT_BGR;
+  index[0] = swap ? 2 - red : red;
+  index[1] = 1;
+  index[2] = swap ? red : 2 - red;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<ImagePreprocessor>> ImagePreprocessor::Create(
+    const Options& options) {
+  auto preprocessor = std::make_unique<ImagePreprocessor>(options);
+  AIS_RETURN_IF_ERROR(preprocessor->Initialize());
+  return preprocessor;
+}
+
+ImagePreprocessor::ImagePreprocessor(const Options& options)
+    : options_(options) {}
+
+Status ImagePreprocessor::Initialize() {
+  if (options_.height <= 0 || options_.width <= 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a non-positive tensor height (%d) or width (%d)",
+        options_.height, options_.width));
+  }
+  switch (options_.color_format) {
+    case RAW_IMAGE_FORMAT_SRGB:
+    case RAW_IMAGE_FORMAT_BGR:
+      channels_ = 3;
+      break;
+    case RAW_IMAGE_FORMAT_GRAY8:
+      channels_ = 1;
+      break;
+    default:
+      return InvalidArgumentError(absl::StrFormat(
+          "Given an unsupported tensor color format (%s)",
+          RawImageFormat_Name(options_.color_format)));
+  }
+  if (options_.dtype != TENSOR_DATA_TYPE_FLOAT32 &&
+      options_.dtype != TENSOR_DATA_TYPE_UINT8) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given an unsupported tensor data type (%s)",
+                        TensorDataType_Name(options_.dtype)));
+  }
+
+  auto per_channel = [this](const std::vector<float>& values,
+                            const char* name) -> StatusOr<std::vector<float>> {
+    if (values.size() == 1) {
+      return std::vector<float>(channels_, values[0]);
+    }
+    if (static_cast<int>(values.size()) != channels_) {
+      return InvalidArgumentError(
+          absl::StrFormat("Given %d %s values for %d channels", values.size(),
+                          name, channels_));
+    }
+    return values;
+  };
+  AIS_ASSIGN_OR_RETURN(std::vector<float> mean,
+                       per_channel(options_.mean, "mean"));
+  AIS_ASSIGN_OR_RETURN(std::vector<float> stddev,
+                       per_channel(options_.stddev, "stddev"));
+  for (int c = 0; c < channels_; ++c) {
+    if (stddev[c] == 0.0f) {
+      return InvalidArgumentError("Given a stddev of zero");
+    }
+    if (options_.dtype == TENSOR_DATA_TYPE_UINT8 &&
+        (mean[c] != 0.0f || stddev[c] != 1.0f)) {
+      return InvalidArgumentError(
+          "Normalization requires a FLOAT32 tensor; UINT8 tensors hold the "
+          "pixel values as they are");
+    }
+    scale_.push_back(1.0f / stddev[c]);
+    offset_.push_back(-mean[c] / stddev[c]);
+  }
+
+  // Every channel of the padding as the bytes of one tensor element.
+  int element_size = GetDataTypeSize(options_.dtype);
+  pad_.resize(static_cast<size_t>(channels_) * element_size);
+  for (int c = 0; c < channels_; ++c) {
+    if (options_.dtype == TENSOR_DATA_TYPE_FLOAT32) {
+      float value = options_.pad_value * scale_[c] + offset_[c];
+      std::memcpy(&pad_[c * element_size], &value, element_size);
+    } else {
+      pad_[c] = options_.pad_value;
+    }
+  }
+  return OkStatus();
+}
+
+std::vector<int64_t> ImagePreprocessor::GetShape(int batch_size) const {
+  if (options_.layout == TensorLayout::kNchw) {
+    return {batch_size, channels_, options_.height, options_.width};
+  }
+  return {batch_size, options_.height, options_.width, channels_};
+}
+
+Tensor ImagePreprocessor::MakeTensor(int batch_size) const {
+  return Tensor(options_.dtype, GetShape(batch_size));
+}
+
+ImagePreprocessor::Placement ImagePreprocessor::GetPlacement(
+    int height, int width, RawImageFormat format) const {
+  Placement placement;
+  placement.src_height = height;
+  placement.src_width = width;
+  placement.dst_height = options_.height;
+  placement.dst_width = options_.width;
+  if (height <= 0 || width <= 0) {
+    return placement;
+  }
+
+  // The image is wider than the tensor if width/height > W/H.
+  int64_t image_aspect = static_cast<int64_t>(width) * options_.height;
+  int64_t tensor_aspect = static_cast<int64_t>(height) * options_.width;
+  switch (options_.fit) {
+    case ImageFit::kStretch:
+      break;
+    case ImageFit::kLetterbox:
+      if (image_aspect >= tensor_aspect) {
+        placement.dst_height = std::max(
+            1, std::min(options_.height,
+                        RoundedDivide(static_cast<int64_t>(height) *
+                                          options_.width,
+                                      width)));
+      } else {
+        placement.dst_width = std::max(
+            1, std::min(options_.width,
+                        RoundedDivide(static_cast<int64_t>(width) *
+                                          options_.height,
+                                      height)));
+      }
+      placement.dst_y = (options_.height - placement.dst_height) / 2;
+      placement.dst_x = (options_.width - placement.dst_width) / 2;
+      break;
+    case ImageFit::kCenterCrop:
+      if (image_aspect > tensor_aspect) {
+        placement.src_width = std::max(
+            1, std::min(width, RoundedDivide(static_cast<int64_t>(height) *
+                                                 options_.width,
+                                             options_.height)));
+      } else {
+        placement.src_height = std::max(
+            1, std::min(height, RoundedDivide(static_cast<int64_t>(width) *
+                                                  options_.height,
+                                              options_.width)));
+      }
+      placement.src_y = (height - placement.src_height) / 2;
+      placement.src_x = (width - placement.src_width) / 2;
+      // Subsampled chroma can only be cropped at even rows and columns.
+      if (IsYuv(format)) {
+        placement.src_y &= ~1;
+        placement.src_x &= ~1;
+      }
+      break;
+  }
+  return placement;
+}
+
+void ImagePreprocessor::UpdatePlan(const RawImageView& image) {
+  if (plan_.height == image.height() && plan_.width == image.width() &&
+      plan_.format == image.format()) {
+    return;
+  }
+  plan_ = Plan();
+  plan_.height = image.height();
+  plan_.width = image.width();
+  plan_.format = image.format();
+  plan_.placement = GetPlacement(image.height(), image.width(), image.format());
+
+  const Placement& p = plan_.placement;
+  ResizeMethod method = options_.resize_method;
+  plan_.x_axis = ComputeWeights(method, p.src_width, p.dst_width);
+  plan_.y_axis = ComputeWeights(method, p.src_height, p.dst_height);
+  int taps = plan_.y_axis.taps;
+  size_t vertical_values = static_cast<size_t>(p.src_width) *
+                           (IsYuv(image.format()) ? 1 : image.channels());
+
+  // Chroma is resampled to half the output height and width, as if the
+  // subsampled image were resized, and each chroma row serves two output rows.
+  if (IsYuv(image.format()) && channels_ == 3) {
+    int chroma_width = (p.dst_width + 1) / 2;
+    plan_.chroma_x_axis =
+        ComputeWeights(method, (p.src_width + 1) / 2, chroma_width);
+    plan_.chroma_y_axis = ComputeWeights(method, (p.src_height + 1) / 2,
+                                         (p.dst_height + 1) / 2);
+    taps = std::max(taps, plan_.chroma_y_axis.taps);
+    vertical_values = std::max<size_t>(vertical_values, p.src_width + 1);
+    plan_.chroma_row.resize(2 * chroma_width);
+    plan_.chroma_row2.resize(chroma_width);
+  }
+  plan_.taps.resize(taps);
+  plan_.vertical_row.resize(vertical_values);
+  plan_.row.resize(static_cast<size_t>(p.dst_width) * 4);
+  plan_.color_row.resize(static_cast<size_t>(p.dst_width) * 3);
+}
+
+StatusOr<Tensor> ImagePreprocessor::Process(const RawImageView& image) {
+  Tensor tensor = MakeTensor(1);
+  AIS_RETURN_IF_ERROR(Process(image, 0, &tensor));
+  return tensor;
+}
+
+Status ImagePreprocessor::Process(const RawImageView& image, int index,
+                                  Tensor* batch) {
+  if (batch == nullptr) {
+    return InvalidArgumentError("Given a null tensor");
+  }
+  if (!IsSupportedImageFormat(image.format())) {
+    return UnimplementedError(
+        absl::StrFormat("Preprocessing a %s image is not supported",
+                        RawImageFormat_Name(image.format())));
+  }
+  if (image.height() == 0 || image.width() == 0) {
+    return InvalidArgumentError("Cannot preprocess an empty image");
+  }
+  std::vector<int64_t> shape = GetShape(batch->rank() > 0 ? batch->dim(0) : 0);
+  if (batch->dtype() != options_.dtype || batch->shape() != shape ||
+      index < 0 || index >= shape[0]) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a %s tensor of shape [%s] for element %d of a %s batch of "
+        "shape [N, %s]",
+        TensorDataType_Name(batch->dtype()),
+        absl::StrJoin(batch->shape(), ", "), index,
+        TensorDataType_Name(options_.dtype),
+        absl::StrJoin(shape.begin() + 1, shape.end(), ", ")));
+  }
+  int element_size = GetDataTypeSize(options_.dtype);
+  bool planar = options_.layout == TensorLayout::kNchw;
+  const std::vector<int64_t>& strides = batch->strides();
+  if (strides[3] != element_size ||
+      (!planar && strides[2] != channels_ * element_size)) {
+    return InvalidArgumentError(
+        "Given a tensor whose pixels are not dense");
+  }
+
+  UpdatePlan(image);
+  const KernelTable& kernels = GetActiveKernelTable();
+  const Placement& p = plan_.placement;
+  uint8_t* base = batch->data() + index * strides[0];
+
+  // Points `row` at the first pixel of tensor row y.
+  uint8_t* row[3] = {nullptr, nullptr, nullptr};
+  auto get_row = [&](int y) {
+    for (int c = 0; c < (planar ? channels_ : 1); ++c) {
+      row[c] = base + c * (planar ? strides[1] : 0) +
+               y * (planar ? strides[2] : strides[1]);
+    }
+  };
+  int pixel_size = (planar ? 1 : channels_) * element_size;
+  auto fill = [&](int x, int count) {
+    if (count <= 0) {
+      return;
+    }
+    // Write one pixel, then keep doubling the filled span.
+    size_t size = static_cast<size_t>(count) * pixel_size;
+    for (int c = 0; c < (planar ? channels_ : 1); ++c) {
+      uint8_t* dst = row[c] + x * pixel_size;
+      std::memcpy(dst, &pad_[c * element_size], pixel_size);
+      for (size_t filled = pixel_size; filled < size; filled *= 2) {
+        std::memcpy(dst + filled, dst, std::min(filled, size - filled));
+      }
+    }
+  };
+
+  for (int y = 0; y < options_.height; ++y) {
+    get_row(y);
+    int i = y - p.dst_y;
+    if (i < 0 || i >= p.dst_height) {
+      fill(0, options_.width);
+      continue;
+    }
+    fill(0, p.dst_x);
+    fill(p.dst_x + p.dst_width, options_.width - p.dst_x - p.dst_width);
+
+    // Resample the source rows into one output row of `row_format`.
+    const uint8_t* pixels = plan_.row.data();
+    RawImageFormat row_format = image.format();
+    const uint8_t** taps = plan_.taps.data();
+    uint16_t* vertical_row = plan_.vertical_row.data();
+    if (IsYuv(image.format())) {
+      ResampleRow(kernels, plan_.y_axis, plan_.x_axis, i,
+                  image.row(p.src_y, 0) + p.src_x, image.planes()[0].stride,
+                  p.src_width, 1, p.dst_width, taps, vertical_row,
+                  plan_.row.data());
+      row_format = RAW_IMAGE_FORMAT_GRAY8;
+      if (channels_ == 3) {
+        int chroma_values = (p.src_width + 1) / 2;
+        int chroma_width = (p.dst_width + 1) / 2;
+        bool nv12 = image.format() == RAW_IMAGE_FORMAT_NV12;
+        if (i % 2 == 0) {
+          if (nv12) {
+            ResampleRow(kernels, plan_.chroma_y_axis, plan_.chroma_x_axis,
+                        i / 2, image.row(p.src_y / 2, 1) + p.src_x,
+                        image.planes()[1].stride, 2 * chroma_values, 2,
+                        chroma_width, taps, vertical_row,
+                        plan_.chroma_row.data());
+          } else {
+            ResampleRow(kernels, plan_.chroma_y_axis, plan_.chroma_x_axis,
+                        i / 2, image.row(p.src_y / 2, 1) + p.src_x / 2,
+                        image.planes()[1].stride, chroma_values, 1,
+                        chroma_width, taps, vertical_row,
+                        plan_.chroma_row.data());
+            ResampleRow(kernels, plan_.chroma_y_axis, plan_.chroma_x_axis,
+                        i / 2, image.row(p.src_y / 2, 2) + p.src_x / 2,
+                        image.planes()[2].stride, chroma_values, 1,
+                        chroma_width, taps, vertical_row,
+                        plan_.chroma_row2.data());
+          }
+        }
+        if (nv12) {
+          kernels.nv12_to_rgb(plan_.row.data(), plan_.chroma_row.data(),
+                              p.dst_width, plan_.color_row.data());
+        } else {
+          kernels.i420_to_rgb(plan_.row.data(), plan_.chroma_row.data(),
+                              plan_.chroma_row2.data(), p.dst_width,
+                              plan_.color_row.data());
+        }
+        pixels = plan_.color_row.data();
+        row_format = RAW_IMAGE_FORMAT_SRGB;
+      }
+    } else {
+      int src_channels = image.channels();
+      ResampleRow(kernels, plan_.y_axis, plan_.x_axis, i,
+                  image.row(p.src_y) + p.src_x * src_channels,
+                  image.row_stride(), p.src_width * src_channels,
+                  src_channels, p.dst_width, taps, vertical_row,
+                  plan_.row.data());
+      if (channels_ == 1 && image.format() != RAW_IMAGE_FORMAT_GRAY8) {
+        GetGrayRowFn(kernels, image.format())(plan_.row.data(), p.dst_width,
+                                              plan_.color_row.data());
+        pixels = plan_.color_row.data();
+        row_format = RAW_IMAGE_FORMAT_GRAY8;
+      }
+    }
+
+    // Write the channels of the tensor, starting at column dst_x.
+    int index_in_pixel[3];
+    GetChannelIndex(row_format, options_.color_format, index_in_pixel);
+    int row_channels = GetNumChannels(row_format);
+    for (int c = 0; c < (planar ? channels_ : 1); ++c) {
+      row[c] += p.dst_x * pixel_size;
+    }
+    if (options_.dtype == TENSOR_DATA_TYPE_FLOAT32) {
+      float* dst[3];
+      for (int c = 0; c < 3; ++c) {
+        dst[c] = reinterpret_cast<float*>(row[c]);
+      }
+      kernels.normalize_row(pixels, row_channels, index_in_pixel,
+                            scale_.data(), offset_.data(), channels_, planar,
+                            p.dst_width, dst);
+    } else {
+      kernels.copy_channels(pixels, row_channels, index_in_pixel, channels_,
+                            planar, p.dst_width, row);
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace aistreams
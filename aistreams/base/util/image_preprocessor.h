@@ -0,0 +1,186 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_IMAGE_PREPROCESSOR_H_
+#define AISTREAMS_BASE_UTIL_IMAGE_PREPROCESSOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_view.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/base/util/image_kernels.h"
+#include "aistreams/base/util/image_kernels_internal.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+#include "aistreams/proto/types/tensor.pb.h"
+
+namespace aistreams {
+
+// How an image is fit into the height and width of a tensor.
+enum class ImageFit {
+  // Resizes the whole image to the tensor, ignoring its aspect ratio.
+  kStretch = 0,
+
+  // Resizes the whole image keeping its aspect ratio, centered in the tensor,
+  // and pads the remaining rows or columns.
+  kLetterbox,
+
+  // Crops the center of the image to the aspect ratio of the tensor, then
+  // resizes it to the tensor.
+  kCenterCrop,
+};
+
+// The order of the dimensions of a preprocessed tensor.
+enum class TensorLayout {
+  // [batch, channels, height, width].
+  kNchw = 0,
+
+  // [batch, height, width, channels].
+  kNhwc,
+};
+
+// An ImagePreprocessor turns RawImages into the input tensors of a model.
+//
+// Cropping, resizing, letterboxing, colorspace conversion, normalization and
+// the transposition to planar channels are fused into a single pass over
+// each output row, using the vectorized kernels of image_kernels.h. No
+// intermediate image is made; only a few rows are staged.
+//
+// Images may be in any format of image_kernels.h, padded or not. Tensors hold
+// one or more images along their first dimension.
+//
+// An ImagePreprocessor caches the resampling weights for the last image
+// geometry it saw. It is not thread-safe.
+class ImagePreprocessor {
+ public:
+  // Options to configure the ImagePreprocessor.
+  struct Options {
+    // The height and width of each image in the tensor.
+    int height = 0;
+    int width = 0;
+
+    // How the image is fit into `height` and `width`.
+    ImageFit fit = ImageFit::kStretch;
+
+    // The interpolation used to resize the image.
+    ResizeMethod resize_method = ResizeMethod::kBilinear;
+
+    // The channels of the tensor: RAW_IMAGE_FORMAT_SRGB or
+    // RAW_IMAGE_FORMAT_BGR for three channels in that order, or
+    // RAW_IMAGE_FORMAT_GRAY8 for luma only.
+    RawImageFormat color_format = RAW_IMAGE_FORMAT_SRGB;
+
+    // The order of the tensor dimensions.
+    TensorLayout layout = TensorLayout::kNchw;
+
+    // The data type of the tensor: TENSOR_DATA_TYPE_FLOAT32, or
+    // TENSOR_DATA_TYPE_UINT8 for the pixel values as they are.
+    TensorDataType dtype = TENSOR_DATA_TYPE_FLOAT32;
+
+    // Each channel c of a FLOAT32 tensor is (value - mean[c]) / stddev[c],
+    // where value is the 8-bit pixel value in [0, 255]. The entries are in
+    // the order of `color_format`; a single entry applies to every channel.
+    //
+    // E.g. use a mean of 0 and stddev of 255 for values in [0, 1].
+    std::vector<float> mean = {0.0f};
+    std::vector<float> stddev = {1.0f};
+
+    // The pixel value of the padding added by kLetterbox, before
+    // normalization.
+    uint8_t pad_value = 0;
+  };
+
+  // The placement of an image in the tensor.
+  struct Placement {
+    // The region of the image that is used.
+    int src_y = 0;
+    int src_x = 0;
+    int src_height = 0;
+    int src_width = 0;
+
+    // The region of the tensor that it is resized to; the rest is padding.
+    int dst_y = 0;
+    int dst_x = 0;
+    int dst_height = 0;
+    int dst_width = 0;
+  };
+
+  // Creates an ImagePreprocessor, validating the given options.
+  static StatusOr<std::unique_ptr<ImagePreprocessor>> Create(const Options&);
+
+  // Returns the number of channels of the tensor.
+  int channels() const { return channels_; }
+
+  // Returns the shape of a tensor holding `batch_size` images.
+  std::vector<int64_t> GetShape(int batch_size) const;
+
+  // Allocates a dense tensor holding `batch_size` images.
+  Tensor MakeTensor(int batch_size) const;
+
+  // Returns where an image of the given size and format is placed in the
+  // tensor; e.g. to map detections back onto the image.
+  Placement GetPlacement(int height, int width, RawImageFormat format) const;
+
+  // Preprocesses `image` into a new tensor with a batch size of 1.
+  StatusOr<Tensor> Process(const RawImageView& image);
+
+  // Preprocesses `image` into element `index` of `batch`, which must have the
+  // shape GetShape(n) for some n > index and the configured data type. Its
+  // innermost dimension must be dense; the others may be padded.
+  Status Process(const RawImageView& image, int index, Tensor* batch);
+
+  // Copy-control members. Use Create() rather than the constructors.
+  explicit ImagePreprocessor(const Options&);
+  ImagePreprocessor(const ImagePreprocessor&) = delete;
+  ImagePreprocessor& operator=(const ImagePreprocessor&) = delete;
+
+ private:
+  // The resampling weights and row buffers for one image geometry.
+  struct Plan {
+    int height = -1;
+    int width = -1;
+    RawImageFormat format = RAW_IMAGE_FORMAT_UNKNOWN;
+    Placement placement;
+    image_kernels_internal::AxisWeights x_axis;
+    image_kernels_internal::AxisWeights y_axis;
+    image_kernels_internal::AxisWeights chroma_x_axis;
+    image_kernels_internal::AxisWeights chroma_y_axis;
+    std::vector<const uint8_t*> taps;
+    std::vector<uint16_t> vertical_row;
+    std::vector<uint8_t> row;
+    std::vector<uint8_t> chroma_row;
+    std::vector<uint8_t> chroma_row2;
+    std::vector<uint8_t> color_row;
+  };
+
+  Status Initialize();
+  void UpdatePlan(const RawImageView& image);
+
+  Options options_;
+  int channels_ = 0;
+  std::vector<float> scale_;
+  std::vector<float> offset_;
+  std::vector<uint8_t> pad_;
+  Plan plan_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_IMAGE_PREPROCESSOR_H_
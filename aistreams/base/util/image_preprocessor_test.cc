@@ -0,0 +1,327 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/image_preprocessor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/base/util/image_kernels.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+#include "aistreams/proto/types/tensor.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+RawImage MakeRandomImage(int height, int width, RawImageFormat format,
+                         int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, 255);
+  RawImage image(height, width, format);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image(i) = static_cast<uint8_t>(dist(gen));
+  }
+  return image;
+}
+
+std::unique_ptr<ImagePreprocessor> MakePreprocessor(
+    const ImagePreprocessor::Options& options) {
+  auto preprocessor_statusor = ImagePreprocessor::Create(options);
+  EXPECT_TRUE(preprocessor_statusor.ok());
+  return std::move(preprocessor_statusor).ValueOrDie();
+}
+
+// Returns element (c, y, x) of the first image of an NCHW or NHWC tensor.
+template <typename T>
+T At(const Tensor& tensor, TensorLayout layout, int c, int y, int x) {
+  const std::vector<int64_t>& s = tensor.strides();
+  int64_t offset = layout == TensorLayout::kNchw
+                       ? c * s[1] + y * s[2] + x * s[3]
+                       : y * s[1] + x * s[2] + c * s[3];
+  T value;
+  std::memcpy(&value, tensor.data() + offset, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+TEST(ImagePreprocessorTest, StretchMatchesResize) {
+  const float kMean[] = {123.675f, 116.28f, 103.53f};
+  const float kStddev[] = {58.395f, 57.12f, 57.375f};
+  for (ResizeMethod method : {ResizeMethod::kBilinear, ResizeMethod::kArea}) {
+    ImagePreprocessor::Options options;
+    options.height = 16;
+    options.width = 24;
+    options.resize_method = method;
+    options.mean.assign(kMean, kMean + 3);
+    options.stddev.assign(kStddev, kStddev + 3);
+    auto preprocessor = MakePreprocessor(options);
+
+    RawImage image = MakeRandomImage(37, 53, RAW_IMAGE_FORMAT_SRGB, 1);
+    auto tensor_statusor = preprocessor->Process(image);
+    ASSERT_TRUE(tensor_statusor.ok());
+    Tensor tensor = std::move(tensor_statusor).ValueOrDie();
+    EXPECT_EQ(tensor.shape(), std::vector<int64_t>({1, 3, 16, 24}));
+
+    RawImage resized(16, 24, RAW_IMAGE_FORMAT_SRGB);
+    ASSERT_TRUE(Resize(image, method, &resized).ok());
+    for (int y = 0; y < 16; ++y) {
+      for (int x = 0; x < 24; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          float expected = (resized.row(y)[3 * x + c] - kMean[c]) / kStddev[c];
+          EXPECT_NEAR(At<float>(tensor, TensorLayout::kNchw, c, y, x),
+                      expected, 1e-5);
+        }
+      }
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, ChannelOrderAndLayout) {
+  RawImage image = MakeRandomImage(20, 30, RAW_IMAGE_FORMAT_RGBA, 2);
+  RawImage resized(10, 12, RAW_IMAGE_FORMAT_RGBA);
+  ASSERT_TRUE(Resize(image, ResizeMethod::kBilinear, &resized).ok());
+  RawImage gray(10, 12, RAW_IMAGE_FORMAT_GRAY8);
+  ASSERT_TRUE(ConvertColor(resized, &gray).ok());
+
+  ImagePreprocessor::Options options;
+  options.height = 10;
+  options.width = 12;
+  options.dtype = TENSOR_DATA_TYPE_UINT8;
+  options.layout = TensorLayout::kNhwc;
+  options.color_format = RAW_IMAGE_FORMAT_BGR;
+  Tensor bgr = MakePreprocessor(options)->Process(image).ValueOrDie();
+  EXPECT_EQ(bgr.shape(), std::vector<int64_t>({1, 10, 12, 3}));
+
+  options.layout = TensorLayout::kNchw;
+  options.color_format = RAW_IMAGE_FORMAT_GRAY8;
+  Tensor luma = MakePreprocessor(options)->Process(image).ValueOrDie();
+  EXPECT_EQ(luma.shape(), std::vector<int64_t>({1, 1, 10, 12}));
+
+  for (int y = 0; y < 10; ++y) {
+    for (int x = 0; x < 12; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_EQ(At<uint8_t>(bgr, TensorLayout::kNhwc, c, y, x),
+                  resized.row(y)[4 * x + 2 - c]);
+      }
+      EXPECT_EQ(At<uint8_t>(luma, TensorLayout::kNchw, 0, y, x),
+                gray.row(y)[x]);
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, Letterbox) {
+  ImagePreprocessor::Options options;
+  options.height = 64;
+  options.width = 64;
+  options.fit = ImageFit::kLetterbox;
+  options.stddev = {255.0f};
+  options.pad_value = 114;
+  auto preprocessor = MakePreprocessor(options);
+
+  auto placement = preprocessor->GetPlacement(50, 100, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(placement.src_height, 50);
+  EXPECT_EQ(placement.src_width, 100);
+  EXPECT_EQ(placement.dst_y, 16);
+  EXPECT_EQ(placement.dst_x, 0);
+  EXPECT_EQ(placement.dst_height, 32);
+  EXPECT_EQ(placement.dst_width, 64);
+
+  RawImage image = MakeRandomImage(50, 100, RAW_IMAGE_FORMAT_SRGB, 3);
+  RawImage resized(32, 64, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(Resize(image, ResizeMethod::kBilinear, &resized).ok());
+  Tensor tensor = preprocessor->Process(image).ValueOrDie();
+  for (int y = 0; y < 64; ++y) {
+    for (int x = 0; x < 64; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        float expected = y < 16 || y >= 48
+                             ? 114 / 255.0f
+                             : resized.row(y - 16)[3 * x + c] / 255.0f;
+        EXPECT_NEAR(At<float>(tensor, TensorLayout::kNchw, c, y, x),
+                    expected, 1e-6);
+      }
+    }
+  }
+
+  // Tall images are padded on the left and right.
+  placement = preprocessor->GetPlacement(100, 30, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(placement.dst_y, 0);
+  EXPECT_EQ(placement.dst_x, 22);
+  EXPECT_EQ(placement.dst_height, 64);
+  EXPECT_EQ(placement.dst_width, 19);
+}
+
+TEST(ImagePreprocessorTest, CenterCrop) {
+  ImagePreprocessor::Options options;
+  options.height = 32;
+  options.width = 32;
+  options.fit = ImageFit::kCenterCrop;
+  options.dtype = TENSOR_DATA_TYPE_UINT8;
+  auto preprocessor = MakePreprocessor(options);
+
+  auto placement = preprocessor->GetPlacement(50, 100, RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(placement.src_y, 0);
+  EXPECT_EQ(placement.src_x, 25);
+  EXPECT_EQ(placement.src_height, 50);
+  EXPECT_EQ(placement.src_width, 50);
+  EXPECT_EQ(placement.dst_height, 32);
+  EXPECT_EQ(placement.dst_width, 32);
+
+  // Subsampled images are cropped at even columns.
+  placement = preprocessor->GetPlacement(50, 100, RAW_IMAGE_FORMAT_NV12);
+  EXPECT_EQ(placement.src_x, 24);
+
+  RawImage image = MakeRandomImage(50, 100, RAW_IMAGE_FORMAT_SRGB, 4);
+  RawImage cropped(50, 50, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(Crop(image, 0, 25, &cropped).ok());
+  RawImage resized(32, 32, RAW_IMAGE_FORMAT_SRGB);
+  ASSERT_TRUE(Resize(cropped, ResizeMethod::kBilinear, &resized).ok());
+  Tensor tensor = preprocessor->Process(image).ValueOrDie();
+  for (int y = 0; y < 32; ++y) {
+    for (int x = 0; x < 32; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_EQ(At<uint8_t>(tensor, TensorLayout::kNchw, c, y, x),
+                  resized.row(y)[3 * x + c]);
+      }
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, YuvImages) {
+  // A uniform color converts to the same pixel everywhere; BT.601 limited
+  // range (81, 90, 240) is (254, 0, 0) after clamping.
+  for (RawImageFormat format :
+       {RAW_IMAGE_FORMAT_NV12, RAW_IMAGE_FORMAT_I420}) {
+    RawImage image(31, 45, format);
+    std::memset(image.row(0, 0), 81, 31 * 45);
+    if (format == RAW_IMAGE_FORMAT_NV12) {
+      for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 23; ++x) {
+          image.row(y, 1)[2 * x] = 90;
+          image.row(y, 1)[2 * x + 1] = 240;
+        }
+      }
+    } else {
+      std::memset(image.row(0, 1), 90, 16 * 23);
+      std::memset(image.row(0, 2), 240, 16 * 23);
+    }
+
+    ImagePreprocessor::Options options;
+    options.height = 20;
+    options.width = 17;
+    options.fit = ImageFit::kCenterCrop;
+    options.dtype = TENSOR_DATA_TYPE_UINT8;
+    options.layout = TensorLayout::kNhwc;
+    Tensor rgb = MakePreprocessor(options)->Process(image).ValueOrDie();
+    options.color_format = RAW_IMAGE_FORMAT_GRAY8;
+    Tensor luma = MakePreprocessor(options)->Process(image).ValueOrDie();
+    for (int y = 0; y < 20; ++y) {
+      for (int x = 0; x < 17; ++x) {
+        EXPECT_EQ(At<uint8_t>(rgb, TensorLayout::kNhwc, 0, y, x), 254);
+        EXPECT_EQ(At<uint8_t>(rgb, TensorLayout::kNhwc, 1, y, x), 0);
+        EXPECT_EQ(At<uint8_t>(rgb, TensorLayout::kNhwc, 2, y, x), 0);
+        EXPECT_EQ(At<uint8_t>(luma, TensorLayout::kNhwc, 0, y, x), 81);
+      }
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, YuvMatchesResizeAndConvert) {
+  for (RawImageFormat format :
+       {RAW_IMAGE_FORMAT_NV12, RAW_IMAGE_FORMAT_I420}) {
+    RawImage image = MakeRandomImage(31, 45, format, 5);
+    RawImage resized(20, 17, format);
+    ASSERT_TRUE(Resize(image, ResizeMethod::kArea, &resized).ok());
+    RawImage rgb(20, 17, RAW_IMAGE_FORMAT_SRGB);
+    ASSERT_TRUE(ConvertColor(resized, &rgb).ok());
+
+    ImagePreprocessor::Options options;
+    options.height = 20;
+    options.width = 17;
+    options.resize_method = ResizeMethod::kArea;
+    options.dtype = TENSOR_DATA_TYPE_UINT8;
+    Tensor tensor = MakePreprocessor(options)->Process(image).ValueOrDie();
+    for (int y = 0; y < 20; ++y) {
+      for (int x = 0; x < 17; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          EXPECT_EQ(At<uint8_t>(tensor, TensorLayout::kNchw, c, y, x),
+                    rgb.row(y)[3 * x + c]);
+        }
+      }
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, Batch) {
+  ImagePreprocessor::Options options;
+  options.height = 8;
+  options.width = 8;
+  auto preprocessor = MakePreprocessor(options);
+  Tensor batch = preprocessor->MakeTensor(3);
+  EXPECT_EQ(batch.shape(), std::vector<int64_t>({3, 3, 8, 8}));
+  std::fill(batch.data_as<float>(), batch.data_as<float>() + 3 * 3 * 64,
+            -1.0f);
+
+  RawImage image(4, 4, RAW_IMAGE_FORMAT_GRAY8);
+  std::memset(image.data(), 7, image.size());
+  ASSERT_TRUE(preprocessor->Process(image, 1, &batch).ok());
+  for (int i = 0; i < 3 * 3 * 64; ++i) {
+    EXPECT_EQ(batch.data_as<float>()[i], i / 192 == 1 ? 7.0f : -1.0f);
+  }
+
+  EXPECT_FALSE(preprocessor->Process(image, 3, &batch).ok());
+  EXPECT_FALSE(preprocessor->Process(image, -1, &batch).ok());
+  Tensor wrong_type(TENSOR_DATA_TYPE_UINT8, {3, 3, 8, 8});
+  EXPECT_FALSE(preprocessor->Process(image, 0, &wrong_type).ok());
+  Tensor wrong_shape(TENSOR_DATA_TYPE_FLOAT32, {3, 8, 8, 3});
+  EXPECT_FALSE(preprocessor->Process(image, 0, &wrong_shape).ok());
+  EXPECT_FALSE(preprocessor->Process(RawImage(), 0, &batch).ok());
+}
+
+TEST(ImagePreprocessorTest, OptionErrors) {
+  ImagePreprocessor::Options options;
+  EXPECT_FALSE(ImagePreprocessor::Create(options).ok());
+  options.height = 8;
+  options.width = 8;
+  EXPECT_TRUE(ImagePreprocessor::Create(options).ok());
+
+  ImagePreprocessor::Options bad = options;
+  bad.color_format = RAW_IMAGE_FORMAT_NV12;
+  EXPECT_FALSE(ImagePreprocessor::Create(bad).ok());
+  bad = options;
+  bad.dtype = TENSOR_DATA_TYPE_INT32;
+  EXPECT_FALSE(ImagePreprocessor::Create(bad).ok());
+  bad = options;
+  bad.mean = {1.0f, 2.0f};
+  EXPECT_FALSE(ImagePreprocessor::Create(bad).ok());
+  bad = options;
+  bad.stddev = {0.0f};
+  EXPECT_FALSE(ImagePreprocessor::Create(bad).ok());
+  bad = options;
+  bad.dtype = TENSOR_DATA_TYPE_UINT8;
+  bad.stddev = {255.0f};
+  EXPECT_FALSE(ImagePreprocessor::Create(bad).ok());
+}
+
+}  // namespace aistreams
@@ -0,0 +1,203 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/jpeg_decoder.h"
+
+// jpeglib.h expects size_t and FILE to be declared.
+// clang-format off
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+// clang-format on
+
+#include <algorithm>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace {
+
+// The most rows handed to libjpeg at once.
+constexpr int kMaxRowsPerRead = 16;
+
+// The DCT scales to try, from the smallest.
+constexpr unsigned int kScaleDenoms[] = {8, 4, 2};
+
+// libjpeg reports fatal errors by calling error_exit, which must not return.
+// It jumps back to the setjmp of the call into libjpeg instead.
+struct ErrorManager {
+  jpeg_error_mgr pub;
+  std::jmp_buf jump;
+};
+
+void ExitOnError(j_common_ptr cinfo) {
+  std::longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+}
+
+// Warnings, e.g. about a truncated frame, are not fatal and are not printed.
+void IgnoreMessage(j_common_ptr /*cinfo*/) {}
+
+J_COLOR_SPACE GetColorSpace(RawImageFormat format) {
+  switch (format) {
+    case RAW_IMAGE_FORMAT_SRGB:
+      return JCS_EXT_RGB;
+    case RAW_IMAGE_FORMAT_BGR:
+      return JCS_EXT_BGR;
+    case RAW_IMAGE_FORMAT_RGBA:
+      return JCS_EXT_RGBA;
+    case RAW_IMAGE_FORMAT_GRAY8:
+      return JCS_GRAYSCALE;
+    default:
+      return JCS_UNKNOWN;
+  }
+}
+
+unsigned int CeilDiv(unsigned int n, unsigned int d) { return (n + d - 1) / d; }
+
+}  // namespace
+
+// The methods that call into libjpeg may be jumped back into on errors, so
+// they must not hold objects with destructors.
+struct JpegDecoder::State {
+  jpeg_decompress_struct cinfo;
+  ErrorManager error;
+  char message[JMSG_LENGTH_MAX];
+
+  State() {
+    cinfo.err = jpeg_std_error(&error.pub);
+    error.pub.error_exit = ExitOnError;
+    error.pub.output_message = IgnoreMessage;
+    jpeg_create_decompress(&cinfo);
+  }
+
+  ~State() { jpeg_destroy_decompress(&cinfo); }
+
+  // Reads the header of the frame at `data` and starts decompressing it into
+  // `color_space`, at the smallest DCT scale at which it is at least
+  // `min_height` by `min_width`. Returns false on errors.
+  bool Start(const char* data, size_t size, J_COLOR_SPACE color_space,
+             int min_height, int min_width) {
+    if (setjmp(error.jump)) {
+      Abort();
+      return false;
+    }
+    jpeg_mem_src(&cinfo, reinterpret_cast<const unsigned char*>(data), size);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = color_space;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    if (min_height > 0 && min_width > 0) {
+      for (unsigned int denom : kScaleDenoms) {
+        if (CeilDiv(cinfo.image_height, denom) >=
+                static_cast<unsigned int>(min_height) &&
+            CeilDiv(cinfo.image_width, denom) >=
+                static_cast<unsigned int>(min_width)) {
+          cinfo.scale_denom = denom;
+          break;
+        }
+      }
+    }
+    jpeg_start_decompress(&cinfo);
+    return true;
+  }
+
+  // Decompresses every row of the started frame into `image`. Returns false
+  // on errors.
+  bool Read(RawImage* image) {
+    if (setjmp(error.jump)) {
+      Abort();
+      return false;
+    }
+    JSAMPROW rows[kMaxRowsPerRead];
+    while (cinfo.output_scanline < cinfo.output_height) {
+      int count = std::min<int>(kMaxRowsPerRead,
+                                cinfo.output_height - cinfo.output_scanline);
+      for (int i = 0; i < count; ++i) {
+        rows[i] = image->row(cinfo.output_scanline + i);
+      }
+      jpeg_read_scanlines(&cinfo, rows, count);
+    }
+    jpeg_finish_decompress(&cinfo);
+    return true;
+  }
+
+  // Saves the message of the error and resets for the next frame.
+  void Abort() {
+    (*cinfo.err->format_message)(reinterpret_cast<j_common_ptr>(&cinfo),
+                                 message);
+    jpeg_abort_decompress(&cinfo);
+  }
+
+  Status LastError() const {
+    return InvalidArgumentError(
+        absl::StrFormat("Failed to decode the JPEG frame: %s", message));
+  }
+};
+
+StatusOr<std::unique_ptr<JpegDecoder>> JpegDecoder::Create(
+    const Options& options) {
+  auto decoder = std::make_unique<JpegDecoder>(options);
+  AIS_RETURN_IF_ERROR(decoder->Initialize());
+  return decoder;
+}
+
+bool JpegDecoder::IsSupportedFormat(RawImageFormat format) {
+  return GetColorSpace(format) != JCS_UNKNOWN;
+}
+
+JpegDecoder::JpegDecoder(const Options& options) : options_(options) {}
+
+JpegDecoder::~JpegDecoder() = default;
+
+Status JpegDecoder::Initialize() {
+  if (!IsSupportedFormat(options_.output_format)) {
+    return InvalidArgumentError(
+        absl::StrFormat("Decoding JPEG frames into %s is not supported",
+                        RawImageFormat_Name(options_.output_format)));
+  }
+  if (options_.min_height < 0 || options_.min_width < 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a negative minimum height (%d) or width (%d)",
+        options_.min_height, options_.min_width));
+  }
+  state_ = std::make_unique<State>();
+  return OkStatus();
+}
+
+StatusOr<RawImage> JpegDecoder::Decode(const char* data, size_t size) {
+  if (data == nullptr || size == 0) {
+    return InvalidArgumentError("Given an empty JPEG frame");
+  }
+  if (!state_->Start(data, size, GetColorSpace(options_.output_format),
+                     options_.min_height, options_.min_width)) {
+    return state_->LastError();
+  }
+  // The image is allocated uninitialized; every row is written below.
+  RawImage image(state_->cinfo.output_height, state_->cinfo.output_width,
+                 options_.output_format);
+  if (!state_->Read(&image)) {
+    return state_->LastError();
+  }
+  return image;
+}
+
+StatusOr<RawImage> JpegDecoder::Decode(const JpegFrame& frame) {
+  return Decode(frame.data(), frame.size());
+}
+
+}  // namespace aistreams
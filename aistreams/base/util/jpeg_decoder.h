@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_JPEG_DECODER_H_
+#define AISTREAMS_BASE_UTIL_JPEG_DECODER_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace aistreams {
+
+// A JpegDecoder decodes JpegFrames into RawImages in-process with
+// libjpeg-turbo.
+//
+// It is a lighter alternative to a GStreamer pipeline for intra-only streams:
+// each frame is decoded straight into the pooled buffer of a RawImage, and
+// frames that are to be shrunk anyway can be decoded at 1/2, 1/4 or 1/8 of
+// their size in the DCT domain, which skips most of the decoding work.
+//
+// A JpegDecoder reuses its libjpeg state across frames. It is not
+// thread-safe.
+class JpegDecoder {
+ public:
+  // Options to configure the JpegDecoder.
+  struct Options {
+    // The format of the decoded RawImages. See IsSupportedFormat.
+    RawImageFormat output_format = RAW_IMAGE_FORMAT_SRGB;
+
+    // The smallest acceptable height and width of the decoded RawImages.
+    //
+    // If both are positive, each frame is decoded at the smallest scale of
+    // 1/2, 1/4 or 1/8 at which it is still at least this large; e.g. set them
+    // to the size the images are resized to afterwards. Otherwise, frames are
+    // decoded at their full size.
+    int min_height = 0;
+    int min_width = 0;
+  };
+
+  // Creates a JpegDecoder, validating the given options.
+  static StatusOr<std::unique_ptr<JpegDecoder>> Create(const Options&);
+
+  // Returns true if frames can be decoded into the given format. These are
+  // RAW_IMAGE_FORMAT_SRGB, RAW_IMAGE_FORMAT_BGR, RAW_IMAGE_FORMAT_RGBA and
+  // RAW_IMAGE_FORMAT_GRAY8.
+  static bool IsSupportedFormat(RawImageFormat format);
+
+  // Decodes the `size` bytes at `data` into a new, packed RawImage.
+  StatusOr<RawImage> Decode(const char* data, size_t size);
+
+  // Same as above, but decodes the bytes of `frame`.
+  StatusOr<RawImage> Decode(const JpegFrame& frame);
+
+  // Copy-control members. Use Create() rather than the constructors.
+  explicit JpegDecoder(const Options&);
+  ~JpegDecoder();
+  JpegDecoder(const JpegDecoder&) = delete;
+  JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+ private:
+  // The libjpeg state, which is kept out of this header.
+  struct State;
+
+  Status Initialize();
+
+  Options options_;
+  std::unique_ptr<State> state_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_JPEG_DECODER_H_
@@ -0,0 +1,143 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/jpeg_decoder.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/util/raw_image_utils.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/file_helpers.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kTestImageLenaPath[] = "testdata/jpegs/lena_color.jpg";
+constexpr char kTestImageLenaPpmPath[] = "testdata/ppms/lena.ppm";
+
+JpegFrame JpegFrameFromFile(const std::string& fname) {
+  std::string file_contents;
+  EXPECT_TRUE(file::GetContents(fname, &file_contents).ok());
+  return JpegFrame(std::move(file_contents));
+}
+
+std::unique_ptr<JpegDecoder> MakeDecoder(RawImageFormat format,
+                                         int min_height = 0,
+                                         int min_width = 0) {
+  JpegDecoder::Options options;
+  options.output_format = format;
+  options.min_height = min_height;
+  options.min_width = min_width;
+  auto decoder_statusor = JpegDecoder::Create(options);
+  EXPECT_TRUE(decoder_statusor.ok());
+  return std::move(decoder_statusor).ValueOrDie();
+}
+
+}  // namespace
+
+TEST(JpegDecoderTest, DecodeTest) {
+  JpegFrame frame = JpegFrameFromFile(kTestImageLenaPath);
+  auto decoder = MakeDecoder(RAW_IMAGE_FORMAT_SRGB);
+  auto image_statusor = decoder->Decode(frame);
+  ASSERT_TRUE(image_statusor.ok());
+  RawImage image = std::move(image_statusor).ValueOrDie();
+  EXPECT_EQ(image.height(), 512);
+  EXPECT_EQ(image.width(), 512);
+  EXPECT_EQ(image.format(), RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_TRUE(image.is_packed());
+
+  // The reference was decoded elsewhere, with different rounding and
+  // upsampling, so only expect it to be close.
+  RawImage expected;
+  ASSERT_TRUE(FromPpmFile(kTestImageLenaPpmPath, &expected).ok());
+  ASSERT_EQ(image.size(), expected.size());
+  int64_t total_diff = 0;
+  for (size_t i = 0; i < image.size(); ++i) {
+    total_diff += std::abs(image.data()[i] - expected.data()[i]);
+  }
+  EXPECT_LT(static_cast<double>(total_diff) / image.size(), 3.0);
+
+  // The decoder is reused across frames.
+  auto again_statusor = decoder->Decode(frame);
+  ASSERT_TRUE(again_statusor.ok());
+  EXPECT_EQ(std::move(again_statusor).ValueOrDie().size(), image.size());
+}
+
+TEST(JpegDecoderTest, FormatTest) {
+  JpegFrame frame = JpegFrameFromFile(kTestImageLenaPath);
+  RawImage rgb =
+      MakeDecoder(RAW_IMAGE_FORMAT_SRGB)->Decode(frame).ValueOrDie();
+  RawImage bgr = MakeDecoder(RAW_IMAGE_FORMAT_BGR)->Decode(frame).ValueOrDie();
+  RawImage rgba =
+      MakeDecoder(RAW_IMAGE_FORMAT_RGBA)->Decode(frame).ValueOrDie();
+  RawImage gray =
+      MakeDecoder(RAW_IMAGE_FORMAT_GRAY8)->Decode(frame).ValueOrDie();
+  EXPECT_EQ(bgr.row(7)[3 * 5], rgb.row(7)[3 * 5 + 2]);
+  EXPECT_EQ(rgba.row(7)[4 * 5 + 1], rgb.row(7)[3 * 5 + 1]);
+  EXPECT_EQ(rgba.row(7)[4 * 5 + 3], 255);
+  EXPECT_EQ(gray.channels(), 1);
+  EXPECT_EQ(gray.size(), 512 * 512);
+
+  JpegDecoder::Options options;
+  options.output_format = RAW_IMAGE_FORMAT_NV12;
+  EXPECT_FALSE(JpegDecoder::Create(options).ok());
+}
+
+TEST(JpegDecoderTest, ScaleTest) {
+  JpegFrame frame = JpegFrameFromFile(kTestImageLenaPath);
+
+  // The smallest scale that is still large enough is picked.
+  RawImage eighth =
+      MakeDecoder(RAW_IMAGE_FORMAT_SRGB, 64, 64)->Decode(frame).ValueOrDie();
+  EXPECT_EQ(eighth.height(), 64);
+  EXPECT_EQ(eighth.width(), 64);
+  RawImage quarter =
+      MakeDecoder(RAW_IMAGE_FORMAT_SRGB, 65, 10)->Decode(frame).ValueOrDie();
+  EXPECT_EQ(quarter.height(), 128);
+  EXPECT_EQ(quarter.width(), 128);
+  RawImage half =
+      MakeDecoder(RAW_IMAGE_FORMAT_SRGB, 224, 224)->Decode(frame).ValueOrDie();
+  EXPECT_EQ(half.height(), 256);
+  RawImage full =
+      MakeDecoder(RAW_IMAGE_FORMAT_SRGB, 300, 300)->Decode(frame).ValueOrDie();
+  EXPECT_EQ(full.height(), 512);
+}
+
+TEST(JpegDecoderTest, ErrorTest) {
+  auto decoder = MakeDecoder(RAW_IMAGE_FORMAT_SRGB);
+  EXPECT_EQ(decoder->Decode(JpegFrame()).status().code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_EQ(decoder->Decode(JpegFrame("not a jpeg")).status().code(),
+            StatusCode::kInvalidArgument);
+
+  // A truncated frame is decoded as far as it goes.
+  std::string bytes;
+  ASSERT_TRUE(file::GetContents(kTestImageLenaPath, &bytes).ok());
+  bytes.resize(bytes.size() / 2);
+  EXPECT_TRUE(decoder->Decode(JpegFrame(bytes)).ok());
+
+  // Errors leave the decoder usable.
+  EXPECT_TRUE(decoder->Decode(JpegFrameFromFile(kTestImageLenaPath)).ok());
+}
+
+}  // namespace aistreams
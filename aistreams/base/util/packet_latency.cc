@@ -0,0 +1,131 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/packet_latency.h"
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+
+namespace aistreams {
+
+namespace {
+
+void RecordInterval(int64_t start_nanos, int64_t end_nanos,
+                    LatencyHistogram* histogram) {
+  if (start_nanos <= 0 || end_nanos <= 0 || end_nanos < start_nanos) {
+    return;
+  }
+  histogram->Record(absl::Nanoseconds(end_nanos - start_nanos));
+}
+
+}  // namespace
+
+std::string LatencyStageName(LatencyStage stage) {
+  switch (stage) {
+    case LatencyStage::kCaptureToSink:
+      return "capture_to_sink";
+    case LatencyStage::kSinkToSend:
+      return "sink_to_send";
+    case LatencyStage::kSendToReceive:
+      return "send_to_receive";
+    case LatencyStage::kReceiveToDecode:
+      return "receive_to_decode";
+    case LatencyStage::kDecode:
+      return "decode";
+    case LatencyStage::kLastStageToConsume:
+      return "last_stage_to_consume";
+    case LatencyStage::kEndToEnd:
+      return "end_to_end";
+    default:
+      return "unknown";
+  }
+}
+
+void PacketLatencyRecorder::Record(const PacketHeader& header, absl::Time now) {
+  const PacketStageTimes& t = header.stage_times();
+  auto h = [this](LatencyStage stage) {
+    return &histograms_[static_cast<int>(stage)];
+  };
+  RecordInterval(t.capture_nanos(), t.sink_enqueue_nanos(),
+                 h(LatencyStage::kCaptureToSink));
+  RecordInterval(t.sink_enqueue_nanos(), t.send_nanos(),
+                 h(LatencyStage::kSinkToSend));
+  RecordInterval(t.send_nanos(), t.receive_nanos(),
+                 h(LatencyStage::kSendToReceive));
+  RecordInterval(t.receive_nanos(), t.decode_start_nanos(),
+                 h(LatencyStage::kReceiveToDecode));
+  RecordInterval(t.decode_start_nanos(), t.decode_end_nanos(),
+                 h(LatencyStage::kDecode));
+
+  const int64_t stages[] = {t.capture_nanos(),      t.sink_enqueue_nanos(),
+                            t.send_nanos(),         t.receive_nanos(),
+                            t.decode_start_nanos(), t.decode_end_nanos()};
+  int64_t first = 0;
+  int64_t last = 0;
+  for (int64_t stage : stages) {
+    if (stage <= 0) {
+      continue;
+    }
+    if (first == 0) {
+      first = stage;
+    }
+    last = stage;
+  }
+  int64_t now_nanos = absl::ToUnixNanos(now);
+  RecordInterval(last, now_nanos, h(LatencyStage::kLastStageToConsume));
+  RecordInterval(first, now_nanos, h(LatencyStage::kEndToEnd));
+}
+
+std::string PacketLatencyRecorder::DebugString() const {
+  std::string s;
+  for (int i = 0; i < static_cast<int>(LatencyStage::kNumStages); ++i) {
+    const LatencyHistogram& histogram = histograms_[i];
+    if (histogram.count() == 0) {
+      continue;
+    }
+    absl::StrAppendFormat(
+        &s, "%s: count=%d mean=%s p50=%s p99=%s max=%s\n",
+        LatencyStageName(static_cast<LatencyStage>(i)), histogram.count(),
+        absl::FormatDuration(histogram.Mean()),
+        absl::FormatDuration(histogram.Percentile(0.5)),
+        absl::FormatDuration(histogram.Percentile(0.99)),
+        absl::FormatDuration(histogram.max()));
+  }
+  return s;
+}
+
+void PacketLatencyRecorder::Reset() {
+  for (auto& histogram : histograms_) {
+    histogram.Reset();
+  }
+}
+
+PacketLatencyRecorder* GetStreamLatencyRecorder(
+    const std::string& stream_name) {
+  static absl::Mutex mu(absl::kConstInit);
+  static auto* recorders =
+      new absl::flat_hash_map<std::string,
+                              std::unique_ptr<PacketLatencyRecorder>>();
+  absl::MutexLock lock(&mu);
+  auto& recorder = (*recorders)[stream_name];
+  if (recorder == nullptr) {
+    recorder = std::make_unique<PacketLatencyRecorder>();
+  }
+  return recorder.get();
+}
+
+}  // namespace aistreams
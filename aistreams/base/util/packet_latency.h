@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_PACKET_LATENCY_H_
+#define AISTREAMS_BASE_UTIL_PACKET_LATENCY_H_
+
+#include <array>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/util/latency_histogram.h"
+
+namespace aistreams {
+
+// The intervals between consecutive stages in PacketStageTimes.
+enum class LatencyStage {
+  // From the estimated capture time to aissink.
+  kCaptureToSink = 0,
+
+  // From aissink to the PacketSender writing to the wire.
+  kSinkToSend,
+
+  // From the PacketSender to the PacketReceiver (includes the server).
+  kSendToReceive,
+
+  // From the PacketReceiver to the decoder input.
+  kReceiveToDecode,
+
+  // Time spent in the decoder.
+  kDecode,
+
+  // From the last recorded stage to the point where Record() was called.
+  kLastStageToConsume,
+
+  // From the earliest recorded stage to the point where Record() was called.
+  kEndToEnd,
+
+  kNumStages,
+};
+
+// Returns a short printable name for `stage`.
+std::string LatencyStageName(LatencyStage stage);
+
+// Accumulates the per-stage latencies of packets into histograms.
+//
+// Call Record() when a packet is consumed. An interval is recorded only when
+// both of its endpoints were stamped, so packets that skipped a stage (e.g.
+// undecoded packets) contribute to the other intervals only.
+//
+// Stage times may be stamped by different hosts, so intervals that cross a
+// host boundary include the clock skew between them.
+//
+// This class is thread-safe.
+class PacketLatencyRecorder {
+ public:
+  PacketLatencyRecorder() = default;
+
+  // Record the stage times in `header`, taking `now` as the consumption time.
+  void Record(const PacketHeader& header, absl::Time now = absl::Now());
+
+  // The histogram of the interval `stage`.
+  const LatencyHistogram& histogram(LatencyStage stage) const {
+    return histograms_[static_cast<int>(stage)];
+  }
+
+  // Returns a human readable summary of the recorded latencies.
+  std::string DebugString() const;
+
+  // Discard all recorded latencies.
+  void Reset();
+
+  PacketLatencyRecorder(const PacketLatencyRecorder&) = delete;
+  PacketLatencyRecorder& operator=(const PacketLatencyRecorder&) = delete;
+
+ private:
+  std::array<LatencyHistogram, static_cast<int>(LatencyStage::kNumStages)>
+      histograms_;
+};
+
+// Returns the process-wide recorder for the stream `stream_name`.
+//
+// The recorder is created on first use and lives until the process exits.
+PacketLatencyRecorder* GetStreamLatencyRecorder(const std::string& stream_name);
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_PACKET_LATENCY_H_
@@ -0,0 +1,84 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/packet_latency.h"
+
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr int64_t kBaseNanos = 1600000000000000000;
+constexpr int64_t kMilli = 1000000;
+
+}  // namespace
+
+TEST(PacketLatencyTest, AllStagesTest) {
+  PacketHeader header;
+  auto* t = header.mutable_stage_times();
+  t->set_capture_nanos(kBaseNanos);
+  t->set_sink_enqueue_nanos(kBaseNanos + 10 * kMilli);
+  t->set_send_nanos(kBaseNanos + 15 * kMilli);
+  t->set_receive_nanos(kBaseNanos + 45 * kMilli);
+  t->set_decode_start_nanos(kBaseNanos + 50 * kMilli);
+  t->set_decode_end_nanos(kBaseNanos + 70 * kMilli);
+
+  PacketLatencyRecorder recorder;
+  recorder.Record(header, absl::FromUnixNanos(kBaseNanos + 100 * kMilli));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kCaptureToSink).sum(),
+            absl::Milliseconds(10));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kSinkToSend).sum(),
+            absl::Milliseconds(5));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kSendToReceive).sum(),
+            absl::Milliseconds(30));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kReceiveToDecode).sum(),
+            absl::Milliseconds(5));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kDecode).sum(),
+            absl::Milliseconds(20));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kLastStageToConsume).sum(),
+            absl::Milliseconds(30));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kEndToEnd).sum(),
+            absl::Milliseconds(100));
+  EXPECT_FALSE(recorder.DebugString().empty());
+}
+
+TEST(PacketLatencyTest, MissingStagesTest) {
+  PacketHeader header;
+  auto* t = header.mutable_stage_times();
+  t->set_send_nanos(kBaseNanos);
+  t->set_receive_nanos(kBaseNanos + 20 * kMilli);
+
+  PacketLatencyRecorder recorder;
+  recorder.Record(header, absl::FromUnixNanos(kBaseNanos + 25 * kMilli));
+  EXPECT_EQ(recorder.histogram(LatencyStage::kCaptureToSink).count(), 0);
+  EXPECT_EQ(recorder.histogram(LatencyStage::kSinkToSend).count(), 0);
+  EXPECT_EQ(recorder.histogram(LatencyStage::kDecode).count(), 0);
+  EXPECT_EQ(recorder.histogram(LatencyStage::kSendToReceive).count(), 1);
+  EXPECT_EQ(recorder.histogram(LatencyStage::kEndToEnd).sum(),
+            absl::Milliseconds(25));
+
+  // A packet without any stamps records nothing.
+  recorder.Reset();
+  recorder.Record(PacketHeader());
+  EXPECT_EQ(recorder.histogram(LatencyStage::kEndToEnd).count(), 0);
+}
+
+TEST(PacketLatencyTest, StreamRegistryTest) {
+  PacketLatencyRecorder* a = GetStreamLatencyRecorder("a");
+  EXPECT_EQ(a, GetStreamLatencyRecorder("a"));
+  EXPECT_NE(a, GetStreamLatencyRecorder("b"));
+}
+
+}  // namespace aistreams
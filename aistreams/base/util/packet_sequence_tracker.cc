@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/packet_sequence_tracker.h"
+
+namespace aistreams {
+
+constexpr int PacketSequenceTracker::kWindowSize;
+
+void PacketSequenceTracker::Record(const PacketHeader& header) {
+  int64_t seq = header.sequence_number();
+  absl::MutexLock lock(&mu_);
+  if (seq <= 0) {
+    ++unsequenced_;
+    return;
+  }
+
+  auto it = sessions_.find(header.sender_session_id());
+  if (it == sessions_.end()) {
+    SessionState& state = sessions_[header.sender_session_id()];
+    state.highest = seq;
+    state.seen.set(0);
+    state.stats.received = 1;
+    return;
+  }
+
+  SessionState& state = it->second;
+  if (seq > state.highest) {
+    int64_t advance = seq - state.highest;
+    state.stats.missing += advance - 1;
+    if (advance >= kWindowSize) {
+      state.seen.reset();
+    } else {
+      state.seen <<= advance;
+    }
+    state.seen.set(0);
+    state.highest = seq;
+    ++state.stats.received;
+    return;
+  }
+
+  int64_t behind = state.highest - seq;
+  if (behind < kWindowSize) {
+    if (state.seen.test(behind)) {
+      ++state.stats.duplicate;
+      return;
+    }
+    state.seen.set(behind);
+  }
+  ++state.stats.received;
+  ++state.stats.reordered;
+  if (state.stats.missing > 0) {
+    --state.stats.missing;
+  }
+}
+
+PacketSequenceStats PacketSequenceTracker::GetStats() const {
+  absl::MutexLock lock(&mu_);
+  PacketSequenceStats total;
+  for (const auto& session : sessions_) {
+    const PacketSequenceStats& stats = session.second.stats;
+    total.received += stats.received;
+    total.missing += stats.missing;
+    total.duplicate += stats.duplicate;
+    total.reordered += stats.reordered;
+  }
+  total.unsequenced = unsequenced_;
+  return total;
+}
+
+PacketSequenceStats PacketSequenceTracker::GetStats(
+    const std::string& sender_session_id) const {
+  absl::MutexLock lock(&mu_);
+  auto it = sessions_.find(sender_session_id);
+  if (it == sessions_.end()) {
+    return PacketSequenceStats();
+  }
+  return it->second.stats;
+}
+
+}  // namespace aistreams
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_PACKET_SEQUENCE_TRACKER_H_
+#define AISTREAMS_BASE_UTIL_PACKET_SEQUENCE_TRACKER_H_
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "aistreams/proto/packet.pb.h"
+
+namespace aistreams {
+
+// Counts of how the packets seen by a PacketSequenceTracker arrived.
+struct PacketSequenceStats {
+  // The number of distinct sequenced packets seen.
+  int64_t received = 0;
+
+  // The number of sequence numbers skipped over and not (yet) seen.
+  //
+  // A packet that arrives after a later one was seen is first counted here
+  // and moved to `reordered` when it shows up.
+  int64_t missing = 0;
+
+  // The number of packets whose sequence number had already been seen.
+  int64_t duplicate = 0;
+
+  // The number of packets that arrived after a packet with a higher sequence
+  // number.
+  int64_t reordered = 0;
+
+  // The number of packets without a sequence number (e.g. control signals
+  // not sent through a PacketSender).
+  int64_t unsequenced = 0;
+};
+
+// Tracks the sequence numbers stamped by PacketSender to account for packets
+// that were dropped, duplicated or reordered on the way to a receiver.
+//
+// Each sender session is tracked independently. Late packets are classified
+// exactly if they arrive within `kWindowSize` sequence numbers of the highest
+// one seen; later than that they count as reordered.
+//
+// This class is thread-safe.
+class PacketSequenceTracker {
+ public:
+  static constexpr int kWindowSize = 1024;
+
+  PacketSequenceTracker() = default;
+
+  // Account for the header of a newly arrived packet.
+  void Record(const PacketHeader& header);
+
+  // Returns the totals across all sender sessions.
+  PacketSequenceStats GetStats() const;
+
+  // Returns the stats of one sender session, or all zeros if it is unknown.
+  PacketSequenceStats GetStats(const std::string& sender_session_id) const;
+
+ private:
+  struct SessionState {
+    int64_t highest = 0;
+    // Bit i is set if sequence number (highest - i) has been seen.
+    std::bitset<kWindowSize> seen;
+    PacketSequenceStats stats;
+  };
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::string, SessionState> sessions_ ABSL_GUARDED_BY(mu_);
+  int64_t unsequenced_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_PACKET_SEQUENCE_TRACKER_H_
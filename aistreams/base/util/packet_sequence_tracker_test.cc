@@ -0,0 +1,101 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/packet_sequence_tracker.h"
+
+#include <string>
+
+#include "aistreams/port/gtest.h"
+#include "aistreams/proto/packet.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+PacketHeader MakeHeader(const std::string& session_id, int64_t seq) {
+  PacketHeader header;
+  header.set_sender_session_id(session_id);
+  header.set_sequence_number(seq);
+  return header;
+}
+
+}  // namespace
+
+TEST(PacketSequenceTrackerTest, InOrderTest) {
+  PacketSequenceTracker tracker;
+  for (int i = 1; i <= 10; ++i) {
+    tracker.Record(MakeHeader("a", i));
+  }
+  auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.received, 10);
+  EXPECT_EQ(stats.missing, 0);
+  EXPECT_EQ(stats.duplicate, 0);
+  EXPECT_EQ(stats.reordered, 0);
+  EXPECT_EQ(stats.unsequenced, 0);
+}
+
+TEST(PacketSequenceTrackerTest, GapsDuplicatesAndReorderingTest) {
+  PacketSequenceTracker tracker;
+  tracker.Record(MakeHeader("a", 1));
+  tracker.Record(MakeHeader("a", 2));
+  tracker.Record(MakeHeader("a", 5));
+  auto stats = tracker.GetStats("a");
+  EXPECT_EQ(stats.received, 3);
+  EXPECT_EQ(stats.missing, 2);
+
+  // 3 arrives late; 4 never does.
+  tracker.Record(MakeHeader("a", 3));
+  stats = tracker.GetStats("a");
+  EXPECT_EQ(stats.received, 4);
+  EXPECT_EQ(stats.missing, 1);
+  EXPECT_EQ(stats.reordered, 1);
+
+  tracker.Record(MakeHeader("a", 3));
+  tracker.Record(MakeHeader("a", 5));
+  stats = tracker.GetStats("a");
+  EXPECT_EQ(stats.received, 4);
+  EXPECT_EQ(stats.duplicate, 2);
+  EXPECT_EQ(stats.missing, 1);
+}
+
+TEST(PacketSequenceTrackerTest, LargeJumpTest) {
+  PacketSequenceTracker tracker;
+  tracker.Record(MakeHeader("a", 1));
+  tracker.Record(MakeHeader("a", 1 + 5 * PacketSequenceTracker::kWindowSize));
+  tracker.Record(MakeHeader("a", 2 + 5 * PacketSequenceTracker::kWindowSize));
+  auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.received, 3);
+  EXPECT_EQ(stats.missing, 5 * PacketSequenceTracker::kWindowSize - 1);
+  EXPECT_EQ(stats.duplicate, 0);
+}
+
+TEST(PacketSequenceTrackerTest, SessionsTest) {
+  PacketSequenceTracker tracker;
+  tracker.Record(MakeHeader("a", 1));
+  tracker.Record(MakeHeader("a", 2));
+  tracker.Record(MakeHeader("b", 1));
+  tracker.Record(MakeHeader("b", 3));
+  tracker.Record(PacketHeader());
+
+  EXPECT_EQ(tracker.GetStats("a").missing, 0);
+  EXPECT_EQ(tracker.GetStats("b").missing, 1);
+  EXPECT_EQ(tracker.GetStats("c").received, 0);
+
+  auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.received, 4);
+  EXPECT_EQ(stats.missing, 1);
+  EXPECT_EQ(stats.unsequenced, 1);
+}
+
+}  // namespace aistreams
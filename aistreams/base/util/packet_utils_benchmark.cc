@@ -0,0 +1,68 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string>
+
+#include "aistreams/base/packet.h"
+#include "aistreams/base/util/packet_utils.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/util/alloc_counter.h"
+
+namespace aistreams {
+
+namespace {
+
+void SetCounters(const AllocationCounter& allocs, int64_t bytes_per_op,
+                 benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * bytes_per_op);
+  state.counters["allocs_per_op"] = benchmark::Counter(
+      allocs.allocations(), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+// IsEos on a data packet; this is the common case on every received packet.
+void BM_IsEosDataPacket(benchmark::State& state) {
+  Packet packet = MakePacket(std::string(state.range(0), 'a')).ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IsEos(packet));
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+BENCHMARK(BM_IsEosDataPacket)->RangeMultiplier(16)->Range(100, 25 << 20);
+
+void BM_IsEosEosPacket(benchmark::State& state) {
+  Packet packet = MakeEosPacket("done").ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IsEos(packet));
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+BENCHMARK(BM_IsEosEosPacket);
+
+void BM_IsEosWithReason(benchmark::State& state) {
+  Packet packet = MakeEosPacket("done").ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    std::string reason;
+    benchmark::DoNotOptimize(IsEos(packet, &reason));
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+BENCHMARK(BM_IsEosWithReason);
+
+}  // namespace aistreams
@@ -0,0 +1,58 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/pending_packet_headers.h"
+
+#include <utility>
+
+namespace aistreams {
+
+PendingPacketHeaders::PendingPacketHeaders(int max_size)
+    : max_size_(max_size) {}
+
+void PendingPacketHeaders::Add(int64_t pts, PacketHeader header) {
+  absl::MutexLock lock(&mu_);
+  if (static_cast<int>(headers_.size()) >= max_size_ && !headers_.empty()) {
+    headers_.erase(headers_.begin());
+  }
+  headers_[pts] = std::move(header);
+}
+
+bool PendingPacketHeaders::Get(int64_t pts, PacketHeader* header) const {
+  absl::MutexLock lock(&mu_);
+  auto it = headers_.find(pts);
+  if (it == headers_.end()) {
+    return false;
+  }
+  *header = it->second;
+  return true;
+}
+
+bool PendingPacketHeaders::Take(int64_t pts, PacketHeader* header) {
+  absl::MutexLock lock(&mu_);
+  auto it = pts < 0 ? headers_.begin() : headers_.find(pts);
+  if (it == headers_.end()) {
+    return false;
+  }
+  *header = std::move(it->second);
+  headers_.erase(it);
+  return true;
+}
+
+int PendingPacketHeaders::size() const {
+  absl::MutexLock lock(&mu_);
+  return headers_.size();
+}
+
+}  // namespace aistreams
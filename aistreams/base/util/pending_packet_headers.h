@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_UTIL_PENDING_PACKET_HEADERS_H_
+#define AISTREAMS_BASE_UTIL_PENDING_PACKET_HEADERS_H_
+
+#include <cstdint>
+#include <map>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "aistreams/proto/packet.pb.h"
+
+namespace aistreams {
+
+// Remembers the headers of source packets while their frames are in a
+// decoder, keyed by the pts that each frame is fed under, so that they can be
+// carried over onto the decoded frames.
+//
+// Decoders need not yield frames in the order they were fed; e.g. H264 with
+// B-frames yields them in presentation order. Taking a header therefore only
+// removes its own entry. Those of frames that never come out (e.g. dropped by
+// the decoder) are evicted, oldest first, once `max_size` are pending.
+//
+// This class is thread-safe.
+class PendingPacketHeaders {
+ public:
+  explicit PendingPacketHeaders(int max_size);
+
+  // Remembers `header` under `pts`, evicting the oldest pending header if
+  // there are already `max_size`.
+  void Add(int64_t pts, PacketHeader header);
+
+  // Copies the header remembered under `pts` into `header`, leaving it
+  // pending. Returns false if there is none.
+  bool Get(int64_t pts, PacketHeader* header) const;
+
+  // Moves the header remembered under `pts` into `header`. If `pts` is
+  // negative (i.e. unknown), the oldest pending header is taken. Returns false
+  // if there is none.
+  bool Take(int64_t pts, PacketHeader* header);
+
+  // Returns the number of pending headers.
+  int size() const;
+
+ private:
+  const int max_size_;
+  mutable absl::Mutex mu_;
+  std::map<int64_t, PacketHeader> headers_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_UTIL_PENDING_PACKET_HEADERS_H_
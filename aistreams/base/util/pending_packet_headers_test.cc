@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/util/pending_packet_headers.h"
+
+#include "aistreams/port/gtest.h"
+#include "aistreams/proto/packet.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+PacketHeader MakeHeader(int64_t seq) {
+  PacketHeader header;
+  header.set_sequence_number(seq);
+  return header;
+}
+
+}  // namespace
+
+TEST(PendingPacketHeadersTest, OutOfOrderTest) {
+  // Frames fed as I(1) P(2) B(3) B(4) come out as I(1) B(3) B(4) P(2).
+  PendingPacketHeaders headers(16);
+  for (int pts = 1; pts <= 4; ++pts) {
+    headers.Add(pts, MakeHeader(pts));
+  }
+  for (int pts : {1, 3, 4, 2}) {
+    PacketHeader header;
+    ASSERT_TRUE(headers.Take(pts, &header));
+    EXPECT_EQ(header.sequence_number(), pts);
+  }
+  EXPECT_EQ(headers.size(), 0);
+
+  PacketHeader header;
+  EXPECT_FALSE(headers.Take(2, &header));
+}
+
+TEST(PendingPacketHeadersTest, GetAndUnknownPtsTest) {
+  PendingPacketHeaders headers(16);
+  headers.Add(5, MakeHeader(5));
+  headers.Add(7, MakeHeader(7));
+
+  PacketHeader header;
+  ASSERT_TRUE(headers.Get(7, &header));
+  EXPECT_EQ(header.sequence_number(), 7);
+  EXPECT_FALSE(headers.Get(6, &header));
+  EXPECT_EQ(headers.size(), 2);
+
+  // An unknown pts takes the oldest header.
+  ASSERT_TRUE(headers.Take(-1, &header));
+  EXPECT_EQ(header.sequence_number(), 5);
+  ASSERT_TRUE(headers.Take(-1, &header));
+  EXPECT_EQ(header.sequence_number(), 7);
+  EXPECT_FALSE(headers.Take(-1, &header));
+}
+
+TEST(PendingPacketHeadersTest, EvictionTest) {
+  // Headers of frames that never come out are evicted, oldest first.
+  PendingPacketHeaders headers(3);
+  for (int pts = 1; pts <= 5; ++pts) {
+    headers.Add(pts, MakeHeader(pts));
+  }
+  EXPECT_EQ(headers.size(), 3);
+  PacketHeader header;
+  EXPECT_FALSE(headers.Take(2, &header));
+  EXPECT_TRUE(headers.Take(3, &header));
+  EXPECT_TRUE(headers.Take(5, &header));
+}
+
+}  // namespace aistreams
@@ -27,11 +27,18 @@
 namespace aistreams {
 
 Status ToPpmFile(absl::string_view file_name, const RawImage& raw_image) {
+  if (raw_image.format() != RAW_IMAGE_FORMAT_SRGB) {
+    return UnimplementedError(absl::StrFormat(
+        "Only SRGB images can be written as PPM files (given %s)",
+        RawImageFormat_Name(raw_image.format())));
+  }
   std::string file_contents(absl::StrFormat(
       "P6\n%d %d\n255\n", raw_image.width(), raw_image.height()));
-  auto data_start = reinterpret_cast<const char*>(raw_image.data());
-  std::copy(data_start, data_start + raw_image.size(),
-            std::back_inserter(file_contents));
+  size_t row_size = raw_image.width() * raw_image.channels();
+  for (int y = 0; y < raw_image.height(); ++y) {
+    file_contents.append(reinterpret_cast<const char*>(raw_image.row(y)),
+                         row_size);
+  }
   return file::SetContents(file_name, file_contents);
 }
 
@@ -23,7 +23,7 @@
 
 namespace aistreams {
 
-// Write the given RawImage as a PPM file.
+// Write the given SRGB RawImage as a PPM file.
 Status ToPpmFile(absl::string_view file_name, const RawImage&);
 
 // Read the given PPM file as a RawImage.
@@ -16,26 +16,77 @@
 
 #include "aistreams/base/wrappers/receivers.h"
 
+#include <algorithm>
 #include <functional>
 #include <thread>
 
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/base/packet_receiver.h"
 #include "aistreams/base/wrappers/receiver_queue.h"
+#include "aistreams/base/wrappers/receivers_internal.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/status_macros.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/util/metrics.h"
 
 namespace aistreams {
 
 namespace {
 constexpr int kDefaultTryPushTimeoutSeconds = 5;
 constexpr int kDefaultBufferCapacity = 300;
+constexpr int kCreditPollIntervalMs = 5;
+
+// Metrics of the queue between the background receiver and the caller.
+struct QueueMetrics {
+  explicit QueueMetrics(const std::string& stream_name) {
+    MetricsRegistry* metrics = MetricsRegistry::Global();
+    MetricLabels labels = {{"stream", stream_name}};
+    depth = metrics->GetGauge(
+        "ais_receiver_queue_depth",
+        "Packets in the receiver queue after the latest push.", labels);
+    occupancy = metrics->GetHistogram(
+        "ais_receiver_queue_occupancy",
+        "Packets in the receiver queue after each push.", labels);
+    full = metrics->GetCounter(
+        "ais_receiver_queue_full_total",
+        "Times a push timed out because the receiver queue was full.", labels);
+    push_wait = metrics->GetLatencyHistogram(
+        "ais_receiver_queue_push_wait_seconds",
+        "Time spent waiting to push into the receiver queue.", labels);
+  }
+
+  Gauge* depth;
+  Histogram* occupancy;
+  Counter* full;
+  LatencyHistogram* push_wait;
+};
 }  // namespace
 
+namespace receivers_internal {
+
+bool GrantCreditsForFreeSpace(const ProducerConsumerQueue<Packet>& packet_queue,
+                              PacketReceiver* packet_receiver) {
+  int64_t outstanding = packet_receiver->outstanding_credits();
+  int64_t available =
+      packet_queue.capacity() - packet_queue.count() - outstanding;
+  int64_t batch = std::max(1, packet_queue.capacity() / 4);
+  if (available >= batch || (outstanding <= 0 && available > 0)) {
+    Status s = packet_receiver->GrantCredits(available);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      return outstanding > 0;
+    }
+    return true;
+  }
+  return outstanding > 0;
+}
+
+}  // namespace receivers_internal
+
 Status MakePacketReceiverQueue(const ReceiverOptions& options,
                                ReceiverQueue<Packet>* receiver_queue) {
   // Create the shared producer/consumer queue.
@@ -58,6 +109,14 @@ Status MakePacketReceiverQueue(const ReceiverOptions& options,
   packet_receiver_options.connection_options = options.connection_options;
   packet_receiver_options.stream_name = options.stream_name;
   packet_receiver_options.receiver_name = options.receiver_name;
+  packet_receiver_options.start_position = options.start_position;
+  packet_receiver_options.start_time = options.start_time;
+  packet_receiver_options.max_packet_age = options.max_packet_age;
+  packet_receiver_options.enable_credit_flow_control =
+      options.enable_credit_flow_control;
+  packet_receiver_options.overflow_policy = options.overflow_policy;
+  packet_receiver_options.max_pending_packets = options.max_pending_packets;
+  packet_receiver_options.max_bytes_in_flight = options.max_bytes_in_flight;
   auto packet_receiver_statusor =
       PacketReceiver::Create(packet_receiver_options);
   if (!packet_receiver_statusor.ok()) {
@@ -65,19 +124,32 @@ Status MakePacketReceiverQueue(const ReceiverOptions& options,
     return UnknownError("Failed to create a PacketReceiver");
   }
   auto packet_receiver = std::move(packet_receiver_statusor).ValueOrDie();
+  QueueMetrics queue_metrics(options.stream_name);
 
   // Run the packet receiver in the background.
   //
   // Transfer the queue and its producer share.
   std::thread packet_receiver_worker(
       [packet_queue = std::move(packet_queue),
-       packet_receiver = std::move(packet_receiver)]() {
+       packet_receiver = std::move(packet_receiver),
+       use_credits = options.enable_credit_flow_control, queue_metrics]() {
         Status s;
         std::unique_ptr<Packet> p;
         while (packet_queue.use_count() > 1) {
           if (p == nullptr) {
+            if (use_credits &&
+                !receivers_internal::GrantCreditsForFreeSpace(
+                    *packet_queue, packet_receiver.get())) {
+              absl::SleepFor(absl::Milliseconds(kCreditPollIntervalMs));
+              continue;
+            }
             p = std::make_unique<Packet>();
             s = packet_receiver->Receive(p.get());
+            if (IsNotFound(s)) {
+              // An empty unary poll; recheck for consumers before the next.
+              p = nullptr;
+              continue;
+            }
             if (!s.ok()) {
               packet_queue->Emplace(
                   MakeEosPacket(
@@ -88,9 +160,17 @@ Status MakePacketReceiverQueue(const ReceiverOptions& options,
               break;
             }
           }
-          if (!packet_queue->TryPush(
-                  p, absl::Seconds(kDefaultTryPushTimeoutSeconds))) {
+          absl::Time push_start = absl::Now();
+          bool pushed = packet_queue->TryPush(
+              p, absl::Seconds(kDefaultTryPushTimeoutSeconds));
+          queue_metrics.push_wait->Record(absl::Now() - push_start);
+          if (!pushed) {
+            queue_metrics.full->Increment();
             LOG(WARNING) << "The shared producer consumer queue is full";
+          } else {
+            int depth = packet_queue->count();
+            queue_metrics.depth->Set(depth);
+            queue_metrics.occupancy->Record(depth);
           }
         }
         return;
@@ -24,6 +24,7 @@
 #include "aistreams/base/wrappers/receiver_queue.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/stream.pb.h"
 
 namespace aistreams {
 
@@ -44,6 +45,43 @@ struct ReceiverOptions {
   //
   // Non-positive values will resolve to a pre-configured default.
   int buffer_capacity = 0;
+
+  // Where to start reading if the server has not seen `receiver_name` before.
+  //
+  // Set this to START_POSITION_LATEST to skip the backlog after a restart, or
+  // to START_POSITION_TIMESTAMP together with `start_time`.
+  StartPosition start_position = START_POSITION_UNSPECIFIED;
+
+  // The starting point when `start_position` is START_POSITION_TIMESTAMP.
+  absl::Time start_time = absl::InfinitePast();
+
+  // If positive, data packets older than this on arrival are dropped before
+  // they are queued. EOS packets are always delivered.
+  absl::Duration max_packet_age = absl::ZeroDuration();
+
+  // Set this true to have the server send only as many packets as there is
+  // free space for in the receiver queue. Packets the server cannot deliver
+  // are then dropped or conflated according to `overflow_policy` rather than
+  // buffered in transit, which keeps the queued packets fresh when the
+  // consumer is slower than the producer.
+  bool enable_credit_flow_control = false;
+
+  // What the server does with packets while the receiver queue is full.
+  //
+  // Only used with `enable_credit_flow_control`.
+  OverflowPolicy overflow_policy = OVERFLOW_POLICY_UNSPECIFIED;
+
+  // The number of packets the server may hold for this receiver while the
+  // receiver queue is full; beyond it, the `overflow_policy` applies.
+  // Non-positive values let the server decide.
+  //
+  // Only used with `enable_credit_flow_control`.
+  int max_pending_packets = 0;
+
+  // If positive, bounds the payload bytes in flight from the server.
+  //
+  // Only used with `enable_credit_flow_control`.
+  int64_t max_bytes_in_flight = 0;
 };
 
 // Create a ReceiverQueue containing packets arriving from the server.
@@ -54,9 +92,14 @@ struct ReceiverOptions {
 // The Packets arriving in the receiver queue have the following properties:
 // 1. (Ordered) Packets are queued in the same order as they were in the stream.
 // 2. (Gapless) If two Packets in the stream were queued, then so did all
-//    Packets that were in between them.
+//    Packets that were in between them. The exception is when
+//    `max_packet_age` is set, or when the server drops packets under
+//    `enable_credit_flow_control`.
 // 3. Packets that arrive either contain data or represent EOS. It is your
 //    responsibility to check for EOS (e.g. using IsEos).
+//
+// To measure packets lost between the senders and your consumer, give the
+// headers of the popped packets to a PacketSequenceTracker.
 Status MakePacketReceiverQueue(const ReceiverOptions& options,
                                ReceiverQueue<Packet>* receiver_queue);
 
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_WRAPPERS_RECEIVERS_INTERNAL_H_
+#define AISTREAMS_BASE_WRAPPERS_RECEIVERS_INTERNAL_H_
+
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/util/producer_consumer_queue.h"
+
+namespace aistreams {
+namespace receivers_internal {
+
+// Grant credits for the free space in `packet_queue` that is not already
+// covered by outstanding credits.
+//
+// Credits are granted in batches of at least a quarter of the capacity so that
+// a consumer popping one packet at a time does not cost one message each.
+// Returns false if nothing is outstanding and the queue has no free space.
+//
+// Exposed for testing.
+bool GrantCreditsForFreeSpace(const ProducerConsumerQueue<Packet>& packet_queue,
+                              PacketReceiver* packet_receiver);
+
+}  // namespace receivers_internal
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_WRAPPERS_RECEIVERS_INTERNAL_H_
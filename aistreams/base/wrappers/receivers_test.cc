@@ -0,0 +1,141 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/wrappers/receivers.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/base/testing/in_memory_stream_server.h"
+#include "aistreams/base/wrappers/receivers_internal.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/util/producer_consumer_queue.h"
+
+namespace aistreams {
+
+namespace {
+
+using ::aistreams::receivers_internal::GrantCreditsForFreeSpace;
+
+constexpr char kStreamName[] = "test-stream";
+
+// Sends the strings [begin, end). Each call returns once the server has
+// stored the packets.
+void SendStrings(const InMemoryStreamServer& server, int begin, int end) {
+  std::vector<Packet> packets;
+  for (int i = begin; i < end; ++i) {
+    auto packet_status_or = MakePacket(absl::StrCat(i));
+    ASSERT_TRUE(packet_status_or.ok());
+    packets.push_back(std::move(packet_status_or).ValueOrDie());
+  }
+  ASSERT_TRUE(SendPackets(server, kStreamName, std::move(packets),
+                          /*enable_unary_rpc=*/true)
+                  .ok());
+}
+
+std::string PopString(ReceiverQueue<Packet>* receiver_queue) {
+  Packet packet;
+  EXPECT_TRUE(receiver_queue->TryPop(packet, absl::Seconds(10)));
+  PacketAs<std::string> packet_as(std::move(packet));
+  EXPECT_TRUE(packet_as.ok());
+  return std::move(packet_as).ValueOrDie();
+}
+
+// Receives `count` packets and pushes them into `packet_queue`.
+void ReceiveInto(PacketReceiver* receiver, int count,
+                 ProducerConsumerQueue<Packet>* packet_queue) {
+  for (int i = 0; i < count; ++i) {
+    auto packet = std::make_unique<Packet>();
+    ASSERT_TRUE(receiver->Receive(packet.get()).ok());
+    ASSERT_TRUE(packet_queue->TryPush(packet));
+  }
+}
+
+}  // namespace
+
+TEST(ReceiversTest, GrantCreditsForFreeSpaceTest) {
+  auto server = StartServer();
+  PacketReceiver::Options options;
+  options.connection_options = server->InsecureConnectionOptions();
+  options.stream_name = kStreamName;
+  options.start_position = START_POSITION_EARLIEST;
+  options.enable_credit_flow_control = true;
+  auto receiver_status_or = PacketReceiver::Create(options);
+  ASSERT_TRUE(receiver_status_or.ok());
+  auto receiver = std::move(receiver_status_or).ValueOrDie();
+
+  // An empty queue gets credits for all of its space, and no more.
+  ProducerConsumerQueue<Packet> packet_queue(8);
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 8);
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 8);
+
+  // Credits used for queued packets are not replaced until there is space.
+  SendStrings(*server, 0, 6);
+  ReceiveInto(receiver.get(), 6, &packet_queue);
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 2);
+
+  // Space is granted in batches of a quarter of the capacity.
+  Packet packet;
+  ASSERT_TRUE(packet_queue.TryPop(packet));
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 2);
+  ASSERT_TRUE(packet_queue.TryPop(packet));
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 4);
+
+  // A full queue with nothing outstanding cannot receive.
+  SendStrings(*server, 6, 10);
+  ReceiveInto(receiver.get(), 4, &packet_queue);
+  EXPECT_EQ(packet_queue.count(), 8);
+  EXPECT_FALSE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 0);
+
+  // With nothing outstanding, any space is granted right away.
+  ASSERT_TRUE(packet_queue.TryPop(packet));
+  EXPECT_TRUE(GrantCreditsForFreeSpace(packet_queue, receiver.get()));
+  EXPECT_EQ(receiver->outstanding_credits(), 1);
+}
+
+TEST(ReceiversTest, MaxPendingPacketsTest) {
+  auto server = StartServer();
+  SendStrings(*server, 0, 10);
+
+  ReceiverOptions options;
+  options.connection_options = server->InsecureConnectionOptions();
+  options.stream_name = kStreamName;
+  options.start_position = START_POSITION_EARLIEST;
+  options.buffer_capacity = 2;
+  options.enable_credit_flow_control = true;
+  options.overflow_policy = OVERFLOW_POLICY_DROP_NEWEST;
+  options.max_pending_packets = 3;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakePacketReceiverQueue(options, &receiver_queue).ok());
+
+  // The server held only the first 3 packets for the full queue.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(PopString(&receiver_queue), absl::StrCat(i));
+  }
+  SendStrings(*server, 10, 11);
+  EXPECT_EQ(PopString(&receiver_queue), "10");
+}
+
+}  // namespace aistreams
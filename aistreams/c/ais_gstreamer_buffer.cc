@@ -43,6 +43,16 @@ const char* AIS_GstreamerBufferGetCapsString(
   return ais_gstreamer_buffer->gstreamer_buffer.get_caps_cstr();
 }
 
+void AIS_GstreamerBufferSetDeltaUnit(
+    int delta_unit, AIS_GstreamerBuffer* ais_gstreamer_buffer) {
+  ais_gstreamer_buffer->gstreamer_buffer.set_delta_unit(delta_unit != 0);
+}
+
+int AIS_GstreamerBufferIsDeltaUnit(
+    const AIS_GstreamerBuffer* ais_gstreamer_buffer) {
+  return ais_gstreamer_buffer->gstreamer_buffer.is_delta_unit() ? 1 : 0;
+}
+
 void AIS_GstreamerBufferAssign(const char* src, size_t count,
                                AIS_GstreamerBuffer* ais_gstreamer_buffer) {
   return ais_gstreamer_buffer->gstreamer_buffer.assign(src, count);
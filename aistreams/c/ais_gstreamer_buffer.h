@@ -46,6 +46,15 @@ extern void AIS_GstreamerBufferSetCapsString(
 extern const char* AIS_GstreamerBufferGetCapsString(
     const AIS_GstreamerBuffer* ais_gstreamer_buffer);
 
+// Set whether the given AIS_GstreamerBuffer holds a delta frame rather than a
+// keyframe; i.e. whether its GstBuffer has GST_BUFFER_FLAG_DELTA_UNIT set.
+extern void AIS_GstreamerBufferSetDeltaUnit(
+    int delta_unit, AIS_GstreamerBuffer* ais_gstreamer_buffer);
+
+// Return non-zero if the given AIS_GstreamerBuffer holds a delta frame.
+extern int AIS_GstreamerBufferIsDeltaUnit(
+    const AIS_GstreamerBuffer* ais_gstreamer_buffer);
+
 // Set the data held in the given AIS_GstreamerBuffer to those given in the
 // address range [src, src+count) by copying.
 extern void AIS_GstreamerBufferAssign(
@@ -49,6 +49,11 @@ TEST(CAPI, AIS_GstreamerBufferTest) {
                             const_cast<char*>(dst2.data()));
   EXPECT_EQ(dst2, dst);
 
+  EXPECT_EQ(AIS_GstreamerBufferIsDeltaUnit(ais_gstreamer_buffer), 0);
+  AIS_GstreamerBufferSetDeltaUnit(1, ais_gstreamer_buffer);
+  EXPECT_NE(AIS_GstreamerBufferIsDeltaUnit(ais_gstreamer_buffer), 0);
+  EXPECT_TRUE(ais_gstreamer_buffer->gstreamer_buffer.is_delta_unit());
+
   AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
 }
 
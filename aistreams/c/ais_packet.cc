@@ -20,6 +20,7 @@
 #include <string>
 #include <utility>
 
+#include "absl/time/clock.h"
 #include "aistreams/base/packet.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/util/packet_utils.h"
@@ -102,6 +103,25 @@ AIS_Packet* AIS_NewGstreamerBufferPacket(
   return ais_packet.release();
 }
 
+void AIS_SetPacketCaptureTime(int64_t capture_pts_nanos,
+                              int64_t capture_unix_nanos,
+                              AIS_Packet* ais_packet) {
+  auto* stage_times =
+      ais_packet->packet.mutable_header()->mutable_stage_times();
+  if (capture_pts_nanos > 0) {
+    stage_times->set_capture_pts_nanos(capture_pts_nanos);
+  }
+  if (capture_unix_nanos > 0) {
+    stage_times->set_capture_nanos(capture_unix_nanos);
+  }
+}
+
+void AIS_StampPacketSinkEnqueue(AIS_Packet* ais_packet) {
+  ais_packet->packet.mutable_header()
+      ->mutable_stage_times()
+      ->set_sink_enqueue_nanos(absl::GetCurrentTimeNanos());
+}
+
 unsigned char AIS_IsEos(const AIS_Packet* ais_packet, char** reason) {
   if (reason == nullptr) {
     return static_cast<unsigned char>(IsEos(ais_packet->packet));
@@ -18,6 +18,7 @@
 #define AISTREAMS_C_AIS_PACKET_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "aistreams/c/ais_gstreamer_buffer.h"
 #include "aistreams/c/ais_status.h"
@@ -75,6 +76,20 @@ extern AIS_Packet* AIS_NewGstreamerBufferPacket(
 // Delete a previously created status object.
 extern void AIS_DeletePacket(AIS_Packet*);
 
+// Record when the data in the given ais_packet was captured.
+//
+// `capture_pts_nanos` is the presentation timestamp of the data in the running
+// time of the source pipeline. `capture_unix_nanos` is the estimated wall-clock
+// time (nanoseconds since the Unix epoch) of the capture. Non-positive values
+// are left unrecorded.
+extern void AIS_SetPacketCaptureTime(int64_t capture_pts_nanos,
+                                     int64_t capture_unix_nanos,
+                                     AIS_Packet* ais_packet);
+
+// Record the current time as the time at which a sink accepted the data in the
+// given ais_packet.
+extern void AIS_StampPacketSinkEnqueue(AIS_Packet* ais_packet);
+
 // Returns whether the given ais_packet is an EOS indicator.
 //
 // If `reason` is not NULL and `ais_packet` is an EOS, then `reason` will
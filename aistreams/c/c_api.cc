@@ -109,23 +109,51 @@ void AIS_DeleteSender(AIS_Sender* ais_sender) { delete ais_sender; }
 
 void AIS_SendPacket(AIS_Sender* ais_sender, AIS_Packet* ais_packet,
                     AIS_Status* ais_status) {
-  ais_status->status = ais_sender->packet_sender->Send(ais_packet->packet);
+  ais_status->status =
+      ais_sender->packet_sender->Send(std::move(ais_packet->packet));
   return;
 }
 
 // --------------------------------------------------------------------------
 
-AIS_Receiver* AIS_NewReceiver(const AIS_ConnectionOptions* options,
-                              const char* stream_name,
-                              const char* receiver_name,
-                              AIS_Status* ais_status) {
-  ReceiverOptions receiver_options;
-  receiver_options.connection_options = options->connection_options;
-  receiver_options.stream_name = ToString(stream_name);
-  receiver_options.receiver_name = ToString(receiver_name);
+AIS_ReceiverOptions* AIS_NewReceiverOptions() {
+  return new AIS_ReceiverOptions;
+}
+
+void AIS_DeleteReceiverOptions(AIS_ReceiverOptions* options) {
+  delete options;
+}
+
+void AIS_SetStartPosition(AIS_StartPosition start_position,
+                          AIS_ReceiverOptions* options) {
+  options->receiver_options.start_position =
+      static_cast<aistreams::StartPosition>(start_position);
+}
+
+void AIS_SetStartTime(int64_t start_time_us, AIS_ReceiverOptions* options) {
+  options->receiver_options.start_time = absl::FromUnixMicros(start_time_us);
+}
+
+void AIS_SetMaxPacketAge(int64_t max_packet_age_ms,
+                         AIS_ReceiverOptions* options) {
+  options->receiver_options.max_packet_age =
+      absl::Milliseconds(max_packet_age_ms);
+}
+
+AIS_Receiver* AIS_NewReceiverWithOptions(
+    const AIS_ConnectionOptions* options, const char* stream_name,
+    const char* receiver_name, const AIS_ReceiverOptions* receiver_options,
+    AIS_Status* ais_status) {
+  ReceiverOptions merged_options;
+  if (receiver_options != nullptr) {
+    merged_options = receiver_options->receiver_options;
+  }
+  merged_options.connection_options = options->connection_options;
+  merged_options.stream_name = ToString(stream_name);
+  merged_options.receiver_name = ToString(receiver_name);
 
   auto receiver_queue = std::make_unique<ReceiverQueue<Packet>>();
-  auto status = MakePacketReceiverQueue(receiver_options, receiver_queue.get());
+  auto status = MakePacketReceiverQueue(merged_options, receiver_queue.get());
   if (!status.ok()) {
     ais_status->status = status;
     return nullptr;
@@ -137,6 +165,14 @@ AIS_Receiver* AIS_NewReceiver(const AIS_ConnectionOptions* options,
   return ais_receiver.release();
 }
 
+AIS_Receiver* AIS_NewReceiver(const AIS_ConnectionOptions* options,
+                              const char* stream_name,
+                              const char* receiver_name,
+                              AIS_Status* ais_status) {
+  return AIS_NewReceiverWithOptions(options, stream_name, receiver_name,
+                                    nullptr, ais_status);
+}
+
 void AIS_DeleteReceiver(AIS_Receiver* ais_receiver) { delete ais_receiver; }
 
 void AIS_ReceivePacket(AIS_Receiver* ais_receiver, AIS_Packet* ais_packet,
@@ -130,6 +130,45 @@ extern AIS_Receiver* AIS_NewReceiver(const AIS_ConnectionOptions* options,
                                      const char* receiver_name,
                                      AIS_Status* ais_status);
 
+// Where a new receiver starts reading from the stream.
+//
+// Values are the same as StartPosition in aistreams/proto/stream.proto.
+typedef enum AIS_StartPosition {
+  AIS_START_POSITION_UNSPECIFIED = 0,
+  AIS_START_POSITION_EARLIEST = 1,
+  AIS_START_POSITION_LATEST = 2,
+  AIS_START_POSITION_TIMESTAMP = 3,
+} AIS_StartPosition;
+
+// AIS_ReceiverOptions contain the optional settings of a packet receiver.
+typedef struct AIS_ReceiverOptions AIS_ReceiverOptions;
+
+// Return a new receiver options object.
+extern AIS_ReceiverOptions* AIS_NewReceiverOptions(void);
+
+// Delete a receiver options object.
+extern void AIS_DeleteReceiverOptions(AIS_ReceiverOptions*);
+
+// Set where to start reading if the server has not seen the receiver name.
+extern void AIS_SetStartPosition(AIS_StartPosition start_position,
+                                 AIS_ReceiverOptions* options);
+
+// Set the start time (microseconds since the Unix epoch) used with
+// AIS_START_POSITION_TIMESTAMP.
+extern void AIS_SetStartTime(int64_t start_time_us,
+                             AIS_ReceiverOptions* options);
+
+// Set the maximum age (milliseconds) of a data packet on arrival. Older
+// packets are dropped on the client. Non-positive values disable the check.
+extern void AIS_SetMaxPacketAge(int64_t max_packet_age_ms,
+                                AIS_ReceiverOptions* options);
+
+// Same as AIS_NewReceiver, but additionally configured by `receiver_options`.
+extern AIS_Receiver* AIS_NewReceiverWithOptions(
+    const AIS_ConnectionOptions* options, const char* stream_name,
+    const char* receiver_name, const AIS_ReceiverOptions* receiver_options,
+    AIS_Status* ais_status);
+
 // Delete a packet receiver object.
 extern void AIS_DeleteReceiver(AIS_Receiver* ais_receiver);
 
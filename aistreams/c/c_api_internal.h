@@ -32,6 +32,10 @@ struct AIS_Sender {
   std::unique_ptr<aistreams::PacketSender> packet_sender = nullptr;
 };
 
+struct AIS_ReceiverOptions {
+  aistreams::ReceiverOptions receiver_options;
+};
+
 struct AIS_Receiver {
   std::unique_ptr<aistreams::ReceiverQueue<aistreams::Packet>> receiver_queue =
       nullptr;
@@ -51,4 +51,23 @@ TEST(CAPI, ConnectionOptionsTest) {
   AIS_DeleteConnectionOptions(ais_options);
 }
 
+TEST(CAPI, ReceiverOptionsTest) {
+  AIS_ReceiverOptions* ais_options = AIS_NewReceiverOptions();
+  ReceiverOptions* options = &ais_options->receiver_options;
+  EXPECT_EQ(options->start_position, START_POSITION_UNSPECIFIED);
+
+  AIS_SetStartPosition(AIS_START_POSITION_LATEST, ais_options);
+  EXPECT_EQ(options->start_position, START_POSITION_LATEST);
+  AIS_SetStartPosition(AIS_START_POSITION_TIMESTAMP, ais_options);
+  EXPECT_EQ(options->start_position, START_POSITION_TIMESTAMP);
+
+  AIS_SetStartTime(1500000, ais_options);
+  EXPECT_EQ(options->start_time, absl::FromUnixMicros(1500000));
+
+  AIS_SetMaxPacketAge(250, ais_options);
+  EXPECT_EQ(options->max_packet_age, absl::Milliseconds(250));
+
+  AIS_DeleteReceiverOptions(ais_options);
+}
+
 }  // namespace aistreams
@@ -0,0 +1,582 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the decode stage in isolation.
+//
+// Short clips of raw, JPEG and H264 frames are encoded up front and then
+// decoded over and over, either directly through GstreamerRawImageYielder or
+// end to end through MakeDecodedReceiverQueue against an in-memory server,
+// which decodes JPEGs in-process unless noted. Each benchmark runs a number of
+// decode pipelines side by side.
+//
+// Besides the time per clip, each reports
+//   fps:              decoded frames per second across all pipelines.
+//   latency_p50_ms,
+//   latency_p99_ms:   the time from feeding (sending) a frame to getting it
+//                     back decoded.
+//   peak_rss_mb:      the peak resident set size of the process so far. Run
+//                     one benchmark at a time (--benchmark_filter) to
+//                     attribute it.
+//   copies_per_frame: the bytes allocated through operator new per byte of
+//                     decoded image. Gstreamer's own buffers are not counted.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/base/testing/in_memory_stream_server.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/util/jpeg_decoder.h"
+#include "aistreams/base/util/packet_utils.h"
+#include "aistreams/cc/decoded_receivers.h"
+#include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
+#include "aistreams/gstreamer/gstreamer_runner.h"
+#include "aistreams/gstreamer/gstreamer_utils.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/alloc_counter.h"
+#include "aistreams/util/file_helpers.h"
+#include "aistreams/util/latency_histogram.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kTestImageLenaPath[] = "testdata/jpegs/lena_color.jpg";
+constexpr int kClipFrames = 30;
+constexpr int64_t kFrameDurationNanos = 33333333;
+constexpr int kDecodedQueueSize = 2 * kClipFrames;
+constexpr absl::Duration kDecodeTimeout = absl::Seconds(30);
+
+enum class Codec { kRaw, kJpeg, kH264 };
+
+// {width, height, number of pipelines}.
+void ResolutionsAndPipelines(benchmark::internal::Benchmark* b) {
+  for (int pipelines : {1, 2, 4}) {
+    b->Args({640, 480, pipelines});
+    b->Args({1280, 720, pipelines});
+    b->Args({1920, 1080, pipelines});
+  }
+  b->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+// Arguments (width, height, decode threads) for a single pipeline.
+void ResolutionsAndDecodeThreads(benchmark::internal::Benchmark* b) {
+  for (int threads : {1, 2, 4, 8}) {
+    b->Args({1280, 720, threads});
+    b->Args({1920, 1080, threads});
+  }
+  b->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+std::string RawCapsString(int width, int height) {
+  return absl::StrFormat(
+      "video/x-raw,format=RGB,width=%d,height=%d,framerate=30/1", width,
+      height);
+}
+
+// Returns a frame of a pattern that moves with `index`, so that the encoders
+// have some motion to work with.
+GstreamerBuffer MakeRawFrame(int width, int height, int index) {
+  // Gstreamer pads RGB rows to a multiple of 4 bytes.
+  int row_stride = (width * 3 + 3) & ~3;
+  std::string bytes(row_stride * height, '\0');
+  for (int y = 0; y < height; ++y) {
+    char* row = &bytes[y * row_stride];
+    for (int x = 0; x < width; ++x) {
+      row[3 * x] = static_cast<char>(x + index * 4);
+      row[3 * x + 1] = static_cast<char>(y + index * 2);
+      row[3 * x + 2] = static_cast<char>((x ^ y) + index);
+    }
+  }
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(RawCapsString(width, height));
+  gstreamer_buffer.assign(std::move(bytes));
+  gstreamer_buffer.set_pts(index * kFrameDurationNanos);
+  return gstreamer_buffer;
+}
+
+// Returns a clip of `kClipFrames` frames of the given size and codec.
+//
+// Every clip starts with a key frame, so it can be decoded repeatedly.
+StatusOr<std::vector<GstreamerBuffer>> MakeClip(Codec codec, int width,
+                                                int height) {
+  std::vector<GstreamerBuffer> raw_frames;
+  for (int i = 0; i < kClipFrames; ++i) {
+    raw_frames.push_back(MakeRawFrame(width, height, i));
+  }
+  if (codec == Codec::kRaw) {
+    return raw_frames;
+  }
+
+  GstreamerRunnerOptions options;
+  options.appsrc_caps_string = RawCapsString(width, height);
+  if (codec == Codec::kJpeg) {
+    options.processing_pipeline_string = "videoconvert ! jpegenc";
+  } else {
+    options.processing_pipeline_string = absl::StrFormat(
+        "videoconvert ! x264enc tune=zerolatency speed-preset=ultrafast "
+        "key-int-max=%d ! video/x-h264,stream-format=byte-stream,"
+        "alignment=au",
+        kClipFrames);
+  }
+  absl::Mutex mu;
+  absl::CondVar cv;
+  std::vector<GstreamerBuffer> encoded_frames;
+  GstreamerRunner runner(options);
+  AIS_RETURN_IF_ERROR(
+      runner.SetReceiver([&](GstreamerBuffer gstreamer_buffer) -> Status {
+        absl::MutexLock lock(&mu);
+        encoded_frames.push_back(std::move(gstreamer_buffer));
+        cv.SignalAll();
+        return OkStatus();
+      }));
+  AIS_RETURN_IF_ERROR(runner.Start());
+  for (const auto& raw_frame : raw_frames) {
+    AIS_RETURN_IF_ERROR(runner.Feed(raw_frame));
+  }
+  bool done;
+  {
+    absl::MutexLock lock(&mu);
+    absl::Time deadline = absl::Now() + kDecodeTimeout;
+    while (encoded_frames.size() < raw_frames.size() &&
+           !cv.WaitWithDeadline(&mu, deadline)) {
+    }
+    done = encoded_frames.size() >= raw_frames.size();
+  }
+  AIS_RETURN_IF_ERROR(runner.End());
+  if (!done) {
+    return DeadlineExceededError("Timed out encoding the clip");
+  }
+  return encoded_frames;
+}
+
+StatusOr<std::vector<GstreamerBuffer>> LoadJpegClip(const std::string& path) {
+  std::string bytes;
+  AIS_RETURN_IF_ERROR(file::GetContents(path, &bytes));
+  std::vector<GstreamerBuffer> clip;
+  for (int i = 0; i < kClipFrames; ++i) {
+    GstreamerBuffer gstreamer_buffer;
+    gstreamer_buffer.set_caps_string("image/jpeg");
+    gstreamer_buffer.assign(bytes);
+    gstreamer_buffer.set_pts(i * kFrameDurationNanos);
+    clip.push_back(std::move(gstreamer_buffer));
+  }
+  return clip;
+}
+
+double PeakRssMb() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+void SetCounters(const LatencyHistogram& latency,
+                 const AllocationCounter& allocs, int64_t frame_bytes,
+                 benchmark::State& state) {
+  int64_t frames = latency.count();
+  state.counters["fps"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+  state.counters["latency_p50_ms"] =
+      absl::ToDoubleMilliseconds(latency.Percentile(0.5));
+  state.counters["latency_p99_ms"] =
+      absl::ToDoubleMilliseconds(latency.Percentile(0.99));
+  state.counters["peak_rss_mb"] = PeakRssMb();
+  if (frames > 0 && frame_bytes > 0) {
+    state.counters["copies_per_frame"] =
+        static_cast<double>(allocs.bytes()) / (frames * frame_bytes);
+  }
+}
+
+// One GstreamerRawImageYielder and the frames it has in flight.
+class YielderPipeline {
+ public:
+  Status Start(const std::string& caps_string, LatencyHistogram* latency) {
+    latency_ = latency;
+    GstreamerRawImageYielder::Options options;
+    options.caps_string = caps_string;
+    options.timed_callback = [this](StatusOr<RawImage> raw_image_statusor,
+                                    int64_t pts) -> Status {
+      if (!raw_image_statusor.ok()) {
+        return OkStatus();
+      }
+      absl::Time now = absl::Now();
+      absl::MutexLock lock(&mu_);
+      auto it = feed_times_.find(pts);
+      if (it != feed_times_.end()) {
+        latency_->Record(now - it->second);
+        feed_times_.erase(it);
+      }
+      frame_bytes_ = raw_image_statusor.ValueOrDie().size();
+      ++decoded_;
+      cv_.SignalAll();
+      return OkStatus();
+    };
+    auto yielder_statusor = GstreamerRawImageYielder::Create(options);
+    AIS_RETURN_IF_ERROR(yielder_statusor.status());
+    yielder_ = std::move(yielder_statusor).ValueOrDie();
+    return OkStatus();
+  }
+
+  // Feeds the clip and waits until all of its frames are decoded.
+  Status DecodeClip(const std::vector<GstreamerBuffer>& clip) {
+    int64_t target;
+    {
+      absl::MutexLock lock(&mu_);
+      target = decoded_ + clip.size();
+    }
+    for (const auto& frame : clip) {
+      GstreamerBuffer gstreamer_buffer = frame;
+      gstreamer_buffer.set_pts(next_pts_);
+      next_pts_ += kFrameDurationNanos;
+      {
+        absl::MutexLock lock(&mu_);
+        feed_times_[gstreamer_buffer.get_pts()] = absl::Now();
+      }
+      AIS_RETURN_IF_ERROR(yielder_->Feed(gstreamer_buffer));
+    }
+    absl::MutexLock lock(&mu_);
+    absl::Time deadline = absl::Now() + kDecodeTimeout;
+    while (decoded_ < target && !cv_.WaitWithDeadline(&mu_, deadline)) {
+    }
+    if (decoded_ < target) {
+      return DeadlineExceededError("Timed out decoding the clip");
+    }
+    return OkStatus();
+  }
+
+  int64_t frame_bytes() {
+    absl::MutexLock lock(&mu_);
+    return frame_bytes_;
+  }
+
+ private:
+  std::unique_ptr<GstreamerRawImageYielder> yielder_;
+  LatencyHistogram* latency_ = nullptr;
+  int64_t next_pts_ = 0;
+
+  absl::Mutex mu_;
+  absl::CondVar cv_;
+  absl::flat_hash_map<int64_t, absl::Time> feed_times_ ABSL_GUARDED_BY(mu_);
+  int64_t decoded_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t frame_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// Runs `fn(i)` for i in [0, n) on n threads and returns the first error.
+Status RunConcurrently(int n, const std::function<Status(int)>& fn) {
+  std::vector<Status> statuses(n);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n; ++i) {
+    threads.emplace_back([&, i]() { statuses[i] = fn(i); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& status : statuses) {
+    AIS_RETURN_IF_ERROR(status);
+  }
+  return OkStatus();
+}
+
+void RunYielderBenchmark(const std::vector<GstreamerBuffer>& clip,
+                         int num_pipelines, benchmark::State& state) {
+  std::vector<std::unique_ptr<YielderPipeline>> pipelines;
+  LatencyHistogram latency;
+  for (int i = 0; i < num_pipelines; ++i) {
+    pipelines.push_back(std::make_unique<YielderPipeline>());
+    CHECK(pipelines.back()->Start(clip.front().get_caps(), &latency).ok());
+  }
+  auto decode_all = [&](int i) { return pipelines[i]->DecodeClip(clip); };
+
+  // Warm up the decoders before measuring.
+  Status status = RunConcurrently(num_pipelines, decode_all);
+  if (!status.ok()) {
+    state.SkipWithError(status.error_message().c_str());
+    return;
+  }
+  latency.Reset();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    status = RunConcurrently(num_pipelines, decode_all);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+  }
+  SetCounters(latency, allocs, pipelines.front()->frame_bytes(), state);
+}
+
+// One MakeDecodedReceiverQueue consumer of its own stream, and the sender
+// that feeds it.
+class DecodedReceiverPipeline {
+ public:
+  Status Start(const InMemoryStreamServer& server, int index,
+               const std::vector<GstreamerBuffer>& clip,
+               bool native_jpeg_decode, int decode_threads) {
+    std::string stream_name = absl::StrCat("decode-benchmark-", index);
+    ConnectionOptions connection_options = server.InsecureConnectionOptions();
+
+    PacketSender::Options sender_options;
+    sender_options.connection_options = connection_options;
+    sender_options.stream_name = stream_name;
+    auto sender_statusor = PacketSender::Create(sender_options);
+    AIS_RETURN_IF_ERROR(sender_statusor.status());
+    sender_ = std::move(sender_statusor).ValueOrDie();
+
+    // MakeDecodedReceiverQueue waits for the first packet, so the first clip
+    // is sent while it is being created.
+    DecodedReceiverOptions options;
+    options.receiver_options.connection_options = connection_options;
+    options.receiver_options.stream_name = stream_name;
+    options.receiver_options.start_position = START_POSITION_EARLIEST;
+    options.queue_size = kDecodedQueueSize;
+    options.timeout = kDecodeTimeout;
+    options.native_jpeg_decode = native_jpeg_decode;
+    options.decode_threads = decode_threads;
+    options.reorder_depth = std::max(options.reorder_depth, decode_threads);
+    Status make_status;
+    std::thread make_queue(
+        [&]() { make_status = MakeDecodedReceiverQueue(options, &queue_); });
+    Status send_status = SendClip(clip);
+    make_queue.join();
+    AIS_RETURN_IF_ERROR(make_status);
+    AIS_RETURN_IF_ERROR(send_status);
+    return PopClip(clip.size(), nullptr);
+  }
+
+  // Sends the clip and waits until all of its frames are decoded.
+  Status DecodeClip(const std::vector<GstreamerBuffer>& clip,
+                    LatencyHistogram* latency) {
+    AIS_RETURN_IF_ERROR(SendClip(clip));
+    return PopClip(clip.size(), latency);
+  }
+
+  // Ends the stream and waits for the decoder to wind down.
+  void Stop() {
+    auto eos_statusor = MakeEosPacket("done");
+    if (sender_ == nullptr || !eos_statusor.ok() ||
+        !sender_->Send(std::move(eos_statusor).ValueOrDie()).ok()) {
+      return;
+    }
+    Packet packet;
+    while (queue_.TryPop(packet, kDecodeTimeout) && !IsEos(packet)) {
+    }
+  }
+
+  int64_t frame_bytes() const { return frame_bytes_; }
+
+ private:
+  Status SendClip(const std::vector<GstreamerBuffer>& clip) {
+    for (const auto& frame : clip) {
+      auto packet_statusor = MakePacket(GstreamerBuffer(frame));
+      AIS_RETURN_IF_ERROR(packet_statusor.status());
+      AIS_RETURN_IF_ERROR(
+          sender_->Send(std::move(packet_statusor).ValueOrDie()));
+    }
+    return OkStatus();
+  }
+
+  Status PopClip(int count, LatencyHistogram* latency) {
+    for (int i = 0; i < count; ++i) {
+      Packet packet;
+      if (!queue_.TryPop(packet, kDecodeTimeout)) {
+        return DeadlineExceededError("Timed out waiting for decoded frames");
+      }
+      if (IsEos(packet)) {
+        return UnavailableError("The decoded stream ended early");
+      }
+      int64_t send_nanos = packet.header().stage_times().send_nanos();
+      if (latency != nullptr && send_nanos > 0) {
+        latency->Record(
+            absl::Nanoseconds(absl::GetCurrentTimeNanos() - send_nanos));
+      }
+      frame_bytes_ = packet.payload().size();
+    }
+    return OkStatus();
+  }
+
+  std::unique_ptr<PacketSender> sender_;
+  ReceiverQueue<Packet> queue_;
+  int64_t frame_bytes_ = 0;
+};
+
+void RunDecodedReceiverBenchmark(const std::vector<GstreamerBuffer>& clip,
+                                 int num_pipelines, bool native_jpeg_decode,
+                                 int decode_threads,
+                                 benchmark::State& state) {
+  auto server = StartServer();
+
+  std::vector<std::unique_ptr<DecodedReceiverPipeline>> pipelines;
+  for (int i = 0; i < num_pipelines; ++i) {
+    pipelines.push_back(std::make_unique<DecodedReceiverPipeline>());
+  }
+  Status status = RunConcurrently(num_pipelines, [&](int i) {
+    return pipelines[i]->Start(*server, i, clip, native_jpeg_decode,
+                               decode_threads);
+  });
+
+  LatencyHistogram latency;
+  AllocationCounter allocs;
+  if (status.ok()) {
+    for (auto _ : state) {
+      status = RunConcurrently(num_pipelines, [&](int i) {
+        return pipelines[i]->DecodeClip(clip, &latency);
+      });
+      if (!status.ok()) {
+        break;
+      }
+    }
+  }
+  if (status.ok()) {
+    SetCounters(latency, allocs, pipelines.front()->frame_bytes(), state);
+  } else {
+    state.SkipWithError(status.error_message().c_str());
+  }
+  for (auto& pipeline : pipelines) {
+    pipeline->Stop();
+  }
+}
+
+template <Codec codec>
+void BM_YielderDecode(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  auto clip_statusor = MakeClip(codec, state.range(0), state.range(1));
+  if (!clip_statusor.ok()) {
+    state.SkipWithError(clip_statusor.status().error_message().c_str());
+    return;
+  }
+  RunYielderBenchmark(clip_statusor.ValueOrDie(), state.range(2), state);
+}
+
+template <Codec codec>
+void BM_DecodedReceiverQueue(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  auto clip_statusor = MakeClip(codec, state.range(0), state.range(1));
+  if (!clip_statusor.ok()) {
+    state.SkipWithError(clip_statusor.status().error_message().c_str());
+    return;
+  }
+  RunDecodedReceiverBenchmark(clip_statusor.ValueOrDie(), state.range(2),
+                              /*native_jpeg_decode=*/true,
+                              /*decode_threads=*/1, state);
+}
+
+// The JPEG clip decoded by a GStreamer pipeline rather than in-process.
+void BM_DecodedReceiverQueueGstreamerJpeg(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  auto clip_statusor = MakeClip(Codec::kJpeg, state.range(0), state.range(1));
+  if (!clip_statusor.ok()) {
+    state.SkipWithError(clip_statusor.status().error_message().c_str());
+    return;
+  }
+  RunDecodedReceiverBenchmark(clip_statusor.ValueOrDie(), state.range(2),
+                              /*native_jpeg_decode=*/false,
+                              /*decode_threads=*/1, state);
+}
+
+// The JPEG clip decoded in-process on several threads.
+void BM_DecodedReceiverQueueParallelJpeg(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  auto clip_statusor = MakeClip(Codec::kJpeg, state.range(0), state.range(1));
+  if (!clip_statusor.ok()) {
+    state.SkipWithError(clip_statusor.status().error_message().c_str());
+    return;
+  }
+  RunDecodedReceiverBenchmark(clip_statusor.ValueOrDie(), 1,
+                              /*native_jpeg_decode=*/true, state.range(2),
+                              state);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_YielderDecode, Codec::kRaw)
+    ->Apply(ResolutionsAndPipelines);
+BENCHMARK_TEMPLATE(BM_YielderDecode, Codec::kJpeg)
+    ->Apply(ResolutionsAndPipelines);
+BENCHMARK_TEMPLATE(BM_YielderDecode, Codec::kH264)
+    ->Apply(ResolutionsAndPipelines);
+
+BENCHMARK_TEMPLATE(BM_DecodedReceiverQueue, Codec::kRaw)
+    ->Apply(ResolutionsAndPipelines);
+BENCHMARK_TEMPLATE(BM_DecodedReceiverQueue, Codec::kJpeg)
+    ->Apply(ResolutionsAndPipelines);
+BENCHMARK(BM_DecodedReceiverQueueGstreamerJpeg)
+    ->Apply(ResolutionsAndPipelines);
+BENCHMARK(BM_DecodedReceiverQueueParallelJpeg)
+    ->Apply(ResolutionsAndDecodeThreads);
+BENCHMARK_TEMPLATE(BM_DecodedReceiverQueue, Codec::kH264)
+    ->Apply(ResolutionsAndPipelines);
+
+// The 512x512 test image, decoded as a sequence of identical JPEGs.
+void BM_YielderDecodeTestdataJpeg(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  auto clip_statusor = LoadJpegClip(kTestImageLenaPath);
+  if (!clip_statusor.ok()) {
+    state.SkipWithError(clip_statusor.status().error_message().c_str());
+    return;
+  }
+  RunYielderBenchmark(clip_statusor.ValueOrDie(), state.range(0), state);
+}
+BENCHMARK(BM_YielderDecodeTestdataJpeg)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// The 512x512 test image decoded in-process, at full size and at 1/2, 1/4 and
+// 1/8 scale.
+void BM_JpegDecoderTestdataJpeg(benchmark::State& state) {
+  std::string bytes;
+  CHECK(file::GetContents(kTestImageLenaPath, &bytes).ok());
+  JpegDecoder::Options options;
+  options.min_height = 512 / state.range(0);
+  options.min_width = 512 / state.range(0);
+  auto decoder = JpegDecoder::Create(options).ValueOrDie();
+  int64_t frame_bytes = 0;
+  for (auto _ : state) {
+    auto raw_image_statusor = decoder->Decode(bytes.data(), bytes.size());
+    CHECK(raw_image_statusor.ok());
+    frame_bytes = raw_image_statusor.ValueOrDie().size();
+  }
+  state.counters["fps"] =
+      benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+  state.SetBytesProcessed(state.iterations() * frame_bytes);
+}
+BENCHMARK(BM_JpegDecoderTestdataJpeg)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace aistreams
@@ -16,11 +16,24 @@
 
 #include "aistreams/cc/decoded_receivers.h"
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <map>
 #include <memory>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "aistreams/base/util/frame_rate_sampler.h"
+#include "aistreams/base/util/jpeg_decoder.h"
+#include "aistreams/base/util/pending_packet_headers.h"
+#include "aistreams/gstreamer/gst-plugins/cli_builders/aissrc_cli_builder.h"
 #include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
 #include "aistreams/gstreamer/type_utils.h"
 #include "aistreams/port/canonical_errors.h"
@@ -28,17 +41,74 @@
 #include "aistreams/port/status.h"
 #include "aistreams/port/status_macros.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/gstreamer_buffer_packet_type_descriptor.pb.h"
+#include "aistreams/util/metrics.h"
 
 namespace aistreams {
 
 namespace {
 
+// The maximum number of source packet headers remembered while their frames
+// are in the decoder. Decoders that hold back more frames than this (or drop
+// frames) only lose the header carry-over for the oldest ones.
+constexpr int kMaxPendingHeaders = 256;
+
+// The caps of GstreamerBuffers holding JPEG frames.
+constexpr char kJpegCapsString[] = "image/jpeg";
+
+// The caps of GstreamerBuffers holding raw video frames.
+constexpr char kRawVideoCapsString[] = "video/x-raw";
+
+// Drops the delta frames of the source pipeline before they are decoded.
+constexpr char kKeyframeFilter[] = "identity drop-buffer-flags=delta-unit";
+
+// How often the decoder thread of a fused pipeline checks whether the
+// consumer has released the queue.
+constexpr absl::Duration kFusedPipelinePollInterval = absl::Milliseconds(100);
+
 class ImageProducer {
  public:
+  // A further output of the decoded frames, with a queue of its own.
+  struct Output {
+    std::string name;
+    ImageTransformOptions transform;
+    std::shared_ptr<ProducerConsumerQueue<Packet>> pcqueue;
+    Counter* frames_dropped = nullptr;
+  };
+
+  // A decoded frame, transformed for the main queue and for each output.
+  struct DecodedImages {
+    RawImage image;
+    std::vector<RawImage> output_images;
+
+    // The image preprocessed into a tensor of one, if a decode thread has
+    // done so already.
+    bool has_tensor = false;
+    Tensor tensor;
+  };
+
   struct Options {
+    std::string stream_name;
     absl::Duration timeout;
+    RawImageFormat output_format;
+    bool native_jpeg_decode;
+    int decode_threads;
+    int reorder_depth;
+    bool keyframes_only;
+    double target_fps;
+    GstreamerRawImageYielder::PipelineOptions decode_pipeline;
+    int64_t decoder_queue_bytes;
+    ImageTransformOptions transform;
+    bool output_tensors;
+    ImagePreprocessor::Options tensor_options;
+    int batch_size;
     std::unique_ptr<ReceiverQueue<Packet>> source_packet_queue;
     std::shared_ptr<ProducerConsumerQueue<Packet>> dest_image_packet_pcqueue;
+    std::vector<Output> outputs;
+
+    // If set, packets come from this GStreamer source pipeline instead of
+    // `source_packet_queue`, and are decoded in the same pipeline.
+    std::string source_pipeline_string;
   };
 
   static StatusOr<std::unique_ptr<ImageProducer>> Create(Options&& options) {
@@ -51,6 +121,28 @@ class ImageProducer {
   }
 
   Status Initialize() {
+    if (decode_threads_ < 1 || reorder_depth_ < decode_threads_ ||
+        reorder_depth_ > kMaxPendingHeaders) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given %d decode threads and a reorder depth of %d; expected at "
+          "least one thread and a depth from the thread count to %d",
+          decode_threads_, reorder_depth_, kMaxPendingHeaders));
+    }
+    if (output_tensors_) {
+      if (batch_size_ < 1) {
+        return InvalidArgumentError(absl::StrFormat(
+            "Given a non-positive batch size (%d)", batch_size_));
+      }
+      auto preprocessor_statusor = ImagePreprocessor::Create(tensor_options_);
+      if (!preprocessor_statusor.ok()) {
+        return preprocessor_statusor.status();
+      }
+      preprocessor_ = std::move(preprocessor_statusor).ValueOrDie();
+    }
+    if (!source_pipeline_string_.empty()) {
+      return InitializeFusedPipeline();
+    }
+
     // We pull the first packet from the source stream and determine whether it
     // has the correct Packet type to even be decodable.
     auto first_packet_statusor = PullSourcePacket();
@@ -59,10 +151,40 @@ class ImageProducer {
       return UnavailableError("Unable to get the first packet from the server");
     }
 
-    // TODO: May need to be a bit more sophisticated to detect when packet
-    // metadata preservation makes sense. This drops it unilaterally.
+    auto first_packet = std::move(first_packet_statusor).ValueOrDie();
+    while (keyframes_only_ && IsDeltaUnit(first_packet)) {
+      frames_skipped_->Increment();
+      first_packet_statusor = PullSourcePacket();
+      if (!first_packet_statusor.ok()) {
+        LOG(ERROR) << first_packet_statusor.status();
+        return UnavailableError("Unable to get a keyframe from the server");
+      }
+      first_packet = std::move(first_packet_statusor).ValueOrDie();
+    }
+    if (IsInProcessDecodable(first_packet)) {
+      frame_sampler_.Sample(GetFrameNanos(first_packet.header()));
+      return InitializeInProcessDecode(std::move(first_packet));
+    }
+
+    // Frames of inter-frame codecs depend on those before them, so unless
+    // only keyframes are decoded, all are and the sampling follows decoding.
+    // The decoder output is then converted by the kernels, after sampling.
+    if (target_fps_ > 0 && !keyframes_only_ &&
+        first_packet.header().type().type_id() ==
+            PACKET_TYPE_GSTREAMER_BUFFER &&
+        !IsIntraOnlyCaps(first_packet)) {
+      sample_after_decode_ = true;
+      convert_after_decode_ = output_format_ == RAW_IMAGE_FORMAT_SRGB ||
+                              output_format_ == RAW_IMAGE_FORMAT_BGR ||
+                              output_format_ == RAW_IMAGE_FORMAT_RGBA;
+    } else {
+      frame_sampler_.Sample(GetFrameNanos(first_packet.header()));
+    }
+
+    // The source packet header is remembered while its frame is decoded and
+    // is carried over onto the resulting raw image packet.
     auto first_gstreamer_buffer_statusor =
-        ToGstreamerBuffer(std::move(first_packet_statusor).ValueOrDie());
+        PrepareForDecode(std::move(first_packet));
     if (!first_gstreamer_buffer_statusor.ok()) {
       LOG(ERROR) << first_gstreamer_buffer_statusor.status();
       return InvalidArgumentError(
@@ -74,10 +196,17 @@ class ImageProducer {
 
     // The packet stream type give by the caller is valid. Proceed to create a
     // GstreamerRawImageYielder to manage/run a raw image decoding pipeline.
+    SetUpCustomPipelineConversion();
     GstreamerRawImageYielder::Options yielder_options;
     yielder_options.caps_string = first_gstreamer_buffer.get_caps();
-    yielder_options.callback =
-        std::bind(&ImageProducer::PushImagePacket, this, std::placeholders::_1);
+    yielder_options.allow_caps_changes = true;
+    yielder_options.max_queued_bytes = decoder_queue_bytes_;
+    yielder_options.pipeline = decode_pipeline_;
+    yielder_options.output_format =
+        convert_after_decode_ ? RAW_IMAGE_FORMAT_UNKNOWN : output_format_;
+    yielder_options.timed_callback =
+        std::bind(&ImageProducer::PushImagePacket, this, std::placeholders::_1,
+                  std::placeholders::_2);
     auto yielder_statusor = GstreamerRawImageYielder::Create(yielder_options);
     if (!yielder_statusor.ok()) {
       LOG(ERROR) << yielder_statusor.status();
@@ -95,11 +224,290 @@ class ImageProducer {
     return OkStatus();
   }
 
+  // Helper to start a GStreamer pipeline that both receives and decodes the
+  // stream.
+  //
+  // No packet is seen before decoding, so frames are only sampled after it.
+  Status InitializeFusedPipeline() {
+    if (target_fps_ > 0) {
+      sample_after_decode_ = true;
+      convert_after_decode_ = output_format_ == RAW_IMAGE_FORMAT_SRGB ||
+                              output_format_ == RAW_IMAGE_FORMAT_BGR ||
+                              output_format_ == RAW_IMAGE_FORMAT_RGBA;
+    }
+    SetUpCustomPipelineConversion();
+    GstreamerRawImageYielder::Options yielder_options;
+    yielder_options.source_pipeline_string = source_pipeline_string_;
+    yielder_options.pipeline = decode_pipeline_;
+    if (keyframes_only_) {
+      yielder_options.source_pipeline_string = absl::StrFormat(
+          "%s ! %s", source_pipeline_string_, kKeyframeFilter);
+    }
+    yielder_options.output_format =
+        convert_after_decode_ ? RAW_IMAGE_FORMAT_UNKNOWN : output_format_;
+    yielder_options.timed_callback =
+        std::bind(&ImageProducer::PushImagePacket, this, std::placeholders::_1,
+                  std::placeholders::_2);
+    auto yielder_statusor = GstreamerRawImageYielder::Create(yielder_options);
+    if (!yielder_statusor.ok()) {
+      LOG(ERROR) << yielder_statusor.status();
+      return UnavailableError(
+          "Unable to start a pipeline that receives and decodes the stream");
+    }
+    yielder_ = std::move(yielder_statusor).ValueOrDie();
+    return OkStatus();
+  }
+
+  // Helper to have the frames of a custom decoding pipeline, whose format
+  // is not known, converted to the output format after decoding.
+  void SetUpCustomPipelineConversion() {
+    if (!decode_pipeline_.processing_pipeline_string.empty()) {
+      convert_after_decode_ = true;
+    }
+  }
+
+  // Returns true if the stream starting with the given Packet is decoded
+  // in-process rather than with a GStreamer pipeline; i.e. it is a stream of
+  // JPEG frames that a JpegDecoder can decode, or one of RawImages that
+  // already have the output format.
+  bool IsInProcessDecodable(const Packet& first_packet) const {
+    if (IsJpegPacket(first_packet)) {
+      return native_jpeg_decode_ &&
+             JpegDecoder::IsSupportedFormat(GetJpegOutputFormat());
+    }
+    if (first_packet.header().type().type_id() != PACKET_TYPE_RAW_IMAGE) {
+      return false;
+    }
+    PacketAs<RawImage> packet_as(first_packet);
+    return packet_as.ok() &&
+           (output_format_ == RAW_IMAGE_FORMAT_UNKNOWN ||
+            packet_as.ValueOrDie().format() == output_format_);
+  }
+
+  // Helper to set up in-process decoding, starting with the first packet of
+  // the stream, and to start the decode threads if there is more than one.
+  Status InitializeInProcessDecode(Packet first_packet) {
+    if (IsJpegPacket(first_packet)) {
+      JpegDecoder::Options decoder_options;
+      decoder_options.output_format = GetJpegOutputFormat();
+      GetMinDecodeSize(&decoder_options.min_height,
+                       &decoder_options.min_width);
+
+      // JpegDecoders are not thread-safe, so each thread gets its own.
+      for (int i = 0; i < decode_threads_; ++i) {
+        auto decoder_statusor = JpegDecoder::Create(decoder_options);
+        if (!decoder_statusor.ok()) {
+          LOG(ERROR) << decoder_statusor.status();
+          return InternalError("Unable to create a JpegDecoder");
+        }
+        jpeg_decoders_.push_back(std::move(decoder_statusor).ValueOrDie());
+      }
+    }
+    in_process_decode_ = true;
+
+    // The first packet is decoded on this thread, before any other.
+    auto status = DecodeAndPush(std::move(first_packet));
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return InternalError("Unable to successfully decode the first packet");
+    }
+    if (decode_threads_ > 1) {
+      // The decode threads also preprocess their frames, so that only the
+      // copy into the batch is serialized. ImagePreprocessors are not
+      // thread-safe either.
+      if (preprocessor_ != nullptr) {
+        for (int i = 0; i < decode_threads_; ++i) {
+          AIS_ASSIGN_OR_RETURN(auto preprocessor,
+                               ImagePreprocessor::Create(tensor_options_));
+          decode_preprocessors_.push_back(std::move(preprocessor));
+        }
+      }
+      decode_tasks_ =
+          std::make_unique<ProducerConsumerQueue<DecodeTask>>(reorder_depth_);
+      for (int i = 0; i < decode_threads_; ++i) {
+        decode_workers_.emplace_back(
+            &ImageProducer::DecodeLoop, this, GetJpegDecoder(i),
+            decode_preprocessors_.empty() ? nullptr
+                                          : decode_preprocessors_[i].get());
+      }
+    }
+    return OkStatus();
+  }
+
+  // Returns the JpegDecoder of the i'th decode thread, or nullptr for streams
+  // of RawImages.
+  JpegDecoder* GetJpegDecoder(int i) const {
+    return jpeg_decoders_.empty() ? nullptr : jpeg_decoders_[i].get();
+  }
+
+  // Returns true if the Packet holds a JpegFrame, or a GstreamerBuffer of
+  // one; e.g. as sent by an ingester.
+  static bool IsJpegPacket(const Packet& packet) {
+    switch (packet.header().type().type_id()) {
+      case PACKET_TYPE_JPEG:
+        return true;
+      case PACKET_TYPE_GSTREAMER_BUFFER: {
+        PacketAs<GstreamerBuffer> packet_as(packet);
+        return packet_as.ok() &&
+               absl::StartsWith(packet_as.ValueOrDie().get_caps(),
+                                kJpegCapsString);
+      }
+      default:
+        return false;
+    }
+  }
+
+  // Returns true if the Packet holds a GstreamerBuffer of a frame that can be
+  // decoded on its own; i.e. JPEG or raw video.
+  static bool IsIntraOnlyCaps(const Packet& packet) {
+    GstreamerBufferPacketTypeDescriptor desc;
+    return packet.header().type().type_descriptor().UnpackTo(&desc) &&
+           (absl::StartsWith(desc.caps_string(), kJpegCapsString) ||
+            absl::StartsWith(desc.caps_string(), kRawVideoCapsString));
+  }
+
+  // Returns true if the Packet holds a GstreamerBuffer of a delta frame. This
+  // only reads the type descriptor, not the payload.
+  static bool IsDeltaUnit(const Packet& packet) {
+    if (packet.header().type().type_id() != PACKET_TYPE_GSTREAMER_BUFFER) {
+      return false;
+    }
+    GstreamerBufferPacketTypeDescriptor desc;
+    return packet.header().type().type_descriptor().UnpackTo(&desc) &&
+           desc.delta_unit();
+  }
+
+  // Returns the time of the frame of the given header that frame sampling
+  // goes by: its capture pts if it has one, or else the time it arrived.
+  static int64_t GetFrameNanos(const PacketHeader& header) {
+    const auto& stage_times = header.stage_times();
+    if (stage_times.capture_pts_nanos() > 0) {
+      return stage_times.capture_pts_nanos();
+    }
+    if (stage_times.receive_nanos() > 0) {
+      return stage_times.receive_nanos();
+    }
+    return absl::GetCurrentTimeNanos();
+  }
+
+  // Returns true if the given source Packet should be decoded rather than be
+  // dropped by frame sampling.
+  bool ShouldDecode(const Packet& packet) {
+    if (keyframes_only_ && IsDeltaUnit(packet)) {
+      return false;
+    }
+    return sample_after_decode_ ||
+           frame_sampler_.Sample(GetFrameNanos(packet.header()));
+  }
+
+  // Returns true if the frame decoded under the given pts should be kept
+  // when sampling follows decoding.
+  bool ShouldKeepDecoded(int64_t pts) {
+    PacketHeader header;
+    return frame_sampler_.Sample(pending_headers_.Get(pts, &header)
+                                     ? GetFrameNanos(header)
+                                     : absl::GetCurrentTimeNanos());
+  }
+
+  // Returns the format the JpegDecoder should produce.
+  RawImageFormat GetJpegOutputFormat() const {
+    return output_format_ == RAW_IMAGE_FORMAT_UNKNOWN ? RAW_IMAGE_FORMAT_SRGB
+                                                      : output_format_;
+  }
+
+  // Returns the largest size that the decoded images are resized to for the
+  // main queue and the outputs, if none crops them first or keeps their
+  // size; otherwise, they are needed at their full size and 0x0 is returned.
+  void GetMinDecodeSize(int* height, int* width) const {
+    *height = 0;
+    *width = 0;
+    int min_height = 0;
+    int min_width = 0;
+    if (!GetResizeSize(transform_, output_tensors_, &min_height,
+                       &min_width)) {
+      return;
+    }
+    for (const auto& output : outputs_) {
+      int output_height = 0;
+      int output_width = 0;
+      if (!GetResizeSize(output.transform, false, &output_height,
+                         &output_width)) {
+        return;
+      }
+      min_height = std::max(min_height, output_height);
+      min_width = std::max(min_width, output_width);
+    }
+    *height = min_height;
+    *width = min_width;
+  }
+
+  // Helper to get the size that images are resized to by `transform`, or by
+  // the tensor options if `tensors` is set. Returns false if they are cropped
+  // first, as the crop region is given in pixels of the full size image, or
+  // are not resized.
+  bool GetResizeSize(const ImageTransformOptions& transform, bool tensors,
+                     int* height, int* width) const {
+    if (transform.crop_height > 0 && transform.crop_width > 0) {
+      return false;
+    }
+    if (transform.resize_height > 0 && transform.resize_width > 0) {
+      *height = transform.resize_height;
+      *width = transform.resize_width;
+    } else if (tensors) {
+      *height = tensor_options_.height;
+      *width = tensor_options_.width;
+    }
+    return *height > 0 && *width > 0;
+  }
+
   ImageProducer(Options&& options)
-      : timeout_(options.timeout),
+      : start_nanos_(absl::GetCurrentTimeNanos()),
+        timeout_(options.timeout),
+        output_format_(options.output_format),
+        native_jpeg_decode_(options.native_jpeg_decode),
+        decode_threads_(options.decode_threads),
+        reorder_depth_(options.reorder_depth),
+        keyframes_only_(options.keyframes_only),
+        target_fps_(options.target_fps),
+        frame_sampler_(options.target_fps),
+        decode_pipeline_(options.decode_pipeline),
+        decoder_queue_bytes_(options.decoder_queue_bytes),
+        transform_(options.transform),
+        output_tensors_(options.output_tensors),
+        tensor_options_(options.tensor_options),
+        batch_size_(options.batch_size),
         source_packet_queue_(std::move(options.source_packet_queue)),
         dest_image_packet_pcqueue_(
-            std::move(options.dest_image_packet_pcqueue)) {}
+            std::move(options.dest_image_packet_pcqueue)),
+        outputs_(std::move(options.outputs)),
+        source_pipeline_string_(options.source_pipeline_string) {
+    MetricsRegistry* metrics = MetricsRegistry::Global();
+    MetricLabels labels = {{"stream", options.stream_name}};
+    frames_decoded_ = metrics->GetCounter(
+        "ais_decoder_frames_total", "Frames produced by the decoder.", labels);
+    frames_dropped_ = metrics->GetCounter(
+        "ais_decoder_dropped_frames_total",
+        "Decoded frames dropped because the output queue was full.", labels);
+    frames_skipped_ = metrics->GetCounter(
+        "ais_decoder_skipped_frames_total",
+        "Source frames skipped by keyframe or frame rate sampling.", labels);
+    decode_latency_ = metrics->GetLatencyHistogram(
+        "ais_decoder_latency_seconds",
+        "Time from feeding a packet to the decoder to getting its frame.",
+        labels);
+    fps_ = metrics->GetGauge("ais_decoder_fps",
+                             "Frames decoded over the last second.", labels);
+    frames_in_flight_metric_ = metrics->GetHistogram(
+        "ais_decoder_frames_in_flight",
+        "Frames in flight across the decode threads as each is submitted.",
+        labels);
+    for (auto& output : outputs_) {
+      output.frames_dropped = metrics->GetCounter(
+          "ais_decoder_dropped_frames_total",
+          "Decoded frames dropped because the output queue was full.",
+          {{"stream", options.stream_name}, {"output", output.name}});
+    }
+  }
 
   // Helper to pull a single packet from the source packet stream.
   StatusOr<Packet> PullSourcePacket() {
@@ -113,13 +521,48 @@ class ImageProducer {
     return p;
   }
 
+  // Helper to convert the given Packet into a GstreamerBuffer for decoding.
+  //
+  // The buffer is given a fresh pts under which the packet header, stamped
+  // with the decode start time, is remembered until the frame is decoded.
+  StatusOr<GstreamerBuffer> PrepareForDecode(Packet packet) {
+    PacketHeader header = packet.header();
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
+    if (!gstreamer_buffer_statusor.ok()) {
+      return gstreamer_buffer_statusor.status();
+    }
+    auto gstreamer_buffer = std::move(gstreamer_buffer_statusor).ValueOrDie();
+    gstreamer_buffer.set_pts(RememberSourceHeader(std::move(header)));
+    return gstreamer_buffer;
+  }
+
+  // Helper to remember the given packet header, stamped with the decode start
+  // time, until its frame is decoded. Returns the fresh pts it is kept under.
+  int64_t RememberSourceHeader(PacketHeader header) {
+    int64_t now_nanos = absl::GetCurrentTimeNanos();
+    header.mutable_stage_times()->set_decode_start_nanos(now_nanos);
+    int64_t pts = std::max(last_pts_ + 1, now_nanos - start_nanos_);
+    last_pts_ = pts;
+    pending_headers_.Add(pts, std::move(header));
+    return pts;
+  }
+
+  // Helper to find the header of the source packet with the given pts.
+  //
+  // Only that header is discarded, as decoders may yield frames out of order
+  // (e.g. H264 with B-frames). If the pts is unknown, the oldest pending
+  // header is used.
+  bool TakeSourceHeader(int64_t pts, PacketHeader* header) {
+    return pending_headers_.Take(pts, header);
+  }
+
   // Helper to convert the given RawImage into a Packet, as well as pushing down
   // the shared producer/consumer queue.
-  Status PushImagePacket(StatusOr<RawImage> raw_image_statusor) {
+  Status PushImagePacket(StatusOr<RawImage> raw_image_statusor, int64_t pts) {
     if (!raw_image_statusor.ok()) {
       // We will detect/push EOS packets separately in Work().
       if (IsResourceExhausted(raw_image_statusor.status())) {
-        return OkStatus();
+        return FlushBatch();
       } else {
         LOG(ERROR) << raw_image_statusor.status();
         return InternalError(
@@ -127,35 +570,413 @@ class ImageProducer {
       }
     }
 
-    // Try to push a RawImage Packet onto the pcqueue.
-    // Drop if it is already full.
-    auto packet_statusor =
-        MakePacket(std::move(raw_image_statusor).ValueOrDie());
+    if (sample_after_decode_ && !ShouldKeepDecoded(pts)) {
+      frames_skipped_->Increment();
+      PacketHeader unused_header;
+      TakeSourceHeader(pts, &unused_header);
+      return OkStatus();
+    }
+    RawImage raw_image = std::move(raw_image_statusor).ValueOrDie();
+    if (convert_after_decode_) {
+      AIS_RETURN_IF_ERROR(ConvertToOutputFormat(&raw_image));
+    }
+    AIS_ASSIGN_OR_RETURN(DecodedImages images,
+                         TransformImage(std::move(raw_image)));
+    return DeliverImage(std::move(images), pts);
+  }
+
+  // Helper to convert the given RawImage to the output format, if one is set.
+  Status ConvertToOutputFormat(RawImage* raw_image) const {
+    if (output_format_ == RAW_IMAGE_FORMAT_UNKNOWN ||
+        raw_image->format() == output_format_) {
+      return OkStatus();
+    }
+    ImageTransformOptions convert;
+    convert.format = output_format_;
+    auto status = Transform(convert, raw_image);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return InternalError("Unable to convert the decoded raw image");
+    }
+    return OkStatus();
+  }
+
+  // Helper to apply the requested post-decode transformations: those of the
+  // outputs, each from the decoded image, and then that of the main queue.
+  //
+  // Outputs whose queue has been released are skipped.
+  StatusOr<DecodedImages> TransformImage(RawImage raw_image) const {
+    DecodedImages images;
+    images.output_images.resize(outputs_.size());
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      if (outputs_[i].pcqueue.use_count() <= 1) {
+        continue;
+      }
+      auto status = Transform(outputs_[i].transform, raw_image,
+                              &images.output_images[i]);
+      if (!status.ok()) {
+        LOG(ERROR) << status;
+        return InternalError(absl::StrFormat(
+            "Unable to transform the decoded raw image for output \"%s\"",
+            outputs_[i].name));
+      }
+    }
+    if (!IsIdentity(transform_)) {
+      auto status = Transform(transform_, &raw_image);
+      if (!status.ok()) {
+        LOG(ERROR) << status;
+        return InternalError("Unable to transform the decoded raw image");
+      }
+    }
+    images.image = std::move(raw_image);
+    return images;
+  }
+
+  // Helper to push the decoded and transformed RawImages of a frame onto the
+  // outputs, and onto the main queue either as a Packet or into the current
+  // batch.
+  //
+  // Calls are serialized, and come in the order the frames were decoded.
+  Status DeliverImage(DecodedImages images, int64_t pts) {
+    UpdateFps(absl::GetCurrentTimeNanos());
+    frames_decoded_->Increment();
+
+    PacketHeader source_header;
+    bool has_source_header = TakeSourceHeader(pts, &source_header);
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      AIS_RETURN_IF_ERROR(
+          QueueOutputPacket(outputs_[i], std::move(images.output_images[i]),
+                            has_source_header ? &source_header : nullptr));
+    }
+    if (preprocessor_ != nullptr) {
+      return AddToBatch(images, has_source_header ? &source_header : nullptr);
+    }
+    return QueuePacket(MakePacket(std::move(images.image)),
+                       has_source_header ? &source_header : nullptr, 1);
+  }
+
+  // Helper to preprocess the image of a frame into the next slot of the
+  // current batch, or to copy it there if it was preprocessed already,
+  // queueing the batch once it is full.
+  Status AddToBatch(const DecodedImages& images, PacketHeader* source_header) {
+    absl::MutexLock lock(&batch_mu_);
+    if (batch_count_ == 0) {
+      batch_ = preprocessor_->MakeTensor(batch_size_);
+      has_batch_header_ = source_header != nullptr;
+      if (has_batch_header_) {
+        batch_header_ = std::move(*source_header);
+      }
+    }
+    if (images.has_tensor) {
+      size_t slot_size = batch_.strides()[0];
+      if (images.tensor.size() != slot_size) {
+        return InternalError(absl::StrFormat(
+            "Got a preprocessed image of %d bytes for a batch slot of %d",
+            images.tensor.size(), slot_size));
+      }
+      std::memcpy(batch_.data() + batch_count_ * slot_size,
+                  images.tensor.data(), slot_size);
+    } else {
+      auto status =
+          preprocessor_->Process(images.image, batch_count_, &batch_);
+      if (!status.ok()) {
+        LOG(ERROR) << status;
+        return InternalError("Unable to preprocess the decoded raw image");
+      }
+    }
+    if (++batch_count_ < batch_size_) {
+      return OkStatus();
+    }
+    return FlushBatchLocked();
+  }
+
+  // Helper to queue the current batch, if any, even if it is not full.
+  Status FlushBatch() {
+    absl::MutexLock lock(&batch_mu_);
+    return FlushBatchLocked();
+  }
+
+  Status FlushBatchLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(batch_mu_) {
+    if (batch_count_ == 0) {
+      return OkStatus();
+    }
+    Tensor batch = std::move(batch_);
+    if (batch_count_ < batch_size_) {
+      // Keep only the filled images, which lead the buffer.
+      TensorDescriptor desc = batch.descriptor();
+      desc.set_shape(0, batch_count_);
+      size_t size = desc.offset() + batch_count_ * batch.strides()[0];
+      std::string buffer = std::move(batch).ReleaseBuffer();
+      buffer.resize(size);
+      batch = Tensor(desc, std::move(buffer));
+    }
+    int frames = batch_count_;
+    batch_count_ = 0;
+    return QueuePacket(MakePacket(std::move(batch)),
+                       has_batch_header_ ? &batch_header_ : nullptr, frames);
+  }
+
+  // Helper to push a decoded Packet of `frames` images onto the pcqueue,
+  // carrying the source packet metadata over. The packet is dropped if the
+  // pcqueue is already full.
+  Status QueuePacket(StatusOr<Packet> packet_statusor,
+                     PacketHeader* source_header, int frames) {
     if (!packet_statusor.ok()) {
       LOG(ERROR) << packet_statusor.status();
-      return InternalError("Unable to create a raw image packet");
+      return InternalError("Unable to create a decoded packet");
+    }
+    auto packet = std::move(packet_statusor).ValueOrDie();
+
+    // Keep the decoded packet type.
+    if (source_header != nullptr) {
+      PacketType decoded_type = packet.header().type();
+      *packet.mutable_header() = std::move(*source_header);
+      *packet.mutable_header()->mutable_type() = std::move(decoded_type);
+    }
+    int64_t now_nanos = absl::GetCurrentTimeNanos();
+    auto* stage_times = packet.mutable_header()->mutable_stage_times();
+    stage_times->set_decode_end_nanos(now_nanos);
+    if (stage_times->decode_start_nanos() > 0) {
+      decode_latency_->Record(
+          absl::Nanoseconds(now_nanos - stage_times->decode_start_nanos()));
+    }
+    if (!dest_image_packet_pcqueue_->TryEmplace(std::move(packet))) {
+      frames_dropped_->Increment(frames);
     }
-    dest_image_packet_pcqueue_->TryEmplace(
-        std::move(packet_statusor).ValueOrDie());
     return OkStatus();
   }
 
-  // Helper to push an EOS Packet shared producer/consumer queue.
+  // Helper to push the RawImage of a decoded frame onto the queue of an
+  // output, carrying a copy of the source packet metadata over. The packet is
+  // dropped if the queue is full, or has been released.
+  Status QueueOutputPacket(const Output& output, RawImage raw_image,
+                           const PacketHeader* source_header) {
+    if (output.pcqueue.use_count() <= 1) {
+      return OkStatus();
+    }
+    auto packet_statusor = MakePacket(std::move(raw_image));
+    if (!packet_statusor.ok()) {
+      LOG(ERROR) << packet_statusor.status();
+      return InternalError("Unable to create a decoded packet");
+    }
+    auto packet = std::move(packet_statusor).ValueOrDie();
+    if (source_header != nullptr) {
+      PacketType decoded_type = packet.header().type();
+      *packet.mutable_header() = *source_header;
+      *packet.mutable_header()->mutable_type() = std::move(decoded_type);
+    }
+    packet.mutable_header()->mutable_stage_times()->set_decode_end_nanos(
+        absl::GetCurrentTimeNanos());
+    if (!output.pcqueue->TryEmplace(std::move(packet))) {
+      output.frames_dropped->Increment();
+    }
+    return OkStatus();
+  }
+
+  // Returns true if the consumer still holds the main queue or that of an
+  // output.
+  bool IsAnyQueueHeld() const {
+    if (dest_image_packet_pcqueue_.use_count() > 1) {
+      return true;
+    }
+    for (const auto& output : outputs_) {
+      if (output.pcqueue.use_count() > 1) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Helper to publish the decoded frame rate once a second.
+  //
+  // This is only called from DeliverImage.
+  void UpdateFps(int64_t now_nanos) {
+    ++frames_in_fps_window_;
+    if (fps_window_start_nanos_ == 0) {
+      fps_window_start_nanos_ = now_nanos;
+      return;
+    }
+    int64_t elapsed_nanos = now_nanos - fps_window_start_nanos_;
+    if (elapsed_nanos >= absl::ToInt64Nanoseconds(absl::Seconds(1))) {
+      fps_->Set(frames_in_fps_window_ * 1000000000 / elapsed_nanos);
+      frames_in_fps_window_ = 0;
+      fps_window_start_nanos_ = now_nanos;
+    }
+  }
+
+  // Helper to push an EOS Packet onto each shared producer/consumer queue
+  // that the consumer still holds.
   Status PushEosPacket(const std::string& reason) {
     auto eos_packet_statusor = MakeEosPacket(reason);
     if (!eos_packet_statusor.ok()) {
       LOG(ERROR) << eos_packet_statusor.status();
       return InternalError("Couldn't create an EOS packet");
     }
-    // Block until EOS can be delivered.
-    dest_image_packet_pcqueue_->Emplace(
-        std::move(eos_packet_statusor).ValueOrDie());
+    // Block until EOS can be delivered. A released queue, which nobody pops,
+    // could block forever.
+    Packet eos_packet = std::move(eos_packet_statusor).ValueOrDie();
+    for (const auto& output : outputs_) {
+      if (output.pcqueue.use_count() > 1) {
+        output.pcqueue->Emplace(eos_packet);
+      }
+    }
+    if (dest_image_packet_pcqueue_.use_count() > 1) {
+      dest_image_packet_pcqueue_->Emplace(std::move(eos_packet));
+    }
     return OkStatus();
   }
 
+  // Helper to decode a Packet in-process and transform its image, decoding
+  // JPEG frames with the given JpegDecoder.
+  StatusOr<DecodedImages> DecodeInProcess(Packet packet,
+                                          JpegDecoder* jpeg_decoder) {
+    RawImage raw_image;
+    if (packet.header().type().type_id() == PACKET_TYPE_RAW_IMAGE) {
+      PacketAs<RawImage> packet_as(std::move(packet));
+      AIS_RETURN_IF_ERROR(packet_as.status());
+      raw_image = std::move(packet_as).ValueOrDie();
+    } else {
+      if (jpeg_decoder == nullptr) {
+        return InvalidArgumentError(absl::StrFormat(
+            "Got a packet of type %s in a stream of raw images",
+            PacketTypeId_Name(packet.header().type().type_id())));
+      }
+      StatusOr<RawImage> raw_image_statusor;
+      if (packet.header().type().type_id() == PACKET_TYPE_JPEG) {
+        PacketAs<JpegFrame> packet_as(std::move(packet));
+        AIS_RETURN_IF_ERROR(packet_as.status());
+        raw_image_statusor = jpeg_decoder->Decode(packet_as.ValueOrDie());
+      } else {
+        PacketAs<GstreamerBuffer> packet_as(std::move(packet));
+        AIS_RETURN_IF_ERROR(packet_as.status());
+        const GstreamerBuffer& gstreamer_buffer = packet_as.ValueOrDie();
+        raw_image_statusor = jpeg_decoder->Decode(gstreamer_buffer.data(),
+                                                  gstreamer_buffer.size());
+      }
+      AIS_RETURN_IF_ERROR(raw_image_statusor.status());
+      raw_image = std::move(raw_image_statusor).ValueOrDie();
+    }
+
+    // Later RawImages of a stream may come in another format.
+    AIS_RETURN_IF_ERROR(ConvertToOutputFormat(&raw_image));
+    return TransformImage(std::move(raw_image));
+  }
+
+  // Helper to push the images of a Packet decoded in-process under the given
+  // pts.
+  //
+  // Frames that fail to decode are dropped without ending the stream.
+  Status PushDecoded(StatusOr<DecodedImages> images_statusor, int64_t pts) {
+    if (!images_statusor.ok()) {
+      LOG(ERROR) << images_statusor.status();
+      PacketHeader unused_header;
+      TakeSourceHeader(pts, &unused_header);
+      return OkStatus();
+    }
+    return DeliverImage(std::move(images_statusor).ValueOrDie(), pts);
+  }
+
+  // Helper to decode a Packet in-process on this thread and push its image.
+  Status DecodeAndPush(Packet packet) {
+    int64_t pts = RememberSourceHeader(packet.header());
+    return PushDecoded(DecodeInProcess(std::move(packet), GetJpegDecoder(0)),
+                       pts);
+  }
+
+  // Helper to hand a Packet to the decode threads, numbered in source order.
+  //
+  // This blocks while `reorder_depth_` frames are already in flight.
+  void SubmitDecodeTask(Packet packet) {
+    DecodeTask task;
+    task.pts = RememberSourceHeader(packet.header());
+    task.packet = std::move(packet);
+    {
+      absl::MutexLock lock(&reorder_mu_);
+      while (frames_in_flight_ >= reorder_depth_) {
+        reorder_cv_.Wait(&reorder_mu_);
+      }
+      ++frames_in_flight_;
+      task.sequence = next_sequence_++;
+      frames_in_flight_metric_->Record(frames_in_flight_);
+    }
+    decode_tasks_->Emplace(std::move(task));
+  }
+
+  // Helper to preprocess the decoded image of a frame into a tensor of its
+  // own, for AddToBatch to copy into the batch.
+  static StatusOr<DecodedImages> Preprocess(DecodedImages images,
+                                            ImagePreprocessor* preprocessor) {
+    auto tensor_statusor = preprocessor->Process(images.image);
+    if (!tensor_statusor.ok()) {
+      LOG(ERROR) << tensor_statusor.status();
+      return InternalError("Unable to preprocess the decoded raw image");
+    }
+    images.tensor = std::move(tensor_statusor).ValueOrDie();
+    images.has_tensor = true;
+    images.image = RawImage();
+    return images;
+  }
+
+  // Main loop of a decode thread.
+  //
+  // Frames finish out of order. Each is held in `decoded_frames_` until the
+  // frames before it are pushed, and the thread that finishes the oldest
+  // frame in flight pushes every frame that is then ready. Decoding and
+  // preprocessing, with the given `preprocessor` if any, happen before that.
+  void DecodeLoop(JpegDecoder* jpeg_decoder, ImagePreprocessor* preprocessor) {
+    while (true) {
+      DecodeTask task;
+      decode_tasks_->Pop(task);
+      if (task.sequence < 0) {
+        return;
+      }
+      auto images_statusor =
+          DecodeInProcess(std::move(task.packet), jpeg_decoder);
+      if (images_statusor.ok() && preprocessor != nullptr) {
+        images_statusor = Preprocess(std::move(images_statusor).ValueOrDie(),
+                                     preprocessor);
+      }
+
+      absl::MutexLock lock(&reorder_mu_);
+      decoded_frames_.emplace(
+          task.sequence, DecodedFrame{task.pts, std::move(images_statusor)});
+      while (!decoded_frames_.empty() &&
+             decoded_frames_.begin()->first == next_delivery_) {
+        DecodedFrame frame = std::move(decoded_frames_.begin()->second);
+        decoded_frames_.erase(decoded_frames_.begin());
+        auto status = PushDecoded(std::move(frame.images), frame.pts);
+        if (!status.ok()) {
+          LOG(ERROR) << status;
+        }
+        ++next_delivery_;
+        --frames_in_flight_;
+        reorder_cv_.Signal();
+      }
+    }
+  }
+
+  // Helper to stop the decode threads once they have pushed every frame
+  // handed to them.
+  void StopDecodeThreads() {
+    for (size_t i = 0; i < decode_workers_.size(); ++i) {
+      decode_tasks_->Emplace(DecodeTask());
+    }
+    for (auto& worker : decode_workers_) {
+      worker.join();
+    }
+    decode_workers_.clear();
+  }
+
   // Helper to feed a convert/feed a Packet into the Gstreamer.
   Status Feed(Packet packet) {
-    auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
+    if (in_process_decode_) {
+      if (decode_workers_.empty()) {
+        return DecodeAndPush(std::move(packet));
+      }
+      SubmitDecodeTask(std::move(packet));
+      return OkStatus();
+    }
+    auto gstreamer_buffer_statusor = PrepareForDecode(std::move(packet));
     if (!gstreamer_buffer_statusor.ok()) {
       return gstreamer_buffer_statusor.status();
     }
@@ -167,9 +988,12 @@ class ImageProducer {
   // By the time this is run, the Gstreamer pipeline has already been
   // initialized and the first probe packet fed.
   Status Work() {
+    if (source_packet_queue_ == nullptr) {
+      return WorkFused();
+    }
     std::string termination_message;
 
-    while (dest_image_packet_pcqueue_.use_count() > 1) {
+    while (IsAnyQueueHeld()) {
       // Get a Packet from the source stream.
       auto packet_statusor = PullSourcePacket();
       if (!packet_statusor.ok()) {
@@ -183,6 +1007,8 @@ class ImageProducer {
       if (IsEos(packet)) {
         termination_message = "The raw image stream has ended";
         break;
+      } else if (!ShouldDecode(packet)) {
+        frames_skipped_->Increment();
       } else {
         auto status = Feed(std::move(packet));
         if (!status.ok()) {
@@ -193,6 +1019,32 @@ class ImageProducer {
     }
 
     // Shut the decoder down and push a final EOS packet to notify the consumer.
+    // In-process decoding holds no frames back once its threads are stopped,
+    // only a partial batch.
+    Status status;
+    if (yielder_ != nullptr) {
+      status = yielder_->SignalEOS();
+    } else {
+      StopDecodeThreads();
+      status = FlushBatch();
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
+    return PushEosPacket(termination_message);
+  }
+
+  // Main loop of the decoder thread for a fused pipeline, which runs on its
+  // own. This only waits for it to end the stream, or for the consumer to
+  // release the queues.
+  Status WorkFused() {
+    std::string termination_message;
+    while (IsAnyQueueHeld()) {
+      if (yielder_->WaitForCompletion(kFusedPipelinePollInterval)) {
+        termination_message = "The raw image stream has ended";
+        break;
+      }
+    }
     auto status = yielder_->SignalEOS();
     if (!status.ok()) {
       LOG(ERROR) << status;
@@ -201,10 +1053,79 @@ class ImageProducer {
   }
 
  private:
+  const int64_t start_nanos_;
+  int64_t last_pts_ = -1;
   absl::Duration timeout_;
+  RawImageFormat output_format_;
+  bool native_jpeg_decode_;
+  const int decode_threads_;
+  const int reorder_depth_;
+  const bool keyframes_only_;
+  const double target_fps_;
+
+  // Used by the decoder thread, or by the decoder's output thread if
+  // `sample_after_decode_` is set.
+  FrameRateSampler frame_sampler_;
+  bool sample_after_decode_ = false;
+  bool convert_after_decode_ = false;
+  GstreamerRawImageYielder::PipelineOptions decode_pipeline_;
+  const int64_t decoder_queue_bytes_;
+  ImageTransformOptions transform_;
+  bool output_tensors_;
+  ImagePreprocessor::Options tensor_options_;
+  int batch_size_;
+  std::unique_ptr<ImagePreprocessor> preprocessor_;
   std::unique_ptr<ReceiverQueue<Packet>> source_packet_queue_;
   std::shared_ptr<ProducerConsumerQueue<Packet>> dest_image_packet_pcqueue_;
+  std::vector<Output> outputs_;
+  const std::string source_pipeline_string_;
   std::unique_ptr<GstreamerRawImageYielder> yielder_;
+  bool in_process_decode_ = false;
+  std::vector<std::unique_ptr<JpegDecoder>> jpeg_decoders_;
+  std::vector<std::unique_ptr<ImagePreprocessor>> decode_preprocessors_;
+
+  Counter* frames_decoded_;
+  Counter* frames_dropped_;
+  Counter* frames_skipped_;
+  LatencyHistogram* decode_latency_;
+  Gauge* fps_;
+  Histogram* frames_in_flight_metric_;
+  int64_t frames_in_fps_window_ = 0;
+  int64_t fps_window_start_nanos_ = 0;
+
+  PendingPacketHeaders pending_headers_{kMaxPendingHeaders};
+
+  // The batch of preprocessed images being filled.
+  absl::Mutex batch_mu_;
+  Tensor batch_ ABSL_GUARDED_BY(batch_mu_);
+  int batch_count_ ABSL_GUARDED_BY(batch_mu_) = 0;
+  bool has_batch_header_ ABSL_GUARDED_BY(batch_mu_) = false;
+  PacketHeader batch_header_ ABSL_GUARDED_BY(batch_mu_);
+
+  // A Packet handed to the decode threads. A negative sequence number tells
+  // the thread that pops it to exit.
+  struct DecodeTask {
+    int64_t sequence = -1;
+    int64_t pts = 0;
+    Packet packet;
+  };
+
+  // A frame decoded by a decode thread, waiting for older frames.
+  struct DecodedFrame {
+    int64_t pts;
+    StatusOr<DecodedImages> images;
+  };
+
+  std::unique_ptr<ProducerConsumerQueue<DecodeTask>> decode_tasks_;
+  std::vector<std::thread> decode_workers_;
+
+  // The frames in flight across the decode threads, ordered by sequence.
+  absl::Mutex reorder_mu_;
+  absl::CondVar reorder_cv_;
+  int64_t next_sequence_ ABSL_GUARDED_BY(reorder_mu_) = 0;
+  int64_t next_delivery_ ABSL_GUARDED_BY(reorder_mu_) = 0;
+  int frames_in_flight_ ABSL_GUARDED_BY(reorder_mu_) = 0;
+  std::map<int64_t, DecodedFrame> decoded_frames_ ABSL_GUARDED_BY(reorder_mu_);
 };
 
 }  // namespace
@@ -212,15 +1133,65 @@ class ImageProducer {
 Status MakeDecodedReceiverQueue(
     const ReceiverOptions& options, int queue_size, absl::Duration timeout,
     ReceiverQueue<Packet>* dest_packet_receiver_queue) {
-  // Create a receiver queue that gets source packets from the stream server.
+  DecodedReceiverOptions decoded_receiver_options;
+  decoded_receiver_options.receiver_options = options;
+  decoded_receiver_options.queue_size = queue_size;
+  decoded_receiver_options.timeout = timeout;
+  return MakeDecodedReceiverQueue(decoded_receiver_options,
+                                  dest_packet_receiver_queue);
+}
+
+Status MakeDecodedReceiverQueue(
+    const DecodedReceiverOptions& decoded_receiver_options,
+    ReceiverQueue<Packet>* dest_packet_receiver_queue) {
+  DecodedReceiverOptions main_only_options = decoded_receiver_options;
+  main_only_options.outputs.clear();
+  std::map<std::string, ReceiverQueue<Packet>> unused_output_queues;
+  return MakeDecodedReceiverQueues(main_only_options,
+                                   dest_packet_receiver_queue,
+                                   &unused_output_queues);
+}
+
+Status MakeDecodedReceiverQueues(
+    const DecodedReceiverOptions& decoded_receiver_options,
+    ReceiverQueue<Packet>* dest_packet_receiver_queue,
+    std::map<std::string, ReceiverQueue<Packet>>* output_queues) {
+  const ReceiverOptions& options = decoded_receiver_options.receiver_options;
+  int queue_size = decoded_receiver_options.queue_size;
+  // Create a receiver queue that gets source packets from the stream server,
+  // or the aissrc element that does so in a fused pipeline.
   //
   // Ownership will be transferred into the decoder background thread below.
-  auto src_packet_receiver_queue = std::make_unique<ReceiverQueue<Packet>>();
-  auto status =
-      MakePacketReceiverQueue(options, src_packet_receiver_queue.get());
-  if (!status.ok()) {
-    LOG(ERROR) << status;
-    return UnknownError("Failed to create the source packet receiver queue");
+  std::unique_ptr<ReceiverQueue<Packet>> src_packet_receiver_queue;
+  std::string source_pipeline_string;
+  if (decoded_receiver_options.fused_pipeline) {
+    auto aissrc_plugin_statusor =
+        AissrcCliBuilder()
+            .SetTargetAddress(options.connection_options.target_address)
+            .SetAuthenticateWithGoogle(
+                options.connection_options.authenticate_with_google)
+            .SetStreamName(options.stream_name)
+            .SetReceiverName(options.receiver_name)
+            .SetSslOptions(options.connection_options.ssl_options)
+            .SetStartPosition(options.start_position)
+            .SetStartTime(options.start_time)
+            .SetMaxPacketAge(options.max_packet_age)
+            .SetTimeout(decoded_receiver_options.timeout)
+            .Finalize();
+    if (!aissrc_plugin_statusor.ok()) {
+      LOG(ERROR) << aissrc_plugin_statusor.status();
+      return InvalidArgumentError(
+          "Could not get a valid configuration for aissrc");
+    }
+    source_pipeline_string = std::move(aissrc_plugin_statusor).ValueOrDie();
+  } else {
+    src_packet_receiver_queue = std::make_unique<ReceiverQueue<Packet>>();
+    auto status =
+        MakePacketReceiverQueue(options, src_packet_receiver_queue.get());
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return UnknownError("Failed to create the source packet receiver queue");
+    }
   }
 
   // Create a producer/consumer queue for raw image packets.
@@ -234,16 +1205,51 @@ Status MakeDecodedReceiverQueue(
       std::make_shared<ProducerConsumerQueue<Packet>>(queue_size);
   *dest_packet_receiver_queue = ReceiverQueue<Packet>(packetized_image_pcqueue);
 
+  // Likewise for each further output.
+  std::vector<ImageProducer::Output> outputs;
+  output_queues->clear();
+  for (const auto& output_options : decoded_receiver_options.outputs) {
+    ImageProducer::Output output;
+    output.name = output_options.first;
+    output.transform = output_options.second.transform;
+    output.pcqueue = std::make_shared<ProducerConsumerQueue<Packet>>(
+        output_options.second.queue_size);
+    (*output_queues)[output.name] = ReceiverQueue<Packet>(output.pcqueue);
+    outputs.push_back(std::move(output));
+  }
+
   // Create the ImageProducer.
   //
   // Note that this will pull the first packet from the stream server to learn
   // whether it is feasible to proceed.
   ImageProducer::Options image_producer_options;
-  image_producer_options.timeout = timeout;
+  image_producer_options.stream_name = options.stream_name;
+  image_producer_options.timeout = decoded_receiver_options.timeout;
+  image_producer_options.output_format = decoded_receiver_options.output_format;
+  image_producer_options.native_jpeg_decode =
+      decoded_receiver_options.native_jpeg_decode;
+  image_producer_options.decode_threads =
+      decoded_receiver_options.decode_threads;
+  image_producer_options.reorder_depth = decoded_receiver_options.reorder_depth;
+  image_producer_options.keyframes_only =
+      decoded_receiver_options.keyframes_only;
+  image_producer_options.target_fps = decoded_receiver_options.target_fps;
+  image_producer_options.decode_pipeline =
+      decoded_receiver_options.decode_pipeline;
+  image_producer_options.decoder_queue_bytes =
+      decoded_receiver_options.decoder_queue_bytes;
+  image_producer_options.transform = decoded_receiver_options.transform;
+  image_producer_options.output_tensors =
+      decoded_receiver_options.output_tensors;
+  image_producer_options.tensor_options =
+      decoded_receiver_options.tensor_options;
+  image_producer_options.batch_size = decoded_receiver_options.batch_size;
   image_producer_options.source_packet_queue =
       std::move(src_packet_receiver_queue);
   image_producer_options.dest_image_packet_pcqueue =
       std::move(packetized_image_pcqueue);
+  image_producer_options.outputs = std::move(outputs);
+  image_producer_options.source_pipeline_string = source_pipeline_string;
   auto image_producer_statusor =
       ImageProducer::Create(std::move(image_producer_options));
   if (!image_producer_statusor.ok()) {
@@ -258,7 +1264,7 @@ Status MakeDecodedReceiverQueue(
         //
         // This terminates succesfully when any of the following is met:
         // + The source packet queue passes an EOS.
-        // + The destination image packet queue is released by the caller.
+        // + The destination image packet queues are released by the caller.
         auto status = image_producer->Work();
         if (!status.ok()) {
           LOG(ERROR) << status;
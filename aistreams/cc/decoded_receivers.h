@@ -16,12 +16,19 @@
 #ifndef AISTREAMS_CC_DECODED_RECEIVERS_H_
 #define AISTREAMS_CC_DECODED_RECEIVERS_H_
 
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <string>
 
 #include "absl/time/time.h"
+#include "aistreams/base/util/image_kernels.h"
+#include "aistreams/base/util/image_preprocessor.h"
 #include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
@@ -39,12 +46,173 @@ namespace aistreams {
 // Unlike MakePacketReceiverQueue, decoded RawImages are pushed into
 // `receiver_queue` if there is space; otherwise, they are dropped.
 //
-// TODO: Add some unit tests for this. We need to add a toy/mock server to do
-// this thoroughly.
+// The decoded RawImages keep the row padding of the decoder output (see
+// RawImage::planes); call RawImage::Pack if you need tightly packed rows.
+//
+// The stream may change resolution, or even codec, midway; the decoder
+// follows without ending the stream (see GstreamerRunnerOptions).
 Status MakeDecodedReceiverQueue(const ReceiverOptions& options, int queue_size,
                                 absl::Duration timeout,
                                 ReceiverQueue<Packet>* receiver_queue);
 
+// Options for a further output of the frames decoded by
+// MakeDecodedReceiverQueues.
+struct DecodedOutputOptions {
+  // The size of the receiver queue of this output.
+  int queue_size = 10;
+
+  // Operations to apply to each decoded RawImage before it is queued on this
+  // output; e.g. to shrink frames to the input of a model. See
+  // image_kernels.h.
+  ImageTransformOptions transform;
+};
+
+// Options for MakeDecodedReceiverQueue.
+struct DecodedReceiverOptions {
+  // Options to receive the source stream.
+  ReceiverOptions receiver_options;
+
+  // The size of the `receiver_queue` to create.
+  int queue_size = 10;
+
+  // The amount of time within which the server must yield a new source
+  // Packet before `receiver_queue` is given an EOS packet.
+  absl::Duration timeout = absl::Seconds(10);
+
+  // The format of the decoded RawImages.
+  //
+  // Video decoders produce YUV (usually I420 or NV12) natively. Asking for
+  // that, or for GRAY8 when only luma is needed, avoids a full colorspace
+  // conversion per frame. Set this to RAW_IMAGE_FORMAT_UNKNOWN to take
+  // whichever supported format the decoder produces.
+  RawImageFormat output_format = RAW_IMAGE_FORMAT_SRGB;
+
+  // If true, streams of JpegFrames, or of GstreamerBuffers with image/jpeg
+  // caps, are decoded in-process with libjpeg-turbo rather than with a
+  // GStreamer pipeline, as long as `output_format` is one that JpegDecoder
+  // produces (RAW_IMAGE_FORMAT_UNKNOWN picks SRGB). See jpeg_decoder.h.
+  //
+  // Frames that are resized by `transform` or `tensor_options` without
+  // cropping are then decoded at the smallest DCT scale (1/2, 1/4 or 1/8) at
+  // which they are still at least that large.
+  bool native_jpeg_decode = true;
+
+  // The number of threads that decode frames in parallel, for streams that
+  // are decoded in-process: those of JPEG frames (see `native_jpeg_decode`)
+  // and those of RawImages that already have `output_format`, which are only
+  // transformed. Their frames do not depend on each other, so each thread
+  // decodes and transforms whole frames, and the results are put back in
+  // source order before they are queued.
+  //
+  // Other streams are decoded on a single thread by GStreamer.
+  int decode_threads = 1;
+
+  // The most frames in flight across the decode threads, including those that
+  // are done but wait for an older frame. Pulling source packets pauses while
+  // this many are in flight. It must be from `decode_threads` to 256.
+  int reorder_depth = 16;
+
+  // If true, only keyframes are decoded; delta frames of inter-frame codecs
+  // (e.g. H264), as marked by aissink, are dropped before they reach the
+  // decoder, which then only runs at the keyframe rate. Decoding starts at the
+  // first keyframe. Every frame of a JPEG or raw image stream is a keyframe.
+  bool keyframes_only = false;
+
+  // If positive, at most this many frames a second are queued; e.g. 1 or 2
+  // for analytics that do not need every frame of a 30 fps stream. Frames are
+  // picked by their capture time when the source stamps it, and by their
+  // arrival time otherwise.
+  //
+  // Frames are dropped before decoding whenever the codec allows it: for JPEG
+  // and raw image streams, and for keyframes with `keyframes_only`. Otherwise
+  // every frame is decoded, and those not picked are dropped before their
+  // colorspace conversion, which is then done by the kernels of
+  // image_kernels.h for formats they produce from YUV.
+  double target_fps = 0;
+
+  // If true, the stream is received and decoded by a single GStreamer
+  // pipeline, `aissrc ! decodebin ! videoconvert ! appsink`, so that packets
+  // go from the network straight into the decoder instead of through a
+  // receiver queue, this process and an appsrc. It suits streams of
+  // GstreamerBuffers of compressed video, whose decoding dominates.
+  //
+  // The aissrc plugin must be on the GST_PLUGIN_PATH. Only the connection,
+  // stream and receiver names, start position and maximum packet age of
+  // `receiver_options` apply, and `timeout` is rounded up to whole seconds.
+  // The source packet headers are not carried over; the queued packets get
+  // fresh ones. Decoding is always done by GStreamer, so
+  // `native_jpeg_decode` and `decode_threads` do not apply, and frames are
+  // sampled for `target_fps` after decoding. Errors that surface after the
+  // pipeline has started, such as an undecodable stream, end the queue with
+  // an EOS packet.
+  bool fused_pipeline = false;
+
+  // Options for the GStreamer pipeline that decodes streams which are not
+  // decoded in-process; e.g. to scale frames to the input size of a model
+  // before their colorspace conversion, to run the converters on more
+  // threads, or to pick the decoder. See gstreamer_raw_image_yielder.h.
+  //
+  // Frames from a custom `processing_pipeline_string` that are not in
+  // `output_format` are converted by the kernels of image_kernels.h.
+  GstreamerRawImageYielder::PipelineOptions decode_pipeline;
+
+  // The most bytes of source frames queued for the GStreamer decoder. While
+  // it is full, pulling source packets pauses, so a decoder that is slower
+  // than the network fills the bounded receiver queue rather than memory.
+  // Set this to 0 for no bound.
+  int64_t decoder_queue_bytes = 16 << 20;
+
+  // Operations to apply to each decoded RawImage before it is queued; e.g. to
+  // crop and resize frames to the input of a model. See image_kernels.h.
+  //
+  // These run on vectorized kernels outside of the decoder. Leaving the
+  // decoder output in YUV and setting `transform.format` lets a frame be
+  // shrunk before it is converted, which is much cheaper than converting the
+  // full frame.
+  ImageTransformOptions transform;
+
+  // If true, each image is turned into a model input with `tensor_options`
+  // after `transform`, and the queue yields Packets of Tensors instead of
+  // RawImages. See image_preprocessor.h.
+  bool output_tensors = false;
+  ImagePreprocessor::Options tensor_options;
+
+  // The number of images stacked along the first dimension of each Tensor
+  // when `output_tensors` is set; e.g. an NCHW batch. The header of a batch
+  // packet is that of its first image. A partial batch is queued when the
+  // stream ends.
+  int batch_size = 1;
+
+  // Further outputs of the same decoded frames, by name, each queued on a
+  // receiver queue of its own by MakeDecodedReceiverQueues; e.g. full size
+  // frames for detection alongside 224x224 ones for classification. The
+  // stream is then received and decoded once for all of them, rather than
+  // once per MakeDecodedReceiverQueue call.
+  //
+  // Each output takes the decoded frames in `output_format`, as sampled by
+  // `keyframes_only` and `target_fps`, and applies its own transform to them;
+  // `transform` and the tensor options only apply to the main queue. As
+  // there, frames are dropped while the queue of an output is full, and the
+  // source packet headers are carried over.
+  std::map<std::string, DecodedOutputOptions> outputs;
+};
+
+// Same as above, but configured with DecodedReceiverOptions.
+//
+// The `outputs` of `options` are ignored; see MakeDecodedReceiverQueues.
+Status MakeDecodedReceiverQueue(const DecodedReceiverOptions& options,
+                                ReceiverQueue<Packet>* receiver_queue);
+
+// Same as above, but also creates a receiver queue in `output_queues` for
+// each of the `outputs` of `options`, under its name.
+//
+// Decoding goes on while any of the queues is held, and every queue that is
+// still held gets an EOS packet when the stream ends.
+Status MakeDecodedReceiverQueues(
+    const DecodedReceiverOptions& options,
+    ReceiverQueue<Packet>* receiver_queue,
+    std::map<std::string, ReceiverQueue<Packet>>* output_queues);
+
 }  // namespace aistreams
 
 #endif  // AISTREAMS_CC_DECODED_RECEIVERS_H_
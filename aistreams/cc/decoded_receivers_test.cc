@@ -0,0 +1,607 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/cc/decoded_receivers.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/testing/in_memory_stream_server.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/tensor.h"
+#include "aistreams/base/util/image_kernels.h"
+#include "aistreams/base/util/jpeg_decoder.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/file_helpers.h"
+#include "aistreams/util/metrics.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kTestImageLenaPath[] = "testdata/jpegs/lena_color.jpg";
+constexpr char kTestImagePngPath[] = "testdata/pngs/google_logo.png";
+constexpr int kLenaSize = 512;
+
+// Frames of a 30 fps stream, a little over 1/30 s apart so that every third
+// one falls on the grid of a 10 fps sampler.
+constexpr int64_t kFirstCaptureNanos = 1000000000;
+constexpr int64_t kFrameNanos = 33333334;
+
+// The first sequence number that a PacketSender stamps.
+constexpr int64_t kFirstSequenceNumber = 1;
+
+// Sends the given packets, and then an EOS, to the named stream.
+void SendStream(const InMemoryStreamServer& server,
+                const std::string& stream_name, std::vector<Packet> packets) {
+  auto eos_statusor = MakeEosPacket("done");
+  ASSERT_TRUE(eos_statusor.ok());
+  packets.push_back(std::move(eos_statusor).ValueOrDie());
+  ASSERT_TRUE(SendPackets(server, stream_name, std::move(packets)).ok());
+}
+
+DecodedReceiverOptions MakeOptions(const InMemoryStreamServer& server,
+                                   const std::string& stream_name) {
+  DecodedReceiverOptions options;
+  options.receiver_options.connection_options =
+      server.InsecureConnectionOptions();
+  options.receiver_options.stream_name = stream_name;
+  options.receiver_options.start_position = START_POSITION_EARLIEST;
+  options.queue_size = 1000;
+  return options;
+}
+
+std::string ReadLena() {
+  std::string bytes;
+  EXPECT_TRUE(file::GetContents(kTestImageLenaPath, &bytes).ok());
+  return bytes;
+}
+
+Packet MakeJpegPacket(std::string bytes) {
+  auto packet_statusor = MakePacket(JpegFrame(std::move(bytes)));
+  EXPECT_TRUE(packet_statusor.ok());
+  return std::move(packet_statusor).ValueOrDie();
+}
+
+// Pops the packets of `receiver_queue` up to its EOS, which must come.
+std::vector<Packet> PopUntilEos(ReceiverQueue<Packet>* receiver_queue) {
+  std::vector<Packet> packets;
+  while (true) {
+    Packet packet;
+    if (!receiver_queue->TryPop(packet, absl::Seconds(30))) {
+      ADD_FAILURE() << "Timed out waiting for an EOS packet";
+      return packets;
+    }
+    if (IsEos(packet)) {
+      return packets;
+    }
+    packets.push_back(std::move(packet));
+  }
+}
+
+RawImage ToRawImage(Packet packet) {
+  PacketAs<RawImage> packet_as(std::move(packet));
+  EXPECT_TRUE(packet_as.ok());
+  RawImage raw_image = std::move(packet_as).ValueOrDie();
+  raw_image.Pack();
+  return raw_image;
+}
+
+void ExpectSameImage(RawImage expected, RawImage actual) {
+  expected.Pack();
+  actual.Pack();
+  ASSERT_EQ(expected.height(), actual.height());
+  ASSERT_EQ(expected.width(), actual.width());
+  ASSERT_EQ(expected.format(), actual.format());
+  ASSERT_EQ(expected.size(), actual.size());
+  EXPECT_EQ(std::memcmp(expected.data(), actual.data(), expected.size()), 0);
+}
+
+// Returns a packet of a raw image filled with `value`, captured at `pts`.
+Packet MakeRawImagePacket(int height, int width, uint8_t value,
+                          int64_t pts_nanos) {
+  RawImage raw_image(height, width, RAW_IMAGE_FORMAT_SRGB);
+  std::memset(raw_image.data(), value, raw_image.size());
+  auto packet_statusor = MakePacket(std::move(raw_image));
+  EXPECT_TRUE(packet_statusor.ok());
+  Packet packet = std::move(packet_statusor).ValueOrDie();
+  packet.mutable_header()->mutable_stage_times()->set_capture_pts_nanos(
+      pts_nanos);
+  return packet;
+}
+
+// Returns a packet of a GstreamerBuffer of `bytes`, captured at `pts`.
+Packet MakeGstreamerBufferPacket(const std::string& caps, std::string bytes,
+                                 bool delta_unit, int64_t pts_nanos) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(caps);
+  gstreamer_buffer.set_delta_unit(delta_unit);
+  gstreamer_buffer.assign(std::move(bytes));
+  auto packet_statusor = MakePacket(std::move(gstreamer_buffer));
+  EXPECT_TRUE(packet_statusor.ok());
+  Packet packet = std::move(packet_statusor).ValueOrDie();
+  packet.mutable_header()->mutable_stage_times()->set_capture_pts_nanos(
+      pts_nanos);
+  return packet;
+}
+
+// Returns the sequence numbers of the given packets, less the first one.
+std::vector<int64_t> GetSourceIndices(const std::vector<Packet>& packets) {
+  std::vector<int64_t> indices;
+  for (const auto& packet : packets) {
+    indices.push_back(packet.header().sequence_number() -
+                      kFirstSequenceNumber);
+  }
+  return indices;
+}
+
+int64_t GetSkippedFrames(const std::string& stream_name) {
+  return MetricsRegistry::Global()
+      ->GetCounter("ais_decoder_skipped_frames_total", "",
+                   {{"stream", stream_name}})
+      ->Value();
+}
+
+RawImage DecodeLena(int min_height, int min_width) {
+  JpegDecoder::Options options;
+  options.min_height = min_height;
+  options.min_width = min_width;
+  auto decoder_statusor = JpegDecoder::Create(options);
+  EXPECT_TRUE(decoder_statusor.ok());
+  auto raw_image_statusor =
+      decoder_statusor.ValueOrDie()->Decode(JpegFrame(ReadLena()));
+  EXPECT_TRUE(raw_image_statusor.ok());
+  return std::move(raw_image_statusor).ValueOrDie();
+}
+
+}  // namespace
+
+TEST(DecodedReceiversTest, JpegDecodeTest) {
+  auto server = StartServer();
+  std::vector<Packet> packets;
+  for (int i = 0; i < 5; ++i) {
+    packets.push_back(MakeJpegPacket(i == 2 ? "not a jpeg" : ReadLena()));
+  }
+  SendStream(*server, "jpeg", std::move(packets));
+
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(
+      MakeDecodedReceiverQueue(MakeOptions(*server, "jpeg"), &receiver_queue)
+          .ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+
+  // The frame that does not decode is dropped without ending the stream.
+  std::vector<int64_t> expected_sequence_numbers = {0, 1, 3, 4};
+  ASSERT_EQ(decoded.size(), expected_sequence_numbers.size());
+  RawImage lena = DecodeLena(0, 0);
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    EXPECT_EQ(decoded[i].header().sequence_number(),
+              kFirstSequenceNumber + expected_sequence_numbers[i]);
+    EXPECT_GT(decoded[i].header().stage_times().decode_end_nanos(), 0);
+    RawImage raw_image = ToRawImage(std::move(decoded[i]));
+    EXPECT_EQ(raw_image.height(), kLenaSize);
+    EXPECT_EQ(raw_image.width(), kLenaSize);
+    ExpectSameImage(lena, std::move(raw_image));
+  }
+}
+
+TEST(DecodedReceiversTest, JpegDctScalingTest) {
+  auto server = StartServer();
+  std::vector<Packet> packets;
+  for (int i = 0; i < 3; ++i) {
+    packets.push_back(MakeJpegPacket(ReadLena()));
+  }
+  SendStream(*server, "scaled", std::move(packets));
+
+  // Frames resized to 64x64 are decoded straight to that size, at 1/8 scale,
+  // rather than decoded in full and resized.
+  DecodedReceiverOptions options = MakeOptions(*server, "scaled");
+  options.transform.resize_height = 64;
+  options.transform.resize_width = 64;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), 3);
+  RawImage scaled_lena = DecodeLena(64, 64);
+  ASSERT_EQ(scaled_lena.height(), 64);
+  for (auto& packet : decoded) {
+    ExpectSameImage(scaled_lena, ToRawImage(std::move(packet)));
+  }
+}
+
+TEST(DecodedReceiversTest, JpegCropDecodesFullSizeTest) {
+  auto server = StartServer();
+  std::vector<Packet> packets;
+  packets.push_back(MakeJpegPacket(ReadLena()));
+  SendStream(*server, "cropped", std::move(packets));
+
+  // The crop region is in pixels of the full size frame, so it is decoded at
+  // that size.
+  DecodedReceiverOptions options = MakeOptions(*server, "cropped");
+  options.transform.crop_y = 128;
+  options.transform.crop_x = 64;
+  options.transform.crop_height = 256;
+  options.transform.crop_width = 256;
+  options.transform.resize_height = 64;
+  options.transform.resize_width = 64;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), 1);
+  RawImage expected = DecodeLena(0, 0);
+  ASSERT_TRUE(Transform(options.transform, &expected).ok());
+  ExpectSameImage(std::move(expected), ToRawImage(std::move(decoded[0])));
+}
+
+TEST(DecodedReceiversTest, ParallelDecodeOrderTest) {
+  auto server = StartServer();
+
+  // Every fourth frame is much larger, so the decode threads finish frames
+  // out of order.
+  constexpr int kNumFrames = 200;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    int size = i % 4 == 0 ? 256 : 8;
+    packets.push_back(MakeRawImagePacket(size, size, i % 256, i * kFrameNanos));
+  }
+  SendStream(*server, "parallel-raw", std::move(packets));
+
+  DecodedReceiverOptions options = MakeOptions(*server, "parallel-raw");
+  options.decode_threads = 4;
+  options.reorder_depth = 4;
+  options.transform.resize_height = 16;
+  options.transform.resize_width = 16;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+
+  // Every frame comes before the EOS, in source order and with the header of
+  // its source packet.
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), kNumFrames);
+  for (int i = 0; i < kNumFrames; ++i) {
+    const PacketHeader& header = decoded[i].header();
+    EXPECT_EQ(header.sequence_number(), kFirstSequenceNumber + i);
+    EXPECT_EQ(header.stage_times().capture_pts_nanos(), i * kFrameNanos);
+    RawImage raw_image = ToRawImage(std::move(decoded[i]));
+    ASSERT_EQ(raw_image.height(), 16);
+    ASSERT_EQ(raw_image.width(), 16);
+    EXPECT_EQ(raw_image.data()[0], i % 256);
+  }
+
+  // The first frame is decoded before the threads start, and no more than
+  // `reorder_depth` frames are ever in flight after it.
+  Histogram* frames_in_flight = MetricsRegistry::Global()->GetHistogram(
+      "ais_decoder_frames_in_flight", "", {{"stream", "parallel-raw"}});
+  EXPECT_EQ(frames_in_flight->count(), kNumFrames - 1);
+  EXPECT_GE(frames_in_flight->max(), 1);
+  EXPECT_LE(frames_in_flight->max(), options.reorder_depth);
+}
+
+TEST(DecodedReceiversTest, ParallelTensorBatchTest) {
+  auto server = StartServer();
+  constexpr int kNumFrames = 31;
+  constexpr int kBatchSize = 4;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    int size = i % 4 == 0 ? 256 : 8;
+    packets.push_back(MakeRawImagePacket(size, size, i, i * kFrameNanos));
+  }
+  SendStream(*server, "parallel-tensor", std::move(packets));
+
+  // The decode threads preprocess the frames, which still land in the
+  // batches in source order.
+  DecodedReceiverOptions options = MakeOptions(*server, "parallel-tensor");
+  options.decode_threads = 4;
+  options.reorder_depth = 4;
+  options.output_tensors = true;
+  options.tensor_options.height = 4;
+  options.tensor_options.width = 4;
+  options.tensor_options.dtype = TENSOR_DATA_TYPE_UINT8;
+  options.batch_size = kBatchSize;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+
+  std::vector<Packet> batches = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(batches.size(), (kNumFrames + kBatchSize - 1) / kBatchSize);
+  int frame = 0;
+  for (auto& batch_packet : batches) {
+    PacketAs<Tensor> packet_as(std::move(batch_packet));
+    ASSERT_TRUE(packet_as.ok());
+    const Tensor& batch = packet_as.ValueOrDie();
+    for (int64_t b = 0; b < batch.dim(0); ++b, ++frame) {
+      const uint8_t* image = batch.data() + b * batch.strides()[0];
+      for (int64_t j = 0; j < batch.strides()[0]; ++j) {
+        ASSERT_EQ(image[j], frame) << "frame " << frame;
+      }
+    }
+  }
+  EXPECT_EQ(frame, kNumFrames);
+}
+
+TEST(DecodedReceiversTest, ParallelJpegDecodeTest) {
+  auto server = StartServer();
+  constexpr int kNumFrames = 30;
+  constexpr int kJunkFrame = 7;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    packets.push_back(
+        MakeJpegPacket(i == kJunkFrame ? "not a jpeg" : ReadLena()));
+  }
+  SendStream(*server, "parallel-jpeg", std::move(packets));
+
+  DecodedReceiverOptions options = MakeOptions(*server, "parallel-jpeg");
+  options.decode_threads = 4;
+  options.reorder_depth = 4;
+  options.transform.resize_height = 64;
+  options.transform.resize_width = 64;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+
+  // The frame that does not decode is dropped without holding back the
+  // frames after it.
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), kNumFrames - 1);
+  RawImage scaled_lena = DecodeLena(64, 64);
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    int64_t source_index = i < kJunkFrame ? i : i + 1;
+    EXPECT_EQ(decoded[i].header().sequence_number(),
+              kFirstSequenceNumber + source_index);
+    ExpectSameImage(scaled_lena, ToRawImage(std::move(decoded[i])));
+  }
+}
+
+TEST(DecodedReceiversTest, ReorderDepthBelowDecodeThreadsTest) {
+  auto server = StartServer();
+  DecodedReceiverOptions options = MakeOptions(*server, "shallow");
+  options.decode_threads = 4;
+  options.reorder_depth = 2;
+  ReceiverQueue<Packet> receiver_queue;
+  EXPECT_FALSE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+}
+
+class SamplingTest : public ::testing::TestWithParam<int> {
+ protected:
+  // Returns options for the named stream, decoded on `GetParam()` threads.
+  DecodedReceiverOptions MakeSamplingOptions(const InMemoryStreamServer& server,
+                                             const std::string& stream_name) {
+    DecodedReceiverOptions options = MakeOptions(server, stream_name);
+    options.decode_threads = GetParam();
+    options.reorder_depth = 4;
+    return options;
+  }
+};
+
+TEST_P(SamplingTest, TargetFpsBeforeDecodeTest) {
+  auto server = StartServer();
+  std::string stream_name = absl::StrCat("raw-fps-", GetParam());
+  constexpr int kNumFrames = 60;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    packets.push_back(
+        MakeRawImagePacket(8, 8, i, kFirstCaptureNanos + i * kFrameNanos));
+  }
+  SendStream(*server, stream_name, std::move(packets));
+
+  // A 30 fps stream sampled at 10 fps keeps every third frame, by its
+  // capture time. Raw images are sampled before they are transformed.
+  DecodedReceiverOptions options = MakeSamplingOptions(*server, stream_name);
+  options.target_fps = 10;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), kNumFrames / 3);
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    EXPECT_EQ(decoded[i].header().sequence_number(),
+              kFirstSequenceNumber + 3 * i);
+    EXPECT_EQ(decoded[i].header().stage_times().capture_pts_nanos(),
+              kFirstCaptureNanos + 3 * i * kFrameNanos);
+    EXPECT_EQ(ToRawImage(std::move(decoded[i])).data()[0], 3 * i);
+  }
+  EXPECT_EQ(GetSkippedFrames(stream_name), kNumFrames - kNumFrames / 3);
+}
+
+TEST_P(SamplingTest, KeyframesOnlyTest) {
+  auto server = StartServer();
+  std::string stream_name = absl::StrCat("keyframes-", GetParam());
+
+  // Every third frame is a keyframe, starting with the third one.
+  constexpr int kNumFrames = 12;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    packets.push_back(MakeGstreamerBufferPacket(
+        "image/jpeg", ReadLena(), i % 3 != 2,
+        kFirstCaptureNanos + i * kFrameNanos));
+  }
+  SendStream(*server, stream_name, std::move(packets));
+
+  // Only the keyframes are decoded, in-process, starting at the first one.
+  DecodedReceiverOptions options = MakeSamplingOptions(*server, stream_name);
+  options.keyframes_only = true;
+  options.transform.resize_height = 64;
+  options.transform.resize_width = 64;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  EXPECT_EQ(GetSourceIndices(decoded), std::vector<int64_t>({2, 5, 8, 11}));
+  RawImage scaled_lena = DecodeLena(64, 64);
+  for (auto& packet : decoded) {
+    ExpectSameImage(scaled_lena, ToRawImage(std::move(packet)));
+  }
+  EXPECT_EQ(GetSkippedFrames(stream_name), 8);
+}
+
+TEST_P(SamplingTest, KeyframesOnlyWithTargetFpsTest) {
+  auto server = StartServer();
+  std::string stream_name = absl::StrCat("keyframes-fps-", GetParam());
+
+  // Keyframes every other frame of a 30 fps stream, so 15 a second.
+  constexpr int kNumFrames = 24;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    packets.push_back(MakeGstreamerBufferPacket(
+        "image/jpeg", ReadLena(), i % 2 != 0,
+        kFirstCaptureNanos + i * kFrameNanos));
+  }
+  SendStream(*server, stream_name, std::move(packets));
+
+  // Delta frames are dropped first, and the keyframes are then sampled at
+  // 5 fps, all before decoding: every third keyframe, on a grid of 6 frames.
+  DecodedReceiverOptions options = MakeSamplingOptions(*server, stream_name);
+  options.keyframes_only = true;
+  options.target_fps = 5;
+  options.transform.resize_height = 64;
+  options.transform.resize_width = 64;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  EXPECT_EQ(GetSourceIndices(decoded), std::vector<int64_t>({0, 6, 12, 18}));
+  EXPECT_EQ(GetSkippedFrames(stream_name), kNumFrames - 4);
+}
+
+INSTANTIATE_TEST_SUITE_P(DecodeThreads, SamplingTest, ::testing::Values(1, 4));
+
+// Needs the GStreamer png decoder.
+TEST(DecodedReceiversTest, TargetFpsAfterDecodeTest) {
+  auto server = StartServer();
+  std::string png;
+  ASSERT_TRUE(file::GetContents(kTestImagePngPath, &png).ok());
+  constexpr int kNumFrames = 30;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumFrames; ++i) {
+    packets.push_back(MakeGstreamerBufferPacket(
+        "image/png", png, false, kFirstCaptureNanos + i * kFrameNanos));
+  }
+  SendStream(*server, "png-fps", std::move(packets));
+
+  // Caps other than those of JPEG and raw video may be those of inter-frame
+  // codecs, so every frame is decoded by GStreamer and sampled after.
+  DecodedReceiverOptions options = MakeOptions(*server, "png-fps");
+  options.target_fps = 10;
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(MakeDecodedReceiverQueue(options, &receiver_queue).ok());
+  std::vector<Packet> decoded = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(decoded.size(), kNumFrames / 3);
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    EXPECT_EQ(decoded[i].header().sequence_number(),
+              kFirstSequenceNumber + 3 * i);
+    EXPECT_EQ(decoded[i].header().stage_times().capture_pts_nanos(),
+              kFirstCaptureNanos + 3 * i * kFrameNanos);
+  }
+  EXPECT_EQ(GetSkippedFrames("png-fps"), kNumFrames - kNumFrames / 3);
+}
+
+class OutputsTest : public ::testing::TestWithParam<int> {
+ protected:
+  static constexpr int kNumFrames = 10;
+
+  // Sends lena frames to the named stream, and returns options to decode it
+  // on `GetParam()` threads into a 64x64 main queue and two further outputs:
+  // "full", which is not transformed, and "small", which is 16x16 GRAY8.
+  DecodedReceiverOptions SendAndMakeOptions(const InMemoryStreamServer& server,
+                                            const std::string& stream_name) {
+    std::vector<Packet> packets;
+    for (int i = 0; i < kNumFrames; ++i) {
+      packets.push_back(MakeJpegPacket(ReadLena()));
+    }
+    SendStream(server, stream_name, std::move(packets));
+
+    DecodedReceiverOptions options = MakeOptions(server, stream_name);
+    options.decode_threads = GetParam();
+    options.reorder_depth = 4;
+    options.transform.resize_height = 64;
+    options.transform.resize_width = 64;
+    options.outputs["full"].queue_size = 100;
+    options.outputs["small"].queue_size = 100;
+    options.outputs["small"].transform.resize_height = 16;
+    options.outputs["small"].transform.resize_width = 16;
+    options.outputs["small"].transform.format = RAW_IMAGE_FORMAT_GRAY8;
+    return options;
+  }
+
+  // Expects `decoded` to hold every frame sent, in order, each being lena
+  // as transformed by `transform`.
+  void ExpectTransformedFrames(const ImageTransformOptions& transform,
+                               std::vector<Packet> decoded) {
+    ASSERT_EQ(decoded.size(), kNumFrames);
+    RawImage expected = DecodeLena(0, 0);
+    ASSERT_TRUE(Transform(transform, &expected).ok());
+    for (int i = 0; i < kNumFrames; ++i) {
+      EXPECT_EQ(decoded[i].header().sequence_number(),
+                kFirstSequenceNumber + i);
+      ExpectSameImage(expected, ToRawImage(std::move(decoded[i])));
+    }
+  }
+};
+
+constexpr int OutputsTest::kNumFrames;
+
+TEST_P(OutputsTest, EachOutputTransformsTest) {
+  auto server = StartServer();
+  std::string stream_name = absl::StrCat("outputs-", GetParam());
+  DecodedReceiverOptions options = SendAndMakeOptions(*server, stream_name);
+  ReceiverQueue<Packet> receiver_queue;
+  std::map<std::string, ReceiverQueue<Packet>> output_queues;
+  ASSERT_TRUE(
+      MakeDecodedReceiverQueues(options, &receiver_queue, &output_queues).ok());
+  ASSERT_EQ(output_queues.size(), 2);
+
+  // The frames are decoded once, at full size for the "full" output, and
+  // each queue gets them with its own transform, then an EOS.
+  std::vector<Packet> main_frames = PopUntilEos(&receiver_queue);
+  ASSERT_EQ(main_frames.size(), kNumFrames);
+  for (auto& packet : main_frames) {
+    RawImage raw_image = ToRawImage(std::move(packet));
+    EXPECT_EQ(raw_image.height(), 64);
+    EXPECT_EQ(raw_image.width(), 64);
+    EXPECT_EQ(raw_image.format(), RAW_IMAGE_FORMAT_SRGB);
+  }
+  ExpectTransformedFrames(ImageTransformOptions(),
+                          PopUntilEos(&output_queues["full"]));
+  ExpectTransformedFrames(options.outputs["small"].transform,
+                          PopUntilEos(&output_queues["small"]));
+}
+
+TEST_P(OutputsTest, ReleasedQueueTest) {
+  auto server = StartServer();
+  std::string stream_name = absl::StrCat("released-", GetParam());
+  DecodedReceiverOptions options = SendAndMakeOptions(*server, stream_name);
+  ReceiverQueue<Packet> receiver_queue;
+  std::map<std::string, ReceiverQueue<Packet>> output_queues;
+  ASSERT_TRUE(
+      MakeDecodedReceiverQueues(options, &receiver_queue, &output_queues).ok());
+
+  // Decoding goes on for the outputs once the main queue is released, and
+  // each of them still gets an EOS.
+  receiver_queue = ReceiverQueue<Packet>();
+  ExpectTransformedFrames(options.outputs["small"].transform,
+                          PopUntilEos(&output_queues["small"]));
+  ExpectTransformedFrames(ImageTransformOptions(),
+                          PopUntilEos(&output_queues["full"]));
+}
+
+INSTANTIATE_TEST_SUITE_P(DecodeThreads, OutputsTest, ::testing::Values(1, 4));
+
+}  // namespace aistreams
@@ -15,12 +15,16 @@
 #include "aistreams/cc/ingesters.h"
 
 #include <regex>
+#include <set>
 #include <string>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/time/time.h"
 #include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/cc/ingesters_internal.h"
 #include "aistreams/gstreamer/gst-plugins/cli_builders/aissink_cli_builder.h"
 #include "aistreams/gstreamer/gstreamer_utils.h"
 #include "aistreams/port/logging.h"
@@ -32,6 +36,11 @@ namespace aistreams {
 
 namespace {
 
+// The names of the tees that split the parsed and the decoded source among
+// the streams of a multi-output ingestion.
+constexpr char kParsedTeeName[] = "parsed";
+constexpr char kDecodedTeeName[] = "decoded";
+
 std::string SetPluginParam(absl::string_view parameter_name,
                            absl::string_view value) {
   if (value.empty()) {
@@ -118,9 +127,144 @@ std::string DecideCodecPlugins(const IngesterOptions& options) {
   }
 }
 
-// Decide what the full gst pipeline should be given the options and source uri.
+// Append the plugins that resize and re-encode decoded frames into the sending
+// format.
+void AppendTranscodePlugins(const IngesterOptions& options,
+                            std::vector<std::string>* gst_pipeline) {
+  auto resize_plugin = DecideResizePlugin(options);
+  if (!resize_plugin.empty()) {
+    gst_pipeline->push_back(resize_plugin);
+  }
+  auto codec_plugin = DecideCodecPlugins(options);
+  if (!codec_plugin.empty()) {
+    gst_pipeline->push_back(codec_plugin);
+  }
+}
+
+// Decide the aissink plugin configuration that sends to the target stream.
+StatusOr<std::string> DecideAissinkPlugin(const IngesterOptions& options) {
+  AissinkCliBuilder aissink_cli_builder;
+  auto aissink_plugin_statusor =
+      aissink_cli_builder
+          .SetTargetAddress(options.connection_options.target_address)
+          .SetAuthenticateWithGoogle(
+              options.connection_options.authenticate_with_google)
+          .SetStreamName(options.target_stream_name)
+          .SetSslOptions(options.connection_options.ssl_options)
+          .Finalize();
+  if (!aissink_plugin_statusor.ok()) {
+    LOG(ERROR) << aissink_plugin_statusor.status();
+    return InvalidArgumentError(
+        "Could not get a valid configuration for aissink");
+  }
+  return std::move(aissink_plugin_statusor).ValueOrDie();
+}
+
+// Returns the options of each stream to send to: those of the target stream,
+// and those of each additional output, which shares its connection.
+std::vector<IngesterOptions> GetStreamOptions(const IngesterOptions& options) {
+  std::vector<IngesterOptions> streams;
+  IngesterOptions stream_options = options;
+  stream_options.additional_outputs.clear();
+  streams.push_back(stream_options);
+  for (const auto& output : options.additional_outputs) {
+    stream_options.target_stream_name = output.target_stream_name;
+    stream_options.send_codec = output.send_codec;
+    stream_options.resize_height = output.resize_height;
+    stream_options.resize_width = output.resize_width;
+    streams.push_back(stream_options);
+  }
+  return streams;
+}
+
+// Decide the full gst pipeline that sends the source to several streams.
+//
+// The source is parsed once, and decoded once for all the streams that
+// require a transcode. Tees then feed a branch per stream:
+//
+// source ! parsebin ! tee name=parsed
+//   parsed. ! queue ! aissink (for each stream sent in the native codec)
+//   parsed. ! queue ! decodebin ! tee name=decoded
+//     decoded. ! queue ! videoscale ! encoder ! aissink (for each other one)
+//
+// Without streams in the native codec, decodebin takes the source directly.
+//
+// A queue decouples the threads of the branches, but the tee still waits for
+// one that is full, unless `leaky_outputs` is set.
+StatusOr<std::string> DecideMultiOutputGstLaunchPipeline(
+    const IngesterOptions& options, const std::string& source_uri) {
+  std::string queue_plugin = "queue";
+  if (options.leaky_outputs) {
+    if (options.output_queue_buffers < 1) {
+      return InvalidArgumentError(
+          absl::StrFormat("Given leaky outputs with a queue of %d buffers",
+                          options.output_queue_buffers));
+    }
+    queue_plugin = absl::StrFormat(
+        "queue leaky=downstream max-size-buffers=%d max-size-bytes=0 "
+        "max-size-time=0",
+        options.output_queue_buffers);
+  }
+
+  std::set<std::string> stream_names;
+  std::vector<std::string> native_branches;
+  std::vector<std::string> transcode_branches;
+  for (const auto& stream : GetStreamOptions(options)) {
+    if (!stream_names.insert(stream.target_stream_name).second) {
+      return InvalidArgumentError(
+          absl::StrFormat("Given the target stream \"%s\" more than once",
+                          stream.target_stream_name));
+    }
+
+    std::vector<std::string> branch = {queue_plugin};
+    bool transcode = IsTranscodeRequired(stream);
+    if (transcode) {
+      AppendTranscodePlugins(stream, &branch);
+    }
+    auto aissink_plugin_statusor = DecideAissinkPlugin(stream);
+    if (!aissink_plugin_statusor.ok()) {
+      return aissink_plugin_statusor.status();
+    }
+    branch.push_back(std::move(aissink_plugin_statusor).ValueOrDie());
+    (transcode ? transcode_branches : native_branches)
+        .push_back(absl::StrJoin(branch, " ! "));
+  }
+
+  std::string source_plugin = DecideInputPlugin(source_uri);
+  std::string gst_pipeline;
+  if (native_branches.empty()) {
+    gst_pipeline = absl::StrFormat("%s ! decodebin ! tee name=%s",
+                                   source_plugin, kDecodedTeeName);
+  } else {
+    gst_pipeline = absl::StrFormat("%s ! parsebin ! tee name=%s",
+                                   source_plugin, kParsedTeeName);
+    for (const auto& branch : native_branches) {
+      absl::StrAppend(&gst_pipeline,
+                      absl::StrFormat(" %s. ! %s", kParsedTeeName, branch));
+    }
+    if (!transcode_branches.empty()) {
+      absl::StrAppend(
+          &gst_pipeline,
+          absl::StrFormat(" %s. ! %s ! decodebin ! tee name=%s",
+                          kParsedTeeName, queue_plugin, kDecodedTeeName));
+    }
+  }
+  for (const auto& branch : transcode_branches) {
+    absl::StrAppend(&gst_pipeline,
+                    absl::StrFormat(" %s. ! %s", kDecodedTeeName, branch));
+  }
+  return gst_pipeline;
+}
+
+}  // namespace
+
+namespace ingesters_internal {
+
 StatusOr<std::string> DecideGstLaunchPipeline(const IngesterOptions& options,
                                               const std::string& source_uri) {
+  if (!options.additional_outputs.empty()) {
+    return DecideMultiOutputGstLaunchPipeline(options, source_uri);
+  }
   std::vector<std::string> gst_pipeline;
 
   // This is the plugin that accepts the source uri into the pipeline.
@@ -138,37 +282,20 @@ StatusOr<std::string> DecideGstLaunchPipeline(const IngesterOptions& options,
     gst_pipeline.push_back("parsebin");
   } else {
     gst_pipeline.push_back("decodebin");
-    auto resize_plugin = DecideResizePlugin(options);
-    if (!resize_plugin.empty()) {
-      gst_pipeline.push_back(resize_plugin);
-    }
-    auto codec_plugin = DecideCodecPlugins(options);
-    if (!codec_plugin.empty()) {
-      gst_pipeline.push_back(codec_plugin);
-    }
+    AppendTranscodePlugins(options, &gst_pipeline);
   }
 
   // Configure aissink.
-  AissinkCliBuilder aissink_cli_builder;
-  auto aissink_plugin_statusor =
-      aissink_cli_builder
-          .SetTargetAddress(options.connection_options.target_address)
-          .SetAuthenticateWithGoogle(
-              options.connection_options.authenticate_with_google)
-          .SetStreamName(options.target_stream_name)
-          .SetSslOptions(options.connection_options.ssl_options)
-          .Finalize();
+  auto aissink_plugin_statusor = DecideAissinkPlugin(options);
   if (!aissink_plugin_statusor.ok()) {
-    LOG(ERROR) << aissink_plugin_statusor.status();
-    return InvalidArgumentError(
-        "Could not get a valid configuration for aissink");
+    return aissink_plugin_statusor.status();
   }
   gst_pipeline.push_back(aissink_plugin_statusor.ValueOrDie());
 
   return absl::StrJoin(gst_pipeline, " ! ");
 }
 
-}  // namespace
+}  // namespace ingesters_internal
 
 Status Ingest(const IngesterOptions& options, absl::string_view source_uri) {
   // If the given source uri is not protocol prefixed, assume that it is a file
@@ -188,7 +315,8 @@ Status Ingest(const IngesterOptions& options, absl::string_view source_uri) {
 
   // Decide what the gst pipeline should be based on the options.
   auto gst_pipeline_statusor =
-      DecideGstLaunchPipeline(options, std::string(source_uri));
+      ingesters_internal::DecideGstLaunchPipeline(options,
+                                                  std::string(source_uri));
   if (!gst_pipeline_statusor.ok()) {
     LOG(ERROR) << gst_pipeline_statusor.status();
     return InvalidArgumentError("Could not decide on a gst pipeline to launch");
@@ -17,6 +17,8 @@
 #define AISTREAMS_CC_INGESTERS_H_
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "aistreams/cc/aistreams_lite.h"
@@ -60,6 +62,37 @@ struct IngesterOptions {
   // Leaving both non-positive will bypass resizing altogether.
   int resize_height = 0;
   int resize_width = 0;
+
+  // -------------------------------------------
+  // (Optional) Further streams to send the data to.
+
+  // A stream to send the data to in addition to `target_stream_name`, with
+  // its own codec and size. The fields mean the same as those above.
+  struct Output {
+    std::string target_stream_name;
+    SendCodec send_codec = SendCodec::kNative;
+    int resize_height = 0;
+    int resize_width = 0;
+  };
+
+  // The data is sent to each of these streams as well; e.g. a low resolution
+  // JPEG stream for previews alongside a full resolution H264 one. The source
+  // is then pulled, and decoded if any stream requires a transcode, only once
+  // for all of them, and split with a tee into a branch per stream.
+  std::vector<Output> additional_outputs;
+
+  // With `additional_outputs`, every stream is sent from a branch of its own
+  // behind a queue. By default these queues never drop data, so a stream that
+  // cannot keep up (e.g. a slow connection) fills its queue and then stops the
+  // tee, and with it every other stream.
+  //
+  // If `leaky_outputs` is set, each queue keeps at most `output_queue_buffers`
+  // buffers and drops its oldest one when full, so that only the slow stream
+  // loses data. This suits live sources. A file read faster than real time
+  // would lose data to it, and a stream in the native codec that loses a
+  // frame is corrupt until the next keyframe.
+  bool leaky_outputs = false;
+  int output_queue_buffers = 8;
 };
 
 // Ingest the stream specified in `source_uri`, and send the data to an AI
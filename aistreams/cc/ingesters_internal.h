@@ -0,0 +1,37 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_CC_INGESTERS_INTERNAL_H_
+#define AISTREAMS_CC_INGESTERS_INTERNAL_H_
+
+#include <string>
+
+#include "aistreams/cc/ingesters.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+namespace ingesters_internal {
+
+// Decide what the full gst pipeline should be given the options and source uri.
+//
+// Exposed for testing.
+StatusOr<std::string> DecideGstLaunchPipeline(const IngesterOptions& options,
+                                              const std::string& source_uri);
+
+}  // namespace ingesters_internal
+}  // namespace aistreams
+
+#endif  // AISTREAMS_CC_INGESTERS_INTERNAL_H_
@@ -0,0 +1,157 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/cc/ingesters_internal.h"
+
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/gstreamer/gst-plugins/cli_builders/aissink_cli_builder.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+namespace {
+
+using ::aistreams::ingesters_internal::DecideGstLaunchPipeline;
+
+constexpr char kSourceUri[] = "rtsp://camera";
+constexpr char kSourcePlugin[] = "urisourcebin uri=rtsp://camera";
+
+IngesterOptions MakeOptions() {
+  IngesterOptions options;
+  options.connection_options.target_address = "localhost:50051";
+  options.connection_options.ssl_options.use_insecure_channel = true;
+  options.target_stream_name = "full";
+  return options;
+}
+
+IngesterOptions::Output MakeOutput(const std::string& stream_name,
+                                   IngesterOptions::SendCodec send_codec) {
+  IngesterOptions::Output output;
+  output.target_stream_name = stream_name;
+  output.send_codec = send_codec;
+  return output;
+}
+
+// The aissink that `MakeOptions()` sends to `stream_name` with.
+std::string Aissink(const std::string& stream_name) {
+  IngesterOptions options = MakeOptions();
+  AissinkCliBuilder aissink_cli_builder;
+  return aissink_cli_builder
+      .SetTargetAddress(options.connection_options.target_address)
+      .SetAuthenticateWithGoogle(
+          options.connection_options.authenticate_with_google)
+      .SetStreamName(stream_name)
+      .SetSslOptions(options.connection_options.ssl_options)
+      .Finalize()
+      .ValueOrDie();
+}
+
+}  // namespace
+
+TEST(IngestersTest, SingleOutputTest) {
+  IngesterOptions options = MakeOptions();
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  ASSERT_TRUE(pipeline_statusor.ok());
+  EXPECT_EQ(absl::StrFormat("%s ! parsebin ! %s", kSourcePlugin,
+                            Aissink("full")),
+            pipeline_statusor.ValueOrDie());
+}
+
+TEST(IngestersTest, NativeOutputsTest) {
+  IngesterOptions options = MakeOptions();
+  options.additional_outputs.push_back(
+      MakeOutput("copy", IngesterOptions::SendCodec::kNative));
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  ASSERT_TRUE(pipeline_statusor.ok());
+  EXPECT_EQ(absl::StrFormat("%s ! parsebin ! tee name=parsed "
+                            "parsed. ! queue ! %s "
+                            "parsed. ! queue ! %s",
+                            kSourcePlugin, Aissink("full"), Aissink("copy")),
+            pipeline_statusor.ValueOrDie());
+}
+
+TEST(IngestersTest, TranscodeOutputsTest) {
+  IngesterOptions options = MakeOptions();
+  options.send_codec = IngesterOptions::SendCodec::kH264;
+  IngesterOptions::Output small =
+      MakeOutput("small", IngesterOptions::SendCodec::kJpeg);
+  small.resize_width = 320;
+  small.resize_height = 240;
+  options.additional_outputs.push_back(small);
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  ASSERT_TRUE(pipeline_statusor.ok());
+  EXPECT_EQ(
+      absl::StrFormat("%s ! decodebin ! tee name=decoded "
+                      "decoded. ! queue ! h264enc ! %s "
+                      "decoded. ! queue ! videoscale ! "
+                      "video/x-raw,width=320,height=240 ! jpegenc ! %s",
+                      kSourcePlugin, Aissink("full"), Aissink("small")),
+      pipeline_statusor.ValueOrDie());
+}
+
+TEST(IngestersTest, MixedOutputsTest) {
+  IngesterOptions options = MakeOptions();
+  options.additional_outputs.push_back(
+      MakeOutput("small", IngesterOptions::SendCodec::kJpeg));
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  ASSERT_TRUE(pipeline_statusor.ok());
+  EXPECT_EQ(absl::StrFormat("%s ! parsebin ! tee name=parsed "
+                            "parsed. ! queue ! %s "
+                            "parsed. ! queue ! decodebin ! tee name=decoded "
+                            "decoded. ! queue ! jpegenc ! %s",
+                            kSourcePlugin, Aissink("full"), Aissink("small")),
+            pipeline_statusor.ValueOrDie());
+}
+
+TEST(IngestersTest, LeakyOutputsTest) {
+  IngesterOptions options = MakeOptions();
+  options.additional_outputs.push_back(
+      MakeOutput("small", IngesterOptions::SendCodec::kJpeg));
+  options.leaky_outputs = true;
+  options.output_queue_buffers = 4;
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  ASSERT_TRUE(pipeline_statusor.ok());
+  const std::string queue =
+      "queue leaky=downstream max-size-buffers=4 max-size-bytes=0 "
+      "max-size-time=0";
+  EXPECT_EQ(absl::StrFormat("%s ! parsebin ! tee name=parsed "
+                            "parsed. ! %s ! %s "
+                            "parsed. ! %s ! decodebin ! tee name=decoded "
+                            "decoded. ! %s ! jpegenc ! %s",
+                            kSourcePlugin, queue, Aissink("full"), queue,
+                            queue, Aissink("small")),
+            pipeline_statusor.ValueOrDie());
+
+  options.output_queue_buffers = 0;
+  pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            pipeline_statusor.status().code());
+}
+
+TEST(IngestersTest, DuplicateStreamNameTest) {
+  IngesterOptions options = MakeOptions();
+  options.additional_outputs.push_back(
+      MakeOutput("small", IngesterOptions::SendCodec::kJpeg));
+  options.additional_outputs.push_back(
+      MakeOutput("full", IngesterOptions::SendCodec::kRawRgb));
+  auto pipeline_statusor = DecideGstLaunchPipeline(options, kSourceUri);
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            pipeline_statusor.status().code());
+}
+
+}  // namespace aistreams
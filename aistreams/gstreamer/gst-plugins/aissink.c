@@ -423,6 +423,38 @@ failed_eos_send : {
 }
 }
 
+// Record the capture time of the buffer and the time it reached the sink.
+//
+// The wall-clock capture time is estimated by subtracting how long ago the
+// buffer's running time was on the pipeline clock from the current time.
+static void ais_sink_stamp_stage_times(GstBaseSink *bsink, GstBuffer *buffer,
+                                       AIS_Packet *packet) {
+  gint64 capture_pts_nanos = 0;
+  gint64 capture_unix_nanos = 0;
+  if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    capture_pts_nanos = (gint64)pts;
+
+    GstClock *clock = gst_element_get_clock(GST_ELEMENT(bsink));
+    if (clock != NULL && bsink->segment.format == GST_FORMAT_TIME) {
+      GstClockTime running_time =
+          gst_segment_to_running_time(&bsink->segment, GST_FORMAT_TIME, pts);
+      GstClockTime now = gst_clock_get_time(clock);
+      GstClockTime base_time = gst_element_get_base_time(GST_ELEMENT(bsink));
+      if (GST_CLOCK_TIME_IS_VALID(running_time) && now >= base_time &&
+          now - base_time >= running_time) {
+        GstClockTime age = now - base_time - running_time;
+        capture_unix_nanos = g_get_real_time() * 1000 - (gint64)age;
+      }
+    }
+    if (clock != NULL) {
+      gst_object_unref(clock);
+    }
+  }
+  AIS_SetPacketCaptureTime(capture_pts_nanos, capture_unix_nanos, packet);
+  AIS_StampPacketSinkEnqueue(packet);
+}
+
 static GstFlowReturn ais_sink_render(GstBaseSink *bsink, GstBuffer *buffer) {
   AisSink *sink = AIS_SINK(bsink);
 
@@ -445,11 +477,17 @@ static GstFlowReturn ais_sink_render(GstBaseSink *bsink, GstBuffer *buffer) {
   g_free(caps_string);
   gst_caps_unref(caps);
 
+  // Mark delta frames so that receivers may skip them without decoding.
+  AIS_GstreamerBufferSetDeltaUnit(
+      GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT),
+      ais_gstreamer_buffer);
+
   // Create and send the packet.
   packet = AIS_NewGstreamerBufferPacket(ais_gstreamer_buffer, sink->ais_status);
   if (packet == NULL) {
     goto failed_new_packet;
   }
+  ais_sink_stamp_stage_times(bsink, buffer, packet);
   AIS_SendPacket(sink->ais_sender, packet, sink->ais_status);
   if (AIS_GetCode(sink->ais_status) != AIS_OK) {
     goto failed_send_packet;
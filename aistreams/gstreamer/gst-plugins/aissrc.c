@@ -67,6 +67,9 @@ enum {
   PROP_USE_INSECURE_CHANNEL,
   PROP_SSL_DOMAIN_NAME,
   PROP_SSL_ROOT_CERT_PATH,
+  PROP_START_POSITION,
+  PROP_START_TIME_US,
+  PROP_MAX_PACKET_AGE_MS,
 };
 
 /* pad templates */
@@ -141,6 +144,30 @@ static void ais_src_class_init(AisSrcClass *klass) {
                           "The file path to the root CA certificate", NULL,
                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property(
+      gobject_class, PROP_START_POSITION,
+      g_param_spec_string("start-position", "Start position",
+                          "Where a new receiver starts reading: earliest, "
+                          "latest or timestamp. Empty lets the server decide",
+                          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_START_TIME_US,
+      g_param_spec_int64("start-time-us", "Start time",
+                         "Microseconds since the Unix epoch to start reading "
+                         "from when start-position is timestamp. Required "
+                         "then, and unset by default",
+                         G_MININT64, G_MAXINT64, AIS_SRC_START_TIME_UNSET,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_PACKET_AGE_MS,
+      g_param_spec_int64("max-packet-age-ms", "Maximum packet age",
+                         "Drop data packets older than this many "
+                         "milliseconds on arrival. Non-positive disables",
+                         G_MININT64, G_MAXINT64, 0,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata(
       gstelement_class, "AI Streamer source", "Generic",
       "Receives packets from an AI Streamer stream server", "Google Inc");
@@ -165,6 +192,9 @@ static void ais_src_init(AisSrc *src) {
   src->use_insecure_channel = FALSE;
   src->ssl_domain_name = g_strdup("");
   src->ssl_root_cert_path = g_strdup("");
+  src->start_position = g_strdup("");
+  src->start_time_us = AIS_SRC_START_TIME_UNSET;
+  src->max_packet_age_ms = 0;
 
   /* we operate in time */
   gst_base_src_set_format(GST_BASE_SRC(src), GST_FORMAT_TIME);
@@ -328,6 +358,59 @@ stream_already_open : {
 }
 }
 
+/**
+ * ais_src_set_start_position
+ * @src: (not nullable): ais src object.
+ * @start_position: one of earliest, latest or timestamp.
+ * Returns: TRUE on success, FALSE otherwise.
+ */
+static gboolean ais_src_set_start_position(AisSrc *src,
+                                           const gchar *start_position,
+                                           GError **error) {
+  if (src->ais_receiver != NULL) {
+    goto stream_already_open;
+  }
+
+  g_free(src->start_position);
+  if (start_position != NULL) {
+    src->start_position = g_strdup(start_position);
+  } else {
+    src->start_position = g_strdup("");
+  }
+
+  return TRUE;
+
+  /* Errors */
+stream_already_open : {
+  g_set_error(error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+              "Changing the 'start_position' property when the client "
+              "already connected is not supported");
+  return FALSE;
+}
+}
+
+/**
+ * ais_src_parse_start_position
+ * @start_position: (not nullable): the start-position property value.
+ * @result: (out): the parsed start position.
+ * Returns: TRUE on success, FALSE if the value is not recognized.
+ */
+static gboolean ais_src_parse_start_position(const gchar *start_position,
+                                             AIS_StartPosition *result) {
+  if (start_position[0] == '\0') {
+    *result = AIS_START_POSITION_UNSPECIFIED;
+  } else if (g_ascii_strcasecmp(start_position, "earliest") == 0) {
+    *result = AIS_START_POSITION_EARLIEST;
+  } else if (g_ascii_strcasecmp(start_position, "latest") == 0) {
+    *result = AIS_START_POSITION_LATEST;
+  } else if (g_ascii_strcasecmp(start_position, "timestamp") == 0) {
+    *result = AIS_START_POSITION_TIMESTAMP;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
 static void ais_src_set_property(GObject *object, guint property_id,
                                  const GValue *value, GParamSpec *pspec) {
   AisSrc *src = AIS_SRC(object);
@@ -357,6 +440,15 @@ static void ais_src_set_property(GObject *object, guint property_id,
     case PROP_SSL_ROOT_CERT_PATH:
       ais_src_set_ssl_root_cert_path(src, g_value_get_string(value), NULL);
       break;
+    case PROP_START_POSITION:
+      ais_src_set_start_position(src, g_value_get_string(value), NULL);
+      break;
+    case PROP_START_TIME_US:
+      src->start_time_us = g_value_get_int64(value);
+      break;
+    case PROP_MAX_PACKET_AGE_MS:
+      src->max_packet_age_ms = g_value_get_int64(value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
   }
@@ -391,6 +483,15 @@ static void ais_src_get_property(GObject *object, guint property_id,
     case PROP_SSL_ROOT_CERT_PATH:
       g_value_set_string(value, src->ssl_root_cert_path);
       break;
+    case PROP_START_POSITION:
+      g_value_set_string(value, src->start_position);
+      break;
+    case PROP_START_TIME_US:
+      g_value_set_int64(value, src->start_time_us);
+      break;
+    case PROP_MAX_PACKET_AGE_MS:
+      g_value_set_int64(value, src->max_packet_age_ms);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
       break;
@@ -407,6 +508,7 @@ void ais_src_dispose(GObject *object) {
   g_free(src->receiver_name);
   g_free(src->ssl_domain_name);
   g_free(src->ssl_root_cert_path);
+  g_free(src->start_position);
 }
 
 static GstFlowReturn ais_src_create(GstPushSrc *psrc, GstBuffer **outbuf) {
@@ -459,6 +561,9 @@ static GstFlowReturn ais_src_create(GstPushSrc *psrc, GstBuffer **outbuf) {
   } else {
     goto failed_buffer_map;
   }
+  if (AIS_GstreamerBufferIsDeltaUnit(ais_gstreamer_buffer)) {
+    GST_BUFFER_FLAG_SET(*outbuf, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
 
 finalize:
   AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
@@ -486,6 +591,7 @@ failed_buffer_map : {
 
 static gboolean ais_src_start(GstBaseSrc *bsrc) {
   AisSrc *src = AIS_SRC(bsrc);
+  AIS_StartPosition start_position;
 
   src->ais_status = AIS_NewStatus();
 
@@ -498,15 +604,45 @@ static gboolean ais_src_start(GstBaseSrc *bsrc) {
   AIS_SetSslDomainName(src->ssl_domain_name, src->ais_connection_options);
   AIS_SetSslRootCertPath(src->ssl_root_cert_path, src->ais_connection_options);
 
-  src->ais_receiver =
-      AIS_NewReceiver(src->ais_connection_options, src->stream_name,
-                      src->receiver_name, src->ais_status);
+  if (!ais_src_parse_start_position(src->start_position, &start_position)) {
+    goto invalid_start_position;
+  }
+  if (start_position == AIS_START_POSITION_TIMESTAMP &&
+      src->start_time_us == AIS_SRC_START_TIME_UNSET) {
+    goto missing_start_time;
+  }
+  src->ais_receiver_options = AIS_NewReceiverOptions();
+  AIS_SetStartPosition(start_position, src->ais_receiver_options);
+  if (src->start_time_us != AIS_SRC_START_TIME_UNSET) {
+    AIS_SetStartTime(src->start_time_us, src->ais_receiver_options);
+  }
+  AIS_SetMaxPacketAge(src->max_packet_age_ms, src->ais_receiver_options);
+
+  src->ais_receiver = AIS_NewReceiverWithOptions(
+      src->ais_connection_options, src->stream_name, src->receiver_name,
+      src->ais_receiver_options, src->ais_status);
   if (src->ais_receiver == NULL) {
     goto failed_new_receiver;
   }
 
   return TRUE;
 
+invalid_start_position : {
+  GST_ELEMENT_ERROR(src, RESOURCE, SETTINGS,
+                    ("Unrecognized start-position \"%s\"",
+                     src->start_position),
+                    (NULL));
+  return FALSE;
+}
+
+missing_start_time : {
+  GST_ELEMENT_ERROR(src, RESOURCE, SETTINGS,
+                    ("start-position is timestamp, but no start-time-us "
+                     "was given"),
+                    (NULL));
+  return FALSE;
+}
+
 failed_new_receiver : {
   GST_ELEMENT_ERROR(src, RESOURCE, NOT_FOUND,
                     ("%s", AIS_Message(src->ais_status)),
@@ -518,6 +654,7 @@ failed_new_receiver : {
 static gboolean ais_src_stop(GstBaseSrc *bsrc) {
   AisSrc *src = AIS_SRC(bsrc);
   AIS_DeleteReceiver(src->ais_receiver);
+  AIS_DeleteReceiverOptions(src->ais_receiver_options);
   AIS_DeleteConnectionOptions(src->ais_connection_options);
   AIS_DeleteStatus(src->ais_status);
   return TRUE;
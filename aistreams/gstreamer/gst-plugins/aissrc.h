@@ -31,6 +31,9 @@ G_BEGIN_DECLS
 #define AIS_IS_SRC(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), AIS_TYPE_SRC))
 #define AIS_IS_SRC_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), AIS_TYPE_SRC))
 
+/* The value of start-time-us when no start time was given. */
+#define AIS_SRC_START_TIME_UNSET G_MININT64
+
 typedef struct _AisSrc AisSrc;
 typedef struct _AisSrcClass AisSrcClass;
 
@@ -72,6 +75,22 @@ struct _AisSrc {
   gchar *ssl_domain_name;
   gchar *ssl_root_cert_path;
 
+  /* Where to start reading if the stream server has not seen the receiver
+   * name before. One of "earliest", "latest" or "timestamp". An empty string
+   * lets the server decide.
+   */
+  gchar *start_position;
+
+  /* The start time (microseconds since the Unix epoch) used when
+   * start_position is "timestamp". AIS_SRC_START_TIME_UNSET if not given.
+   */
+  gint64 start_time_us;
+
+  /* Data packets older than this (milliseconds) on arrival are dropped.
+   * Non-positive values disable the check.
+   */
+  gint64 max_packet_age_ms;
+
   /* ----- private ----- */
 
   /* An AI Streamer status object. */
@@ -80,6 +99,9 @@ struct _AisSrc {
   /* Options to configure the AI Streamer connection. */
   AIS_ConnectionOptions *ais_connection_options;
 
+  /* Options to configure the AI Streamer receiver. */
+  AIS_ReceiverOptions *ais_receiver_options;
+
   /* An AI Streamer receiver object. */
   AIS_Receiver *ais_receiver;
 };
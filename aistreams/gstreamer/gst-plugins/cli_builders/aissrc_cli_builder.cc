@@ -16,6 +16,7 @@
 
 #include <string>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
@@ -31,6 +32,19 @@ namespace {
 
 std::string ToString(bool b) { return b ? "true" : "false"; }
 
+std::string ToString(StartPosition start_position) {
+  switch (start_position) {
+    case START_POSITION_EARLIEST:
+      return "earliest";
+    case START_POSITION_LATEST:
+      return "latest";
+    case START_POSITION_TIMESTAMP:
+      return "timestamp";
+    default:
+      return "";
+  }
+}
+
 std::string SetPluginParam(absl::string_view parameter_name,
                            absl::string_view value) {
   if (value.empty()) {
@@ -56,6 +70,11 @@ Status AissrcCliBuilder::ValidateSettings() const {
       return InvalidArgumentError("Given an empty path to the ssl root cert");
     }
   }
+  if (start_position_ == START_POSITION_TIMESTAMP &&
+      start_time_ == absl::InfinitePast()) {
+    return InvalidArgumentError(
+        "Given a timestamp start position but no start time");
+  }
   return OkStatus();
 }
 
@@ -67,10 +86,33 @@ StatusOr<std::string> AissrcCliBuilder::Finalize() const {
   tokens.push_back(SetPluginParam("authenticate-with-google",
                                   ToString(authenticate_with_google_)));
   tokens.push_back(SetPluginParam("stream-name", stream_name_));
+  if (!receiver_name_.empty()) {
+    tokens.push_back(SetPluginParam("receiver-name", receiver_name_));
+  }
   tokens.push_back(
       SetPluginParam("use-insecure-channel", ToString(use_insecure_channel_)));
   tokens.push_back(SetPluginParam("ssl-domain-name", ssl_domain_name_));
   tokens.push_back(SetPluginParam("ssl-root-cert-path", ssl_root_cert_path_));
+  if (start_position_ != START_POSITION_UNSPECIFIED) {
+    tokens.push_back(
+        SetPluginParam("start-position", ToString(start_position_)));
+  }
+  if (start_position_ == START_POSITION_TIMESTAMP) {
+    tokens.push_back(SetPluginParam(
+        "start-time-us", absl::StrCat(absl::ToUnixMicros(start_time_))));
+  }
+  if (max_packet_age_ > absl::ZeroDuration()) {
+    tokens.push_back(SetPluginParam(
+        "max-packet-age-ms",
+        absl::StrCat(absl::ToInt64Milliseconds(max_packet_age_))));
+  }
+  if (timeout_ > absl::ZeroDuration()) {
+    // aissrc takes whole seconds; round up so that short timeouts still wait.
+    tokens.push_back(SetPluginParam(
+        "timeout-in-sec",
+        absl::StrCat(
+            absl::ToInt64Seconds(absl::Ceil(timeout_, absl::Seconds(1))))));
+  }
   return absl::StrJoin(tokens, " ");
 }
 
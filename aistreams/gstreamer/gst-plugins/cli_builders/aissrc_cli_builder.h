@@ -20,10 +20,12 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/stream.pb.h"
 
 namespace aistreams {
 
@@ -47,6 +49,12 @@ class AissrcCliBuilder {
     return *this;
   }
 
+  // Leave this empty to get a random assignment.
+  AissrcCliBuilder& SetReceiverName(const std::string& receiver_name) {
+    receiver_name_ = receiver_name;
+    return *this;
+  }
+
   AissrcCliBuilder& SetSslOptions(const SslOptions& options) {
     use_insecure_channel_ = options.use_insecure_channel;
     if (!use_insecure_channel_) {
@@ -56,6 +64,29 @@ class AissrcCliBuilder {
     return *this;
   }
 
+  AissrcCliBuilder& SetStartPosition(StartPosition start_position) {
+    start_position_ = start_position;
+    return *this;
+  }
+
+  // Only used when the start position is START_POSITION_TIMESTAMP.
+  AissrcCliBuilder& SetStartTime(absl::Time start_time) {
+    start_time_ = start_time;
+    return *this;
+  }
+
+  AissrcCliBuilder& SetMaxPacketAge(absl::Duration max_packet_age) {
+    max_packet_age_ = max_packet_age;
+    return *this;
+  }
+
+  // The time within which the server must yield a packet before the stream
+  // is ended with an error. Non-positive values wait indefinitely.
+  AissrcCliBuilder& SetTimeout(absl::Duration timeout) {
+    timeout_ = timeout;
+    return *this;
+  }
+
   // On success, returns the gstreamer commandline configuration string.
   StatusOr<std::string> Finalize() const;
 
@@ -65,10 +96,16 @@ class AissrcCliBuilder {
   std::string target_address_;
   bool authenticate_with_google_;
   std::string stream_name_;
+  std::string receiver_name_;
 
   bool use_insecure_channel_;
   std::string ssl_domain_name_;
   std::string ssl_root_cert_path_;
+
+  StartPosition start_position_ = START_POSITION_UNSPECIFIED;
+  absl::Time start_time_ = absl::InfinitePast();
+  absl::Duration max_packet_age_ = absl::ZeroDuration();
+  absl::Duration timeout_ = absl::ZeroDuration();
 };
 
 }  // namespace aistreams
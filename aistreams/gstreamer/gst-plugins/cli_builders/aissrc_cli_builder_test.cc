@@ -0,0 +1,104 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/gstreamer/gst-plugins/cli_builders/aissrc_cli_builder.h"
+
+#include <string>
+
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+namespace {
+
+AissrcCliBuilder MakeBuilder() {
+  SslOptions ssl_options;
+  ssl_options.use_insecure_channel = true;
+  AissrcCliBuilder builder;
+  builder.SetTargetAddress("localhost:50051")
+      .SetAuthenticateWithGoogle(false)
+      .SetStreamName("test-stream")
+      .SetSslOptions(ssl_options);
+  return builder;
+}
+
+}  // namespace
+
+TEST(AissrcCliBuilderTest, DefaultStartTest) {
+  auto cli_statusor = MakeBuilder().Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  const std::string& cli = cli_statusor.ValueOrDie();
+  EXPECT_FALSE(absl::StrContains(cli, "start-position"));
+  EXPECT_FALSE(absl::StrContains(cli, "start-time-us"));
+  EXPECT_FALSE(absl::StrContains(cli, "max-packet-age-ms"));
+}
+
+TEST(AissrcCliBuilderTest, StartPositionTest) {
+  auto cli_statusor =
+      MakeBuilder().SetStartPosition(START_POSITION_EARLIEST).Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  EXPECT_TRUE(
+      absl::StrContains(cli_statusor.ValueOrDie(), "start-position=earliest"));
+  EXPECT_FALSE(absl::StrContains(cli_statusor.ValueOrDie(), "start-time-us"));
+
+  cli_statusor =
+      MakeBuilder().SetStartPosition(START_POSITION_LATEST).Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  EXPECT_TRUE(
+      absl::StrContains(cli_statusor.ValueOrDie(), "start-position=latest"));
+}
+
+TEST(AissrcCliBuilderTest, StartTimeTest) {
+  auto cli_statusor = MakeBuilder()
+                          .SetStartPosition(START_POSITION_TIMESTAMP)
+                          .SetStartTime(absl::FromUnixMicros(1500000))
+                          .Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  const std::string& cli = cli_statusor.ValueOrDie();
+  EXPECT_TRUE(absl::StrContains(cli, "start-position=timestamp"));
+  EXPECT_TRUE(absl::StrContains(cli, "start-time-us=1500000"));
+
+  // The start time is only passed along with a timestamp start position.
+  cli_statusor = MakeBuilder()
+                     .SetStartPosition(START_POSITION_LATEST)
+                     .SetStartTime(absl::FromUnixMicros(1500000))
+                     .Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  EXPECT_FALSE(absl::StrContains(cli_statusor.ValueOrDie(), "start-time-us"));
+}
+
+TEST(AissrcCliBuilderTest, MissingStartTimeTest) {
+  auto cli_statusor =
+      MakeBuilder().SetStartPosition(START_POSITION_TIMESTAMP).Finalize();
+  EXPECT_EQ(StatusCode::kInvalidArgument, cli_statusor.status().code());
+}
+
+TEST(AissrcCliBuilderTest, MaxPacketAgeTest) {
+  auto cli_statusor =
+      MakeBuilder().SetMaxPacketAge(absl::Milliseconds(250)).Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  EXPECT_TRUE(
+      absl::StrContains(cli_statusor.ValueOrDie(), "max-packet-age-ms=250"));
+
+  cli_statusor = MakeBuilder().SetMaxPacketAge(absl::ZeroDuration()).Finalize();
+  ASSERT_TRUE(cli_statusor.ok());
+  EXPECT_FALSE(
+      absl::StrContains(cli_statusor.ValueOrDie(), "max-packet-age-ms"));
+}
+
+}  // namespace aistreams
@@ -14,7 +14,13 @@
 
 #include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
 
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "aistreams/gstreamer/gstreamer_utils.h"
 #include "aistreams/gstreamer/type_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
@@ -25,17 +31,70 @@ namespace aistreams {
 
 namespace {
 
-constexpr char kGenericDecodeString[] =
-    "decodebin ! videoconvert ! video/x-raw,format=RGB";
+// The decoder used unless another is given.
+constexpr char kGenericDecoder[] = "decodebin";
+
+// The formats accepted when the caller has no preference, in order of
+// preference for when a conversion is needed.
+constexpr char kAnyFormat[] = "(string){I420,NV12,RGB,BGR,RGBA,GRAY8}";
+
+// Returns the n-threads property of videoscale and videoconvert, which is
+// left out when it is the default so that older GStreamers still accept it.
+std::string ConverterThreadsProperty(int converter_threads) {
+  if (converter_threads == 1) {
+    return "";
+  }
+  return absl::StrFormat(" n-threads=%d", converter_threads);
+}
+
+// Builds the decoding pipeline. The videoscale runs before the videoconvert,
+// on the decoder output format, and the videoconvert is a passthrough when
+// the decoder already produces the requested format.
+StatusOr<std::string> ConstructProcessingPipelineString(
+    const GstreamerRawImageYielder::Options& options) {
+  const auto& pipeline = options.pipeline;
+  if (!pipeline.processing_pipeline_string.empty()) {
+    return pipeline.processing_pipeline_string;
+  }
+  if (pipeline.output_height < 0 || pipeline.output_width < 0 ||
+      pipeline.converter_threads < 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a negative output height (%d), width (%d) or converter thread "
+        "count (%d)",
+        pipeline.output_height, pipeline.output_width,
+        pipeline.converter_threads));
+  }
+  std::string format = kAnyFormat;
+  if (options.output_format != RAW_IMAGE_FORMAT_UNKNOWN) {
+    AIS_ASSIGN_OR_RETURN(format, ToGstreamerVideoFormat(options.output_format));
+  }
+  std::string threads = ConverterThreadsProperty(pipeline.converter_threads);
+
+  std::vector<std::string> elements;
+  elements.push_back(pipeline.decoder_string.empty() ? kGenericDecoder
+                                                     : pipeline.decoder_string);
+  if (pipeline.output_height > 0 && pipeline.output_width > 0) {
+    elements.push_back(absl::StrCat("videoscale", threads));
+    elements.push_back(absl::StrFormat("video/x-raw,width=%d,height=%d",
+                                       pipeline.output_width,
+                                       pipeline.output_height));
+  }
+  elements.push_back(absl::StrCat("videoconvert", threads));
+  elements.push_back(absl::StrFormat("video/x-raw,format=%s", format));
+  return absl::StrJoin(elements, " ! ");
+}
 
-// TODO: Simply use the generic decoding pipeline for starters.
 // Let the runner handle the checks. May want to consider doing more upfront
 // checks here in the future.
-GstreamerRunnerOptions ConstructGstreamerRunnerOptions(
+StatusOr<GstreamerRunnerOptions> ConstructGstreamerRunnerOptions(
     const GstreamerRawImageYielder::Options& options) {
   GstreamerRunnerOptions runner_options;
   runner_options.appsrc_caps_string = options.caps_string;
-  runner_options.processing_pipeline_string = kGenericDecodeString;
+  runner_options.allow_caps_changes = options.allow_caps_changes;
+  runner_options.appsrc_max_bytes = options.max_queued_bytes;
+  runner_options.source_pipeline_string = options.source_pipeline_string;
+  AIS_ASSIGN_OR_RETURN(runner_options.processing_pipeline_string,
+                       ConstructProcessingPipelineString(options));
   return runner_options;
 }
 
@@ -49,7 +108,8 @@ GstreamerRawImageYielder::GstreamerRawImageYielder(const Options& options)
     : options_(options) {}
 
 GstreamerRawImageYielder::~GstreamerRawImageYielder() {
-  if (!eos_signaled_) {
+  // Initialize may have failed before the runner was created.
+  if (gstreamer_runner_ != nullptr && !eos_signaled_) {
     SignalEOS();
   }
 }
@@ -66,21 +126,27 @@ GstreamerRawImageYielder::Create(const Options& options) {
 }
 
 Status GstreamerRawImageYielder::Initialize() {
-  auto gstreamer_runner_options = ConstructGstreamerRunnerOptions(options_);
+  for (const auto& decoder_rank : options_.pipeline.decoder_ranks) {
+    AIS_RETURN_IF_ERROR(
+        GstSetElementRank(decoder_rank.first, decoder_rank.second));
+  }
+  AIS_ASSIGN_OR_RETURN(auto gstreamer_runner_options,
+                       ConstructGstreamerRunnerOptions(options_));
   gstreamer_runner_ =
       std::make_unique<GstreamerRunner>(gstreamer_runner_options);
   auto gstreamer_runner_receiver =
       [this](GstreamerBuffer gstreamer_buffer) -> Status {
     // No-op if callback is not supplied.
-    if (!options_.callback) {
+    if (!options_.callback && !options_.timed_callback) {
       return OkStatus();
     }
 
     // Otherwise, try to convert the raw image.
     // Leave the statusor interpretation to the recipient.
     // TODO: Decide on some special status codes to pause/halt the pipeline.
+    int64_t pts = gstreamer_buffer.get_pts();
     auto raw_image_status_or = ToRawImage(std::move(gstreamer_buffer));
-    options_.callback(std::move(raw_image_status_or));
+    Deliver(std::move(raw_image_status_or), pts);
     return OkStatus();
   };
   gstreamer_runner_->SetReceiver(gstreamer_runner_receiver);
@@ -101,7 +167,14 @@ Status GstreamerRawImageYielder::Feed(const GstreamerBuffer& gstreamer_buffer) {
   return gstreamer_runner_->Feed(gstreamer_buffer);
 }
 
+bool GstreamerRawImageYielder::WaitForCompletion(absl::Duration timeout) {
+  return gstreamer_runner_->WaitForCompletion(timeout);
+}
+
 Status GstreamerRawImageYielder::SignalEOS() {
+  if (gstreamer_runner_ == nullptr) {
+    return FailedPreconditionError("The GstreamerRunner was never created");
+  }
   eos_signaled_ = true;
   auto status = gstreamer_runner_->End();
   if (!status.ok()) {
@@ -110,11 +183,20 @@ Status GstreamerRawImageYielder::SignalEOS() {
   }
 
   // Deliver EOS. Ignore any callback errors.
+  status = Deliver(EOSStatus(), -1);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+  return OkStatus();
+}
+
+Status GstreamerRawImageYielder::Deliver(
+    StatusOr<RawImage> raw_image_status_or, int64_t pts) {
+  if (options_.timed_callback) {
+    return options_.timed_callback(std::move(raw_image_status_or), pts);
+  }
   if (options_.callback) {
-    status = options_.callback(EOSStatus());
-    if (!status.ok()) {
-      LOG(ERROR) << status;
-    }
+    return options_.callback(std::move(raw_image_status_or));
   }
   return OkStatus();
 }
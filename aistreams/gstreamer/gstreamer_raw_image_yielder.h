@@ -17,14 +17,19 @@
 #ifndef AISTREAMS_GSTREAMER_GSTREAMER_RAW_IMAGE_YIELDER_H_
 #define AISTREAMS_GSTREAMER_GSTREAMER_RAW_IMAGE_YIELDER_H_
 
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <string>
 
+#include "absl/time/time.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/raw_image.h"
 #include "aistreams/gstreamer/gstreamer_runner.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
@@ -39,9 +44,41 @@ namespace aistreams {
 // TODO(dschao): Check that the yielded raw image sequence is "maximal".
 class GstreamerRawImageYielder {
  public:
+  // Options to configure the decoding pipeline, which by default is
+  //
+  // decodebin ! videoconvert ! video/x-raw,format=<output_format>
+  struct PipelineOptions {
+    // If both are positive, decoded frames are scaled to this size before
+    // their colorspace conversion, which then runs on fewer pixels; e.g. set
+    // them to the input size of a model. The aspect ratio is not kept.
+    int output_height = 0;
+    int output_width = 0;
+
+    // The number of threads used by videoscale and videoconvert for each
+    // frame. Set this to 0 to use one per core.
+    int converter_threads = 1;
+
+    // If set, this replaces decodebin; e.g. "h264parse ! avdec_h264
+    // max-threads=4" to pick a decoder and set its properties.
+    std::string decoder_string;
+
+    // The ranks to give to element factories before the pipeline is built, so
+    // that decodebin prefers (or avoids) particular decoders; e.g.
+    // {{"avdec_h264", GST_RANK_PRIMARY + 1}}. These are process-wide.
+    std::map<std::string, int> decoder_ranks;
+
+    // If set, this replaces the whole decoding pipeline, and none of the
+    // options above nor `output_format` apply. It must produce raw video in a
+    // format that has a RawImageFormat.
+    std::string processing_pipeline_string;
+  };
+
   // Options to configure the GstreamerRawImageYielder.
   //
   // `caps_string`: indicates the caps of all fed GstreamerBuffers.
+  // `allow_caps_changes`: if true, the fed GstreamerBuffers may change caps
+  //                       mid-stream, e.g. when a camera changes resolution.
+  //                       See GstreamerRunnerOptions.
   // `callback`: will be called as soon as a new RawImage is available.
   //
   // The argument passed to the callback can contain a RawImage when no special
@@ -49,10 +86,39 @@ class GstreamerRawImageYielder {
   // Below are error codes that require special handling:
   // `kResourceExhausted`: This indicates that EOS (end-of-stream) is
   //                       reached. You should quit gracefully.
+  //
+  // `timed_callback`: if set, it is called instead of `callback` and also
+  //                   receives the pts of the GstreamerBuffer from which the
+  //                   RawImage was decoded (negative if unknown).
+  //
+  // `output_format`: the format of the yielded RawImages. Decoders produce
+  //                  YUV (usually I420 or NV12) natively, so asking for
+  //                  that format avoids a colorspace conversion. Set this to
+  //                  RAW_IMAGE_FORMAT_UNKNOWN to take whichever supported
+  //                  format the decoder produces.
+  //
+  // `source_pipeline_string`: if set, the GstreamerBuffers are not fed but
+  //                           come from this GStreamer source pipeline; e.g.
+  //                           an aissrc element, which hands the packets it
+  //                           receives straight to the decoder. The
+  //                           `caps_string` is then unused.
+  //
+  // `pipeline`: configures the decoding pipeline.
+  //
+  // `max_queued_bytes`: if positive, Feed() blocks while about this many bytes
+  //                     of fed buffers wait for the decoder. See
+  //                     GstreamerRunnerOptions::appsrc_max_bytes.
   using Callback = std::function<Status(StatusOr<RawImage>)>;
+  using TimedCallback = std::function<Status(StatusOr<RawImage>, int64_t)>;
   struct Options {
     std::string caps_string;
+    bool allow_caps_changes = false;
     Callback callback;
+    TimedCallback timed_callback;
+    RawImageFormat output_format = RAW_IMAGE_FORMAT_SRGB;
+    std::string source_pipeline_string;
+    PipelineOptions pipeline;
+    int64_t max_queued_bytes = 0;
   };
 
   // Create an instance in a fully initialized state.
@@ -68,6 +134,10 @@ class GstreamerRawImageYielder {
   // earlier. Otherwise, you may wait for the destructor.
   Status SignalEOS();
 
+  // Waits up to `timeout` for the source pipeline to end the stream, or to
+  // fail. Returns true if it has; you should then call SignalEOS().
+  bool WaitForCompletion(absl::Duration timeout);
+
   // Copy-control members. Use Create() rather than the constructors.
   ~GstreamerRawImageYielder();
   GstreamerRawImageYielder(const Options&);
@@ -79,6 +149,7 @@ class GstreamerRawImageYielder {
 
  private:
   Status Initialize();
+  Status Deliver(StatusOr<RawImage>, int64_t pts);
 
   Options options_;
   bool eos_signaled_ = false;
@@ -132,7 +132,8 @@ TEST(GstreamerRawImageYielder, JpegSequenceTest) {
     EXPECT_EQ(r.height(), 243);
     EXPECT_EQ(r.width(), 243);
     EXPECT_EQ(r.channels(), 3);
-    EXPECT_EQ(r.size(), 177147);
+    EXPECT_EQ(r.row_stride(), 732);
+    EXPECT_EQ(r.size(), 177876);
   }
   {
     RawImage r;
@@ -142,6 +143,85 @@ TEST(GstreamerRawImageYielder, JpegSequenceTest) {
   }
 }
 
+TEST(GstreamerRawImageYielder, OutputFormatTest) {
+  const RawImageFormat formats[] = {RAW_IMAGE_FORMAT_GRAY8,
+                                    RAW_IMAGE_FORMAT_NV12,
+                                    RAW_IMAGE_FORMAT_I420};
+  for (RawImageFormat format : formats) {
+    ProducerConsumerQueue<RawImage> pcqueue(10);
+    GstreamerRawImageYielder::Options options;
+    options.caps_string = kJpegCapsString;
+    options.output_format = format;
+    options.callback =
+        [&pcqueue](StatusOr<RawImage> raw_image_statusor) -> Status {
+      if (raw_image_statusor.ok()) {
+        pcqueue.TryEmplace(std::move(raw_image_statusor).ValueOrDie());
+      }
+      return OkStatus();
+    };
+    auto yielder = GstreamerRawImageYielder::Create(options).ValueOrDie();
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(kTestImageSquaresPath, kJpegCapsString)
+            .ValueOrDie();
+    EXPECT_TRUE(yielder->Feed(gstreamer_buffer).ok());
+    EXPECT_TRUE(yielder->SignalEOS().ok());
+
+    RawImage r;
+    EXPECT_TRUE(pcqueue.TryPop(r, absl::Seconds(1)));
+    EXPECT_EQ(r.format(), format);
+    EXPECT_EQ(r.height(), 243);
+    EXPECT_EQ(r.width(), 243);
+  }
+}
+
+TEST(GstreamerRawImageYielder, PipelineOptionsTest) {
+  // Scale before converting, and use a custom pipeline.
+  GstreamerRawImageYielder::PipelineOptions scaled;
+  scaled.output_height = 60;
+  scaled.output_width = 80;
+  scaled.converter_threads = 2;
+  scaled.decoder_string = "jpegparse ! jpegdec";
+  GstreamerRawImageYielder::PipelineOptions custom;
+  custom.processing_pipeline_string =
+      "decodebin ! videoconvert ! video/x-raw,format=GRAY8";
+  for (const auto& pipeline : {scaled, custom}) {
+    ProducerConsumerQueue<RawImage> pcqueue(10);
+    GstreamerRawImageYielder::Options options;
+    options.caps_string = kJpegCapsString;
+    options.pipeline = pipeline;
+    options.callback =
+        [&pcqueue](StatusOr<RawImage> raw_image_statusor) -> Status {
+      if (raw_image_statusor.ok()) {
+        pcqueue.TryEmplace(std::move(raw_image_statusor).ValueOrDie());
+      }
+      return OkStatus();
+    };
+    auto yielder = GstreamerRawImageYielder::Create(options).ValueOrDie();
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(kTestImageSquaresPath, kJpegCapsString)
+            .ValueOrDie();
+    EXPECT_TRUE(yielder->Feed(gstreamer_buffer).ok());
+    EXPECT_TRUE(yielder->SignalEOS().ok());
+
+    RawImage r;
+    EXPECT_TRUE(pcqueue.TryPop(r, absl::Seconds(1)));
+    if (pipeline.processing_pipeline_string.empty()) {
+      EXPECT_EQ(r.format(), RAW_IMAGE_FORMAT_SRGB);
+      EXPECT_EQ(r.height(), 60);
+      EXPECT_EQ(r.width(), 80);
+    } else {
+      EXPECT_EQ(r.format(), RAW_IMAGE_FORMAT_GRAY8);
+      EXPECT_EQ(r.height(), 243);
+    }
+  }
+
+  // Ranks can only be set for elements that exist.
+  GstreamerRawImageYielder::Options options;
+  options.caps_string = kJpegCapsString;
+  options.pipeline.decoder_ranks = {{"no_such_decoder", 0}};
+  EXPECT_FALSE(GstreamerRawImageYielder::Create(options).ok());
+}
+
 TEST(GstreamerRawImageYielder, DtorSignalEOSTest) {
   ProducerConsumerQueue<RawImage> pcqueue(10);
 
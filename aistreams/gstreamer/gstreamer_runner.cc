@@ -16,17 +16,24 @@
 
 #include <gst/app/gstappsink.h>
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 #include <algorithm>
-#include <thread>
+#include <map>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "aistreams/gstreamer/gstreamer_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/status_macros.h"
+#include "aistreams/util/metrics.h"
 
 namespace aistreams {
 
@@ -34,30 +41,49 @@ namespace {
 
 constexpr char kAppSrcName[] = "feed";
 constexpr char kAppSinkName[] = "fetch";
+constexpr char kTeeName[] = "split";
 
-// Callback attached to the GLib main loop.
-gboolean gst_bus_message_callback(GstBus* bus, GstMessage* message,
-                                  GMainLoop* loop) {
-  GError* err;
-  gchar* debug_info;
-  switch (GST_MESSAGE_TYPE(message)) {
-    case GST_MESSAGE_EOS:
-      g_main_loop_quit(loop);
-      break;
-    case GST_MESSAGE_ERROR:
-      gst_message_parse_error(message, &err, &debug_info);
-      LOG(ERROR) << absl::StrFormat("Error from gstreamer element %s: %s",
-                                    GST_OBJECT_NAME(message->src),
-                                    err->message);
-      LOG(ERROR) << absl::StrFormat("Additional debug info: %s",
-                                    debug_info ? debug_info : "none");
-      LOG(ERROR) << "Got gstreamer error; shutting down event loop";
-      g_main_loop_quit(loop);
-      break;
-    default:
-      break;
-  }
-  return TRUE;
+Counter* BuffersFedCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_buffers_fed_total",
+      "Buffers fed into GstreamerRunner pipelines.");
+  return counter;
+}
+
+Counter* BuffersYieldedCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_buffers_yielded_total",
+      "Buffers yielded by GstreamerRunner pipelines.");
+  return counter;
+}
+
+Counter* CapsChangesCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_caps_changes_total",
+      "Caps changes of the buffers fed into GstreamerRunner pipelines.");
+  return counter;
+}
+
+Counter* PipelineRestartsCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_pipeline_restarts_total",
+      "GstreamerRunner pipelines restarted for a change of media type.");
+  return counter;
+}
+
+Counter* FeedDropsCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_feed_drops_total",
+      "Buffers that GstreamerRunner pipelines dropped because their appsrc "
+      "queue was full.");
+  return counter;
+}
+
+Counter* FeedErrorsCounter() {
+  static Counter* counter = MetricsRegistry::Global()->GetCounter(
+      "ais_gstreamer_feed_errors_total",
+      "Buffers that GstreamerRunner pipelines failed to accept.");
+  return counter;
 }
 
 // Callback for receiving new GstSample's from appsink.
@@ -65,6 +91,7 @@ GstFlowReturn on_new_sample_from_sink(
     GstElement* elt, GstreamerRunner::ReceiverCallback* receiver_callback) {
   // Get the GstSample from appsink.
   GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(elt));
+  BuffersYieldedCounter()->Increment();
 
   // No-op if callbacks are not supplied.
   if (receiver_callback == nullptr || !(*receiver_callback)) {
@@ -85,6 +112,23 @@ GstFlowReturn on_new_sample_from_sink(
   gst_buffer_map(buffer, &map, GST_MAP_READ);
   gstreamer_buffer.assign(reinterpret_cast<char*>(map.data), map.size);
   gst_buffer_unmap(buffer, &map);
+  if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+    gstreamer_buffer.set_pts(static_cast<int64_t>(GST_BUFFER_PTS(buffer)));
+  }
+  gstreamer_buffer.set_delta_unit(
+      GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+
+  // Carry a non-default plane layout along so that padded frames can be used
+  // as they are.
+  GstVideoMeta* video_meta = gst_buffer_get_video_meta(buffer);
+  if (video_meta != nullptr) {
+    std::vector<GstreamerBuffer::VideoPlane> video_planes(video_meta->n_planes);
+    for (guint i = 0; i < video_meta->n_planes; ++i) {
+      video_planes[i].offset = video_meta->offset[i];
+      video_planes[i].stride = video_meta->stride[i];
+    }
+    gstreamer_buffer.set_video_planes(std::move(video_planes));
+  }
   gst_sample_unref(sample);
 
   // Deliver the GstreamerBuffer using the callback.
@@ -96,13 +140,31 @@ GstFlowReturn on_new_sample_from_sink(
   return GST_FLOW_OK;
 }
 
+// Probe on the appsink pad that tells upstream elements that padded video
+// frames described by a GstVideoMeta are accepted, so that they need not be
+// repacked into the default layout before reaching the appsink.
+GstPadProbeReturn advertise_video_meta(GstPad* pad, GstPadProbeInfo* info,
+                                       gpointer user_data) {
+  GstQuery* query = GST_PAD_PROBE_INFO_QUERY(info);
+  if (GST_QUERY_TYPE(query) == GST_QUERY_ALLOCATION) {
+    gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, NULL);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
 Status ValidateRunnerOptions(const GstreamerRunnerOptions& options) {
   if (options.processing_pipeline_string.empty()) {
     return InvalidArgumentError("Given an empty processing pipeline string");
   }
-  if (options.appsrc_caps_string.empty()) {
+  if (options.source_pipeline_string.empty() &&
+      options.appsrc_caps_string.empty()) {
     return InvalidArgumentError("Given an empty appsrc caps string");
   }
+  if (options.leaky_outputs && options.output_queue_buffers < 1) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given leaky outputs with a queue of %d buffers",
+                        options.output_queue_buffers));
+  }
   return OkStatus();
 }
 
@@ -114,7 +176,14 @@ class GstreamerRunner::GstreamerRuntimeImpl {
   struct Options {
     std::string processing_pipeline_string;
     std::string appsrc_caps_string;
+    std::string source_pipeline_string;
+    int64_t appsrc_max_bytes = 0;
     ReceiverCallback receiver_callback;
+    std::map<std::string, std::string> output_pipeline_strings;
+    bool leaky_outputs = false;
+    int output_queue_buffers = 0;
+    std::map<std::string, ReceiverCallback> output_callbacks;
+    absl::Duration end_timeout;
   };
 
   GstreamerRuntimeImpl(const Options& options) : options_(options) {}
@@ -123,8 +192,35 @@ class GstreamerRunner::GstreamerRuntimeImpl {
   // to support its execution.
   Status Initialize();
 
-  // Feeds a GstreamerBuffer down the Gstreamer pipeline.
-  Status Feed(const GstreamerBuffer&);
+  // Feeds a GstreamerBuffer down the Gstreamer pipeline, waiting up to
+  // `timeout` for room in the appsrc queue.
+  Status Feed(const GstreamerBuffer&, absl::Duration timeout);
+
+  // Changes the caps of the appsrc in place. The elements downstream
+  // renegotiate when the next buffer reaches them.
+  //
+  // Only caps of the same media type are accepted; decodebin does not
+  // replace the elements it has plugged for another. Returns
+  // FailedPrecondition for caps of another media type and InvalidArgument for
+  // caps that do not parse.
+  Status SetAppsrcCaps(const std::string& caps_string);
+
+  const std::string& appsrc_caps_string() const {
+    return options_.appsrc_caps_string;
+  }
+
+  // Waits up to `timeout` for the pipeline to reach EOS or fail.
+  bool WaitForCompletion(absl::Duration timeout);
+
+  // Handles a message posted on the bus of the pipeline.
+  //
+  // Messages are handled synchronously, on the thread that posts them, rather
+  // than by a GLib main loop on a thread of each pipeline. They are only
+  // logged or noted, and are then dropped.
+  GstBusSyncReply HandleBusMessage(GstMessage* message);
+
+  // Notes that a buffer of `size` bytes has left the appsrc queue.
+  void OnBufferDequeued(int64_t size);
 
   // Frees the Gstreamer pipeline and any resources that was needed for its
   // executution.
@@ -135,17 +231,103 @@ class GstreamerRunner::GstreamerRuntimeImpl {
  private:
   Options options_;
   GstElement* gst_pipeline_ = nullptr;
-  GMainLoop* glib_main_loop_ = nullptr;
   GstElement* gst_appsrc_ = nullptr;
-  GstElement* gst_appsink_ = nullptr;
-  std::thread glib_main_loop_runner_;
+  std::vector<GstElement*> gst_appsinks_;
+
+  absl::Mutex state_mu_;
+
+  // Set once the pipeline has reached EOS or failed.
+  bool done_ ABSL_GUARDED_BY(state_mu_) = false;
+
+  // The bytes of the buffers in the appsrc queue, counted only when it is
+  // bounded, and signalled as they leave it.
+  int64_t queued_bytes_ ABSL_GUARDED_BY(state_mu_) = 0;
+  absl::CondVar dequeued_cv_;
+
+  // Builds and plays the pipeline for Initialize(), which tears down whatever
+  // it leaves behind on failure.
+  Status InitializePipeline();
+
+  // Stops the pipeline without waiting for EOS and releases it and its
+  // elements. Safe to call on a partially initialized pipeline.
+  void Teardown();
+
+  // Waits up to `timeout` for there to be room in the appsrc queue for a
+  // buffer of `size` bytes, and reserves it. Returns false if there is none.
+  bool ReserveQueueRoom(int64_t size, absl::Duration timeout);
+  bool HasQueueRoom(int64_t size) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(state_mu_);
+
+  // Connects the appsink of the given name to `receiver_callback`, which may
+  // be null.
+  Status SetUpAppsink(const std::string& name,
+                      ReceiverCallback* receiver_callback);
+
+  // Sets the video format of the appsrc from its caps.
+  void UpdateAppsrcVideoInfo(GstCaps* appsrc_caps);
+
+  // The video format of the appsrc caps, if they are video/x-raw.
+  bool has_appsrc_video_info_ = false;
+  GstVideoInfo appsrc_video_info_;
 };
 
+void GstreamerRunner::GstreamerRuntimeImpl::UpdateAppsrcVideoInfo(
+    GstCaps* appsrc_caps) {
+  has_appsrc_video_info_ = false;
+  if (gst_structure_has_name(gst_caps_get_structure(appsrc_caps, 0),
+                             "video/x-raw")) {
+    has_appsrc_video_info_ =
+        gst_video_info_from_caps(&appsrc_video_info_, appsrc_caps);
+  }
+}
+
 Status GstreamerRunner::GstreamerRuntimeImpl::Initialize() {
+  // Do not leave a half-started pipeline behind; its elements would still
+  // call back into this and into the receivers.
+  Status status = InitializePipeline();
+  if (!status.ok()) {
+    Teardown();
+  }
+  return status;
+}
+
+Status GstreamerRunner::GstreamerRuntimeImpl::InitializePipeline() {
   // Create the full gstreamer pipeline.
-  std::string pipeline_string =
-      absl::StrFormat("appsrc name=%s ! %s ! appsink name=%s", kAppSrcName,
-                      options_.processing_pipeline_string, kAppSinkName);
+  std::string source_string = options_.source_pipeline_string;
+  if (source_string.empty()) {
+    source_string = absl::StrFormat("appsrc name=%s", kAppSrcName);
+  }
+  std::string pipeline_string;
+  if (options_.output_pipeline_strings.empty()) {
+    pipeline_string =
+        absl::StrFormat("%s ! %s ! appsink name=%s", source_string,
+                        options_.processing_pipeline_string, kAppSinkName);
+  } else {
+    // Each branch of the tee gets a queue, and so a thread, of its own. Unless
+    // it is leaky, the tee waits for a full queue, which stalls the other
+    // branches.
+    pipeline_string =
+        absl::StrFormat("%s ! %s ! tee name=%s", source_string,
+                        options_.processing_pipeline_string, kTeeName);
+    std::string queue_string = "queue";
+    if (options_.leaky_outputs) {
+      queue_string = absl::StrFormat(
+          "queue leaky=downstream max-size-buffers=%d max-size-bytes=0 "
+          "max-size-time=0",
+          options_.output_queue_buffers);
+    }
+    int i = 0;
+    for (const auto& output : options_.output_pipeline_strings) {
+      std::string branch_string = queue_string;
+      if (!output.second.empty()) {
+        absl::StrAppend(&branch_string, " ! ", output.second);
+      }
+      absl::StrAppend(&pipeline_string,
+                      absl::StrFormat(" %s. ! %s ! appsink name=%s_%d",
+                                      kTeeName, branch_string, kAppSinkName,
+                                      i++));
+    }
+  }
   gst_pipeline_ = gst_parse_launch(pipeline_string.c_str(), NULL);
   if (gst_pipeline_ == nullptr) {
     return InvalidArgumentError(absl::StrFormat(
@@ -154,84 +336,246 @@ Status GstreamerRunner::GstreamerRuntimeImpl::Initialize() {
         pipeline_string));
   }
 
-  // Create the GLib event loop.
-  glib_main_loop_ = g_main_loop_new(NULL, FALSE);
+  // Watch the bus for EOS and errors.
   GstBus* bus = gst_element_get_bus(gst_pipeline_);
-  gst_bus_add_watch(bus, (GstBusFunc)gst_bus_message_callback, glib_main_loop_);
+  gst_bus_set_sync_handler(
+      bus,
+      [](GstBus* bus, GstMessage* message, gpointer impl) {
+        return static_cast<GstreamerRuntimeImpl*>(impl)->HandleBusMessage(
+            message);
+      },
+      this, NULL);
   gst_object_unref(bus);
 
-  // Setup the appsrc.
-  gst_appsrc_ = gst_bin_get_by_name(GST_BIN(gst_pipeline_), kAppSrcName);
-  if (gst_appsrc_ == nullptr) {
-    return InternalError("Failed to get a pointer to the appsrc element");
+  // Setup the appsrc, unless the source pipeline takes its place.
+  if (options_.source_pipeline_string.empty()) {
+    gst_appsrc_ = gst_bin_get_by_name(GST_BIN(gst_pipeline_), kAppSrcName);
+    if (gst_appsrc_ == nullptr) {
+      return InternalError("Failed to get a pointer to the appsrc element");
+    }
+    GstCaps* appsrc_caps =
+        gst_caps_from_string(options_.appsrc_caps_string.c_str());
+    if (appsrc_caps == nullptr) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Failed to create a GstCaps from \"%s\"; make sure it is a valid "
+          "cap string",
+          options_.appsrc_caps_string));
+    }
+    g_object_set(G_OBJECT(gst_appsrc_), "caps", appsrc_caps, NULL);
+    UpdateAppsrcVideoInfo(appsrc_caps);
+    gst_caps_unref(appsrc_caps);
+
+    // Count the buffers leaving the queue of a bounded appsrc.
+    if (options_.appsrc_max_bytes > 0) {
+      GstPad* appsrc_pad = gst_element_get_static_pad(gst_appsrc_, "src");
+      gst_pad_add_probe(
+          appsrc_pad, GST_PAD_PROBE_TYPE_BUFFER,
+          [](GstPad* pad, GstPadProbeInfo* info, gpointer impl) {
+            static_cast<GstreamerRuntimeImpl*>(impl)->OnBufferDequeued(
+                gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info)));
+            return GST_PAD_PROBE_OK;
+          },
+          this, NULL);
+      gst_object_unref(appsrc_pad);
+    }
   }
-  GstCaps* appsrc_caps =
-      gst_caps_from_string(options_.appsrc_caps_string.c_str());
-  if (appsrc_caps == nullptr) {
-    return InvalidArgumentError(absl::StrFormat(
-        "Failed to create a GstCaps from \"%s\"; make sure it is a valid "
-        "cap string",
-        options_.appsrc_caps_string));
+
+  // Setup the appsinks.
+  if (options_.output_pipeline_strings.empty()) {
+    AIS_RETURN_IF_ERROR(
+        SetUpAppsink(kAppSinkName, &options_.receiver_callback));
+  } else {
+    int i = 0;
+    for (const auto& output : options_.output_pipeline_strings) {
+      auto it = options_.output_callbacks.find(output.first);
+      AIS_RETURN_IF_ERROR(SetUpAppsink(
+          absl::StrFormat("%s_%d", kAppSinkName, i++),
+          it == options_.output_callbacks.end() ? nullptr : &it->second));
+    }
   }
-  g_object_set(G_OBJECT(gst_appsrc_), "caps", appsrc_caps, NULL);
-  gst_caps_unref(appsrc_caps);
 
-  // Setup the appsink.
-  gst_appsink_ = gst_bin_get_by_name(GST_BIN(gst_pipeline_), kAppSinkName);
-  if (gst_appsink_ == nullptr) {
-    return InternalError("Failed to get a pointer to the appsink element");
+  // Play the gstreamer pipeline.
+  //
+  // A source element that cannot start (e.g. an aissrc that cannot reach the
+  // server) fails the state change right away.
+  if (gst_element_set_state(gst_pipeline_, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    return UnavailableError(absl::StrFormat(
+        "Failed to start the gstreamer pipeline \"%s\"", pipeline_string));
   }
-  g_object_set(G_OBJECT(gst_appsink_), "emit-signals", TRUE, "sync", FALSE,
-               NULL);
-  g_signal_connect(gst_appsink_, "new-sample",
-                   G_CALLBACK(on_new_sample_from_sink),
-                   &options_.receiver_callback);
 
-  // Play the gstreamer pipeline and start the glib main loop.
-  gst_element_set_state(gst_pipeline_, GST_STATE_PLAYING);
-  glib_main_loop_runner_ =
-      std::thread([this]() { g_main_loop_run(glib_main_loop_); });
+  return OkStatus();
+}
 
+Status GstreamerRunner::GstreamerRuntimeImpl::SetUpAppsink(
+    const std::string& name, ReceiverCallback* receiver_callback) {
+  GstElement* appsink = gst_bin_get_by_name(GST_BIN(gst_pipeline_),
+                                            name.c_str());
+  if (appsink == nullptr) {
+    return InternalError(absl::StrFormat(
+        "Failed to get a pointer to the appsink element \"%s\"", name));
+  }
+  gst_appsinks_.push_back(appsink);
+  g_object_set(G_OBJECT(appsink), "emit-signals", TRUE, "sync", FALSE, NULL);
+  g_signal_connect(appsink, "new-sample", G_CALLBACK(on_new_sample_from_sink),
+                   receiver_callback);
+  GstPad* appsink_pad = gst_element_get_static_pad(appsink, "sink");
+  gst_pad_add_probe(appsink_pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM,
+                    advertise_video_meta, NULL, NULL);
+  gst_object_unref(appsink_pad);
   return OkStatus();
 }
 
+GstBusSyncReply GstreamerRunner::GstreamerRuntimeImpl::HandleBusMessage(
+    GstMessage* message) {
+  GError* err;
+  gchar* debug_info;
+  switch (GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_EOS:
+      break;
+    case GST_MESSAGE_ERROR:
+      gst_message_parse_error(message, &err, &debug_info);
+      LOG(ERROR) << absl::StrFormat("Error from gstreamer element %s: %s",
+                                    GST_OBJECT_NAME(message->src),
+                                    err->message);
+      LOG(ERROR) << absl::StrFormat("Additional debug info: %s",
+                                    debug_info ? debug_info : "none");
+      LOG(ERROR) << "Got gstreamer error; the pipeline has stopped";
+      g_clear_error(&err);
+      g_free(debug_info);
+      break;
+    default:
+      return GST_BUS_DROP;
+  }
+  absl::MutexLock lock(&state_mu_);
+  done_ = true;
+  dequeued_cv_.SignalAll();
+  return GST_BUS_DROP;
+}
+
+void GstreamerRunner::GstreamerRuntimeImpl::OnBufferDequeued(int64_t size) {
+  absl::MutexLock lock(&state_mu_);
+  queued_bytes_ -= size;
+  dequeued_cv_.SignalAll();
+}
+
+bool GstreamerRunner::GstreamerRuntimeImpl::ReserveQueueRoom(
+    int64_t size, absl::Duration timeout) {
+  absl::Time deadline = absl::Now() + timeout;
+  absl::MutexLock lock(&state_mu_);
+
+  while (!HasQueueRoom(size)) {
+    if (dequeued_cv_.WaitWithDeadline(&state_mu_, deadline) &&
+        !HasQueueRoom(size)) {
+      return false;
+    }
+  }
+  queued_bytes_ += size;
+  return true;
+}
+
+bool GstreamerRunner::GstreamerRuntimeImpl::HasQueueRoom(int64_t size) const {
+  // A buffer larger than the bound still goes into an empty queue. Once the
+  // pipeline is done, pushing fails regardless.
+  return done_ || queued_bytes_ <= 0 ||
+         queued_bytes_ + size <= options_.appsrc_max_bytes;
+}
+
 Status GstreamerRunner::GstreamerRuntimeImpl::Finalize() {
-  // Signal EOS. This will cause the pipeline to cease and trigger the GLib
-  // event loop to stop.
+  // Signal EOS and wait for it to reach the end of the pipeline, so that the
+  // frames in flight are delivered. A pipeline that has failed will not get
+  // there, and is done already; one that is stuck is stopped after
+  // `end_timeout`.
   //
-  // TODO(dschao): Check whether this works when the pipeline is already in an
-  // error state. Find the "end-of-stream" handler in the gstreamer source.
-  GstFlowReturn ret;
-  g_signal_emit_by_name(gst_appsrc_, "end-of-stream", &ret);
-  if (glib_main_loop_runner_.joinable()) {
-    glib_main_loop_runner_.join();
+  // Without an appsrc, the pipeline sends the EOS to its source elements. The
+  // EOS may reach the bus before this returns, so no lock is held.
+  bool done;
+  {
+    absl::MutexLock lock(&state_mu_);
+    done = done_;
+  }
+  if (!done) {
+    if (gst_appsrc_ != nullptr) {
+      GstFlowReturn ret;
+      g_signal_emit_by_name(gst_appsrc_, "end-of-stream", &ret);
+    } else {
+      gst_element_send_event(gst_pipeline_, gst_event_new_eos());
+    }
+    absl::MutexLock lock(&state_mu_);
+    if (!state_mu_.AwaitWithTimeout(absl::Condition(&done_),
+                                    options_.end_timeout)) {
+      LOG(WARNING) << absl::StrFormat(
+          "The gstreamer pipeline did not reach EOS within %s; stopping it "
+          "with its frames in flight",
+          absl::FormatDuration(options_.end_timeout));
+    }
   }
 
+  Teardown();
+  return OkStatus();
+}
+
+void GstreamerRunner::GstreamerRuntimeImpl::Teardown() {
   // Set the pipeline to the null state.
-  gst_element_set_state(gst_pipeline_, GST_STATE_NULL);
+  if (gst_pipeline_ != nullptr) {
+    gst_element_set_state(gst_pipeline_, GST_STATE_NULL);
+  }
 
   // Cleanup.
-  gst_object_unref(gst_appsink_);
-  gst_object_unref(gst_appsrc_);
-  g_main_loop_unref(glib_main_loop_);
-  gst_object_unref(gst_pipeline_);
-
-  return OkStatus();
+  for (GstElement* appsink : gst_appsinks_) {
+    gst_object_unref(appsink);
+  }
+  gst_appsinks_.clear();
+  if (gst_appsrc_ != nullptr) {
+    gst_object_unref(gst_appsrc_);
+    gst_appsrc_ = nullptr;
+  }
+  if (gst_pipeline_ != nullptr) {
+    gst_object_unref(gst_pipeline_);
+    gst_pipeline_ = nullptr;
+  }
 }
 
 Status GstreamerRunner::GstreamerRuntimeImpl::Feed(
-    const GstreamerBuffer& gstreamer_buffer) {
+    const GstreamerBuffer& gstreamer_buffer, absl::Duration timeout) {
+  if (gst_appsrc_ == nullptr) {
+    return FailedPreconditionError(
+        "The pipeline has a source pipeline string and cannot be fed");
+  }
+
   // Check that the given caps agree with those of the pipeline.
-  //
-  // Our way of supporting caps changes is to bringup/teardown the
-  // GstreamerRuntimeImpl itself rather than deal with the nuances of doing this
-  // in situ from within Gstreamer.
   if (gstreamer_buffer.get_caps() != options_.appsrc_caps_string) {
     return InvalidArgumentError(absl::StrFormat(
         "Feeding an appsrc with caps \"%s\" with a data of caps \"%s\"",
         options_.appsrc_caps_string, gstreamer_buffer.get_caps()));
   }
 
+  // A non-default plane layout can only be described for raw video.
+  const auto& video_planes = gstreamer_buffer.get_video_planes();
+  if (!video_planes.empty()) {
+    if (!has_appsrc_video_info_) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given video planes for a buffer with caps \"%s\", which is not "
+          "raw video",
+          gstreamer_buffer.get_caps()));
+    }
+    if (video_planes.size() !=
+        GST_VIDEO_INFO_N_PLANES(&appsrc_video_info_)) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given %d video planes for a format with %d", video_planes.size(),
+          GST_VIDEO_INFO_N_PLANES(&appsrc_video_info_)));
+    }
+  }
+
+  // Wait for room in a bounded appsrc queue, or drop the buffer.
+  bool bounded = options_.appsrc_max_bytes > 0;
+  if (bounded && !ReserveQueueRoom(gstreamer_buffer.size(), timeout)) {
+    FeedDropsCounter()->Increment();
+    return ResourceExhaustedError(absl::StrFormat(
+        "The appsrc queue has had no room for %d more bytes within %s",
+        gstreamer_buffer.size(), absl::FormatDuration(timeout)));
+  }
+
   // Create a new GstBuffer by copying.
   GstBuffer* buffer = gst_buffer_new_and_alloc(gstreamer_buffer.size());
   GstMapInfo map;
@@ -240,20 +584,97 @@ Status GstreamerRunner::GstreamerRuntimeImpl::Feed(
             gstreamer_buffer.data() + gstreamer_buffer.size(), (char*)map.data);
   gst_buffer_unmap(buffer, &map);
 
+  // Describe the plane layout with a GstVideoMeta rather than repacking it.
+  if (!video_planes.empty()) {
+    gsize offset[GST_VIDEO_MAX_PLANES] = {0};
+    gint stride[GST_VIDEO_MAX_PLANES] = {0};
+    for (size_t i = 0; i < video_planes.size(); ++i) {
+      offset[i] = video_planes[i].offset;
+      stride[i] = video_planes[i].stride;
+    }
+    gst_buffer_add_video_meta_full(
+        buffer, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_INFO_FORMAT(&appsrc_video_info_),
+        GST_VIDEO_INFO_WIDTH(&appsrc_video_info_),
+        GST_VIDEO_INFO_HEIGHT(&appsrc_video_info_), video_planes.size(),
+        offset, stride);
+  }
+
+  // Carry the timestamp through so that outputs can be matched to inputs.
+  if (gstreamer_buffer.get_pts() >= 0) {
+    GST_BUFFER_PTS(buffer) =
+        static_cast<GstClockTime>(gstreamer_buffer.get_pts());
+  }
+  if (gstreamer_buffer.is_delta_unit()) {
+    GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+
   // Feed the buffer.
   GstFlowReturn ret;
   g_signal_emit_by_name(gst_appsrc_, "push-buffer", buffer, &ret);
   gst_buffer_unref(buffer);
   if (ret != GST_FLOW_OK) {
+    if (bounded) {
+      absl::MutexLock lock(&state_mu_);
+      queued_bytes_ -= gstreamer_buffer.size();
+    }
+    FeedErrorsCounter()->Increment();
     return InternalError("Failed to push a GstBuffer");
   }
+  BuffersFedCounter()->Increment();
+  return OkStatus();
+}
+
+Status GstreamerRunner::GstreamerRuntimeImpl::SetAppsrcCaps(
+    const std::string& caps_string) {
+  if (gst_appsrc_ == nullptr) {
+    return FailedPreconditionError(
+        "The pipeline has a source pipeline string and has no appsrc caps");
+  }
+  GstCaps* caps = gst_caps_from_string(caps_string.c_str());
+  if (caps == nullptr || gst_caps_is_empty(caps)) {
+    if (caps != nullptr) {
+      gst_caps_unref(caps);
+    }
+    return InvalidArgumentError(absl::StrFormat(
+        "Failed to create a GstCaps from \"%s\"; make sure it is a valid "
+        "cap string",
+        caps_string));
+  }
+  GstCaps* current_caps =
+      gst_caps_from_string(options_.appsrc_caps_string.c_str());
+  bool same_media_type = gst_structure_has_name(
+      gst_caps_get_structure(caps, 0),
+      gst_structure_get_name(gst_caps_get_structure(current_caps, 0)));
+  gst_caps_unref(current_caps);
+  if (!same_media_type) {
+    gst_caps_unref(caps);
+    return FailedPreconditionError(absl::StrFormat(
+        "Cannot change the appsrc caps from \"%s\" to \"%s\" in place",
+        options_.appsrc_caps_string, caps_string));
+  }
+
+  // The appsrc sends the new caps downstream ahead of the next buffer.
+  g_object_set(G_OBJECT(gst_appsrc_), "caps", caps, NULL);
+  UpdateAppsrcVideoInfo(caps);
+  gst_caps_unref(caps);
+  options_.appsrc_caps_string = caps_string;
   return OkStatus();
 }
 
+bool GstreamerRunner::GstreamerRuntimeImpl::WaitForCompletion(
+    absl::Duration timeout) {
+  absl::MutexLock lock(&state_mu_);
+  return state_mu_.AwaitWithTimeout(absl::Condition(&done_), timeout);
+}
+
 GstreamerRunner::GstreamerRuntimeImpl::~GstreamerRuntimeImpl() {
-  // Prevent the program from terminating if Finalize wasn't called/complete.
-  if (glib_main_loop_runner_.joinable()) {
-    glib_main_loop_runner_.detach();
+  // Stop handling the messages of a pipeline that was not finalized, as it
+  // may outlive this.
+  if (gst_pipeline_ != nullptr) {
+    GstBus* bus = gst_element_get_bus(gst_pipeline_);
+    gst_bus_set_sync_handler(bus, NULL, NULL, NULL);
+    gst_object_unref(bus);
   }
 }
 
@@ -285,6 +706,16 @@ Status GstreamerRunner::SetReceiver(const ReceiverCallback& callback) {
   return OkStatus();
 }
 
+Status GstreamerRunner::SetReceiver(const std::string& output_name,
+                                    const ReceiverCallback& callback) {
+  if (IsStarted()) {
+    return FailedPreconditionError(
+        "You cannot SetReceiver while the runner has Started");
+  }
+  output_callbacks_[output_name] = callback;
+  return OkStatus();
+}
+
 bool GstreamerRunner::IsStarted() const {
   return gstreamer_runtime_impl_ != nullptr;
 }
@@ -307,19 +738,35 @@ Status GstreamerRunner::Start() {
     LOG(ERROR) << status;
     return InvalidArgumentError("The given GstreamerRunnerOptions has errors");
   }
+  for (const auto& output : output_callbacks_) {
+    if (options_.output_pipeline_strings.count(output.first) == 0) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given a receiver for \"%s\", which is not one of the "
+          "output_pipeline_strings",
+          output.first));
+    }
+  }
+  return StartRuntime(options_.appsrc_caps_string);
+}
+
+Status GstreamerRunner::StartRuntime(const std::string& appsrc_caps_string) {
   GstreamerRuntimeImpl::Options options;
   options.processing_pipeline_string = options_.processing_pipeline_string;
-  options.appsrc_caps_string = options_.appsrc_caps_string;
+  options.appsrc_caps_string = appsrc_caps_string;
+  options.source_pipeline_string = options_.source_pipeline_string;
+  options.appsrc_max_bytes = options_.appsrc_max_bytes;
   options.receiver_callback = receiver_callback_;
+  options.output_pipeline_strings = options_.output_pipeline_strings;
+  options.leaky_outputs = options_.leaky_outputs;
+  options.output_queue_buffers = options_.output_queue_buffers;
+  options.output_callbacks = output_callbacks_;
+  options.end_timeout = options_.end_timeout;
   gstreamer_runtime_impl_ = std::make_unique<GstreamerRuntimeImpl>(options);
 
   // Initialize the GstreamerRuntimeImpl.
-  status = gstreamer_runtime_impl_->Initialize();
+  Status status = gstreamer_runtime_impl_->Initialize();
   if (!status.ok()) {
     LOG(ERROR) << status;
-
-    // TODO(dschao): This could leak resources. Probably ok for most cases, but
-    // would be nice if this could be friendlier.
     gstreamer_runtime_impl_.reset(nullptr);
     return UnknownError("Failed to Initialize a GstreamerRuntimeImpl");
   }
@@ -339,11 +786,51 @@ Status GstreamerRunner::End() {
   return OkStatus();
 }
 
+Status GstreamerRunner::ChangeCaps(const std::string& caps_string) {
+  if (caps_string == gstreamer_runtime_impl_->appsrc_caps_string()) {
+    return OkStatus();
+  }
+  Status status = gstreamer_runtime_impl_->SetAppsrcCaps(caps_string);
+  if (status.ok()) {
+    CapsChangesCounter()->Increment();
+    return OkStatus();
+  }
+  if (status.code() != StatusCode::kFailedPrecondition) {
+    return status;
+  }
+
+  // Otherwise, the media type differs. Deliver the frames in flight and start
+  // over with the new caps.
+  CapsChangesCounter()->Increment();
+  LOG(INFO) << status.message() << "; restarting the pipeline";
+  PipelineRestartsCounter()->Increment();
+  AIS_RETURN_IF_ERROR(End());
+  return StartRuntime(caps_string);
+}
+
 Status GstreamerRunner::Feed(const GstreamerBuffer& gstreamer_buffer) {
+  return Feed(gstreamer_buffer, options_.appsrc_leaky
+                                    ? absl::ZeroDuration()
+                                    : absl::InfiniteDuration());
+}
+
+Status GstreamerRunner::Feed(const GstreamerBuffer& gstreamer_buffer,
+                             absl::Duration timeout) {
   if (!IsStarted()) {
     return FailedPreconditionError("The runner has not been Started");
   }
-  Status status = gstreamer_runtime_impl_->Feed(gstreamer_buffer);
+  // A source pipeline has no appsrc, so let the runtime reject the buffer.
+  if (options_.allow_caps_changes && options_.source_pipeline_string.empty()) {
+    Status status = ChangeCaps(gstreamer_buffer.get_caps());
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return UnknownError("Failed to change the caps of the GstreamerRunner");
+    }
+  }
+  Status status = gstreamer_runtime_impl_->Feed(gstreamer_buffer, timeout);
+  if (IsResourceExhausted(status)) {
+    return status;
+  }
   if (!status.ok()) {
     LOG(ERROR) << status;
     return UnknownError("Failed to Feed the GstreamerRunner");
@@ -351,4 +838,11 @@ Status GstreamerRunner::Feed(const GstreamerBuffer& gstreamer_buffer) {
   return OkStatus();
 }
 
+bool GstreamerRunner::WaitForCompletion(absl::Duration timeout) {
+  if (!IsStarted()) {
+    return true;
+  }
+  return gstreamer_runtime_impl_->WaitForCompletion(timeout);
+}
+
 }  // namespace aistreams
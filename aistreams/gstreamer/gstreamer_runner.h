@@ -18,8 +18,12 @@
 #define AISTREAMS_GSTREAMER_GSTREAMER_RUNNER_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <string>
 
+#include "absl/time/time.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
@@ -39,6 +43,63 @@ struct GstreamerRunnerOptions {
 
   // The string representing the appsrc caps that you intend to feed.
   std::string appsrc_caps_string;
+
+  // If set, this takes the place of the appsrc in the gst-launch command
+  // above; e.g. an aissrc element that receives the packets of a stream. The
+  // pipeline then produces its inputs on its own, so the runner cannot be fed
+  // and `appsrc_caps_string` is not used.
+  std::string source_pipeline_string;
+
+  // If true, buffers whose caps differ from those of the appsrc may be fed.
+  //
+  // For caps of the same media type (e.g. a new resolution or profile of
+  // video/x-h264), the appsrc caps are changed in place and the elements
+  // downstream renegotiate, which takes no longer than any other buffer.
+  // Otherwise, the pipeline is drained of the frames in flight and restarted
+  // with the new caps.
+  //
+  // If false, such buffers are rejected.
+  bool allow_caps_changes = false;
+
+  // If positive, at most about this many bytes of fed buffers wait in the
+  // appsrc for the pipeline, e.g. for a decoder that is slower than the
+  // network. Feed() then waits for room, or drops the buffer if
+  // `appsrc_leaky` is set. A single larger buffer is still accepted into an
+  // empty queue.
+  //
+  // Otherwise, the queue is unbounded.
+  int64_t appsrc_max_bytes = 0;
+  bool appsrc_leaky = false;
+
+  // If not empty, the output of the processing pipeline is split by a tee
+  // into one branch per entry, in place of the single appsink above:
+  //
+  // gst-launch appsrc ! <processing-pipeline-string> ! tee
+  //   ! queue ! <output-pipeline-string> ! appsink (for each entry)
+  //
+  // Each entry maps the name of an output to a string that forms its branch;
+  // e.g. "videoscale ! video/x-raw,width=224,height=224" for a smaller copy of
+  // the decoded frames. An empty string passes the frames as they are. The
+  // work shared by every output, such as decoding, is then done only once.
+  //
+  // The results of each output are given to the receiver set for its name.
+  std::map<std::string, std::string> output_pipeline_strings;
+
+  // Each output branch starts with a queue, which runs it on a thread of its
+  // own. By default, the queues never drop buffers: once that of a slow output
+  // (e.g. one with a slow receiver) is full, the tee waits for it, which
+  // stalls every other output and, with `appsrc_max_bytes`, Feed().
+  //
+  // If `leaky_outputs` is set, the queue of each output holds at most
+  // `output_queue_buffers` buffers and drops its oldest one to make room, so
+  // that only the slow output loses buffers.
+  bool leaky_outputs = false;
+  int output_queue_buffers = 8;
+
+  // The longest that End() waits for the pipeline to deliver the frames in
+  // flight and reach EOS; e.g. behind an element that is stuck. The pipeline
+  // is then stopped regardless, and the frames still in flight are discarded.
+  absl::Duration end_timeout = absl::Seconds(10);
 };
 
 // This class manages a running gstreamer pipeline and supports an interface to
@@ -53,8 +114,17 @@ struct GstreamerRunnerOptions {
 // You may only feed and receive buffers when the runner has "Started".
 //
 // Buffers fed will have their results be completed and delivered in FIFO order.
-// When the runner transitions to "Ended", any processing that are currently
-// in-flight and any un-delivered results will be discarded.
+// When the runner transitions to "Ended", the buffers in flight are processed
+// and their results delivered before End() returns, unless the pipeline does
+// not reach EOS within `end_timeout`; whatever is still in flight then is
+// discarded.
+//
+// The runner starts no threads of its own. The receiver callback is called,
+// and the messages of the pipeline are handled, on the streaming threads of
+// GStreamer, so many runners can share a process. The callbacks of different
+// outputs (see `output_pipeline_strings`) run on different threads, and may
+// be called concurrently; a slow one may still hold up the others (see
+// `leaky_outputs`).
 //
 // Most resources are allocated and initialized when Start() is called. To
 // properly cleanup, you must also call End(). Merely running the destructor
@@ -88,6 +158,10 @@ class GstreamerRunner {
   // The callback that is set does not unless you explicitly make another call.
   Status SetReceiver(const ReceiverCallback&);
 
+  // Same as above, but for the output of the given name in
+  // `output_pipeline_strings`. Outputs without a receiver drop their results.
+  Status SetReceiver(const std::string& output_name, const ReceiverCallback&);
+
   // Start the runner.
   //
   // You should call End() when you are done to reclaim the resources.
@@ -97,8 +171,25 @@ class GstreamerRunner {
   bool IsStarted() const;
 
   // Feed a GstreamerBuffer object for processing.
+  //
+  // Its caps must be those of the appsrc unless `allow_caps_changes` is set.
+  // If the buffer has a pts, it is set on the GstBuffer and is visible on the
+  // outputs that the pipeline derives from it (e.g. decoded frames).
   Status Feed(const GstreamerBuffer&);
 
+  // Same as above, but waits at most `timeout` for room in a bounded appsrc
+  // queue (see `appsrc_max_bytes`), regardless of `appsrc_leaky`. If there is
+  // none, the buffer is dropped and a kResourceExhausted Status is returned
+  // so that the caller can slow down or skip frames.
+  Status Feed(const GstreamerBuffer&, absl::Duration timeout);
+
+  // Waits up to `timeout` for the pipeline to finish on its own; i.e. for an
+  // EOS or an error to reach the end of it. This is mostly useful with a
+  // `source_pipeline_string`, whose source decides when the stream ends.
+  //
+  // Returns true if the pipeline has finished. You should still call End().
+  bool WaitForCompletion(absl::Duration timeout);
+
   // End the runner.
   Status End();
 
@@ -110,8 +201,12 @@ class GstreamerRunner {
   GstreamerRunner& operator=(GstreamerRunner&&) = delete;
 
  private:
+  Status StartRuntime(const std::string& appsrc_caps_string);
+  Status ChangeCaps(const std::string& caps_string);
+
   GstreamerRunnerOptions options_;
   ReceiverCallback receiver_callback_;
+  std::map<std::string, ReceiverCallback> output_callbacks_;
 
   class GstreamerRuntimeImpl;
   std::unique_ptr<GstreamerRuntimeImpl> gstreamer_runtime_impl_;
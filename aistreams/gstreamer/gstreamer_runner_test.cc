@@ -16,8 +16,13 @@
 
 #include <gst/gst.h>
 
+#include <atomic>
 #include <string>
+#include <utility>
 
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/gtest.h"
@@ -283,4 +288,366 @@ TEST(GstreamerRunner, PipelineChangeTest) {
   }
 }
 
+TEST(GstreamerRunner, CapsChangeTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+
+  GstreamerRunnerOptions options;
+  options.processing_pipeline_string = kProcessingPipelineString;
+  options.appsrc_caps_string = "image/jpeg,width=512,height=512";
+  options.allow_caps_changes = true;
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+
+  // A new resolution is renegotiated in place; a new media type restarts the
+  // pipeline. Neither loses frames.
+  const std::pair<const char*, std::string> inputs[] = {
+      {kTestImageLenaPath, "image/jpeg,width=512,height=512"},
+      {kTestImageSquaresPath, "image/jpeg,width=243,height=243"},
+      {kTestImageGooglePath, kPngCapsString},
+      {kTestImageLenaPath, "image/jpeg,width=512,height=512"},
+  };
+  for (const auto& input : inputs) {
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(input.first, input.second).ValueOrDie();
+    EXPECT_TRUE(runner.Feed(gstreamer_buffer).ok());
+  }
+
+  // Caps that do not parse are rejected without ending the runner.
+  GstreamerBuffer malformed =
+      GstreamerBufferFromFile(kTestImageLenaPath, kPngCapsString).ValueOrDie();
+  malformed.set_caps_string("not a caps string,,");
+  EXPECT_FALSE(runner.Feed(malformed).ok());
+  EXPECT_TRUE(runner.IsStarted());
+
+  EXPECT_TRUE(runner.End().ok());
+
+  const int expected_heights[] = {512, 243, 225, 512};
+  for (int expected_height : expected_heights) {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    GstCaps* gst_caps = gst_caps_from_string(gstreamer_buffer.get_caps_cstr());
+    GstStructure* structure = gst_caps_get_structure(gst_caps, 0);
+    int height;
+    EXPECT_TRUE(gst_structure_get_int(structure, "height", &height) == TRUE);
+    gst_caps_unref(gst_caps);
+    EXPECT_EQ(height, expected_height);
+  }
+}
+
+TEST(GstreamerRunner, BackPressureTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+
+  // Each buffer holds up the pipeline for 200ms, and the appsrc queue has
+  // room for one.
+  GstreamerRunnerOptions options;
+  options.processing_pipeline_string = "identity sleep-time=200000";
+  options.appsrc_caps_string = "application/octet-stream";
+  options.appsrc_max_bytes = 10;
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string("application/octet-stream");
+  gstreamer_buffer.assign(std::string(8, 'x'));
+
+  // The first is taken into the pipeline and the second waits in the queue,
+  // which leaves no room for a third until the first is done.
+  EXPECT_TRUE(runner.Feed(gstreamer_buffer, absl::Seconds(1)).ok());
+  EXPECT_TRUE(runner.Feed(gstreamer_buffer, absl::Seconds(1)).ok());
+  EXPECT_EQ(runner.Feed(gstreamer_buffer, absl::ZeroDuration()).code(),
+            StatusCode::kResourceExhausted);
+  EXPECT_TRUE(runner.Feed(gstreamer_buffer, absl::Seconds(1)).ok());
+  EXPECT_TRUE(runner.End().ok());
+  EXPECT_EQ(pcqueue.count(), 3);
+}
+
+TEST(GstreamerRunner, SourcePipelineTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+
+  // The source produces a fixed number of frames and then ends the stream.
+  GstreamerRunnerOptions options;
+  options.source_pipeline_string =
+      "videotestsrc num-buffers=3 ! video/x-raw,width=64,height=48";
+  options.processing_pipeline_string =
+      "videoconvert ! video/x-raw,format=RGB";
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+  EXPECT_TRUE(runner.WaitForCompletion(absl::Seconds(10)));
+
+  // There is no appsrc to feed.
+  {
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(kTestImageLenaPath, kJpegCapsString)
+            .ValueOrDie();
+    EXPECT_FALSE(runner.Feed(gstreamer_buffer).ok());
+  }
+  EXPECT_TRUE(runner.End().ok());
+
+  for (int i = 0; i < 3; ++i) {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    EXPECT_EQ(gstreamer_buffer.size(), 64 * 48 * 3);
+  }
+  {
+    GstreamerBuffer gstreamer_buffer;
+    EXPECT_FALSE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+  }
+
+  // A source that never ends is stopped by End().
+  options.source_pipeline_string = "videotestsrc is-live=true";
+  EXPECT_TRUE(runner.SetOptions(options).ok());
+  EXPECT_TRUE(runner.Start().ok());
+  EXPECT_FALSE(runner.WaitForCompletion(absl::Milliseconds(100)));
+  EXPECT_TRUE(runner.End().ok());
+}
+
+TEST(GstreamerRunner, FailedStartTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+
+  // The source fails to start, like an aissrc that cannot reach its server.
+  GstreamerRunnerOptions options;
+  options.source_pipeline_string =
+      "filesrc location=/no/such/file ! video/x-raw,width=64,height=48";
+  options.processing_pipeline_string = "identity";
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_FALSE(runner.Start().ok());
+  EXPECT_FALSE(runner.IsStarted());
+
+  // The failed pipeline is gone, and the runner starts over cleanly.
+  options.source_pipeline_string =
+      "videotestsrc num-buffers=2 ! video/x-raw,width=64,height=48";
+  options.processing_pipeline_string =
+      "videoconvert ! video/x-raw,format=RGB";
+  EXPECT_TRUE(runner.SetOptions(options).ok());
+  EXPECT_TRUE(runner.Start().ok());
+  EXPECT_TRUE(runner.WaitForCompletion(absl::Seconds(10)));
+  EXPECT_TRUE(runner.End().ok());
+  for (int i = 0; i < 2; ++i) {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    EXPECT_EQ(gstreamer_buffer.size(), 64 * 48 * 3);
+  }
+}
+
+TEST(GstreamerRunner, MultipleOutputsTest) {
+  ProducerConsumerQueue<GstreamerBuffer> full_pcqueue(10);
+  ProducerConsumerQueue<GstreamerBuffer> small_pcqueue(10);
+
+  // Each frame is decoded once and then given to every output.
+  GstreamerRunnerOptions options;
+  options.processing_pipeline_string = kProcessingPipelineString;
+  options.appsrc_caps_string = kJpegCapsString;
+  options.output_pipeline_strings = {
+      {"full", ""},
+      {"small",
+       "videoscale ! video/x-raw,width=128,height=64 ! videoconvert ! "
+       "video/x-raw,format=GRAY8"},
+      {"unread", ""},
+  };
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      "full", [&full_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        full_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  status = runner.SetReceiver(
+      "small", [&small_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        small_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+
+  GstreamerBuffer gstreamer_buffer =
+      GstreamerBufferFromFile(kTestImageLenaPath, kJpegCapsString)
+          .ValueOrDie();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(runner.Feed(gstreamer_buffer).ok());
+  }
+  EXPECT_TRUE(runner.End().ok());
+
+  EXPECT_EQ(full_pcqueue.count(), 3);
+  EXPECT_EQ(small_pcqueue.count(), 3);
+  for (int i = 0; i < 3; ++i) {
+    GstreamerBuffer full;
+    ASSERT_TRUE(full_pcqueue.TryPop(full, absl::Seconds(1)));
+    EXPECT_EQ(full.size(), 512 * 512 * 3);
+    GstreamerBuffer small;
+    ASSERT_TRUE(small_pcqueue.TryPop(small, absl::Seconds(1)));
+    EXPECT_EQ(small.size(), 128 * 64);
+  }
+
+  // A receiver must be for one of the outputs.
+  EXPECT_TRUE(runner.SetReceiver("other", nullptr).ok());
+  EXPECT_FALSE(runner.Start().ok());
+}
+
+TEST(GstreamerRunner, LeakyOutputsTest) {
+  ProducerConsumerQueue<GstreamerBuffer> fast_pcqueue(100);
+  std::atomic<int> slow_count(0);
+  absl::Notification release_slow;
+
+  GstreamerRunnerOptions options;
+  options.processing_pipeline_string = "identity";
+  options.appsrc_caps_string = "application/octet-stream";
+  options.output_pipeline_strings = {{"fast", ""}, {"slow", ""}};
+  options.leaky_outputs = true;
+  options.output_queue_buffers = 1;
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      "fast", [&fast_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        fast_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  status = runner.SetReceiver(
+      "slow", [&slow_count, &release_slow](GstreamerBuffer) -> Status {
+        release_slow.WaitForNotification();
+        ++slow_count;
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string("application/octet-stream");
+  gstreamer_buffer.assign(std::string(8, 'x'));
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_TRUE(runner.Feed(gstreamer_buffer).ok());
+  }
+
+  // The fast output gets every buffer while the slow one is stuck, whose
+  // queue drops all but the newest.
+  for (int i = 0; i < 20; ++i) {
+    GstreamerBuffer fast;
+    ASSERT_TRUE(fast_pcqueue.TryPop(fast, absl::Seconds(5)));
+  }
+  release_slow.Notify();
+  EXPECT_TRUE(runner.End().ok());
+  EXPECT_LT(slow_count.load(), 20);
+
+  options.output_queue_buffers = 0;
+  EXPECT_TRUE(runner.SetOptions(options).ok());
+  EXPECT_FALSE(runner.Start().ok());
+}
+
+TEST(GstreamerRunner, ConcurrentFailureTest) {
+  ProducerConsumerQueue<GstreamerBuffer> healthy_pcqueue(1000);
+  std::atomic<int> failing_count(0);
+
+  // A live source that runs until it is ended.
+  GstreamerRunnerOptions healthy_options;
+  healthy_options.source_pipeline_string =
+      "videotestsrc is-live=true ! "
+      "video/x-raw,width=64,height=48,framerate=30/1";
+  healthy_options.processing_pipeline_string =
+      "videoconvert ! video/x-raw,format=RGB";
+  GstreamerRunner healthy_runner(healthy_options);
+  Status status = healthy_runner.SetReceiver(
+      [&healthy_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        healthy_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+
+  // A live source in a format that the processing pipeline does not accept,
+  // which fails once it starts streaming.
+  GstreamerRunnerOptions failing_options;
+  failing_options.source_pipeline_string =
+      "videotestsrc is-live=true ! video/x-raw,format=RGB,width=64,height=48";
+  failing_options.processing_pipeline_string = "video/x-raw,format=GRAY8";
+  GstreamerRunner failing_runner(failing_options);
+  status = failing_runner.SetReceiver(
+      [&failing_count](GstreamerBuffer) -> Status {
+        ++failing_count;
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+
+  EXPECT_TRUE(healthy_runner.Start().ok());
+  GstreamerBuffer gstreamer_buffer;
+  ASSERT_TRUE(healthy_pcqueue.TryPop(gstreamer_buffer, absl::Seconds(5)));
+  EXPECT_TRUE(failing_runner.Start().ok());
+  EXPECT_TRUE(failing_runner.WaitForCompletion(absl::Seconds(10)));
+
+  // The error is only seen by the runner of the failed pipeline; the other
+  // keeps producing.
+  EXPECT_FALSE(healthy_runner.WaitForCompletion(absl::ZeroDuration()));
+  while (healthy_pcqueue.TryPop(gstreamer_buffer, absl::ZeroDuration())) {
+  }
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(healthy_pcqueue.TryPop(gstreamer_buffer, absl::Seconds(5)));
+    EXPECT_EQ(gstreamer_buffer.size(), 64 * 48 * 3);
+  }
+  EXPECT_FALSE(healthy_runner.WaitForCompletion(absl::ZeroDuration()));
+
+  EXPECT_TRUE(failing_runner.End().ok());
+  EXPECT_TRUE(healthy_runner.End().ok());
+  EXPECT_EQ(failing_count.load(), 0);
+}
+
+TEST(GstreamerRunner, EndTimeoutTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+
+  // Each buffer holds up the pipeline for a second, so delivering all that
+  // are fed would take five.
+  GstreamerRunnerOptions options;
+  options.processing_pipeline_string = "identity sleep-time=1000000";
+  options.appsrc_caps_string = "application/octet-stream";
+  options.end_timeout = absl::Milliseconds(100);
+
+  GstreamerRunner runner(options);
+  Status status = runner.SetReceiver(
+      [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+        pcqueue.TryEmplace(std::move(gstreamer_buffer));
+        return OkStatus();
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(runner.Start().ok());
+
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string("application/octet-stream");
+  gstreamer_buffer.assign(std::string(8, 'x'));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(runner.Feed(gstreamer_buffer).ok());
+  }
+
+  // End() stops the pipeline rather than wait for the buffers in flight.
+  absl::Time start = absl::Now();
+  EXPECT_TRUE(runner.End().ok());
+  EXPECT_LT(absl::Now() - start, absl::Seconds(4));
+  EXPECT_LT(pcqueue.count(), 5);
+}
+
 }  // namespace aistreams
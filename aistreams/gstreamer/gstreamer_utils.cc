@@ -87,4 +87,20 @@ Status GstLaunchPipeline(const std::string &gst_pipeline) {
   return OkStatus();
 }
 
+Status GstSetElementRank(const std::string &element_name, int rank) {
+  auto status = GstInit();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return InternalError("Could not initialize Gstreamer");
+  }
+  GstElementFactory *factory = gst_element_factory_find(element_name.c_str());
+  if (factory == nullptr) {
+    return NotFoundError(absl::StrFormat(
+        "There is no gstreamer element named \"%s\"", element_name));
+  }
+  gst_plugin_feature_set_rank(GST_PLUGIN_FEATURE(factory), rank);
+  gst_object_unref(factory);
+  return OkStatus();
+}
+
 }  // namespace aistreams
@@ -35,6 +35,12 @@ Status GstInit();
 // `gst_pipeline`: This is a string that you would normally pass to gst-launch.
 Status GstLaunchPipeline(const std::string& gst_pipeline);
 
+// Set the rank of the named element factory; e.g. to have decodebin prefer
+// (or, with GST_RANK_NONE, never pick) a particular decoder.
+//
+// The rank is process-wide and applies to pipelines built afterwards.
+Status GstSetElementRank(const std::string& element_name, int rank);
+
 }  // namespace aistreams
 
 #endif  // AISTREAMS_GSTREAMER_GSTREAMER_UTILS_H_
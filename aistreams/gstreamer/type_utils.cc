@@ -19,10 +19,14 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
+#include <string>
+#include <vector>
+
 #include "absl/strings/str_format.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/jpeg_frame.h"
 #include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/types/raw_image_helpers.h"
 #include "aistreams/base/util/packet_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/status.h"
@@ -30,8 +34,6 @@
 #include "aistreams/port/statusor.h"
 #include "aistreams/proto/types/raw_image.pb.h"
 
-#define ROUND_UP_4(num) (((num) + 3) & ~0x3)
-
 namespace aistreams {
 
 namespace {
@@ -52,10 +54,49 @@ struct GstreamerRawImageInfo {
   int size = -1;
   int planes = -1;
   int components = -1;
-  int rstride = -1;
-  int pstride = -1;
+
+  // The default layout of each plane.
+  std::vector<GstreamerBuffer::VideoPlane> default_planes;
+};
+
+// Maps between the Gstreamer video formats and the RawImageFormats that have
+// the same memory layout.
+struct VideoFormatMapping {
+  GstVideoFormat gst_format;
+  RawImageFormat raw_image_format;
 };
 
+constexpr VideoFormatMapping kVideoFormatMappings[] = {
+    {GST_VIDEO_FORMAT_RGB, RAW_IMAGE_FORMAT_SRGB},
+    {GST_VIDEO_FORMAT_RGBA, RAW_IMAGE_FORMAT_RGBA},
+    {GST_VIDEO_FORMAT_BGR, RAW_IMAGE_FORMAT_BGR},
+    {GST_VIDEO_FORMAT_GRAY8, RAW_IMAGE_FORMAT_GRAY8},
+    {GST_VIDEO_FORMAT_NV12, RAW_IMAGE_FORMAT_NV12},
+    {GST_VIDEO_FORMAT_I420, RAW_IMAGE_FORMAT_I420},
+};
+
+StatusOr<RawImageFormat> ToRawImageFormat(GstVideoFormat gst_format) {
+  for (const auto& mapping : kVideoFormatMappings) {
+    if (mapping.gst_format == gst_format) {
+      return mapping.raw_image_format;
+    }
+  }
+  return UnimplementedError(
+      absl::StrFormat("We currently do not support \"%s\"",
+                      gst_video_format_to_string(gst_format)));
+}
+
+StatusOr<GstVideoFormat> ToGstVideoFormat(RawImageFormat format) {
+  for (const auto& mapping : kVideoFormatMappings) {
+    if (mapping.raw_image_format == format) {
+      return mapping.gst_format;
+    }
+  }
+  return UnimplementedError(absl::StrFormat(
+      "We currently do not support raw images with your given format (%s)",
+      RawImageFormat_Name(format)));
+}
+
 // Parse the given gstremaer caps string (in Gstreamer's format) for the raw
 // image metadata.
 Status ParseAsRawImageCaps(const std::string& caps_string,
@@ -94,55 +135,54 @@ Status ParseAsRawImageCaps(const std::string& caps_string,
   info->width = GST_VIDEO_INFO_WIDTH(&gst_info);
   info->size = GST_VIDEO_INFO_SIZE(&gst_info);
 
-  // TODO: Support just single planed images to start.
-  // This is fine for most machine learning use cases.
-  if (info->planes == 1) {
-    info->rstride = GST_VIDEO_INFO_PLANE_STRIDE(&gst_info, 0);
-    info->pstride = GST_VIDEO_INFO_COMP_PSTRIDE(&gst_info, 0);
-  } else {
-    if (info->planes > 1) {
-      return UnimplementedError(
-          "We currently support only single planed images");
-    } else {
-      return InvalidArgumentError("The given image has no planes");
-    }
+  if (info->planes < 1) {
+    gst_caps_unref(caps);
+    return InvalidArgumentError("The given image has no planes");
+  }
+  info->default_planes.resize(info->planes);
+  for (int i = 0; i < info->planes; ++i) {
+    info->default_planes[i].offset = GST_VIDEO_INFO_PLANE_OFFSET(&gst_info, i);
+    info->default_planes[i].stride = GST_VIDEO_INFO_PLANE_STRIDE(&gst_info, i);
   }
   gst_caps_unref(caps);
 
   return OkStatus();
 }
 
-// The caller is responsible for ensuring that the GstreamerRawImageInfo is a
-// RGB image. The GstreamerRawImageInfo must also be parsed from the given
-// GstreamerBuffer.
-StatusOr<RawImage> ToRgbRawImage(const GstreamerRawImageInfo& info,
-                                 GstreamerBuffer gstreamer_buffer) {
-  // Fast path when there is no extra padding.
-  if (info.pstride == info.components &&
-      info.rstride == info.width * info.pstride &&
-      static_cast<int>(gstreamer_buffer.size()) == info.height * info.rstride) {
-    RawImageDescriptor desc;
-    desc.set_format(RAW_IMAGE_FORMAT_SRGB);
-    desc.set_height(info.height);
-    desc.set_width(info.width);
-    RawImage r(desc, std::move(gstreamer_buffer).ReleaseBuffer());
-    return r;
-  }
+// The GstreamerRawImageInfo must be parsed from the given GstreamerBuffer.
+//
+// The buffer is adopted without copying; any row padding or gaps between the
+// planes are described by the planes of the RawImage rather than removed.
+StatusOr<RawImage> ToRawImage(const GstreamerRawImageInfo& info,
+                              RawImageFormat format,
+                              GstreamerBuffer gstreamer_buffer) {
+  // A GstVideoMeta on the buffer takes precedence over the default layout.
+  std::vector<GstreamerBuffer::VideoPlane> planes =
+      gstreamer_buffer.get_video_planes().empty()
+          ? info.default_planes
+          : gstreamer_buffer.get_video_planes();
 
-  // Slow path to close extra padding.
-  RawImage r(info.height, info.width, RAW_IMAGE_FORMAT_SRGB);
-  for (int i = 0; i < info.height; ++i) {
-    int src_row_start = info.rstride * i;
-    int dst_row_start = info.width * info.components * i;
-    for (int j = 0; j < info.width; ++j) {
-      int src_pix_start = src_row_start + info.pstride * j;
-      int dst_pix_start = dst_row_start + info.components * j;
-      for (int k = 0; k < info.components; ++k) {
-        r(dst_pix_start + k) = gstreamer_buffer.data()[src_pix_start + k];
-      }
-    }
+  RawImageDescriptor desc;
+  desc.set_format(format);
+  desc.set_height(info.height);
+  desc.set_width(info.width);
+  for (const auto& plane : planes) {
+    RawImagePlane* p = desc.add_planes();
+    p->set_offset(plane.offset);
+    p->set_stride(plane.stride);
+  }
+  AIS_RETURN_IF_ERROR(Validate(desc));
+  AIS_ASSIGN_OR_RETURN(int min_size, GetBufferSize(desc));
+  if (static_cast<int>(gstreamer_buffer.size()) < min_size) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The given buffer has %d bytes but its layout needs at least %d",
+        gstreamer_buffer.size(), min_size));
   }
-  return r;
+  if (IsPacked(desc) &&
+      static_cast<int>(gstreamer_buffer.size()) == min_size) {
+    desc.clear_planes();
+  }
+  return RawImage(desc, std::move(gstreamer_buffer).ReleaseBuffer());
 }
 
 StatusOr<GstreamerBuffer> GstreamerBufferPacketToGstreamerBuffer(Packet p) {
@@ -170,37 +210,46 @@ StatusOr<GstreamerBuffer> JpegPacketToGstreamerBuffer(Packet p) {
   return gstreamer_buffer;
 }
 
-StatusOr<GstreamerBuffer> RgbRawImageToGstreamerBuffer(RawImage r) {
+StatusOr<GstreamerBuffer> RawImageToGstreamerBuffer(RawImage r) {
+  AIS_ASSIGN_OR_RETURN(GstVideoFormat gst_format, ToGstVideoFormat(r.format()));
+
   // Set the caps string.
   GstreamerBuffer gstreamer_buffer;
   GstCaps* caps = gst_caps_new_simple(
-      kRawImageGstreamerMimeType, "format", G_TYPE_STRING, "RGB", "width",
-      G_TYPE_INT, r.width(), "height", G_TYPE_INT, r.height(), NULL);
+      kRawImageGstreamerMimeType, "format", G_TYPE_STRING,
+      gst_video_format_to_string(gst_format), "width", G_TYPE_INT, r.width(),
+      "height", G_TYPE_INT, r.height(), NULL);
   gchar* caps_string = gst_caps_to_string(caps);
   gstreamer_buffer.set_caps_string(caps_string);
   g_free(caps_string);
   gst_caps_unref(caps);
 
-  // Fast path for when padding is not needed.
-  // See
+  // Gstreamer assumes a default layout given just the caps; e.g. it pads
+  // each RGB row up to the nearest size divisible by 4. See
   // https://gstreamer.freedesktop.org/documentation/additional/design/mediatype-video-raw.html?gi-language=c
-  // for more details. In this case, RGB images must pad each row up to the
-  // nearest size divisible by 4.
-  if (!(r.width() * r.channels() % 4)) {
-    gstreamer_buffer.assign(std::move(r).ReleaseBuffer());
-    return gstreamer_buffer;
+  // for more details. Any other layout is described by video planes, which
+  // are attached as a GstVideoMeta, so that the bytes pass through as is.
+  //
+  // The released buffer may also start with bytes that precede the image.
+  GstVideoInfo gst_info;
+  gst_video_info_set_format(&gst_info, gst_format, r.width(), r.height());
+  size_t origin = r.buffer_offset();
+  bool default_layout = true;
+  for (size_t i = 0; i < r.planes().size(); ++i) {
+    default_layout &= origin + r.planes()[i].offset ==
+                          GST_VIDEO_INFO_PLANE_OFFSET(&gst_info, i) &&
+                      r.planes()[i].stride ==
+                          GST_VIDEO_INFO_PLANE_STRIDE(&gst_info, i);
   }
-
-  // Slow path for when padding is needed.
-  int row_size = r.width() * r.channels();
-  int row_stride = ROUND_UP_4(row_size);
-  std::string bytes;
-  bytes.resize(row_stride * r.height());
-  for (int i = 0; i < r.height(); ++i) {
-    std::copy(r.data() + row_size * i, r.data() + row_size * (i + 1),
-              const_cast<char*>(bytes.data() + row_stride * i));
+  if (!default_layout) {
+    std::vector<GstreamerBuffer::VideoPlane> video_planes(r.planes().size());
+    for (size_t i = 0; i < r.planes().size(); ++i) {
+      video_planes[i].offset = origin + r.planes()[i].offset;
+      video_planes[i].stride = r.planes()[i].stride;
+    }
+    gstreamer_buffer.set_video_planes(std::move(video_planes));
   }
-  gstreamer_buffer.assign(std::move(bytes));
+  gstreamer_buffer.assign(std::move(r).ReleaseBuffer());
   return gstreamer_buffer;
 }
 
@@ -211,15 +260,7 @@ StatusOr<GstreamerBuffer> RawImagePacketToGstreamerBuffer(Packet p) {
     return InternalError(
         "Failed to adapt supposedly a RawImage packet into a RawImage");
   }
-  RawImage raw_image = std::move(packet_as).ValueOrDie();
-
-  if (raw_image.format() != RAW_IMAGE_FORMAT_SRGB) {
-    return UnimplementedError(absl::StrFormat(
-        "We currently do not support raw images with your given format (%s)",
-        RawImageFormat_Name(raw_image.format())));
-  }
-
-  return RgbRawImageToGstreamerBuffer(std::move(raw_image));
+  return RawImageToGstreamerBuffer(std::move(packet_as).ValueOrDie());
 }
 
 }  // namespace
@@ -233,13 +274,14 @@ StatusOr<RawImage> ToRawImage(GstreamerBuffer gstreamer_buffer) {
         "Failed to parse the given buffer as a raw image");
   }
 
-  switch (info.gst_format_id) {
-    case GST_VIDEO_FORMAT_RGB:
-      return ToRgbRawImage(info, std::move(gstreamer_buffer));
-    default:
-      return UnimplementedError(absl::StrFormat(
-          "We currently do not support \"%s\"", info.format_name));
-  }
+  AIS_ASSIGN_OR_RETURN(RawImageFormat format,
+                       ToRawImageFormat(info.gst_format_id));
+  return ToRawImage(info, format, std::move(gstreamer_buffer));
+}
+
+StatusOr<std::string> ToGstreamerVideoFormat(RawImageFormat format) {
+  AIS_ASSIGN_OR_RETURN(GstVideoFormat gst_format, ToGstVideoFormat(format));
+  return std::string(gst_video_format_to_string(gst_format));
 }
 
 StatusOr<GstreamerBuffer> ToGstreamerBuffer(Packet p) {
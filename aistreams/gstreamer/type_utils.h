@@ -17,15 +17,21 @@
 #ifndef AISTREAMS_GSTREAMER_TYPE_UTILS_H_
 #define AISTREAMS_GSTREAMER_TYPE_UTILS_H_
 
+#include <string>
+
 #include "aistreams/base/packet.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/raw_image.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
+#include "aistreams/proto/types/raw_image.pb.h"
 
 namespace aistreams {
 
 // Converts a GstreamerBuffer into a RawImage.
+//
+// Buffers of video/x-raw caps whose format has a RawImageFormat counterpart
+// (RGB, RGBA, BGR, GRAY8, NV12 and I420) are converted without copying.
 // You should pass an rvalue for `gstreamer_buffer` if possible.
 //
 // Of course, this may not always be possible based just on the fact
@@ -33,6 +39,10 @@ namespace aistreams {
 // In any case, the returned status will indicate why a conversion failed.
 StatusOr<RawImage> ToRawImage(GstreamerBuffer gstreamer_buffer);
 
+// Returns the name of the Gstreamer video format (as used in video/x-raw caps)
+// with the same memory layout as the given RawImageFormat.
+StatusOr<std::string> ToGstreamerVideoFormat(RawImageFormat format);
+
 // Convert the given Packet into a GstreamerBuffer.
 // You should pass an rvalue for `packet` if possible.
 //
@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/gstreamer/gstreamer_utils.h"
+#include "aistreams/gstreamer/type_utils.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/util/alloc_counter.h"
+
+namespace aistreams {
+
+namespace {
+
+// Image sizes from about 100 B to 25 MB as {width, height}.
+//
+// RGB rows are padded to a multiple of 4 bytes in Gstreamer, so the widths
+// divisible by 4 are unpadded and the odd widths are padded.
+void UnpaddedSizes(benchmark::internal::Benchmark* b) {
+  b->Args({8, 4})->Args({64, 48})->Args({640, 480})->Args({1920, 1080});
+  b->Args({3840, 2160});
+}
+
+void PaddedSizes(benchmark::internal::Benchmark* b) {
+  b->Args({7, 4})->Args({63, 48})->Args({641, 480})->Args({1919, 1080});
+  b->Args({3839, 2160});
+}
+
+void SetCounters(const AllocationCounter& allocs, int64_t bytes_per_op,
+                 benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * bytes_per_op);
+  state.counters["allocs_per_op"] = benchmark::Counter(
+      allocs.allocations(), benchmark::Counter::kAvgIterations);
+}
+
+GstreamerBuffer MakeRgbGstreamerBuffer(int width, int height) {
+  int row_stride = (width * 3 + 3) & ~3;
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(absl::StrFormat(
+      "video/x-raw,format=RGB,width=%d,height=%d", width, height));
+  gstreamer_buffer.assign(std::string(row_stride * height, 'a'));
+  return gstreamer_buffer;
+}
+
+}  // namespace
+
+// The conversions take their input by value, so each iteration includes one
+// copy of the input; compare against BM_CopyGstreamerBuffer for the baseline.
+void BM_ToRawImage(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  GstreamerBuffer gstreamer_buffer =
+      MakeRgbGstreamerBuffer(state.range(0), state.range(1));
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    auto raw_image_statusor = ToRawImage(gstreamer_buffer);
+    CHECK(raw_image_statusor.ok());
+    benchmark::DoNotOptimize(raw_image_statusor);
+  }
+  SetCounters(allocs, gstreamer_buffer.size(), state);
+}
+BENCHMARK(BM_ToRawImage)->Apply(UnpaddedSizes);
+BENCHMARK(BM_ToRawImage)->Apply(PaddedSizes);
+
+void BM_CopyGstreamerBuffer(benchmark::State& state) {
+  GstreamerBuffer gstreamer_buffer =
+      MakeRgbGstreamerBuffer(state.range(0), state.range(1));
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    GstreamerBuffer copy = gstreamer_buffer;
+    benchmark::DoNotOptimize(copy);
+  }
+  SetCounters(allocs, gstreamer_buffer.size(), state);
+}
+BENCHMARK(BM_CopyGstreamerBuffer)->Apply(UnpaddedSizes);
+
+void BM_RawImageToGstreamerBuffer(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  RawImage raw_image(state.range(1), state.range(0), RAW_IMAGE_FORMAT_SRGB);
+  Packet packet = MakePacket(std::move(raw_image)).ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(packet);
+    CHECK(gstreamer_buffer_statusor.ok());
+    benchmark::DoNotOptimize(gstreamer_buffer_statusor);
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+BENCHMARK(BM_RawImageToGstreamerBuffer)->Apply(UnpaddedSizes);
+BENCHMARK(BM_RawImageToGstreamerBuffer)->Apply(PaddedSizes);
+
+void BM_JpegFrameToGstreamerBuffer(benchmark::State& state) {
+  CHECK(GstInit().ok());
+  Packet packet =
+      MakePacket(JpegFrame(std::string(state.range(0), 'a'))).ValueOrDie();
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(packet);
+    CHECK(gstreamer_buffer_statusor.ok());
+    benchmark::DoNotOptimize(gstreamer_buffer_statusor);
+  }
+  SetCounters(allocs, packet.payload().size(), state);
+}
+BENCHMARK(BM_JpegFrameToGstreamerBuffer)
+    ->RangeMultiplier(16)
+    ->Range(100, 25 << 20);
+
+}  // namespace aistreams
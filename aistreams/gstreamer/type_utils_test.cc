@@ -132,11 +132,17 @@ TEST(TypeUtils, PaddingTest) {
     EXPECT_EQ(r.height(), 243);
     EXPECT_EQ(r.width(), 243);
     EXPECT_EQ(r.channels(), 3);
+
+    // The padded rows are adopted as they are.
+    EXPECT_FALSE(r.is_packed());
+    EXPECT_EQ(r.row_stride(), 732);
+    EXPECT_EQ(r.size(), 177876);
+    r.Pack();
     EXPECT_EQ(r.size(), 177147);
   }
 }
 
-TEST(TypeUtils, YuvFailTest) {
+TEST(TypeUtils, YuvTest) {
   ProducerConsumerQueue<GstreamerBuffer> pcqueue(1);
 
   {
@@ -166,12 +172,19 @@ TEST(TypeUtils, YuvFailTest) {
     GstreamerBuffer gstreamer_buffer;
     EXPECT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
     auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
-    EXPECT_FALSE(raw_image_statusor.ok());
-    LOG(ERROR) << raw_image_statusor.status();
+    EXPECT_TRUE(raw_image_statusor.ok());
+    RawImage r = std::move(raw_image_statusor).ValueOrDie();
+    EXPECT_EQ(r.format(), RAW_IMAGE_FORMAT_I420);
+    EXPECT_EQ(r.height(), 243);
+    EXPECT_EQ(r.width(), 243);
+    ASSERT_EQ(r.planes().size(), 3);
+    EXPECT_GE(r.planes()[0].stride, 243);
+    EXPECT_GE(r.planes()[1].stride, 122);
+    EXPECT_GT(r.planes()[2].offset, r.planes()[1].offset);
   }
 }
 
-TEST(TypeUtils, RgbaFailTest) {
+TEST(TypeUtils, RgbaTest) {
   ProducerConsumerQueue<GstreamerBuffer> pcqueue(1);
 
   {
@@ -201,8 +214,47 @@ TEST(TypeUtils, RgbaFailTest) {
     GstreamerBuffer gstreamer_buffer;
     EXPECT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
     auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
-    EXPECT_FALSE(raw_image_statusor.ok());
-    LOG(ERROR) << raw_image_statusor.status();
+    EXPECT_TRUE(raw_image_statusor.ok());
+    RawImage r = std::move(raw_image_statusor).ValueOrDie();
+    EXPECT_EQ(r.format(), RAW_IMAGE_FORMAT_RGBA);
+    EXPECT_EQ(r.channels(), 4);
+    EXPECT_TRUE(r.is_packed());
+    EXPECT_EQ(r.size(), 243 * 243 * 4);
+  }
+}
+
+TEST(TypeUtils, UnsupportedFormatFailTest) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(
+      "video/x-raw,format=YUY2,width=4,height=2");
+  gstreamer_buffer.assign(std::string(16, 0));
+  auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+  EXPECT_FALSE(raw_image_statusor.ok());
+  LOG(ERROR) << raw_image_statusor.status();
+}
+
+TEST(TypeUtils, PlanarRawImagePacketToGstreamerBuffer) {
+  // A packed I420 image of odd size differs from Gstreamer's default layout,
+  // which rounds strides up to 4 bytes.
+  RawImage r_src(5, 7, RAW_IMAGE_FORMAT_I420);
+  for (size_t i = 0; i < r_src.size(); ++i) {
+    r_src(i) = i;
+  }
+  auto gstreamer_buffer_statusor =
+      ToGstreamerBuffer(MakePacket(r_src).ValueOrDie());
+  EXPECT_TRUE(gstreamer_buffer_statusor.ok());
+  auto gstreamer_buffer = std::move(gstreamer_buffer_statusor).ValueOrDie();
+  EXPECT_NE(gstreamer_buffer.get_caps().find("I420"), std::string::npos);
+  EXPECT_EQ(gstreamer_buffer.get_video_planes().size(), 3);
+
+  auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+  EXPECT_TRUE(raw_image_statusor.ok());
+  RawImage r_dst = std::move(raw_image_statusor).ValueOrDie();
+  EXPECT_EQ(r_dst.format(), RAW_IMAGE_FORMAT_I420);
+  EXPECT_TRUE(r_dst.is_packed());
+  ASSERT_EQ(r_dst.size(), r_src.size());
+  for (size_t i = 0; i < r_dst.size(); ++i) {
+    EXPECT_EQ(r_dst(i), r_src(i));
   }
 }
 
@@ -332,7 +384,7 @@ TEST(TypeUtils, PaddingRgbRawImagePacketToGstreamerBuffer) {
     EXPECT_EQ(r_src.height(), 243);
     EXPECT_EQ(r_src.width(), 243);
     EXPECT_EQ(r_src.channels(), 3);
-    EXPECT_EQ(r_src.size(), 177147);
+    EXPECT_EQ(r_src.row_stride(), 732);
 
     auto packet = MakePacket(r_src).ValueOrDie();
     auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
@@ -347,7 +399,61 @@ TEST(TypeUtils, PaddingRgbRawImagePacketToGstreamerBuffer) {
     EXPECT_EQ(r_dst.height(), r_src.height());
     EXPECT_EQ(r_dst.width(), r_src.width());
     EXPECT_EQ(r_dst.channels(), r_src.channels());
+    EXPECT_EQ(r_dst.row_stride(), r_src.row_stride());
     EXPECT_EQ(r_dst.size(), r_src.size());
+
+    // A packed image with odd width passes through with a GstVideoMeta.
+    r_src.Pack();
+    packet = MakePacket(r_src).ValueOrDie();
+    gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
+    EXPECT_TRUE(gstreamer_buffer_statusor.ok());
+    gstreamer_buffer_dst = std::move(gstreamer_buffer_statusor).ValueOrDie();
+    EXPECT_EQ(gstreamer_buffer_dst.size(), 177147);
+    ASSERT_EQ(gstreamer_buffer_dst.get_video_planes().size(), 1);
+    EXPECT_EQ(gstreamer_buffer_dst.get_video_planes()[0].stride, 729);
+    raw_image_statusor = ToRawImage(std::move(gstreamer_buffer_dst));
+    EXPECT_TRUE(raw_image_statusor.ok());
+    r_dst = std::move(raw_image_statusor).ValueOrDie();
+    EXPECT_TRUE(r_dst.is_packed());
+  }
+}
+
+TEST(TypeUtils, PaddedRawImageThroughRunner) {
+  // A packed, odd width image is fed with a GstVideoMeta and must come out of
+  // a pipeline that converts it to the default layout intact.
+  RawImage src(5, 7, RAW_IMAGE_FORMAT_SRGB);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src(i) = i % 251;
+  }
+  GstreamerBuffer gstreamer_buffer =
+      ToGstreamerBuffer(MakePacket(src).ValueOrDie()).ValueOrDie();
+
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(1);
+  {
+    GstreamerRunnerOptions options;
+    options.processing_pipeline_string = "videoconvert";
+    options.appsrc_caps_string = gstreamer_buffer.get_caps();
+
+    GstreamerRunner runner(options);
+    Status status = runner.SetReceiver(
+        [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+          pcqueue.TryEmplace(std::move(gstreamer_buffer));
+          return OkStatus();
+        });
+    EXPECT_TRUE(runner.Start().ok());
+    EXPECT_TRUE(runner.Feed(gstreamer_buffer).ok());
+    EXPECT_TRUE(runner.End().ok());
+  }
+
+  GstreamerBuffer output;
+  EXPECT_TRUE(pcqueue.TryPop(output, absl::Seconds(1)));
+  auto raw_image_statusor = ToRawImage(std::move(output));
+  EXPECT_TRUE(raw_image_statusor.ok());
+  RawImage dst = std::move(raw_image_statusor).ValueOrDie();
+  dst.Pack();
+  ASSERT_EQ(dst.size(), src.size());
+  for (size_t i = 0; i < dst.size(); ++i) {
+    EXPECT_EQ(dst(i), src(i));
   }
 }
 
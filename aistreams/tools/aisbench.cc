@@ -0,0 +1,487 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A load generator for the packet transport.
+//
+// It runs senders and receivers of synthetic packets against a stream server
+// and reports the one-way latency, throughput, drops and CPU cost per packet.
+// Leave --target_address empty to run against an in-memory server in this
+// process; e.g. to compare transport options offline:
+//
+//   aisbench --num_senders=4 --payload_bytes=65536 --rate=30
+//   aisbench --unary_send --unary_receive
+//   aisbench --compression=gzip --compressible_payload
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/base/testing/in_memory_stream_server.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/util/packet_sequence_tracker.h"
+#include "aistreams/base/util/packet_utils.h"
+#include "aistreams/base/wrappers/receivers.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/latency_histogram.h"
+
+ABSL_FLAG(std::string, target_address, "",
+          "Address (ip:port) to the AI Streams instance. Leave empty to start "
+          "an in-memory server in this process.");
+ABSL_FLAG(bool, authenticate_with_google, false,
+          "Set to true for the managed service; otherwise false.");
+ABSL_FLAG(std::string, stream_name, "aisbench",
+          "Name of the stream to send to and receive from.");
+ABSL_FLAG(bool, use_insecure_channel, true, "Use an insecure channel.");
+ABSL_FLAG(std::string, ssl_domain_name, "aistreams.googleapis.com",
+          "The expected ssl domain name of the service.");
+ABSL_FLAG(std::string, ssl_root_cert_path, "",
+          "The path to the ssl root certificate.");
+ABSL_FLAG(std::string, local_ssl_cert_path, "",
+          "The certificate chain the in-memory server serves TLS with.");
+ABSL_FLAG(std::string, local_ssl_key_path, "",
+          "The private key the in-memory server serves TLS with.");
+ABSL_FLAG(std::string, compression, "",
+          "Compress sent messages with gzip or deflate; empty for none.");
+ABSL_FLAG(int, num_senders, 1, "The number of concurrent senders.");
+ABSL_FLAG(int, num_receivers, 1,
+          "The number of concurrent receivers. Each receives every packet.");
+ABSL_FLAG(std::string, receiver_type, "receiver",
+          "How packets are received: \"receiver\" calls PacketReceiver "
+          "directly, \"queue\" pops from MakePacketReceiverQueue.");
+ABSL_FLAG(std::string, packet_type, "string",
+          "The payload type: string, jpeg, raw_image or gstreamer_buffer.");
+ABSL_FLAG(int, payload_bytes, 16384, "The approximate payload size.");
+ABSL_FLAG(bool, compressible_payload, false,
+          "Fill payloads with zeros instead of random bytes.");
+ABSL_FLAG(double, rate, 30,
+          "Packets per second per sender. Use 0 to send as fast as possible.");
+ABSL_FLAG(absl::Duration, duration, absl::Seconds(10),
+          "How long the senders run.");
+ABSL_FLAG(absl::Duration, drain_timeout, absl::Seconds(5),
+          "How long to wait for receivers to catch up after sending stops.");
+ABSL_FLAG(bool, unary_send, false, "Use unary rpc to send packets.");
+ABSL_FLAG(bool, unary_receive, false, "Use unary rpc to receive packets.");
+ABSL_FLAG(bool, credit_flow_control, false,
+          "Receive with credit based flow control.");
+ABSL_FLAG(int, receiver_buffer_capacity, 0,
+          "The capacity of each receiver queue. Non-positive values resolve "
+          "to the default.");
+
+namespace aistreams {
+
+namespace {
+
+// Receivers are connected this long before sending starts, so that the
+// first packets are not missed.
+constexpr absl::Duration kReceiverSettleTime = absl::Milliseconds(500);
+
+// How long a receiver waits for a packet before checking if it should stop.
+constexpr absl::Duration kReceivePollTimeout = absl::Milliseconds(100);
+
+constexpr char kEosReason[] = "aisbench done";
+
+absl::Time PacketTime(const PacketHeader& header) {
+  return absl::FromUnixSeconds(header.timestamp().seconds()) +
+         absl::Nanoseconds(header.timestamp().nanos());
+}
+
+absl::Duration CpuTime() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return absl::DurationFromTimeval(usage.ru_utime) +
+         absl::DurationFromTimeval(usage.ru_stime);
+}
+
+std::string MakePayloadBytes(int size) {
+  std::string bytes(std::max(0, size), '\0');
+  if (!absl::GetFlag(FLAGS_compressible_payload)) {
+    std::mt19937 gen(size);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (char& c : bytes) {
+      c = static_cast<char>(dist(gen));
+    }
+  }
+  return bytes;
+}
+
+StatusOr<Packet> MakeTemplatePacket(const std::string& packet_type,
+                                    int payload_bytes) {
+  if (packet_type == "string") {
+    return MakePacket(MakePayloadBytes(payload_bytes));
+  } else if (packet_type == "jpeg") {
+    return MakePacket(JpegFrame(MakePayloadBytes(payload_bytes)));
+  } else if (packet_type == "gstreamer_buffer") {
+    GstreamerBuffer gstreamer_buffer;
+    gstreamer_buffer.set_caps_string("video/x-h264");
+    gstreamer_buffer.assign(MakePayloadBytes(payload_bytes));
+    return MakePacket(std::move(gstreamer_buffer));
+  } else if (packet_type == "raw_image") {
+    int side = std::max(1, static_cast<int>(std::sqrt(payload_bytes / 3)));
+    RawImage raw_image(side, side, RAW_IMAGE_FORMAT_SRGB);
+    std::string bytes = MakePayloadBytes(raw_image.size());
+    std::copy(bytes.begin(), bytes.end(), raw_image.data());
+    return MakePacket(std::move(raw_image));
+  }
+  return InvalidArgumentError(
+      absl::StrFormat("Unknown packet type \"%s\"", packet_type));
+}
+
+ConnectionOptions GetConnectionOptions(const std::string& target_address) {
+  ConnectionOptions options;
+  options.target_address = target_address;
+  options.authenticate_with_google =
+      absl::GetFlag(FLAGS_authenticate_with_google);
+  options.ssl_options.use_insecure_channel =
+      absl::GetFlag(FLAGS_use_insecure_channel);
+  options.ssl_options.ssl_domain_name = absl::GetFlag(FLAGS_ssl_domain_name);
+  options.ssl_options.ssl_root_cert_path =
+      absl::GetFlag(FLAGS_ssl_root_cert_path);
+  options.rpc_options.compression_algorithm = absl::GetFlag(FLAGS_compression);
+  return options;
+}
+
+// What the senders and receivers observed, shared across their threads.
+struct BenchStats {
+  std::atomic<int64_t> packets_sent{0};
+  std::atomic<int64_t> bytes_sent{0};
+  std::atomic<int64_t> send_errors{0};
+
+  std::atomic<int64_t> packets_received{0};
+  std::atomic<int64_t> bytes_received{0};
+  std::atomic<int> receivers_done{0};
+
+  // The time from when a sender wrote a packet to when a receiver got it off
+  // the wire.
+  LatencyHistogram transport_latency;
+
+  // The time from when a packet was created to when it was consumed. For
+  // queue consumers, this includes the time spent in the queue.
+  LatencyHistogram end_to_end_latency;
+
+  absl::Mutex mu;
+  PacketSequenceStats sequence_stats ABSL_GUARDED_BY(mu);
+};
+
+void RunSender(const PacketSender::Options& options, const Packet& packet,
+               absl::Time start, absl::Time end, BenchStats* stats) {
+  auto sender_status_or = PacketSender::Create(options);
+  if (!sender_status_or.ok()) {
+    LOG(ERROR) << sender_status_or.status();
+    stats->send_errors++;
+    return;
+  }
+  auto sender = std::move(sender_status_or).ValueOrDie();
+
+  double rate = absl::GetFlag(FLAGS_rate);
+  absl::Duration interval =
+      rate > 0 ? absl::Seconds(1) / rate : absl::ZeroDuration();
+  absl::Time next_send = start;
+  while (absl::Now() < end) {
+    if (interval > absl::ZeroDuration()) {
+      absl::SleepFor(next_send - absl::Now());
+      next_send += interval;
+    }
+    Packet p = packet;
+    timespec ts = absl::ToTimespec(absl::Now());
+    p.mutable_header()->mutable_timestamp()->set_seconds(ts.tv_sec);
+    p.mutable_header()->mutable_timestamp()->set_nanos(ts.tv_nsec);
+    Status status = sender->Send(std::move(p));
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      stats->send_errors++;
+      continue;
+    }
+    stats->packets_sent++;
+    stats->bytes_sent += packet.payload().size();
+  }
+
+  auto eos_status_or = MakeEosPacket(kEosReason);
+  if (eos_status_or.ok()) {
+    sender->Send(std::move(eos_status_or).ValueOrDie()).IgnoreError();
+  }
+}
+
+// Accounts for one packet; returns true when the packet was EOS.
+bool ConsumePacket(const Packet& packet, PacketSequenceTracker* tracker,
+                   BenchStats* stats) {
+  if (IsEos(packet)) {
+    return true;
+  }
+  const PacketStageTimes& stage_times = packet.header().stage_times();
+  if (stage_times.send_nanos() > 0 && stage_times.receive_nanos() > 0) {
+    stats->transport_latency.Record(absl::Nanoseconds(
+        stage_times.receive_nanos() - stage_times.send_nanos()));
+  }
+  stats->end_to_end_latency.Record(absl::Now() -
+                                   PacketTime(packet.header()));
+  tracker->Record(packet.header());
+  stats->packets_received++;
+  stats->bytes_received += packet.payload().size();
+  return false;
+}
+
+void RunReceiver(const ReceiverOptions& options,
+                 absl::BlockingCounter* connected,
+                 const std::atomic<bool>* stop, BenchStats* stats) {
+  int num_senders = absl::GetFlag(FLAGS_num_senders);
+  int eos_count = 0;
+  PacketSequenceTracker tracker;
+
+  if (absl::GetFlag(FLAGS_receiver_type) == "queue") {
+    ReceiverQueue<Packet> receiver_queue;
+    Status status = MakePacketReceiverQueue(options, &receiver_queue);
+    connected->DecrementCount();
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    } else {
+      Packet packet;
+      while (eos_count < num_senders && !*stop) {
+        if (receiver_queue.TryPop(packet, kReceivePollTimeout)) {
+          eos_count += ConsumePacket(packet, &tracker, stats);
+        }
+      }
+    }
+  } else {
+    PacketReceiver::Options receiver_options;
+    receiver_options.connection_options = options.connection_options;
+    receiver_options.stream_name = options.stream_name;
+    receiver_options.start_position = options.start_position;
+    receiver_options.enable_unary_rpc = absl::GetFlag(FLAGS_unary_receive);
+    receiver_options.unary_rpc_max_wait = kReceivePollTimeout;
+    receiver_options.enable_credit_flow_control =
+        options.enable_credit_flow_control;
+    auto receiver_status_or = PacketReceiver::Create(receiver_options);
+    connected->DecrementCount();
+    if (!receiver_status_or.ok()) {
+      LOG(ERROR) << receiver_status_or.status();
+    } else {
+      auto receiver = std::move(receiver_status_or).ValueOrDie();
+      Packet packet;
+      while (eos_count < num_senders && !*stop) {
+        Status status = receiver->Receive(&packet);
+        if (IsNotFound(status)) {
+          continue;
+        }
+        if (!status.ok()) {
+          LOG(ERROR) << status;
+          break;
+        }
+        eos_count += ConsumePacket(packet, &tracker, stats);
+      }
+    }
+  }
+
+  PacketSequenceStats sequence_stats = tracker.GetStats();
+  absl::MutexLock lock(&stats->mu);
+  stats->sequence_stats.received += sequence_stats.received;
+  stats->sequence_stats.missing += sequence_stats.missing;
+  stats->sequence_stats.duplicate += sequence_stats.duplicate;
+  stats->sequence_stats.reordered += sequence_stats.reordered;
+  stats->receivers_done++;
+}
+
+std::string FormatLatency(const LatencyHistogram& histogram) {
+  if (histogram.count() == 0) {
+    return "n/a";
+  }
+  return absl::StrFormat(
+      "p50 %s  p99 %s  p999 %s  max %s",
+      absl::FormatDuration(histogram.Percentile(0.5)),
+      absl::FormatDuration(histogram.Percentile(0.99)),
+      absl::FormatDuration(histogram.Percentile(0.999)),
+      absl::FormatDuration(histogram.max()));
+}
+
+void PrintReport(BenchStats* stats, absl::Duration elapsed,
+                 absl::Duration cpu_time) {
+  int num_receivers = absl::GetFlag(FLAGS_num_receivers);
+  double seconds = std::max(absl::ToDoubleSeconds(elapsed), 1e-9);
+  int64_t sent = stats->packets_sent;
+  int64_t received = stats->packets_received;
+  int64_t expected = sent * num_receivers;
+  PacketSequenceStats sequence_stats;
+  {
+    absl::MutexLock lock(&stats->mu);
+    sequence_stats = stats->sequence_stats;
+  }
+  int64_t dropped = std::max<int64_t>(0, expected - sequence_stats.received);
+
+  std::cout << absl::StrFormat(
+      "sent:       %d packets, %.1f packets/s, %.2f MB/s, %d errors\n", sent,
+      sent / seconds, stats->bytes_sent / seconds / 1e6,
+      stats->send_errors.load());
+  std::cout << absl::StrFormat(
+      "received:   %d packets, %.1f packets/s, %.2f MB/s (all receivers)\n",
+      received, received / seconds, stats->bytes_received / seconds / 1e6);
+  std::cout << absl::StrFormat(
+      "drops:      %d of %d (%.3f%%), %d duplicate, %d reordered\n", dropped,
+      expected, expected > 0 ? 100.0 * dropped / expected : 0.0,
+      sequence_stats.duplicate, sequence_stats.reordered);
+  std::cout << "transport:  " << FormatLatency(stats->transport_latency)
+            << " (send to receive)\n";
+  std::cout << "end-to-end: " << FormatLatency(stats->end_to_end_latency)
+            << " (create to consume)\n";
+  std::cout << absl::StrFormat(
+      "cpu:        %s, %s per packet sent, %s per packet received\n",
+      absl::FormatDuration(cpu_time),
+      absl::FormatDuration(sent > 0 ? cpu_time / sent : absl::ZeroDuration()),
+      absl::FormatDuration(received > 0 ? cpu_time / received
+                                        : absl::ZeroDuration()));
+}
+
+}  // namespace
+
+int RunBench() {
+  // Start an in-memory server unless one is given.
+  std::string target_address = absl::GetFlag(FLAGS_target_address);
+  std::unique_ptr<InMemoryStreamServer> local_server;
+  if (target_address.empty()) {
+    InMemoryStreamServer::Options server_options;
+    server_options.ssl_cert_path = absl::GetFlag(FLAGS_local_ssl_cert_path);
+    server_options.ssl_key_path = absl::GetFlag(FLAGS_local_ssl_key_path);
+    auto server_status_or = InMemoryStreamServer::Create(server_options);
+    if (!server_status_or.ok()) {
+      LOG(ERROR) << server_status_or.status();
+      return EXIT_FAILURE;
+    }
+    local_server = std::move(server_status_or).ValueOrDie();
+    target_address = local_server->address();
+    LOG(INFO) << "Started an in-memory server at " << target_address;
+  }
+
+  auto packet_status_or = MakeTemplatePacket(
+      absl::GetFlag(FLAGS_packet_type), absl::GetFlag(FLAGS_payload_bytes));
+  if (!packet_status_or.ok()) {
+    LOG(ERROR) << packet_status_or.status();
+    return EXIT_FAILURE;
+  }
+  Packet packet = std::move(packet_status_or).ValueOrDie();
+
+  ConnectionOptions connection_options = GetConnectionOptions(target_address);
+  int num_senders = std::max(1, absl::GetFlag(FLAGS_num_senders));
+  int num_receivers = std::max(0, absl::GetFlag(FLAGS_num_receivers));
+  BenchStats stats;
+  std::atomic<bool> stop{false};
+
+  // Connect the receivers first.
+  ReceiverOptions receiver_options;
+  receiver_options.connection_options = connection_options;
+  receiver_options.stream_name = absl::GetFlag(FLAGS_stream_name);
+  receiver_options.buffer_capacity =
+      absl::GetFlag(FLAGS_receiver_buffer_capacity);
+  receiver_options.start_position = START_POSITION_LATEST;
+  receiver_options.enable_credit_flow_control =
+      absl::GetFlag(FLAGS_credit_flow_control);
+  absl::BlockingCounter connected(num_receivers);
+  std::vector<std::thread> receivers;
+  for (int i = 0; i < num_receivers; ++i) {
+    receivers.emplace_back(RunReceiver, receiver_options, &connected, &stop,
+                           &stats);
+  }
+  connected.Wait();
+  absl::SleepFor(kReceiverSettleTime);
+
+  // Run the senders.
+  PacketSender::Options sender_options;
+  sender_options.connection_options = connection_options;
+  sender_options.stream_name = absl::GetFlag(FLAGS_stream_name);
+  sender_options.enable_unary_rpc = absl::GetFlag(FLAGS_unary_send);
+  absl::Duration cpu_start = CpuTime();
+  absl::Time start = absl::Now();
+  absl::Time end = start + absl::GetFlag(FLAGS_duration);
+  std::vector<std::thread> senders;
+  for (int i = 0; i < num_senders; ++i) {
+    senders.emplace_back(RunSender, sender_options, std::cref(packet), start,
+                         end, &stats);
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+
+  // Give the receivers a chance to drain.
+  absl::Time drain_deadline = absl::Now() + absl::GetFlag(FLAGS_drain_timeout);
+  while (stats.receivers_done < num_receivers &&
+         absl::Now() < drain_deadline) {
+    absl::SleepFor(kReceivePollTimeout);
+  }
+  stop = true;
+  absl::Duration elapsed = absl::Now() - start;
+  absl::Duration cpu_time = CpuTime() - cpu_start;
+
+  std::cout << absl::StrFormat(
+      "%d sender(s) -> %d %s(s) at %s; %s payload of %d bytes at %g/s per "
+      "sender; %s send, %s receive%s, %s, compression %s\n",
+      num_senders, num_receivers, absl::GetFlag(FLAGS_receiver_type),
+      local_server != nullptr ? "an in-memory server" : target_address,
+      absl::GetFlag(FLAGS_packet_type), packet.payload().size(),
+      absl::GetFlag(FLAGS_rate),
+      absl::GetFlag(FLAGS_unary_send) ? "unary" : "streaming",
+      absl::GetFlag(FLAGS_unary_receive) ? "unary" : "streaming",
+      absl::GetFlag(FLAGS_credit_flow_control) ? " with credits" : "",
+      connection_options.ssl_options.use_insecure_channel ? "insecure" : "TLS",
+      absl::GetFlag(FLAGS_compression).empty()
+          ? "none"
+          : absl::GetFlag(FLAGS_compression));
+  PrintReport(&stats, elapsed, cpu_time);
+  if (local_server != nullptr) {
+    std::cout << "note:       cpu includes the in-memory server\n";
+  }
+  std::cout.flush();
+
+  // Stopping the local server ends blocked receives. Receivers of a remote
+  // server that never saw every EOS may still be blocked on the wire.
+  local_server.reset();
+  if (stats.receivers_done < num_receivers) {
+    absl::SleepFor(kReceivePollTimeout);
+  }
+  if (stats.receivers_done < num_receivers) {
+    LOG(WARNING) << "Some receivers did not finish; exiting without them";
+    std::quick_exit(EXIT_SUCCESS);
+  }
+  for (auto& receiver : receivers) {
+    receiver.join();
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace aistreams
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  return aistreams::RunBench();
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_UTIL_ALLOC_COUNTER_H_
+#define AISTREAMS_UTIL_ALLOC_COUNTER_H_
+
+#include <cstdint>
+
+namespace aistreams {
+
+// Counts the heap allocations made through the global operator new.
+//
+// Linking this library replaces the global operator new/delete of the binary
+// with counting versions; it is meant for benchmarks and tests only.
+//
+// Example:
+//
+//   AllocationCounter allocs;
+//   for (auto _ : state) { ... }
+//   state.counters["allocs_per_op"] = benchmark::Counter(
+//       allocs.allocations(), benchmark::Counter::kAvgIterations);
+class AllocationCounter {
+ public:
+  // Starts counting from the current totals.
+  AllocationCounter();
+
+  // The number of allocations since construction (or Reset()).
+  int64_t allocations() const;
+
+  // The number of bytes allocated since construction (or Reset()).
+  int64_t bytes() const;
+
+  // Restart counting from the current totals.
+  void Reset();
+
+ private:
+  int64_t start_allocations_;
+  int64_t start_bytes_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_UTIL_ALLOC_COUNTER_H_
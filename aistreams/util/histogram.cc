@@ -0,0 +1,129 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aistreams {
+
+constexpr int Histogram::kSubBuckets;
+constexpr int Histogram::kMaxExponent;
+constexpr int Histogram::kNumBuckets;
+
+Histogram::Histogram() { Reset(); }
+
+// Values below kSubBuckets get a bucket each. Above that, a value with
+// highest set bit e goes to one of the kSubBuckets buckets that split
+// [2^e, 2^(e+1)), selected by the two bits following the highest one.
+int Histogram::BucketIndex(int64_t value) {
+  if (value < kSubBuckets) {
+    return static_cast<int>(std::max<int64_t>(value, 0));
+  }
+  int e = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+  int sub = static_cast<int>((value >> (e - 2)) & (kSubBuckets - 1));
+  int index = kSubBuckets * (e - 1) + sub;
+  return std::min(index, kNumBuckets - 1);
+}
+
+int64_t Histogram::BucketLower(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int e = index / kSubBuckets + 1;
+  int sub = index % kSubBuckets;
+  return static_cast<int64_t>(kSubBuckets + sub) << (e - 2);
+}
+
+int64_t Histogram::BucketUpper(int index) {
+  if (index + 1 >= kNumBuckets) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return BucketLower(index + 1);
+}
+
+void Histogram::Record(int64_t value) {
+  value = std::max<int64_t>(0, value);
+  counts_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  int64_t prev_max = max_.load(std::memory_order_relaxed);
+  while (value > prev_max && !max_.compare_exchange_weak(
+                                 prev_max, value, std::memory_order_relaxed)) {
+  }
+}
+
+int64_t Histogram::count() const {
+  return count_.load(std::memory_order_relaxed);
+}
+
+int64_t Histogram::sum() const { return sum_.load(std::memory_order_relaxed); }
+
+int64_t Histogram::max() const { return max_.load(std::memory_order_relaxed); }
+
+double Histogram::Mean() const {
+  int64_t n = count();
+  if (n == 0) {
+    return 0;
+  }
+  return static_cast<double>(sum()) / n;
+}
+
+int64_t Histogram::Percentile(double q) const {
+  q = std::min(1.0, std::max(0.0, q));
+  int64_t total = 0;
+  std::array<int64_t, kNumBuckets> counts;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  int64_t rank = std::max<int64_t>(1, std::ceil(q * total));
+  int64_t seen = 0;
+  int64_t max_value = max();
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(BucketUpper(i), max_value);
+    }
+  }
+  return max_value;
+}
+
+std::vector<Histogram::Bucket> Histogram::Buckets() const {
+  std::vector<Bucket> buckets;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    int64_t n = counts_[i].load(std::memory_order_relaxed);
+    if (n == 0) {
+      continue;
+    }
+    buckets.push_back({BucketLower(i), BucketUpper(i), n});
+  }
+  return buckets;
+}
+
+void Histogram::Reset() {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace aistreams
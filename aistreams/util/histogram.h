@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_UTIL_HISTOGRAM_H_
+#define AISTREAMS_UTIL_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace aistreams {
+
+// A histogram of non-negative integers with logarithmically spaced buckets.
+//
+// Each power of two is split into 4 buckets, so values are resolved to within
+// 25% across the whole range. Recording is a few relaxed atomic increments and
+// never blocks.
+//
+// This class is thread-safe.
+class Histogram {
+ public:
+  // One bucket of the histogram. It counts values in [lower, upper).
+  struct Bucket {
+    int64_t lower;
+    int64_t upper;
+    int64_t count;
+  };
+
+  Histogram();
+
+  // Record one value. Negative values are recorded as zero.
+  void Record(int64_t value);
+
+  // The number of recorded values.
+  int64_t count() const;
+
+  // The sum of the recorded values.
+  int64_t sum() const;
+
+  // The largest recorded value.
+  int64_t max() const;
+
+  // The mean of the recorded values; zero if there are none.
+  double Mean() const;
+
+  // An upper bound of the `q`-quantile for q in [0, 1]; zero if empty.
+  //
+  // This is the upper edge of the bucket holding the quantile, clamped to the
+  // largest recorded value.
+  int64_t Percentile(double q) const;
+
+  // The non-empty buckets in increasing order.
+  std::vector<Bucket> Buckets() const;
+
+  // Discard all recorded values.
+  void Reset();
+
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+ private:
+  static constexpr int kSubBuckets = 4;
+  static constexpr int kMaxExponent = 62;
+  static constexpr int kNumBuckets = kSubBuckets * kMaxExponent;
+
+  static int BucketIndex(int64_t value);
+  static int64_t BucketLower(int index);
+  static int64_t BucketUpper(int index);
+
+  std::array<std::atomic<int64_t>, kNumBuckets> counts_;
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_UTIL_HISTOGRAM_H_
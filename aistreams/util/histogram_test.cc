@@ -0,0 +1,52 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/histogram.h"
+
+#include <limits>
+
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+TEST(HistogramTest, SmallValuesAreExactTest) {
+  Histogram histogram;
+  for (int i = 0; i < 4; ++i) {
+    histogram.Record(i);
+  }
+  auto buckets = histogram.Buckets();
+  ASSERT_EQ(buckets.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(buckets[i].lower, i);
+    EXPECT_EQ(buckets[i].upper, i + 1);
+    EXPECT_EQ(buckets[i].count, 1);
+  }
+  EXPECT_EQ(histogram.sum(), 6);
+  EXPECT_DOUBLE_EQ(histogram.Mean(), 1.5);
+}
+
+TEST(HistogramTest, LargeValuesTest) {
+  Histogram histogram;
+  histogram.Record(int64_t{1} << 40);
+  histogram.Record(std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(histogram.count(), 2);
+  EXPECT_EQ(histogram.max(), std::numeric_limits<int64_t>::max());
+  auto buckets = histogram.Buckets();
+  ASSERT_EQ(buckets.size(), 2);
+  EXPECT_EQ(buckets[0].lower, int64_t{1} << 40);
+  EXPECT_EQ(buckets[1].upper, std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(histogram.Percentile(0.5), buckets[0].upper);
+}
+
+}  // namespace aistreams
@@ -0,0 +1,52 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/latency_histogram.h"
+
+#include <limits>
+
+namespace aistreams {
+
+void LatencyHistogram::Record(absl::Duration latency) {
+  histogram_.Record(absl::ToInt64Microseconds(latency));
+}
+
+absl::Duration LatencyHistogram::sum() const {
+  return absl::Microseconds(histogram_.sum());
+}
+
+absl::Duration LatencyHistogram::max() const {
+  return absl::Microseconds(histogram_.max());
+}
+
+absl::Duration LatencyHistogram::Mean() const {
+  return absl::Microseconds(histogram_.Mean());
+}
+
+absl::Duration LatencyHistogram::Percentile(double q) const {
+  return absl::Microseconds(histogram_.Percentile(q));
+}
+
+std::vector<LatencyHistogram::Bucket> LatencyHistogram::Buckets() const {
+  std::vector<Bucket> buckets;
+  for (const auto& bucket : histogram_.Buckets()) {
+    absl::Duration upper = bucket.upper == std::numeric_limits<int64_t>::max()
+                               ? absl::InfiniteDuration()
+                               : absl::Microseconds(bucket.upper);
+    buckets.push_back({absl::Microseconds(bucket.lower), upper, bucket.count});
+  }
+  return buckets;
+}
+
+}  // namespace aistreams
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_UTIL_LATENCY_HISTOGRAM_H_
+#define AISTREAMS_UTIL_LATENCY_HISTOGRAM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "aistreams/util/histogram.h"
+
+namespace aistreams {
+
+// A histogram of latencies with logarithmically spaced buckets.
+//
+// This is a Histogram of microseconds, so values are resolved to within 25%
+// from 1us upwards. Recording is a few relaxed atomic increments and never
+// blocks.
+//
+// This class is thread-safe.
+class LatencyHistogram {
+ public:
+  // One bucket of the histogram. It counts values in [lower, upper).
+  struct Bucket {
+    absl::Duration lower;
+    absl::Duration upper;
+    int64_t count;
+  };
+
+  LatencyHistogram() = default;
+
+  // Record one latency. Negative values are recorded as zero.
+  void Record(absl::Duration latency);
+
+  // The number of recorded values.
+  int64_t count() const { return histogram_.count(); }
+
+  // The sum of the recorded values.
+  absl::Duration sum() const;
+
+  // The largest recorded value.
+  absl::Duration max() const;
+
+  // The mean of the recorded values; zero if there are none.
+  absl::Duration Mean() const;
+
+  // An upper bound of the `q`-quantile for q in [0, 1]; zero if empty.
+  //
+  // This is the upper edge of the bucket holding the quantile, clamped to the
+  // largest recorded value.
+  absl::Duration Percentile(double q) const;
+
+  // The non-empty buckets in increasing order.
+  std::vector<Bucket> Buckets() const;
+
+  // Discard all recorded values.
+  void Reset() { histogram_.Reset(); }
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+ private:
+  Histogram histogram_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_UTIL_LATENCY_HISTOGRAM_H_
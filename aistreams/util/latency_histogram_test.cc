@@ -0,0 +1,87 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/latency_histogram.h"
+
+#include <thread>
+#include <vector>
+
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+TEST(LatencyHistogramTest, EmptyTest) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.Mean(), absl::ZeroDuration());
+  EXPECT_EQ(histogram.Percentile(0.5), absl::ZeroDuration());
+  EXPECT_TRUE(histogram.Buckets().empty());
+}
+
+TEST(LatencyHistogramTest, PercentileTest) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.Record(absl::Milliseconds(i));
+  }
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.max(), absl::Milliseconds(1000));
+  EXPECT_EQ(histogram.Mean(), absl::Microseconds(500500));
+
+  // Quantiles are upper bounds within a quarter of the true value.
+  absl::Duration p50 = histogram.Percentile(0.5);
+  EXPECT_GE(p50, absl::Milliseconds(500));
+  EXPECT_LE(p50, absl::Milliseconds(625));
+  absl::Duration p99 = histogram.Percentile(0.99);
+  EXPECT_GE(p99, absl::Milliseconds(990));
+  EXPECT_LE(p99, absl::Milliseconds(1000));
+  EXPECT_EQ(histogram.Percentile(1.0), absl::Milliseconds(1000));
+}
+
+TEST(LatencyHistogramTest, BucketsTest) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::Microseconds(-5));
+  histogram.Record(absl::Microseconds(2));
+  histogram.Record(absl::Microseconds(100));
+  histogram.Record(absl::Microseconds(100));
+  auto buckets = histogram.Buckets();
+  ASSERT_EQ(buckets.size(), 3);
+  EXPECT_EQ(buckets[0].lower, absl::ZeroDuration());
+  EXPECT_EQ(buckets[0].count, 1);
+  EXPECT_EQ(buckets[1].lower, absl::Microseconds(2));
+  EXPECT_EQ(buckets[2].count, 2);
+  EXPECT_LE(buckets[2].lower, absl::Microseconds(100));
+  EXPECT_GT(buckets[2].upper, absl::Microseconds(100));
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.count(), 0);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordTest) {
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&histogram]() {
+      for (int i = 0; i < 10000; ++i) {
+        histogram.Record(absl::Microseconds(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(histogram.count(), 40000);
+  EXPECT_EQ(histogram.max(), absl::Microseconds(9999));
+}
+
+}  // namespace aistreams
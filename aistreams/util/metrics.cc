@@ -0,0 +1,264 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/metrics.h"
+
+#include <limits>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "aistreams/port/logging.h"
+
+namespace aistreams {
+
+namespace {
+
+std::string EscapeLabelValue(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    switch (c) {
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Renders labels as `a="x",b="y"` (without braces).
+std::string RenderLabels(const MetricLabels& labels) {
+  return absl::StrJoin(labels, ",",
+                       [](std::string* out,
+                          const std::pair<std::string, std::string>& label) {
+                         absl::StrAppend(out, label.first, "=\"",
+                                         EscapeLabelValue(label.second), "\"");
+                       });
+}
+
+std::string LabelSet(const MetricLabels& labels, const std::string& extra) {
+  std::string rendered = RenderLabels(labels);
+  if (!extra.empty()) {
+    rendered = rendered.empty() ? extra : absl::StrCat(rendered, ",", extra);
+  }
+  if (rendered.empty()) {
+    return "";
+  }
+  return absl::StrCat("{", rendered, "}");
+}
+
+std::string FormatDouble(double value) {
+  return absl::StrFormat("%.9g", value);
+}
+
+const char* PrometheusType(MetricType type) {
+  switch (type) {
+    case MetricType::kCounter:
+      return "counter";
+    case MetricType::kGauge:
+      return "gauge";
+    default:
+      return "histogram";
+  }
+}
+
+}  // namespace
+
+constexpr int Counter::kNumShards;
+constexpr int Counter::kShardSize;
+
+int64_t Counter::Value() const {
+  int64_t sum = 0;
+  for (const auto& shard : shards_) {
+    sum += shard.value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+MetricsRegistry* MetricsRegistry::Global() {
+  static auto* registry = new MetricsRegistry();
+  return registry;
+}
+
+MetricsRegistry::Metric* MetricsRegistry::GetMetric(const std::string& name,
+                                                    const std::string& help,
+                                                    const MetricLabels& labels,
+                                                    MetricType type) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_.emplace(name, Family()).first;
+    it->second.help = help;
+    it->second.type = type;
+  }
+  Family& family = it->second;
+  if (family.type != type) {
+    LOG(FATAL) << "Metric " << name << " is already registered with a "
+               << "different type";
+  }
+  Metric& metric = family.metrics[RenderLabels(labels)];
+  metric.labels = labels;
+  return &metric;
+}
+
+Counter* MetricsRegistry::GetCounter(const std::string& name,
+                                     const std::string& help,
+                                     const MetricLabels& labels) {
+  absl::MutexLock lock(&mu_);
+  Metric* metric = GetMetric(name, help, labels, MetricType::kCounter);
+  if (metric->counter == nullptr) {
+    metric->counter = std::make_unique<Counter>();
+  }
+  return metric->counter.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(const std::string& name,
+                                 const std::string& help,
+                                 const MetricLabels& labels) {
+  absl::MutexLock lock(&mu_);
+  Metric* metric = GetMetric(name, help, labels, MetricType::kGauge);
+  if (metric->gauge == nullptr) {
+    metric->gauge = std::make_unique<Gauge>();
+  }
+  return metric->gauge.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(const std::string& name,
+                                         const std::string& help,
+                                         const MetricLabels& labels) {
+  absl::MutexLock lock(&mu_);
+  Metric* metric = GetMetric(name, help, labels, MetricType::kHistogram);
+  if (metric->histogram == nullptr) {
+    metric->histogram = std::make_unique<Histogram>();
+  }
+  return metric->histogram.get();
+}
+
+LatencyHistogram* MetricsRegistry::GetLatencyHistogram(
+    const std::string& name, const std::string& help,
+    const MetricLabels& labels) {
+  absl::MutexLock lock(&mu_);
+  Metric* metric =
+      GetMetric(name, help, labels, MetricType::kLatencyHistogram);
+  if (metric->latency_histogram == nullptr) {
+    metric->latency_histogram = std::make_unique<LatencyHistogram>();
+  }
+  return metric->latency_histogram.get();
+}
+
+std::vector<MetricSnapshot> MetricsRegistry::Snapshot() const {
+  std::vector<MetricSnapshot> snapshots;
+  absl::MutexLock lock(&mu_);
+  for (const auto& family : families_) {
+    for (const auto& entry : family.second.metrics) {
+      const Metric& metric = entry.second;
+      MetricSnapshot snapshot;
+      snapshot.name = family.first;
+      snapshot.labels = metric.labels;
+      snapshot.type = family.second.type;
+      switch (snapshot.type) {
+        case MetricType::kCounter:
+          snapshot.value = metric.counter->Value();
+          break;
+        case MetricType::kGauge:
+          snapshot.value = metric.gauge->Value();
+          break;
+        case MetricType::kHistogram: {
+          int64_t cumulative = 0;
+          for (const auto& bucket : metric.histogram->Buckets()) {
+            cumulative += bucket.count;
+            if (bucket.upper == std::numeric_limits<int64_t>::max()) {
+              continue;
+            }
+            // Values are integers in [lower, upper).
+            snapshot.buckets.push_back(
+                {static_cast<double>(bucket.upper - 1), cumulative});
+          }
+          snapshot.count = cumulative;
+          snapshot.sum = metric.histogram->sum();
+          break;
+        }
+        case MetricType::kLatencyHistogram: {
+          int64_t cumulative = 0;
+          for (const auto& bucket : metric.latency_histogram->Buckets()) {
+            cumulative += bucket.count;
+            if (bucket.upper == absl::InfiniteDuration()) {
+              continue;
+            }
+            snapshot.buckets.push_back(
+                {absl::ToDoubleSeconds(bucket.upper), cumulative});
+          }
+          snapshot.count = cumulative;
+          snapshot.sum = absl::ToDoubleSeconds(metric.latency_histogram->sum());
+          break;
+        }
+      }
+      snapshots.push_back(std::move(snapshot));
+    }
+  }
+  return snapshots;
+}
+
+std::string MetricsRegistry::ToPrometheusText() const {
+  std::map<std::string, std::string> help;
+  {
+    absl::MutexLock lock(&mu_);
+    for (const auto& family : families_) {
+      help[family.first] = family.second.help;
+    }
+  }
+
+  std::string text;
+  std::string last_name;
+  for (const auto& snapshot : Snapshot()) {
+    if (snapshot.name != last_name) {
+      absl::StrAppend(&text, "# HELP ", snapshot.name, " ", help[snapshot.name],
+                      "\n# TYPE ", snapshot.name, " ",
+                      PrometheusType(snapshot.type), "\n");
+      last_name = snapshot.name;
+    }
+    if (snapshot.type == MetricType::kCounter ||
+        snapshot.type == MetricType::kGauge) {
+      absl::StrAppend(&text, snapshot.name, LabelSet(snapshot.labels, ""), " ",
+                      snapshot.value, "\n");
+      continue;
+    }
+    for (const auto& bucket : snapshot.buckets) {
+      absl::StrAppend(
+          &text, snapshot.name, "_bucket",
+          LabelSet(snapshot.labels,
+                   absl::StrCat("le=\"", FormatDouble(bucket.upper_bound),
+                                "\"")),
+          " ", bucket.count, "\n");
+    }
+    absl::StrAppend(&text, snapshot.name, "_bucket",
+                    LabelSet(snapshot.labels, "le=\"+Inf\""), " ",
+                    snapshot.count, "\n");
+    absl::StrAppend(&text, snapshot.name, "_sum",
+                    LabelSet(snapshot.labels, ""), " ",
+                    FormatDouble(snapshot.sum), "\n");
+    absl::StrAppend(&text, snapshot.name, "_count",
+                    LabelSet(snapshot.labels, ""), " ", snapshot.count, "\n");
+  }
+  return text;
+}
+
+}  // namespace aistreams
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_UTIL_METRICS_H_
+#define AISTREAMS_UTIL_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "aistreams/util/histogram.h"
+#include "aistreams/util/latency_histogram.h"
+
+namespace aistreams {
+
+// Label names and values that distinguish metrics of the same name, e.g.
+// {{"stream", "my-stream"}}.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// The kinds of metrics held in a MetricsRegistry.
+enum class MetricType {
+  kCounter,
+  kGauge,
+  kHistogram,
+  kLatencyHistogram,
+};
+
+namespace internal {
+
+// Returns a small per-thread index used to pick the shard to update.
+inline int ThisThreadShard() {
+  static std::atomic<int> next_shard{0};
+  thread_local int shard = next_shard.fetch_add(1, std::memory_order_relaxed);
+  return shard;
+}
+
+}  // namespace internal
+
+// A monotonically increasing count.
+//
+// Increments go to one of several cache-line padded shards picked by the
+// calling thread, so concurrent writers do not contend. Reading sums the
+// shards.
+//
+// This class is thread-safe.
+class Counter {
+ public:
+  Counter() = default;
+
+  // Add `n` to the count.
+  void Increment(int64_t n = 1) {
+    shards_[internal::ThisThreadShard() % kNumShards].value.fetch_add(
+        n, std::memory_order_relaxed);
+  }
+
+  // Returns the current count.
+  int64_t Value() const;
+
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+ private:
+  static constexpr int kNumShards = 16;
+
+  // Shards are spaced two cache lines apart so that no two share a line
+  // without relying on over-aligned allocation.
+  static constexpr int kShardSize = 128;
+  struct Shard {
+    std::atomic<int64_t> value{0};
+    char padding[kShardSize - sizeof(std::atomic<int64_t>)];
+  };
+  std::array<Shard, kNumShards> shards_;
+};
+
+// A value that can go up and down, e.g. a queue depth.
+//
+// This class is thread-safe.
+class Gauge {
+ public:
+  Gauge() = default;
+
+  // Set the value to `value`.
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+
+  // Add `n` to the value.
+  void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+
+  // Returns the current value.
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+  Gauge(const Gauge&) = delete;
+  Gauge& operator=(const Gauge&) = delete;
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// A point-in-time copy of one metric.
+struct MetricSnapshot {
+  // A cumulative histogram bucket: `count` values were <= `upper_bound`.
+  struct Bucket {
+    double upper_bound;
+    int64_t count;
+  };
+
+  std::string name;
+  MetricLabels labels;
+  MetricType type;
+
+  // The value of a counter or gauge.
+  int64_t value = 0;
+
+  // The contents of a histogram. Latencies are in seconds.
+  int64_t count = 0;
+  double sum = 0;
+  std::vector<Bucket> buckets;
+};
+
+// A collection of named metrics.
+//
+// Metrics are created on first lookup and live as long as the registry, so
+// components should look them up once and keep the pointer for the hot path.
+// Lookups of the same name and labels return the same metric. A name may only
+// be used with one MetricType.
+//
+// This class is thread-safe.
+class MetricsRegistry {
+ public:
+  MetricsRegistry() = default;
+
+  // Returns the registry that the library components record into.
+  static MetricsRegistry* Global();
+
+  // Returns the metric with the given name and labels, creating it if needed.
+  //
+  // `help` describes the metric; only the first one given for a name is kept.
+  Counter* GetCounter(const std::string& name, const std::string& help,
+                      const MetricLabels& labels = {});
+  Gauge* GetGauge(const std::string& name, const std::string& help,
+                  const MetricLabels& labels = {});
+  Histogram* GetHistogram(const std::string& name, const std::string& help,
+                          const MetricLabels& labels = {});
+  LatencyHistogram* GetLatencyHistogram(const std::string& name,
+                                        const std::string& help,
+                                        const MetricLabels& labels = {});
+
+  // Returns a copy of all metrics, ordered by name.
+  std::vector<MetricSnapshot> Snapshot() const;
+
+  // Returns all metrics in the Prometheus text exposition format.
+  std::string ToPrometheusText() const;
+
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+ private:
+  struct Metric {
+    MetricLabels labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+    std::unique_ptr<LatencyHistogram> latency_histogram;
+  };
+
+  struct Family {
+    std::string help;
+    MetricType type;
+    // Keyed by the rendered labels.
+    std::map<std::string, Metric> metrics;
+  };
+
+  Metric* GetMetric(const std::string& name, const std::string& help,
+                    const MetricLabels& labels, MetricType type)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+  std::map<std::string, Family> families_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_UTIL_METRICS_H_
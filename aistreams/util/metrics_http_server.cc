@@ -0,0 +1,179 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/metrics_http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr int kPollIntervalMs = 200;
+constexpr int kRequestTimeoutSeconds = 2;
+constexpr size_t kMaxRequestSize = 8192;
+
+void WriteAll(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = send(fd, data.data() + written, data.size() - written,
+                     MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    written += n;
+  }
+}
+
+std::string HttpResponse(const std::string& status,
+                         const std::string& content_type,
+                         const std::string& body) {
+  return absl::StrCat("HTTP/1.1 ", status, "\r\nContent-Type: ", content_type,
+                      "\r\nContent-Length: ", body.size(),
+                      "\r\nConnection: close\r\n\r\n", body);
+}
+
+}  // namespace
+
+MetricsHttpServer::MetricsHttpServer(const Options& options)
+    : options_(options) {
+  if (options_.registry == nullptr) {
+    options_.registry = MetricsRegistry::Global();
+  }
+}
+
+MetricsHttpServer::~MetricsHttpServer() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+}
+
+StatusOr<std::unique_ptr<MetricsHttpServer>> MetricsHttpServer::Create(
+    const Options& options) {
+  auto server = std::make_unique<MetricsHttpServer>(options);
+  AIS_RETURN_IF_ERROR(server->Initialize());
+  return server;
+}
+
+Status MetricsHttpServer::Initialize() {
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options_.port);
+  if (inet_pton(AF_INET, options_.address.c_str(), &addr.sin_addr) != 1) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given an invalid IPv4 address \"%s\"", options_.address));
+  }
+
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return InternalError(
+        absl::StrFormat("Failed to create a socket: %s", strerror(errno)));
+  }
+  int reuse = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    return UnavailableError(absl::StrFormat("Failed to bind to %s:%d: %s",
+                                            options_.address, options_.port,
+                                            strerror(errno)));
+  }
+  if (listen(listen_fd_, 8) < 0) {
+    return InternalError(
+        absl::StrFormat("Failed to listen: %s", strerror(errno)));
+  }
+
+  socklen_t addr_len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+  port_ = ntohs(addr.sin_port);
+
+  thread_ = std::thread(&MetricsHttpServer::Serve, this);
+  return OkStatus();
+}
+
+void MetricsHttpServer::Serve() {
+  while (!stop_) {
+    pollfd pfd;
+    pfd.fd = listen_fd_;
+    pfd.events = POLLIN;
+    int ready = poll(&pfd, 1, kPollIntervalMs);
+    if (ready <= 0) {
+      continue;
+    }
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    HandleConnection(fd);
+    close(fd);
+  }
+}
+
+void MetricsHttpServer::HandleConnection(int fd) {
+  timeval timeout;
+  timeout.tv_sec = kRequestTimeoutSeconds;
+  timeout.tv_usec = 0;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Read until the end of the request headers.
+  std::string request;
+  char buf[1024];
+  while (request.size() < kMaxRequestSize &&
+         request.find("\r\n\r\n") == std::string::npos) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    request.append(buf, n);
+  }
+
+  if (!absl::StartsWith(request, "GET ")) {
+    WriteAll(fd, HttpResponse("405 Method Not Allowed", "text/plain",
+                              "Only GET is supported\n"));
+    return;
+  }
+  size_t path_end = request.find(' ', 4);
+  std::string path = request.substr(4, path_end - 4);
+  if (path != "/metrics" && path != "/") {
+    WriteAll(fd, HttpResponse("404 Not Found", "text/plain", "Not found\n"));
+    return;
+  }
+  WriteAll(fd, HttpResponse("200 OK", "text/plain; version=0.0.4",
+                            options_.registry->ToPrometheusText()));
+}
+
+}  // namespace aistreams
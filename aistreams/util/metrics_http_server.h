@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_UTIL_METRICS_HTTP_SERVER_H_
+#define AISTREAMS_UTIL_METRICS_HTTP_SERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/metrics.h"
+
+namespace aistreams {
+
+// A minimal HTTP server that serves the metrics of a MetricsRegistry in the
+// Prometheus text format at /metrics.
+//
+// Requests are handled one at a time on a single background thread, which is
+// plenty for a scraper polling every few seconds.
+class MetricsHttpServer {
+ public:
+  struct Options {
+    // The address to listen on. Defaults to the loopback interface only.
+    std::string address = "127.0.0.1";
+
+    // The port to listen on. Use 0 to pick any free port.
+    int port = 9464;
+
+    // The registry to serve. Defaults to MetricsRegistry::Global().
+    MetricsRegistry* registry = nullptr;
+  };
+
+  // Create and start a server.
+  static StatusOr<std::unique_ptr<MetricsHttpServer>> Create(const Options&);
+
+  // Returns the port the server is listening on.
+  int port() const { return port_; }
+
+  // Copy-control members. Use Create() rather than the constructors.
+  //
+  // The destructor stops the server.
+  MetricsHttpServer(const Options&);
+  ~MetricsHttpServer();
+  MetricsHttpServer(const MetricsHttpServer&) = delete;
+  MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+ private:
+  Status Initialize();
+  void Serve();
+  void HandleConnection(int fd);
+
+  Options options_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_UTIL_METRICS_HTTP_SERVER_H_
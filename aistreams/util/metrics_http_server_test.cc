@@ -0,0 +1,83 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/metrics_http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+std::string Get(int port, const std::string& path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return "";
+  }
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  send(fd, request.data(), request.size(), 0);
+  std::string response;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    response.append(buf, n);
+  }
+  close(fd);
+  return response;
+}
+
+}  // namespace
+
+TEST(MetricsHttpServerTest, ServesMetricsTest) {
+  MetricsRegistry registry;
+  registry.GetCounter("requests_total", "Requests.")->Increment(4);
+
+  MetricsHttpServer::Options options;
+  options.port = 0;
+  options.registry = &registry;
+  auto server_statusor = MetricsHttpServer::Create(options);
+  ASSERT_TRUE(server_statusor.ok());
+  auto server = std::move(server_statusor).ValueOrDie();
+  ASSERT_GT(server->port(), 0);
+
+  std::string response = Get(server->port(), "/metrics");
+  EXPECT_TRUE(absl::StartsWith(response, "HTTP/1.1 200 OK"));
+  EXPECT_TRUE(absl::StrContains(response, "requests_total 4\n"));
+
+  response = Get(server->port(), "/nope");
+  EXPECT_TRUE(absl::StartsWith(response, "HTTP/1.1 404"));
+}
+
+TEST(MetricsHttpServerTest, InvalidAddressTest) {
+  MetricsHttpServer::Options options;
+  options.address = "not-an-address";
+  EXPECT_FALSE(MetricsHttpServer::Create(options).ok());
+}
+
+}  // namespace aistreams
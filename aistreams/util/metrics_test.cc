@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/util/metrics.h"
+
+#include <thread>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+TEST(MetricsTest, CounterTest) {
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&counter]() {
+      for (int i = 0; i < 10000; ++i) {
+        counter.Increment();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  counter.Increment(5);
+  EXPECT_EQ(counter.Value(), 80005);
+}
+
+TEST(MetricsTest, RegistryLookupTest) {
+  MetricsRegistry registry;
+  Counter* a = registry.GetCounter("packets_total", "Packets.", {{"s", "a"}});
+  Counter* b = registry.GetCounter("packets_total", "Packets.", {{"s", "b"}});
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, registry.GetCounter("packets_total", "", {{"s", "a"}}));
+
+  a->Increment(2);
+  registry.GetGauge("depth", "Depth.")->Set(7);
+  auto snapshots = registry.Snapshot();
+  ASSERT_EQ(snapshots.size(), 3);
+  EXPECT_EQ(snapshots[0].name, "depth");
+  EXPECT_EQ(snapshots[0].value, 7);
+  EXPECT_EQ(snapshots[1].name, "packets_total");
+  EXPECT_EQ(snapshots[1].labels[0].second, "a");
+  EXPECT_EQ(snapshots[1].value, 2);
+  EXPECT_EQ(snapshots[2].value, 0);
+}
+
+TEST(MetricsTest, PrometheusTextTest) {
+  MetricsRegistry registry;
+  registry.GetCounter("sent_total", "Sent.", {{"stream", "a\"b"}})
+      ->Increment(3);
+  auto* latency = registry.GetLatencyHistogram("latency_seconds", "Latency.");
+  latency->Record(absl::Milliseconds(1));
+  latency->Record(absl::Milliseconds(3));
+  registry.GetHistogram("depth", "Depth.")->Record(2);
+
+  std::string text = registry.ToPrometheusText();
+  EXPECT_TRUE(absl::StrContains(text, "# TYPE sent_total counter\n"));
+  EXPECT_TRUE(absl::StrContains(text, "sent_total{stream=\"a\\\"b\"} 3\n"));
+  EXPECT_TRUE(absl::StrContains(text, "# TYPE latency_seconds histogram\n"));
+  EXPECT_TRUE(
+      absl::StrContains(text, "latency_seconds_bucket{le=\"+Inf\"} 2\n"));
+  EXPECT_TRUE(absl::StrContains(text, "latency_seconds_sum 0.004\n"));
+  EXPECT_TRUE(absl::StrContains(text, "latency_seconds_count 2\n"));
+  EXPECT_TRUE(absl::StrContains(text, "depth_bucket{le=\"2\"} 1\n"));
+}
+
+}  // namespace aistreams
@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/time/time.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/util/alloc_counter.h"
+#include "aistreams/util/producer_consumer_queue.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr int kQueueCapacity = 1024;
+
+}  // namespace
+
+// Each benchmark thread with an even index produces and each with an odd index
+// consumes, so Threads(2) is 1P1C and Threads(8) is 4P4C. Every thread runs
+// the same number of iterations, so the pushes and pops balance out.
+//
+// Elements are moved through the queue, so the cost does not depend on the
+// payload size; the elements are plain integers and the results are reported
+// as items per second.
+void BM_ProducerConsumerQueue(benchmark::State& state) {
+  static ProducerConsumerQueue<int64_t>* queue;
+  if (state.thread_index == 0) {
+    queue = new ProducerConsumerQueue<int64_t>(kQueueCapacity);
+  }
+  bool is_producer = state.thread_index % 2 == 0;
+  AllocationCounter allocs;
+  int64_t i = 0;
+  for (auto _ : state) {
+    if (is_producer) {
+      queue->Emplace(i++);
+    } else {
+      int64_t element;
+      queue->Pop(element);
+      benchmark::DoNotOptimize(element);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs_per_op"] = benchmark::Counter(
+      allocs.allocations(), benchmark::Counter::kAvgIterations);
+  if (state.thread_index == 0) {
+    delete queue;
+  }
+}
+BENCHMARK(BM_ProducerConsumerQueue)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->UseRealTime();
+
+// TryPush/TryPop with unique_ptr elements, as used by the receiver queues.
+void BM_ProducerConsumerQueueTryPush(benchmark::State& state) {
+  static ProducerConsumerQueue<std::string>* queue;
+  if (state.thread_index == 0) {
+    queue = new ProducerConsumerQueue<std::string>(kQueueCapacity);
+  }
+  bool is_producer = state.thread_index % 2 == 0;
+  AllocationCounter allocs;
+  for (auto _ : state) {
+    if (is_producer) {
+      auto element = std::make_unique<std::string>();
+      while (!queue->TryPush(element, absl::Milliseconds(1))) {
+      }
+    } else {
+      std::string element;
+      while (!queue->TryPop(element, absl::Milliseconds(1))) {
+      }
+      benchmark::DoNotOptimize(element);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs_per_op"] = benchmark::Counter(
+      allocs.allocations(), benchmark::Counter::kAvgIterations);
+  if (state.thread_index == 0) {
+    delete queue;
+  }
+}
+BENCHMARK(BM_ProducerConsumerQueueTryPush)
+    ->Threads(2)
+    ->Threads(8)
+    ->UseRealTime();
+
+}  // namespace aistreams
@@ -83,6 +83,14 @@ def aistreams_sdk_deps():
         path = "/usr",
     )
 
+    # This requires libjpeg-turbo to be installed on your system.
+    maybe(
+        native.new_local_repository,
+        name = "libjpeg_turbo",
+        build_file = "//third_party:libjpeg_turbo.BUILD",
+        path = "/usr",
+    )
+
     maybe(
         http_archive,
         name = "pybind11",
@@ -110,7 +110,7 @@ Status RunSender() {
     auto packet = std::move(packet_statusor).ValueOrDie();
 
     // Send the Packet.
-    auto status = sender->Send(packet);
+    auto status = sender->Send(std::move(packet));
     LOG(INFO) << "Sent " << i+1 << "'th packet.";
     if (!status.ok()) {
       LOG(ERROR) << status;